@@ -0,0 +1,477 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host side check of the ADC read out of the scope firmware
+//
+//The read out was split in fpga_read_adc_data, which only clocks the samples out of the FPGA, and fpga_process_adc_data, which does the
+//compensation, measurements and zero crossing detection on the stored samples. This runs the firmware version of these functions and
+//the original single loop version side by side on synthetic captures, and compares the trace buffers and all the channel
+//measurements. The FPGA data bus is simulated with a sample array, so the firmware source is used as is.
+//
+//The captures are random noise, sines, squares and flat signals near zero, with random sample counts and ADC compensation values.
+//
+//Build: make adc_readout_test
+//   or: gcc -O2 -fcommon -I../fnirsi_1013d_scope -o adc_readout_test adc_readout_test.c ../fnirsi_1013d_scope/variables.c -lm
+//  Run: make check
+//Usage: adc_readout_test [number of captures] [random seed]
+//  e.g. ./adc_readout_test 300000
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Take the firmware headers first, so the bus macros can be replaced by reads from the simulated data bus
+
+#include "fpga_control.h"
+#include "fnirsi_1013d_scope.h"
+
+uint8 *busdata;
+uint32 busvalue;
+
+#undef  FPGA_CTRL_INIT
+#undef  FPGA_CLK_INIT
+#undef  FPGA_BUS_DIR_IN
+#undef  FPGA_DATA_READ
+#undef  FPGA_PULSE_CLK
+#undef  FPGA_GET_DATA
+
+#define FPGA_CTRL_INIT()        ((void)0)
+#define FPGA_CLK_INIT()         ((void)0)
+#define FPGA_BUS_DIR_IN()       ((void)0)
+#define FPGA_DATA_READ()        ((void)0)
+#define FPGA_PULSE_CLK()        (busvalue = *busdata++)
+#define FPGA_GET_DATA()         (busvalue)
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Only the read out functions of the firmware are used. The other ones access the hardware and are never called. The ARM assembly in
+//the delay functions is left out, which leaves a statement without effect and an unused loop counter. Those warnings are only
+//switched off for the firmware source
+
+#define __asm__
+#define __volatile__(...)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-value"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+#include "fpga_control.c"
+
+#pragma GCC diagnostic pop
+
+#undef  __asm__
+#undef  __volatile__
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The conversion functions check the touch panel while waiting. Not used here
+
+void tp_i2c_read_status(void)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The read out as it was before the split, with the samples compensated and measured while they are clocked out of the FPGA
+
+void old_fpga_read_adc_data(PCHANNELSETTINGS settings)
+{
+  register int32  sample;
+  register uint32 count;
+  register uint32 sum = 0;
+  
+  //Set the bus for reading
+  FPGA_BUS_DIR_IN();
+  
+  //Set the control lines for reading a command
+  FPGA_DATA_READ();
+  
+  //Set the number of samples to read
+  count = scopesettings.nofsamples;
+  
+  //Read the data as long as there is count
+  while(count)
+  {
+    //Clock the data to the output of the FPGA
+    FPGA_PULSE_CLK();
+
+    //Read the data
+    sample = FPGA_GET_DATA();
+    
+    //Sum the raw data for ADC difference calibration
+    sum += sample;
+
+    //Compensate the value for ADC in equality
+    sample += settings->compensation;
+    
+    //Check if sample became negative
+    if(sample < 0)
+    {
+      //Keep it on zero if so
+      sample = 0;
+    }
+    
+    //Check if sample over its max
+    if(sample > 255)
+    {
+      //Keep it on max if so
+      sample = 255;
+    }
+    
+    //Check if busy with second ADC data
+    if(settings->checkfirstadc)
+    {
+      //When ADC1 compensation is positive, ADC1 bottoms out on this value
+      //Near the top ADC2 reaches the top value first, so same method is needed
+      if(settings->adc1compensation > 0)
+      {
+        //So when the compensated ADC2 sample is below the ADC1 compensation value the reading needs to be matched
+        if(sample < settings->adc1compensation)
+        {
+          //Match the two readings when within compensation range
+          settings->buffer[1] = sample;
+        }
+        //Or when the compensated ADC1 sample is above max value ADC2 can reach the reading also needs to be matched
+        else if(settings->buffer[1] > (255 + settings->adc2compensation))
+        {
+          //Use the compensated ADC1 sample in that case
+          sample = settings->buffer[1];
+        }
+      }
+      //When ADC1 compensation is negative, ADC2 bottoms out on it's compensation value
+      else if(settings->adc1compensation < 0)
+      {
+        //So when the compensated ADC1 sample is below the ADC2 compensation value the reading needs to be matched
+        if(settings->buffer[1] < settings->adc2compensation)
+        {
+          //Use the compensated ADC1 sample in that case
+          sample = settings->buffer[1];
+        }
+        //Or when the compensated ADC2 sample is above max value ADC1 can reach the reading also needs to be matched
+        else if(sample > (255 + settings->adc1compensation))
+        {
+          //Match the two readings when within compensation range
+          settings->buffer[1] = sample;
+        }
+      }
+    }
+    
+    //Get the minimum value of the samples
+    if(sample < settings->min)
+    {
+      //Keep the lowest
+      settings->min = sample;
+    }
+    
+    //Get the maximum value of the samples
+    if(sample > settings->max)
+    {
+      //Keep the highest
+      settings->max = sample;
+    }
+    
+    //Add the samples for average calculation
+    settings->average += sample;
+    
+    //Store the data
+    *settings->buffer = sample;
+
+    //Check if busy with second ADC data to see if frequency determination can be done
+    if(settings->checkfirstadc)
+    {
+      //Check against the high level
+      if(sample > settings->highlevel)
+      {
+        //If above, check if in low state
+        if(settings->state == 0)
+        {
+          //If so flip the state
+          settings->state = 1;
+          
+          //Check if first zero crossing detected
+          if(settings->zerocrossings == 0)
+          {
+            //Set the previous index if so
+            settings->previousindex = count;
+          }
+          else
+          {
+            //Calculate the total number of samples in the low parts of the signal
+            settings->lowsamplecount += settings->previousindex - count;
+            
+            //Add one to the low divider for average calculation
+            settings->lowdivider++;
+            
+            //Set the new previous index
+            settings->previousindex = count;
+          }
+
+          //Found a zero crossing
+          settings->zerocrossings++;
+        }
+      }
+      //Check against the low level
+      else if(sample < settings->lowlevel)
+      {
+        //If below check if in high state
+        if(settings->state == 1)
+        {
+          //If so flip the state
+          settings->state = 0;
+
+          //Check if first zero crossing detected
+          if(settings->zerocrossings == 0)
+          {
+            //Set the previous index if so
+            settings->previousindex = count;
+          }
+          else
+          {
+            //Calculate the total number of samples in the high parts of the signal
+            settings->highsamplecount += settings->previousindex - count;
+            
+            //Add one to the low divider for average calculation
+            settings->highdivider++;
+            
+            //Set the new previous index
+            settings->previousindex = count;
+          }
+          
+          //Found a zero crossing
+          settings->zerocrossings++;
+        }
+      }
+    }    
+    
+    //Skip a sample to allow for ADC2 data to be placed into
+    settings->buffer += 2;
+    
+    //One read done
+    count--;
+  }
+ 
+  //Calculate the raw average
+  settings->rawaverage = sum / scopesettings.nofsamples;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Simple random generator, so a run can be repeated with the same seed on any host
+
+uint32 randomstate;
+
+uint32 random_value(uint32 range)
+{
+  randomstate = (randomstate * 1103515245) + 12345;
+
+  return(((randomstate >> 8) & 0x00FFFFFF) % range);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Fill the simulated bus with a capture of the given type
+
+void make_capture(uint8 *data, uint32 count)
+{
+  uint32 type = random_value(4);
+  uint32 noise = random_value(8);
+  uint32 amplitude = random_value(160);
+  uint32 center = random_value(256);
+  uint32 period = random_value(200) + 4;
+  uint32 index;
+  int32  sample;
+
+  for(index=0;index<count;index++)
+  {
+    switch(type)
+    {
+      default:
+        //Random noise over the full range
+        sample = random_value(256);
+        break;
+
+      case 1:
+        //Sine with some noise
+        sample = center + (amplitude * sin((2 * M_PI * index) / period)) + random_value(noise + 1) - (noise / 2);
+        break;
+
+      case 2:
+        //Square with some noise
+        sample = (((index / (period / 2)) & 1) ? center + amplitude : center - amplitude) + random_value(noise + 1) - (noise / 2);
+        break;
+
+      case 3:
+        //Flat near zero, which makes the low level wrap around below zero
+        sample = random_value(noise + 1);
+        break;
+    }
+
+    //The ADC does not go beyond its range
+    if(sample < 0)
+    {
+      sample = 0;
+    }
+    else if(sample > 255)
+    {
+      sample = 255;
+    }
+
+    data[index] = sample;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Read both ADC's of a channel like fpga_read_sample_data does, with the given read out function
+
+void read_channel(PCHANNELSETTINGS settings, void (*readadcdata)(PCHANNELSETTINGS settings), uint8 *adc1data, uint8 *adc2data)
+{
+  uint32 threshold;
+
+  settings->min     = 0x7FFFFFFF;
+  settings->max     = 0;
+  settings->average = 0;
+
+  //First ADC
+  settings->checkfirstadc = 0;
+  settings->compensation = settings->adc1compensation;
+  settings->buffer = &settings->tracebuffer[1];
+
+  busdata = adc1data;
+  readadcdata(settings);
+
+  settings->adc1rawaverage = settings->rawaverage;
+
+  //Zero crossing levels for the second ADC
+  settings->center = (settings->max + settings->min) / 2;
+
+  threshold = ((settings->max - settings->min) / 10) + 2;
+
+  settings->highlevel = settings->center + threshold;
+  settings->lowlevel  = settings->center - threshold;
+
+  settings->zerocrossings   = 0;
+  settings->lowsamplecount  = 0;
+  settings->lowdivider      = 0;
+  settings->highsamplecount = 0;
+  settings->highdivider     = 0;
+
+  settings->state = (settings->tracebuffer[1] > settings->highlevel) ? 1 : 0;
+
+  //Second ADC
+  settings->checkfirstadc = 1;
+  settings->compensation = settings->adc2compensation;
+  settings->buffer = &settings->tracebuffer[0];
+
+  busdata = adc2data;
+  readadcdata(settings);
+
+  settings->adc2rawaverage = settings->rawaverage;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the name of the first measurement that differs, or zero when all are the same
+
+const char *compare_channels(PCHANNELSETTINGS old, PCHANNELSETTINGS new, uint32 count)
+{
+  if(memcmp(old->tracebuffer, new->tracebuffer, count * 2))      return("trace buffer");
+  if((old->buffer - old->tracebuffer) != (new->buffer - new->tracebuffer)) return("buffer pointer");
+  if(old->min != new->min)                                       return("min");
+  if(old->max != new->max)                                       return("max");
+  if(old->average != new->average)                               return("average");
+  if(old->adc1rawaverage != new->adc1rawaverage)                 return("adc1 raw average");
+  if(old->adc2rawaverage != new->adc2rawaverage)                 return("adc2 raw average");
+  if(old->state != new->state)                                   return("state");
+  if(old->zerocrossings != new->zerocrossings)                   return("zero crossings");
+  if(old->lowsamplecount != new->lowsamplecount)                 return("low sample count");
+  if(old->lowdivider != new->lowdivider)                         return("low divider");
+  if(old->highsamplecount != new->highsamplecount)               return("high sample count");
+  if(old->highdivider != new->highdivider)                       return("high divider");
+  if((old->zerocrossings > 1) && (old->previousindex != new->previousindex)) return("previous index");
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  static uint8 adc1data[ADC_MAX_SAMPLES];
+  static uint8 adc2data[ADC_MAX_SAMPLES];
+  static uint8 oldtrace[ADC_MAX_SAMPLES * 2];
+  static uint8 newtrace[ADC_MAX_SAMPLES * 2];
+
+  CHANNELSETTINGS old;
+  CHANNELSETTINGS new;
+
+  uint32 captures = 300000;
+  uint32 capture;
+  uint32 failures = 0;
+  const char *difference;
+
+  if(argc > 1)
+  {
+    captures = strtoul(argv[1], 0, 0);
+  }
+
+  randomstate = (argc > 2) ? strtoul(argv[2], 0, 0) : 1013;
+
+  //Setup the clamp table. The hardware setup in it does nothing on the host
+  fpga_init();
+
+  for(capture=0;capture<captures;capture++)
+  {
+    //Mostly the full record, but also odd counts to check the samples that do not fill a word
+    if(random_value(4))
+    {
+      scopesettings.nofsamples = (random_value(2)) ? ADC_MAX_SAMPLES : SEGMENT_NOF_SAMPLES;
+    }
+    else
+    {
+      scopesettings.nofsamples = random_value(ADC_MAX_SAMPLES) + 1;
+    }
+
+    scopesettings.samplecount = scopesettings.nofsamples * 2;
+
+    make_capture(adc1data, scopesettings.nofsamples);
+    make_capture(adc2data, scopesettings.nofsamples);
+
+    //Both versions start with the same settings
+    memset(&old, 0, sizeof(old));
+
+    if(random_value(8))
+    {
+      old.adc1compensation = (int32)random_value(41) - 20;
+      old.adc2compensation = (int32)random_value(41) - 20;
+    }
+    else
+    {
+      //Now and then a compensation beyond the sample range
+      old.adc1compensation = (int32)random_value(701) - 350;
+      old.adc2compensation = (int32)random_value(701) - 350;
+    }
+
+    //The stored previous index is only used after the first zero crossing, so it starts with what was left from another capture
+    old.previousindex = random_value(ADC_MAX_SAMPLES);
+
+    new = old;
+
+    old.tracebuffer = oldtrace;
+    new.tracebuffer = newtrace;
+
+    memset(oldtrace, 0, sizeof(oldtrace));
+    memset(newtrace, 0, sizeof(newtrace));
+
+    read_channel(&old, old_fpga_read_adc_data, adc1data, adc2data);
+    read_channel(&new, fpga_read_adc_data, adc1data, adc2data);
+
+    if((difference = compare_channels(&old, &new, scopesettings.nofsamples)))
+    {
+      if(failures < 10)
+      {
+        printf("Capture %u with %u samples and compensation %d, %d: %s differs\n", capture, scopesettings.nofsamples, old.adc1compensation, old.adc2compensation, difference);
+      }
+
+      failures++;
+    }
+  }
+
+  printf("%u captures checked, %u differ\n", captures, failures);
+
+  return(failures ? 1 : 0);
+}
@@ -0,0 +1,187 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host benchmark for the display library primitives. Run the test program with -benchmark to get the Mpixel/s figures.
+//The numbers are host numbers, so only the relative differences say something about the speed on the scope.
+//
+//The before figures are the median of three runs with the display library as it was before the word wide, clip once primitives,
+//built with -O2 on an x86-64 host. Its copy functions already used memcpy, so they are about the same. The speedup column is only
+//meaningful on a comparable host.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "display_lib.h"
+#include "display_lib_benchmark.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static uint16 benchmarkscreen[BENCHMARK_SCREEN_WIDTH * BENCHMARK_SCREEN_HEIGHT] __attribute__ ((aligned (32)));
+static uint16 benchmarksource[BENCHMARK_SCREEN_WIDTH * BENCHMARK_SCREEN_HEIGHT] __attribute__ ((aligned (32)));
+static uint16 benchmarkgradient[BENCHMARK_SCREEN_HEIGHT];
+
+static uint8  benchmarkicon[((BENCHMARK_ICON_WIDTH + 7) / 8) * BENCHMARK_ICON_HEIGHT];
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_fill_screen(void)
+{
+  display_fill_rect(0, 0, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_fill_trace_area(void)
+{
+  //Same rectangle the scope clears for every trace display
+  display_fill_rect(2, 46, 728, 434);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_fill_odd_rect(void)
+{
+  //Odd start and width to have the unaligned head and tail handling in it
+  display_fill_rect(3, 47, 301, 201);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_copy_to_screen(void)
+{
+  display_copy_rect_to_screen(2, 46, 728, 434);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_copy_to_screen_full(void)
+{
+  display_copy_rect_to_screen(0, 0, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_copy_from_screen(void)
+{
+  display_copy_rect_from_screen(2, 46, 728, 434);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_icon_use_colors(void)
+{
+  display_copy_icon_use_colors(benchmarkicon, 100, 100, BENCHMARK_ICON_WIDTH, BENCHMARK_ICON_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_icon_use_colors_unaligned(void)
+{
+  display_copy_icon_use_colors(benchmarkicon, 101, 100, BENCHMARK_ICON_WIDTH, BENCHMARK_ICON_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_icon_fg_color(void)
+{
+  display_copy_icon_fg_color(benchmarkicon, 100, 100, BENCHMARK_ICON_WIDTH, BENCHMARK_ICON_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void benchmark_icon_fg_color_y_gradient(void)
+{
+  display_copy_icon_fg_color_y_gradient(benchmarkicon, 100, 100, BENCHMARK_ICON_WIDTH, BENCHMARK_ICON_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static const BENCHMARKITEM benchmarkitems[] =
+{
+  { "display_fill_rect (full screen)",              benchmark_fill_screen,               BENCHMARK_SCREEN_WIDTH * BENCHMARK_SCREEN_HEIGHT,  2593.5 },
+  { "display_fill_rect (trace area)",               benchmark_fill_trace_area,           728 * 434,                                         2522.4 },
+  { "display_fill_rect (unaligned)",                benchmark_fill_odd_rect,             301 * 201,                                         2347.4 },
+  { "display_copy_rect_to_screen (trace area)",     benchmark_copy_to_screen,            728 * 434,                                        14037.0 },
+  { "display_copy_rect_to_screen (full screen)",    benchmark_copy_to_screen_full,       BENCHMARK_SCREEN_WIDTH * BENCHMARK_SCREEN_HEIGHT, 14592.5 },
+  { "display_copy_rect_from_screen (trace area)",   benchmark_copy_from_screen,          728 * 434,                                        14493.3 },
+  { "display_copy_icon_use_colors",                 benchmark_icon_use_colors,           BENCHMARK_ICON_WIDTH * BENCHMARK_ICON_HEIGHT,      1160.4 },
+  { "display_copy_icon_use_colors (unaligned)",     benchmark_icon_use_colors_unaligned, BENCHMARK_ICON_WIDTH * BENCHMARK_ICON_HEIGHT,      1167.1 },
+  { "display_copy_icon_fg_color",                   benchmark_icon_fg_color,             BENCHMARK_ICON_WIDTH * BENCHMARK_ICON_HEIGHT,       742.2 },
+  { "display_copy_icon_fg_color_y_gradient",        benchmark_icon_fg_color_y_gradient,  BENCHMARK_ICON_WIDTH * BENCHMARK_ICON_HEIGHT,       615.4 },
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static uint64 benchmark_get_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  //Return the time in microseconds
+  return(((uint64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_lib_benchmark(void)
+{
+  uint32 item;
+  uint32 i;
+  uint64 calls;
+  uint64 start;
+  uint64 elapsed;
+  double mpixels;
+
+  //Setup the display library on the benchmark buffers
+  display_set_dimensions(BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+  display_set_screen_buffer(benchmarkscreen);
+  display_set_source_buffer(benchmarksource);
+  display_set_destination_buffer(benchmarksource);
+  display_set_fg_color(0x00FFFF00);
+  display_set_bg_color(0x00000000);
+  display_set_fg_y_gradient(benchmarkgradient, 0, BENCHMARK_SCREEN_HEIGHT - 1, 0x00FF0000, 0x000000FF);
+
+  //Give the source some content
+  for(i=0;i<(BENCHMARK_SCREEN_WIDTH * BENCHMARK_SCREEN_HEIGHT);i++)
+  {
+    benchmarksource[i] = i;
+  }
+
+  //Use a pattern with both empty and filled bytes for the icon, like the real icons have
+  for(i=0;i<sizeof(benchmarkicon);i++)
+  {
+    benchmarkicon[i] = (i % 3) ? 0x00 : (0x5A ^ i);
+  }
+
+  printf("%-46s %12s %10s %10s %8s\n", "Primitive", "Calls", "Mpixel/s", "Before", "Speedup");
+
+  //Run every primitive for at least the minimal time
+  for(item=0;item<(sizeof(benchmarkitems) / sizeof(BENCHMARKITEM));item++)
+  {
+    calls = 0;
+    start = benchmark_get_time();
+
+    do
+    {
+      //Do a batch of calls between the time checks
+      for(i=0;i<16;i++)
+      {
+        benchmarkitems[item].function();
+      }
+
+      calls += 16;
+      elapsed = benchmark_get_time() - start;
+    } while(elapsed < BENCHMARK_MIN_TIME);
+
+    //Pixels per microsecond equals mega pixels per second
+    mpixels = (double)(calls * benchmarkitems[item].pixels) / (double)elapsed;
+
+    printf("%-46s %12llu %10.1f %10.1f %7.2fx\n", benchmarkitems[item].name, calls, mpixels, benchmarkitems[item].before, mpixels / benchmarkitems[item].before);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,43 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef DISPLAY_LIB_BENCHMARK_H
+#define DISPLAY_LIB_BENCHMARK_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "types.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define BENCHMARK_SCREEN_WIDTH      800
+#define BENCHMARK_SCREEN_HEIGHT     480
+
+#define BENCHMARK_ICON_WIDTH         61
+#define BENCHMARK_ICON_HEIGHT        48
+
+//Minimum time a single primitive is run for in microseconds
+#define BENCHMARK_MIN_TIME       500000
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef void (*BENCHMARKFUNCTION)(void);
+
+typedef struct tagBenchmarkItem   BENCHMARKITEM,  *PBENCHMARKITEM;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagBenchmarkItem
+{
+  char              *name;
+  BENCHMARKFUNCTION  function;
+  uint32             pixels;              //Number of pixels handled per call of the function
+  double             before;              //Mpixel/s of the display library before the word wide primitives
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_lib_benchmark(void);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* DISPLAY_LIB_BENCHMARK_H */
@@ -3,10 +3,11 @@
 #include <string.h>
 
 #include "xlibfunctions.h"
-#include "../../F1C100s/fnirsi_1013d_scope/sin_cos_math.h"
-#include "../../F1C100s/fnirsi_1013d_scope/types.h"
-#include "../../F1C100s/fnirsi_1013d_scope/font_structs.h"
-#include "../../F1C100s/fnirsi_1013d_scope/display_lib.h"
+#include "sin_cos_math.h"
+#include "types.h"
+#include "font_structs.h"
+#include "display_lib.h"
+#include "display_lib_benchmark.h"
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -1067,6 +1068,15 @@ void scope_display_channel_trace(uint16 *buffer, uint16 xpos, uint16 yoffset, ui
 
 int main(int argc,char **argv)
 {
+  //Check if only the primitives benchmark needs to be run
+  if((argc > 1) && (strcmp(argv[1], "-benchmark") == 0))
+  {
+    //No window needed for this
+    display_lib_benchmark();
+
+    return 0;
+  }
+
   //Basic setup for the xlib system  
 	Display *display = XOpenDisplay(NULL);
 	int screen_num = DefaultScreen(display);
@@ -36,9 +36,11 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 # Object Files
 OBJECTFILES= \
 	${OBJECTDIR}/display_lib.o \
+	${OBJECTDIR}/display_lib_benchmark.o \
 	${OBJECTDIR}/display_lib_test.o \
 	${OBJECTDIR}/font_0.o \
 	${OBJECTDIR}/font_2.o \
+	${OBJECTDIR}/icons.o \
 	${OBJECTDIR}/sin_cos_math.o \
 	${OBJECTDIR}/xlibfunctions.o
 
@@ -72,6 +74,11 @@ ${OBJECTDIR}/display_lib.o: display_lib.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/display_lib.o display_lib.c
 
+${OBJECTDIR}/display_lib_benchmark.o: display_lib_benchmark.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/display_lib_benchmark.o display_lib_benchmark.c
+
 ${OBJECTDIR}/display_lib_test.o: display_lib_test.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -87,6 +94,11 @@ ${OBJECTDIR}/font_2.o: font_2.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/font_2.o font_2.c
 
+${OBJECTDIR}/icons.o: icons.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/icons.o icons.c
+
 ${OBJECTDIR}/sin_cos_math.o: sin_cos_math.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
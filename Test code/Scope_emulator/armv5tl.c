@@ -937,7 +937,7 @@ ARMV5TL_ADDRESS_MAP address_map[] =
   { 0x00010000, 0x00019FFF,    F1C100sSram2,              NULL,                NULL },   //SRAM2
   { 0x01C00000, 0x01C00FFF,            NULL,              NULL,                NULL },   //System Controller
   { 0x01C01000, 0x01C01FFF,    F1C100sDRAMC,  F1C100sDRAMCRead,   F1C100sDRAMCWrite },   //DRAMC
-  { 0x01C02000, 0x01C02FFF,            NULL,              NULL,                NULL },   //DMA
+  { 0x01C02000, 0x01C02FFF,      F1C100sDMA,    F1C100sDMARead,     F1C100sDMAWrite },   //DMA
   { 0x01C05000, 0x01C05FFF,     F1C100sSPI0,   F1C100sSPI0Read,    F1C100sSPI0Write },   //SPI0
   { 0x01C06000, 0x01C06FFF,            NULL,              NULL,                NULL },   //SPI1
   { 0x01C0A000, 0x01C0AFFF,            NULL,              NULL,                NULL },   //TVE
@@ -2546,11 +2546,30 @@ void ArmV5tlMRCMCR(PARMV5TL_CORE core)
 //  uint32_t crm = core->arm_instruction.mrcmcr.crm;
 //  uint32_t crn = core->arm_instruction.mrcmcr.crn;
   
+  uint32_t data = 0;
+
   //For now only coprocessor 15 read is implemented
   if((core->arm_instruction.mrcmcr.cpn == 15) && (core->arm_instruction.mrcmcr.d))
   {
-    //Clear destination register to indicate MMU is disabled and vectors are in low memory
-    *core->registers[core->current_bank][core->arm_instruction.mrcmcr.rd] = 0;
+    //The caches are not emulated, so the test and clean operations on register c7 always report a clean cache with the zero flag set.
+    //For the other registers zero indicates MMU is disabled and vectors are in low memory
+    if(core->arm_instruction.mrcmcr.crn == 7)
+    {
+      data = 0x40000000;
+    }
+
+    //With r15 as destination only the condition flags are loaded from the top bits and the pc is left alone
+    if(core->arm_instruction.mrcmcr.rd == 15)
+    {
+      core->status->flags.N = (data >> 31) & 1;
+      core->status->flags.Z = (data >> 30) & 1;
+      core->status->flags.C = (data >> 29) & 1;
+      core->status->flags.V = (data >> 28) & 1;
+    }
+    else
+    {
+      *core->registers[core->current_bank][core->arm_instruction.mrcmcr.rd] = data;
+    }
   }
 }
 
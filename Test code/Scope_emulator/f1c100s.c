@@ -16,6 +16,9 @@ void F1C100sProcess(PARMV5TL_CORE core)
   if(core->f1c100s_ccu.bus_clk_gate0.m_32bit & CCU_BCGR0_SPI0_EN)
     F1C100sProcessSPI0(core);
   
+  if(core->f1c100s_ccu.bus_clk_gate0.m_32bit & CCU_BCGR0_DMA_EN)
+    F1C100sProcessDMA(core);
+  
   if(core->f1c100s_ccu.bus_clk_gate1.m_32bit & CCU_BCGR1_LCD_EN)
     F1C100sProcessTCON(core);
   
@@ -82,6 +82,7 @@ void  F1C100sProcessINTC(PARMV5TL_CORE core);
 void  F1C100sProcessTimer(PARMV5TL_CORE core);
 
 void  F1C100sProcessSPI0(PARMV5TL_CORE core);
+void  F1C100sProcessDMA(PARMV5TL_CORE core);
 void  F1C100sProcessTCON(PARMV5TL_CORE core);
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -114,6 +115,11 @@ void *F1C100sTimer(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
 void  F1C100sTimerRead(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
 void  F1C100sTimerWrite(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
 
+//DMA control registers
+void *F1C100sDMA(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
+void  F1C100sDMARead(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
+void  F1C100sDMAWrite(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
+
 //SPI control registers
 void *F1C100sSPI0(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
 void  F1C100sSPI0Read(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
@@ -123,6 +129,8 @@ void *F1C100sSPI(F1C100S_SPI *registers, uint32_t address, uint32_t mode);
 void  F1C100sSPIRead(F1C100S_SPI *registers, uint32_t address, uint32_t mode);
 void  F1C100sSPIWrite(PARMV5TL_CORE core, F1C100S_SPI *registers, uint32_t address, uint32_t mode);
 
+uint32_t F1C100sSPI0DMARead(PARMV5TL_CORE core, uint8_t *buffer, uint32_t count);
+
 //UART control registers
 void *F1C100sUART0(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
 void  F1C100sUART0Read(PARMV5TL_CORE core, uint32_t address, uint32_t mode);
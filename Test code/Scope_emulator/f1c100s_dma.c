@@ -0,0 +1,196 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "f1c100s.h"
+#include "f1c100s_dma.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Processing of the DMA is called every core instruction. Only the SPI0 to DRAM path of the dedicated channels is handled
+void F1C100sProcessDMA(PARMV5TL_CORE core)
+{
+  F1C100S_DDMA *channel;
+  uint8_t       buffer[DDMA_BYTES_PER_CYCLE];
+  uint32_t      count;
+  uint32_t      offset;
+  uint32_t      i;
+  int           ch;
+  
+  //Check all the dedicated channels
+  for(ch=0;ch<DDMA_CHANNELS;ch++)
+  {
+    channel = &core->f1c100s_dma.ddma[ch];
+    
+    //Only active channels need handling
+    if((channel->cfg.m_32bit & DDMA_CFG_LOADING) == 0)
+      continue;
+    
+    //Check if it is a supported transfer
+    if(((channel->cfg.m_32bit & DDMA_CFG_SRC_DRQ_MASK) != DDMA_CFG_SRC_DRQ_SPI0) || ((channel->cfg.m_32bit & DDMA_CFG_DST_DRQ_MASK) != DDMA_CFG_DST_DRQ_SDRAM))
+      continue;
+    
+    //Limit the number of bytes moved in a single cycle
+    count = channel->count;
+    
+    if(count > DDMA_BYTES_PER_CYCLE)
+      count = DDMA_BYTES_PER_CYCLE;
+    
+    //Get the bytes the SPI has available. Nothing when it is not reading
+    count = F1C100sSPI0DMARead(core, buffer, count);
+    
+    //Copy them into DRAM
+    for(i=0;i<count;i++)
+    {
+      //Wrap on the DRAM size to stay within the emulated memory
+      offset = (channel->address - DDMA_DRAM_START) & (DDMA_DRAM_SIZE - 1);
+      
+      core->dram[offset >> 2].m_8bit[offset & 3] = buffer[i];
+      
+      channel->address++;
+    }
+    
+    //Take of the bytes done
+    channel->count -= count;
+    
+    //Check if the transfer is finished
+    if(channel->count == 0)
+    {
+      //Signal the channel is done
+      channel->cfg.m_32bit &= ~(DDMA_CFG_LOADING | DDMA_CFG_BUSY);
+      
+      //Set the full transfer interrupt status for this channel
+      core->f1c100s_dma.interruptstatus |= DMA_INT_STA_DDMA_FULL(ch);
+      core->f1c100s_dma.int_sta.m_32bit = core->f1c100s_dma.interruptstatus;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//DMA control registers
+void *F1C100sDMA(PARMV5TL_CORE core, uint32_t address, uint32_t mode)
+{
+  F1C100S_MEMORY *ptr = NULL;
+  F1C100S_DDMA   *channel;
+  
+  //Check if the address is in the dedicated channel range
+  if(((address & 0x00000FFC) >= DDMA_BASE) && ((address & 0x00000FFC) < (DDMA_BASE + (DDMA_CHANNELS * DDMA_CHANNEL_SIZE))))
+  {
+    //Select the channel
+    channel = &core->f1c100s_dma.ddma[((address & 0x00000FFC) - DDMA_BASE) / DDMA_CHANNEL_SIZE];
+    
+    //Select the target register based on the channel word address
+    switch(address & (DDMA_CHANNEL_SIZE - 4))
+    {
+      case DDMA_CFG:
+        ptr = &channel->cfg;
+        break;
+        
+      case DDMA_SRC_ADR:
+        ptr = &channel->src_adr;
+        break;
+        
+      case DDMA_DES_ADR:
+        ptr = &channel->des_adr;
+        break;
+        
+      case DDMA_BYTE_CNT:
+        ptr = &channel->byte_cnt;
+        break;
+        
+      case DDMA_PAR:
+        ptr = &channel->par;
+        break;
+    }
+  }
+  else
+  {
+    //Select the target register based on word address
+    switch(address & 0x00000FFC)
+    {
+      case DMA_INT_CTRL:
+        ptr = &core->f1c100s_dma.int_ctrl;
+        break;
+        
+      case DMA_INT_STA:
+        ptr = &core->f1c100s_dma.int_sta;
+        break;
+        
+      case DMA_PTY_CFG:
+        ptr = &core->f1c100s_dma.pty_cfg;
+        break;
+    }
+  }
+
+  //Check if valid address has been given
+  if(ptr)
+  {
+    //Return the pointer based on the requested mode
+    switch(mode & ARM_MEMORY_MASK)
+    {
+      case ARM_MEMORY_WORD:
+        //Return the word aligned data
+        return(&ptr->m_32bit);
+
+      case ARM_MEMORY_SHORT:
+        //Return the short aligned data
+        return(&ptr->m_16bit[(address & 2) >> 1]);
+
+      case ARM_MEMORY_BYTE:
+        //Return the byte aligned data
+        return(&ptr->m_8bit[address & 3]);
+    }
+  }
+
+  return(NULL); 
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//DMA control registers read
+void F1C100sDMARead(PARMV5TL_CORE core, uint32_t address, uint32_t mode)
+{
+  //Select the target register based on word address
+  switch(address & 0x00000FFC)
+  {
+    case DMA_INT_STA:
+      //Copy the internal interrupt status to the readable register
+      core->f1c100s_dma.int_sta.m_32bit = core->f1c100s_dma.interruptstatus;
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//DMA control registers write
+void F1C100sDMAWrite(PARMV5TL_CORE core, uint32_t address, uint32_t mode)
+{
+  F1C100S_DDMA *channel;
+  
+  //Check if the address is in the dedicated channel range
+  if(((address & 0x00000FFC) >= DDMA_BASE) && ((address & 0x00000FFC) < (DDMA_BASE + (DDMA_CHANNELS * DDMA_CHANNEL_SIZE))))
+  {
+    //Select the channel
+    channel = &core->f1c100s_dma.ddma[((address & 0x00000FFC) - DDMA_BASE) / DDMA_CHANNEL_SIZE];
+    
+    //A write to the configuration register with the loading bit set starts the transfer
+    if(((address & (DDMA_CHANNEL_SIZE - 4)) == DDMA_CFG) && (channel->cfg.m_32bit & DDMA_CFG_LOADING))
+    {
+      //Take the destination and the count for the internal transfer state
+      channel->address = channel->des_adr.m_32bit;
+      channel->count = channel->byte_cnt.m_32bit & DDMA_BYTE_CNT_MASK;
+      
+      //Signal the channel is busy
+      channel->cfg.m_32bit |= DDMA_CFG_BUSY;
+    }
+  }
+  else if((address & 0x00000FFC) == DMA_INT_STA)
+  {
+    //Clear the bits in the internal interrupt status register on write with 1
+    core->f1c100s_dma.interruptstatus &= ~(core->f1c100s_dma.int_sta.m_32bit & DMA_INT_STA_DDMA_MASK);
+
+    //Let the status register reflect the actual status after the clear
+    core->f1c100s_dma.int_sta.m_32bit = core->f1c100s_dma.interruptstatus;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef F1C100S_DMA_H
+#define F1C100S_DMA_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define DMA_INT_CTRL                       0x00000000      //DMA interrupt control register
+#define DMA_INT_STA                        0x00000004      //DMA interrupt status register
+#define DMA_PTY_CFG                        0x00000008      //DMA auto gating register
+
+//Dedicated DMA channels start here with 0x20 bytes per channel
+#define DDMA_BASE                          0x00000300
+#define DDMA_CHANNEL_SIZE                  0x00000020
+#define DDMA_CHANNELS                      4
+
+#define DDMA_CFG                           0x00000000      //Dedicated DMA configuration register
+#define DDMA_SRC_ADR                       0x00000004      //Dedicated DMA source address register
+#define DDMA_DES_ADR                       0x00000008      //Dedicated DMA destination address register
+#define DDMA_BYTE_CNT                      0x0000000C      //Dedicated DMA byte counter register
+#define DDMA_PAR                           0x00000018      //Dedicated DMA parameter register
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define DDMA_CFG_LOADING                   0x80000000      //Start the transfer. Cleared when done
+#define DDMA_CFG_BUSY                      0x40000000      //Transfer in progress
+
+#define DDMA_CFG_DST_DRQ_MASK              0x001F0000
+#define DDMA_CFG_DST_DRQ_SDRAM             0x00010000
+
+#define DDMA_CFG_SRC_DRQ_MASK              0x0000001F
+#define DDMA_CFG_SRC_DRQ_SPI0              0x00000004
+
+#define DDMA_BYTE_CNT_MASK                 0x00FFFFFF
+
+//Full transfer done bit for a dedicated channel
+#define DMA_INT_STA_DDMA_FULL(x)           (0x00020000 << ((x) * 2))
+
+//Only the dedicated channel bits are handled
+#define DMA_INT_STA_DDMA_MASK              0xFFFF0000
+
+//Number of bytes moved per emulated cycle
+#define DDMA_BYTES_PER_CYCLE               64
+
+//DRAM location in the memory map
+#define DDMA_DRAM_START                    0x80000000
+#define DDMA_DRAM_SIZE                     0x02000000
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* F1C100S_DMA_H */
+
@@ -12,9 +12,43 @@
 //SPI0 processing
 void F1C100sProcessSPI0(PARMV5TL_CORE core)
 {
+  uint32_t count;
+  
   //Action needed when active and in flash read mode
   if((core->f1c100s_spi[0].tcr.m_32bit & SPI_TCR_XCH_START) && (core->flashmemory.mode == FLASH_MODE_READ))
   {
+    //Check if the data is part of the command burst
+    if(core->flashmemory.readcount)
+    {
+      //When DMA is enabled the DMA controller takes the data, otherwise wait for the fifo to be emptied
+      if((core->f1c100s_spi[0].fcr.m_32bit & SPI_FCR_RX_DRQ_EN) || core->f1c100s_spi[0].fsr.m_32bit)
+        return;
+      
+      //Fill the fifo with the next part of the data
+      count = core->flashmemory.readcount;
+      
+      if(count > 64)
+        count = 64;
+      
+      //When there is a flash file read from it and return that data
+      if(core->FlashFilePointer)
+      {
+        fread(core->f1c100s_spi[0].rxfifo, 1, count, core->FlashFilePointer);
+      }
+      
+      //Set the fifo count and start reading from the first byte
+      core->f1c100s_spi[0].fsr.m_32bit = count;
+      core->f1c100s_spi[0].rxindex = 0;
+      
+      //Take of the bytes done and end the burst when all are read
+      core->flashmemory.readcount -= count;
+      
+      if(core->flashmemory.readcount == 0)
+        core->f1c100s_spi[0].tcr.m_32bit &= ~SPI_TCR_XCH_START;
+      
+      return;
+    }
+    
     //For now just keep it on max 64 for the count
     if(core->f1c100s_spi[0].mbc.m_32bit > 64)
       core->f1c100s_spi[0].mbc.m_32bit = 64;
@@ -27,12 +61,44 @@ void F1C100sProcessSPI0(PARMV5TL_CORE core)
     
     //Set the count to the number of bytes requested. For now instant fulfillment of the need
     core->f1c100s_spi[0].fsr.m_32bit = core->f1c100s_spi[0].mbc.m_32bit;
+    core->f1c100s_spi[0].rxindex = 0;
     
     //Clear the exchange start flag after reading the bytes from file
     core->f1c100s_spi[0].tcr.m_32bit &= ~SPI_TCR_XCH_START;
   }
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//SPI0 receive data for the DMA controller. Returns the number of bytes put in the buffer
+uint32_t F1C100sSPI0DMARead(PARMV5TL_CORE core, uint8_t *buffer, uint32_t count)
+{
+  //Only data of a command burst with the DMA request enabled can be taken
+  if(((core->f1c100s_spi[0].tcr.m_32bit & SPI_TCR_XCH_START) == 0) || (core->flashmemory.mode != FLASH_MODE_READ) || ((core->f1c100s_spi[0].fcr.m_32bit & SPI_FCR_RX_DRQ_EN) == 0))
+    return(0);
+  
+  //Limit on what is left in the burst
+  if(count > core->flashmemory.readcount)
+    count = core->flashmemory.readcount;
+  
+  //When there is a flash file read from it and return that data, otherwise an erased flash is returned
+  if(core->FlashFilePointer)
+  {
+    fread(buffer, 1, count, core->FlashFilePointer);
+  }
+  else
+  {
+    memset(buffer, 0xFF, count);
+  }
+  
+  //Take of the bytes done and end the burst when all are read
+  core->flashmemory.readcount -= count;
+  
+  if(core->flashmemory.readcount == 0)
+    core->f1c100s_spi[0].tcr.m_32bit &= ~SPI_TCR_XCH_START;
+  
+  return(count);
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //SPI0 reset
 void F1C100sResetSPI0(PARMV5TL_CORE core)
@@ -202,7 +268,7 @@ void F1C100sSPIRead(F1C100S_SPI *registers, uint32_t address, uint32_t mode)
       if(registers->fsr.m_32bit)
       {
         //Return the bytes starting from fifo[0] based on requested number of bytes and the current fifo count
-        registers->rxd.m_8bit[0] = registers->rxfifo[registers->mbc.m_32bit - registers->fsr.m_32bit];
+        registers->rxd.m_8bit[0] = registers->rxfifo[registers->rxindex++ & 0x3F];
         
         //Take of a byte
         registers->fsr.m_32bit--;
@@ -236,11 +302,26 @@ void F1C100sSPIWrite(PARMV5TL_CORE core, F1C100S_SPI *registers, uint32_t addres
         if(core->FlashFilePointer)
           fseek(core->FlashFilePointer, core->flashmemory.readaddress, SEEK_SET);
 
-        //Clear the exchange start flag after reception of the fourth byte
-        registers->tcr.m_32bit &= ~SPI_TCR_XCH_START;
-        
-        //Signal 4 bytes received to satisfy the code
-        core->f1c100s_spi[0].fsr.m_32bit = core->f1c100s_spi[0].mbc.m_32bit;
+        //Check if the data is read in the same burst as the command (more bytes in the burst than transmitted)
+        if(registers->mbc.m_32bit > registers->mtc.m_32bit)
+        {
+          //Keep the exchange going until all the data bytes are read
+          core->flashmemory.readcount = registers->mbc.m_32bit - registers->mtc.m_32bit;
+          
+          //Only the data bytes end up in the fifo
+          registers->fsr.m_32bit = 0;
+        }
+        else
+        {
+          core->flashmemory.readcount = 0;
+          
+          //Clear the exchange start flag after reception of the fourth byte
+          registers->tcr.m_32bit &= ~SPI_TCR_XCH_START;
+
+          //Signal 4 bytes received to satisfy the code
+          core->f1c100s_spi[0].fsr.m_32bit = core->f1c100s_spi[0].mbc.m_32bit;
+          core->f1c100s_spi[0].rxindex = 0;
+        }
       }
       
       //When the slave select is de-asserted clear the flash memory state and mode
@@ -248,6 +329,7 @@ void F1C100sSPIWrite(PARMV5TL_CORE core, F1C100S_SPI *registers, uint32_t addres
       {
         core->flashmemory.commandstate = FLASH_STATE_IDLE;
         core->flashmemory.mode = FLASH_MODE_IDLE;
+        core->flashmemory.readcount = 0;
       }
       break;
       
@@ -259,6 +341,15 @@ void F1C100sSPIWrite(PARMV5TL_CORE core, F1C100S_SPI *registers, uint32_t addres
       
     case SPI_FCR:  //FIFO control register. Upper 16 bit TX FIFO. Lower 16 bit RX FIFO.
       //For a receive this is either cleared with setting of the SPI_FCR_RX_FIFO_RST bit or by reading the bytes in the fifo
+      if(registers->fcr.m_32bit & SPI_FCR_RX_FIFO_RST)
+      {
+        //Empty the receive fifo
+        registers->fsr.m_32bit = 0;
+        registers->rxindex = 0;
+      }
+      
+      //The reset bits are self clearing
+      registers->fcr.m_32bit &= ~(SPI_FCR_TX_FIFO_RST | SPI_FCR_RX_FIFO_RST);
       break;
       
     case SPI_FSR:  //FIFO status register. Upper 16 bit TX FIFO. Lower 16 bit RX FIFO.
@@ -287,15 +378,18 @@ void F1C100sSPIWrite(PARMV5TL_CORE core, F1C100S_SPI *registers, uint32_t addres
       //After the bytes have been transmitted out of the fifo the SPI_TCR_XCH_START needs to be cleared
       //The mode specifies how many bytes need to be copied to the fifo
       
-      //Simple state machine for getting the flash read address. Only command used for now
+      //Simple state machine for getting the flash read address. Only the read commands are used
       //For now all data is used in byte mode since the code is known to do so
       //Need a flash data structure to hold state machine information
       switch(core->flashmemory.commandstate)
       {
         //First byte written is the command byte
         case FLASH_STATE_IDLE:
-          if(registers->txd.m_8bit[0] == 0x03)
+          if((registers->txd.m_8bit[0] == FLASH_CMD_READ) || (registers->txd.m_8bit[0] == FLASH_CMD_FAST_READ_DUAL))
+          {
+            core->flashmemory.command = registers->txd.m_8bit[0];
             core->flashmemory.commandstate = FLASH_STATE_RX_ADDRESS_H;
+          }
           break;
           
         case FLASH_STATE_RX_ADDRESS_H:
@@ -313,6 +407,16 @@ void F1C100sSPIWrite(PARMV5TL_CORE core, F1C100S_SPI *registers, uint32_t addres
         case FLASH_STATE_RX_ADDRESS_L:
           //Get the low byte of the address (24 bit addressing)
           core->flashmemory.readaddress |= registers->txd.m_8bit[0];
+          
+          //The fast read needs a dummy byte before the data comes
+          if(core->flashmemory.command == FLASH_CMD_FAST_READ_DUAL)
+            core->flashmemory.commandstate = FLASH_STATE_RX_DUMMY;
+          else
+            core->flashmemory.commandstate = FLASH_STATE_PROCESS;
+          break;
+          
+        case FLASH_STATE_RX_DUMMY:
+          //Skip the dummy byte
           core->flashmemory.commandstate = FLASH_STATE_PROCESS;
           break;
       }
@@ -52,6 +52,7 @@
 #define SPI_FCR_TX_TRIG_LEV_64      0x00400000       //Trigger level for transmit FIFO
 
 #define SPI_FCR_RX_FIFO_RST         0x00008000       //Receive FIFO reset. Self clearing
+#define SPI_FCR_RX_DRQ_EN           0x00000100       //Receive FIFO DMA request enable
 #define SPI_FCR_RX_TRIG_LEV_1       0x00000001       //Trigger level for receive FIFO
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -74,6 +75,10 @@
 #define FLASH_STATE_RX_ADDRESS_M         2
 #define FLASH_STATE_RX_ADDRESS_L         3
 #define FLASH_STATE_PROCESS              4
+#define FLASH_STATE_RX_DUMMY             5
+
+#define FLASH_CMD_READ                0x03
+#define FLASH_CMD_FAST_READ_DUAL      0x3B
 
 #define FLASH_MODE_IDLE                  0
 #define FLASH_MODE_READ                  1
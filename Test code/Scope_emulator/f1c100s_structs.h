@@ -13,6 +13,8 @@ typedef struct tagF1C100S_PERIPH_STATUS    F1C100S_PERIPH_STATUS;
 typedef struct tagF1C100S_CCU              F1C100S_CCU;
 typedef struct tagF1C100S_DRAMC            F1C100S_DRAMC;
 typedef struct tagF1C100S_TIMER            F1C100S_TIMER;
+typedef struct tagF1C100S_DMA              F1C100S_DMA;
+typedef struct tagF1C100S_DDMA             F1C100S_DDMA;
 typedef struct tagF1C100S_INTC             F1C100S_INTC;
 typedef struct tagF1C100S_SPI              F1C100S_SPI;
 typedef struct tagF1C100S_UART             F1C100S_UART;
@@ -58,7 +60,9 @@ struct tagFLASH_MEMORY
 {
   uint32_t  commandstate;
   uint32_t  mode;
+  uint32_t  command;
   uint32_t  readaddress;
+  uint32_t  readcount;               //Bytes left to read when the command and the data are in a single burst
 };
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -310,6 +314,38 @@ struct tagF1C100S_SPI
   //Not directly addressable are the two fifo's each spi interface has
   uint8_t txfifo[64];
   uint8_t rxfifo[64];
+  
+  //Read index in the receive fifo
+  uint32_t rxindex;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A dedicated DMA channel register set
+struct tagF1C100S_DDMA
+{
+  F1C100S_MEMORY cfg;
+  F1C100S_MEMORY src_adr;
+  F1C100S_MEMORY des_adr;
+  F1C100S_MEMORY byte_cnt;
+  F1C100S_MEMORY par;
+  
+  //Internal transfer state
+  uint32_t address;
+  uint32_t count;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The DMA controller register set. Only the dedicated channels are modeled
+struct tagF1C100S_DMA
+{
+  F1C100S_MEMORY int_ctrl;
+  F1C100S_MEMORY int_sta;
+  F1C100S_MEMORY pty_cfg;
+  
+  F1C100S_DDMA   ddma[4];
+  
+  //DMA interrupt status bits
+  uint32_t interruptstatus;
 };
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -43,21 +43,22 @@ OBJECTFILES= \
 	${OBJECTDIR}/f1c100s.o \
 	${OBJECTDIR}/f1c100s_ccu.o \
 	${OBJECTDIR}/f1c100s_debe.o \
+	${OBJECTDIR}/f1c100s_dma.o \
 	${OBJECTDIR}/f1c100s_dramc.o \
 	${OBJECTDIR}/f1c100s_intc.o \
+	${OBJECTDIR}/f1c100s_log.o \
+	${OBJECTDIR}/f1c100s_mmc.o \
 	${OBJECTDIR}/f1c100s_pio.o \
 	${OBJECTDIR}/f1c100s_spi.o \
 	${OBJECTDIR}/f1c100s_tcon.o \
 	${OBJECTDIR}/f1c100s_timer.o \
 	${OBJECTDIR}/f1c100s_uart.o \
-	${OBJECTDIR}/f1c100s_mmc.o \
-	${OBJECTDIR}/f1c100s_log.o \
-	${OBJECTDIR}/sd.o \
-	${OBJECTDIR}/sdmmc-internal.o \
-	${OBJECTDIR}/sd_trace.o \
-	${OBJECTDIR}/sd_blk.o \
 	${OBJECTDIR}/lcdisplay.o \
 	${OBJECTDIR}/mousehandling.o \
+	${OBJECTDIR}/sd.o \
+	${OBJECTDIR}/sd_blk.o \
+	${OBJECTDIR}/sd_trace.o \
+	${OBJECTDIR}/sdmmc-internal.o \
 	${OBJECTDIR}/touchpanel.o \
 	${OBJECTDIR}/xlibfunctions.o
 
@@ -126,6 +127,11 @@ ${OBJECTDIR}/f1c100s_debe.o: f1c100s_debe.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -I/usr/include/freetype2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/f1c100s_debe.o f1c100s_debe.c
 
+${OBJECTDIR}/f1c100s_dma.o: f1c100s_dma.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -I/usr/include/freetype2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/f1c100s_dma.o f1c100s_dma.c
+
 ${OBJECTDIR}/f1c100s_dramc.o: f1c100s_dramc.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
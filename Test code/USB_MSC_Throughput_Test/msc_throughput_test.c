@@ -0,0 +1,216 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host side test for the scope USB mass storage throughput
+//
+//Reads the scope's disk device in big chunks, times it and compares the data with an image taken from the same SD card.
+//With the -w option the image data is also written back to the device, which leaves the card contents unchanged
+//when the image matches the card, and then read back for verification.
+//
+//Build: make CONF=Release, which puts the program in dist/Release/GNU-Linux
+//   or: gcc -O2 -o msc_throughput_test msc_throughput_test.c
+//Usage: msc_throughput_test [-w] <device> <sd card image> [megabytes]
+//  e.g. sudo ./msc_throughput_test /dev/sdb sdcard.img 64
+//
+//Make an image first with: sudo dd if=/dev/sdb of=sdcard.img bs=1M count=64
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//About the size of the READ10 and WRITE10 requests a Linux host sends to a USB disk
+#define CHUNK_SIZE      (128 * 1024)
+
+#define DEFAULT_SIZE    64
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+double get_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return(ts.tv_sec + (ts.tv_nsec / 1e9));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int read_and_compare(int fd, int fi, long long size, unsigned char *data, unsigned char *reference, const char *text)
+{
+  long long offset;
+  long long errors = 0;
+  double    start;
+  double    time;
+  ssize_t   length;
+
+  //Start from the beginning of both the device and the image
+  lseek(fd, 0, SEEK_SET);
+  lseek(fi, 0, SEEK_SET);
+
+  start = get_time();
+
+  //Read the device in chunks and compare each with the image
+  for(offset=0;offset<size;offset+=CHUNK_SIZE)
+  {
+    //Read the device data. The compare with the image is timed too, but is negligible compared to USB
+    length = read(fd, data, CHUNK_SIZE);
+
+    if(length != CHUNK_SIZE)
+    {
+      printf("Read error at offset %lld\n", offset);
+      return(-1);
+    }
+
+    //Get the same part of the image
+    if(read(fi, reference, CHUNK_SIZE) != CHUNK_SIZE)
+    {
+      printf("Image too small for the requested size\n");
+      return(-1);
+    }
+
+    //Check if the data matches
+    if(memcmp(data, reference, CHUNK_SIZE))
+    {
+      errors++;
+    }
+  }
+
+  time = get_time() - start;
+
+  printf("%s: %lld MB in %.2f s, %.2f MB/s, %lld chunks with differences\n", text, size >> 20, time, (size / 1048576.0) / time, errors);
+
+  return(errors != 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int write_image(int fd, int fi, long long size, unsigned char *data)
+{
+  long long offset;
+  double    start;
+  double    time;
+
+  //Start from the beginning of both the device and the image
+  lseek(fd, 0, SEEK_SET);
+  lseek(fi, 0, SEEK_SET);
+
+  start = get_time();
+
+  //Write the image to the device in chunks
+  for(offset=0;offset<size;offset+=CHUNK_SIZE)
+  {
+    if(read(fi, data, CHUNK_SIZE) != CHUNK_SIZE)
+    {
+      printf("Image too small for the requested size\n");
+      return(-1);
+    }
+
+    if(write(fd, data, CHUNK_SIZE) != CHUNK_SIZE)
+    {
+      printf("Write error at offset %lld\n", offset);
+      return(-1);
+    }
+  }
+
+  //Make sure it is all on the card before stopping the clock
+  fsync(fd);
+
+  time = get_time() - start;
+
+  printf("Write: %lld MB in %.2f s, %.2f MB/s\n", size >> 20, time, (size / 1048576.0) / time);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  unsigned char *data;
+  unsigned char *reference;
+  long long      size = DEFAULT_SIZE;
+  int            dowrite = 0;
+  int            flags = O_RDONLY;
+  int            arg = 1;
+  int            result;
+  int            fd;
+  int            fi;
+
+  //Check on the write option
+  if((argc > arg) && (strcmp(argv[arg], "-w") == 0))
+  {
+    dowrite = 1;
+    flags = O_RDWR;
+    arg++;
+  }
+
+  //Need at least the device and the image
+  if((argc - arg) < 2)
+  {
+    printf("Usage: %s [-w] <device> <sd card image> [megabytes]\n", argv[0]);
+    return(1);
+  }
+
+  //Get the optional size
+  if((argc - arg) > 2)
+  {
+    size = atoll(argv[arg + 2]);
+  }
+
+  //Work in bytes from here on, rounded down on whole chunks
+  size = ((size << 20) / CHUNK_SIZE) * CHUNK_SIZE;
+
+  //Bypass the host page cache so the USB transfers are measured and not memory copies
+  fd = open(argv[arg], flags | O_DIRECT);
+
+  if(fd < 0)
+  {
+    printf("Can't open device %s\n", argv[arg]);
+    return(1);
+  }
+
+  fi = open(argv[arg + 1], O_RDONLY);
+
+  if(fi < 0)
+  {
+    printf("Can't open image %s\n", argv[arg + 1]);
+    close(fd);
+    return(1);
+  }
+
+  //Direct IO needs aligned buffers
+  if(posix_memalign((void **)&data, 4096, CHUNK_SIZE) || posix_memalign((void **)&reference, 4096, CHUNK_SIZE))
+  {
+    printf("Out of memory\n");
+    return(1);
+  }
+
+  //Measure the read speed and check the data
+  result = read_and_compare(fd, fi, size, data, reference, "Read");
+
+  //Check if the write test is needed
+  if((result == 0) && dowrite)
+  {
+    //Write the image back and verify it
+    result = write_image(fd, fi, size, data);
+
+    if(result == 0)
+    {
+      result = read_and_compare(fd, fi, size, data, reference, "Verify");
+    }
+  }
+
+  free(data);
+  free(reference);
+  close(fi);
+  close(fd);
+
+  return(result != 0);
+}
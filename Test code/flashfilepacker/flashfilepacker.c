@@ -20,8 +20,211 @@
 
 #define LOWER_CASE_CONVERT  0x5F     //Used to convert lower case to upper case by anding
 
+//Header of a compressed main program. Needs to match the bootloader (lz4_decompress.h)
+#define LZ4_IMAGE_MAGIC_OFFSET        4
+#define LZ4_IMAGE_MAGIC_SIZE          8
+#define LZ4_IMAGE_MAGIC               "FNLZ4IMG"
+#define LZ4_IMAGE_LENGTH_OFFSET      16
+#define LZ4_IMAGE_SIZE_OFFSET        20
+#define LZ4_IMAGE_HEADER_SIZE        32
+
+//Settings for the LZ4 block compressor
+#define LZ4_HASH_BITS                16
+#define LZ4_MIN_MATCH                 4
+#define LZ4_MAX_OFFSET            65535
+#define LZ4_LAST_LITERALS             5
+#define LZ4_MATCH_LIMIT              12
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void lz4_put_length(unsigned char **dest, int length)
+{
+  unsigned char *ptr = *dest;
+
+  //Lengths of 15 and up are continued in extra bytes
+  while(length >= 255)
+  {
+    *ptr++ = 255;
+    length -= 255;
+  }
+
+  *ptr++ = length;
+
+  *dest = ptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Greedy LZ4 block compressor. The destination needs to be able to hold the worst case size (length + (length / 255) + 16)
+
+int lz4_compress(unsigned char *source, int length, unsigned char *dest)
+{
+  int           *table = malloc(sizeof(int) << LZ4_HASH_BITS);
+  unsigned char *dptr = dest;
+  unsigned char *token;
+  unsigned int   sequence;
+  unsigned int   hash;
+  int            index = 0;
+  int            anchor = 0;
+  int            match;
+  int            matchlength;
+  int            literals;
+
+  if(table == NULL)
+  {
+    return(-1);
+  }
+
+  //No positions seen yet
+  memset(table, 0xFF, sizeof(int) << LZ4_HASH_BITS);
+
+  //Matches are not allowed to start in the last bytes of the block
+  while(index < (length - LZ4_MATCH_LIMIT))
+  {
+    //Look up the last position of the next four bytes
+    sequence = source[index] | (source[index + 1] << 8) | (source[index + 2] << 16) | (source[index + 3] << 24);
+    hash = (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+    match = table[hash];
+    table[hash] = index;
+
+    //Check if there is a usable match
+    if((match < 0) || ((index - match) > LZ4_MAX_OFFSET) || (memcmp(&source[match], &source[index], LZ4_MIN_MATCH) != 0))
+    {
+      index++;
+      continue;
+    }
+
+    //See how far the match goes. The last bytes of the block need to be literals
+    matchlength = LZ4_MIN_MATCH;
+
+    while(((index + matchlength) < (length - LZ4_LAST_LITERALS)) && (source[match + matchlength] == source[index + matchlength]))
+    {
+      matchlength++;
+    }
+
+    //Write the token with the literal length and the match length
+    literals = index - anchor;
+    token = dptr++;
+    *token = 0;
+
+    if(literals >= 15)
+    {
+      *token = 0xF0;
+      lz4_put_length(&dptr, literals - 15);
+    }
+    else
+    {
+      *token = literals << 4;
+    }
+
+    //Copy the literals
+    memcpy(dptr, &source[anchor], literals);
+    dptr += literals;
+
+    //Write the offset
+    *dptr++ = (index - match) & 0xFF;
+    *dptr++ = (index - match) >> 8;
+
+    //Write the match length minus the minimum length
+    if((matchlength - LZ4_MIN_MATCH) >= 15)
+    {
+      *token |= 0x0F;
+      lz4_put_length(&dptr, matchlength - LZ4_MIN_MATCH - 15);
+    }
+    else
+    {
+      *token |= matchlength - LZ4_MIN_MATCH;
+    }
+
+    //Continue after the match
+    index += matchlength;
+    anchor = index;
+  }
+
+  //The last sequence only holds literals
+  literals = length - anchor;
+
+  if(literals >= 15)
+  {
+    *dptr++ = 0xF0;
+    lz4_put_length(&dptr, literals - 15);
+  }
+  else
+  {
+    *dptr++ = literals << 4;
+  }
+
+  memcpy(dptr, &source[anchor], literals);
+  dptr += literals;
+
+  free(table);
+
+  return(dptr - dest);
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------
+//Replace the program with a compressed version. The original header is kept apart from the magic and the lengths
+
+int compress_image(unsigned char **data, int *length)
+{
+  unsigned char *image = *data;
+  unsigned char *packed;
+  int            size;
+  int            packedsize;
+
+  if(*length <= LZ4_IMAGE_HEADER_SIZE)
+  {
+    return(-1);
+  }
+
+  //Get the program length from the header, but don't go beyond the end of the file
+  size = ((image[19] << 24) | (image[18] << 16) | (image[17] << 8) | image[16]) - LZ4_IMAGE_HEADER_SIZE;
+
+  if((size <= 0) || (size > (*length - LZ4_IMAGE_HEADER_SIZE)))
+  {
+    size = *length - LZ4_IMAGE_HEADER_SIZE;
+  }
+
+  packed = malloc(LZ4_IMAGE_HEADER_SIZE + size + (size / 255) + 16);
+
+  if(packed == NULL)
+  {
+    return(-1);
+  }
+
+  //Compress the program after the header
+  packedsize = lz4_compress(&image[LZ4_IMAGE_HEADER_SIZE], size, &packed[LZ4_IMAGE_HEADER_SIZE]);
+
+  if(packedsize < 0)
+  {
+    free(packed);
+    return(-1);
+  }
 
+  //Fill in the header for the bootloader
+  memcpy(packed, image, LZ4_IMAGE_HEADER_SIZE);
+  memcpy(&packed[LZ4_IMAGE_MAGIC_OFFSET], LZ4_IMAGE_MAGIC, LZ4_IMAGE_MAGIC_SIZE);
+
+  packedsize += LZ4_IMAGE_HEADER_SIZE;
+
+  packed[LZ4_IMAGE_LENGTH_OFFSET]     = packedsize;
+  packed[LZ4_IMAGE_LENGTH_OFFSET + 1] = packedsize >> 8;
+  packed[LZ4_IMAGE_LENGTH_OFFSET + 2] = packedsize >> 16;
+  packed[LZ4_IMAGE_LENGTH_OFFSET + 3] = packedsize >> 24;
+
+  packed[LZ4_IMAGE_SIZE_OFFSET]     = size;
+  packed[LZ4_IMAGE_SIZE_OFFSET + 1] = size >> 8;
+  packed[LZ4_IMAGE_SIZE_OFFSET + 2] = size >> 16;
+  packed[LZ4_IMAGE_SIZE_OFFSET + 3] = size >> 24;
+
+  printf("Compressed program from %d to %d bytes\n", size + LZ4_IMAGE_HEADER_SIZE, packedsize);
+
+  free(image);
+
+  *data = packed;
+  *length = packedsize;
+
+  return(0);
+}
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -37,6 +240,7 @@ int main(int argc, char **argv)
   int  lastbyte = 0;
   char curchar;
   int  writelocation = 0;
+  int  compress = 0;
   
   int checkdata[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 } ;
   int index;
@@ -52,11 +256,12 @@ int main(int argc, char **argv)
       { "out_file",     required_argument, 0, 'o' },
       { "in_file",      required_argument, 0, 'i' },
       { "location",     required_argument, 0, 'l' },
+      { "lz4",          no_argument,       0, 'z' },
       { "help",         no_argument,       0, 'h' },      
       { 0,              0,                 0, 0   }
     };
 
-    c = getopt_long(argc, argv, "o:i:l:h", long_options, &option_index);
+    c = getopt_long(argc, argv, "o:i:l:zh", long_options, &option_index);
     
     if(c == -1)
       break;
@@ -80,12 +285,17 @@ int main(int argc, char **argv)
         location = optarg;
         break;
         
+      case 'z':
+        compress = 1;
+        break;
+        
       case 'h':
         printf("\nUsage: %s <options>\n\n"
           "Options:\n"
           "  --out_file=filename    (-o) File to write the input file to\n"
           "  --in_file=filename     (-i) File to add to the output file at location given with --location\n"
-          "  --location=location    (-l) Location in the output file where to write input file data\n\n"
+          "  --location=location    (-l) Location in the output file where to write input file data\n"
+          "  --lz4                  (-z) Compress the input file, a program with a 32 byte header, for the bootloader\n\n"
           "When output file exists it will be loaded first and data will be written from given location\n"
           "If it does not exist it will be created and filled with zeros up to given location.",
           argv[0]);
@@ -183,6 +393,7 @@ int main(int argc, char **argv)
   int opflen;
   int ipflen;
   unsigned char *buffer;
+  unsigned char *ipdata;
   unsigned char byte;
   unsigned char bitflag;
 
@@ -196,6 +407,26 @@ int main(int argc, char **argv)
     exit(0);
   }
   
+  //Load the input file data from the start
+  ipdata = malloc(ipflen);
+  
+  if(ipdata == NULL)
+  {
+    fclose(ipf);
+    exit(0);
+  }
+  
+  fseek(ipf, 0, SEEK_SET);
+  fread(ipdata, 1, ipflen, ipf);
+  
+  //Compress it when requested
+  if(compress && (compress_image(&ipdata, &ipflen) != 0))
+  {
+    printf("\nError: Input file could not be compressed\n\n");
+    fclose(ipf);
+    exit(0);
+  }
+  
   if(opf)
   {
     fseek(opf, 0, SEEK_END);
@@ -229,11 +460,8 @@ int main(int argc, char **argv)
     //Load the output file data to the buffer
     fread(buffer, 1, opflen, opf);
 
-    //Get the input file data from the start
-    fseek(ipf, 0, SEEK_SET);
-    
-    //Load the input file data to the buffer starting from write location
-    fread(&buffer[writelocation], 1, ipflen, ipf);
+    //Copy the input file data to the buffer starting from write location
+    memcpy(&buffer[writelocation], ipdata, ipflen);
 
     //Calculate the check data
     //Go through all the data bytes
@@ -287,6 +515,8 @@ int main(int argc, char **argv)
     free(buffer);
   }
     
+  free(ipdata);
+  
   fclose(ipf);
   fclose(opf);
   
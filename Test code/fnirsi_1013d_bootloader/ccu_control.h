@@ -148,6 +148,7 @@
 //--------------------------------------------------------------------------------------
 //Bus clock gating settings
 #define CCU_BCGR0_SPI0_EN                       0x00100000
+#define CCU_BCGR0_DMA_EN                        0x00000040
 
 
 #define CCU_BCGR1_LCD_EN                        0x00000010
@@ -158,6 +159,7 @@
 //--------------------------------------------------------------------------------------
 //Bus software reset settings
 #define CCU_BSRR0_SPI0_RST                      0x00100000
+#define CCU_BSRR0_DMA_RST                       0x00000040
 
 
 #define CCU_BSRR1_LCD_RST                       0x00000010
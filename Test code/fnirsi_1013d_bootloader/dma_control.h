@@ -0,0 +1,58 @@
+#ifndef DMA_CONTROL_H
+#define DMA_CONTROL_H
+
+//Allwinner F1C100s DMA controller registers
+#define DMA_INT_CTRL_REG         ((volatile unsigned int *)(0x01C02000))
+#define DMA_INT_STA_REG          ((volatile unsigned int *)(0x01C02004))
+#define DMA_PTY_CFG_REG          ((volatile unsigned int *)(0x01C02008))
+
+//Dedicated DMA channel 0 registers. The other three channels follow on 0x20 byte steps
+#define DDMA0_CFG_REG            ((volatile unsigned int *)(0x01C02300))
+#define DDMA0_SRC_ADR_REG        ((volatile unsigned int *)(0x01C02304))
+#define DDMA0_DES_ADR_REG        ((volatile unsigned int *)(0x01C02308))
+#define DDMA0_BYTE_CNT_REG       ((volatile unsigned int *)(0x01C0230C))
+#define DDMA0_PAR_REG            ((volatile unsigned int *)(0x01C02318))
+
+//--------------------------------------------------------------------------------------
+//Interrupt status settings. Write one to clear
+#define DMA_INT_STA_DDMA0_HALF      0x00010000       //Dedicated channel 0 half transfer done
+#define DMA_INT_STA_DDMA0_FULL      0x00020000       //Dedicated channel 0 full transfer done
+
+//--------------------------------------------------------------------------------------
+//Dedicated DMA configuration settings
+#define DDMA_CFG_LOADING            0x80000000       //Start the transfer. Cleared by hardware when done
+#define DDMA_CFG_BUSY               0x40000000       //Transfer in progress
+
+#define DDMA_CFG_DST_WIDTH_8        0x00000000       //Destination data width 8 bits
+#define DDMA_CFG_DST_WIDTH_16       0x02000000       //Destination data width 16 bits
+#define DDMA_CFG_DST_WIDTH_32       0x04000000       //Destination data width 32 bits
+#define DDMA_CFG_DST_BURST_1        0x00000000       //Destination burst length 1
+#define DDMA_CFG_DST_BURST_4        0x00800000       //Destination burst length 4
+#define DDMA_CFG_DST_LINEAR         0x00000000       //Destination address increments
+#define DDMA_CFG_DST_IO             0x00200000       //Destination address is fixed
+#define DDMA_CFG_DST_DRQ_SDRAM      0x00010000       //Destination is SDRAM
+
+#define DDMA_CFG_SRC_WIDTH_8        0x00000000       //Source data width 8 bits
+#define DDMA_CFG_SRC_WIDTH_16       0x00000200       //Source data width 16 bits
+#define DDMA_CFG_SRC_WIDTH_32       0x00000400       //Source data width 32 bits
+#define DDMA_CFG_SRC_BURST_1        0x00000000       //Source burst length 1
+#define DDMA_CFG_SRC_BURST_4        0x00000080       //Source burst length 4
+#define DDMA_CFG_SRC_LINEAR         0x00000000       //Source address increments
+#define DDMA_CFG_SRC_IO             0x00000020       //Source address is fixed
+#define DDMA_CFG_SRC_DRQ_SPI0       0x00000004       //Source is the SPI0 receive FIFO
+
+//--------------------------------------------------------------------------------------
+//Dedicated DMA parameter settings
+//Data block size (N + 1) and wait clock cycles (N + 1) between the blocks for both sides of the transfer
+#define DDMA_PAR_DST_BLK_SIZE(x)    ((x & 0xFF) << 24)
+#define DDMA_PAR_DST_WAIT_CYC(x)    ((x & 0xFF) << 16)
+#define DDMA_PAR_SRC_BLK_SIZE(x)    ((x & 0xFF) << 8)
+#define DDMA_PAR_SRC_WAIT_CYC(x)    (x & 0xFF)
+
+//The SPI needs a block size of one and two wait cycles
+#define DDMA_PAR_SPI                (DDMA_PAR_DST_BLK_SIZE(0) | DDMA_PAR_DST_WAIT_CYC(1) | DDMA_PAR_SRC_BLK_SIZE(0) | DDMA_PAR_SRC_WAIT_CYC(1))
+
+//The byte counter is 24 bits wide
+#define DDMA_MAX_BYTE_COUNT         0x00FFFFFF
+
+#endif /* DMA_CONTROL_H */
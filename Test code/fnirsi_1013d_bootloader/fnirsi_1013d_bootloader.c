@@ -3,6 +3,12 @@
 #include "spi_control.h"
 #include "display_control.h"
 #include "fpga_control.h"
+#include "lz4_decompress.h"
+
+//DRAM locations used while booting
+#define PROGRAM_ADDRESS     0x80000000
+#define BITMAP_ADDRESS      0x81000000
+#define STAGING_ADDRESS     0x81200000
 
 int main(void)
 {
@@ -13,7 +19,8 @@ int main(void)
   unsigned short ysize;
   unsigned short xpos;
   unsigned short ypos;
-  int i,j;
+  unsigned int size = 0;
+  int compressed;
   
   //Initialize the clock system
   sys_clock_init();
@@ -45,34 +52,53 @@ int main(void)
   xpos = (800 - xsize) >> 1;
   ypos = (480 - ysize) >> 1;
 
-  //Read the bitmap into DRAM. Skip an extra 8 bytes after the header
-  sys_spi_flash_read(0x13028, (unsigned char *)0x81000000, length);
+  //Read the bitmap into DRAM with the fast dual read. Skip an extra 8 bytes after the header
+  sys_spi_flash_read_fast(0x13028, (unsigned char *)BITMAP_ADDRESS, length);
   
-  //Display the bitmap
-  display_bitmap(xpos, ypos, xsize, ysize, (unsigned short *)0x81000000, (unsigned short *)0x81B00000);
+  //Load the main program from flash
+  //Get the header first
+  sys_spi_flash_read(0x27000, buffer, 32);
+
+  //Get the length from the header and take of the header
+  length = ((buffer[19] << 24) | (buffer[18] << 16) | (buffer[17] << 8) | buffer[16]) - 32;
+
+  //Check if the flash file packer stored the program compressed
+  compressed = lz4_is_compressed_image(buffer);
   
-  //Got some 200mS to spare
-  for(j=0;j<950;j++)
+  //Start reading the main program into DRAM. A compressed program is read into a staging area first
+  if(compressed)
+  {
+    //Get the decompressed length from the header
+    size = (buffer[LZ4_IMAGE_SIZE_OFFSET + 3] << 24) | (buffer[LZ4_IMAGE_SIZE_OFFSET + 2] << 16) | (buffer[LZ4_IMAGE_SIZE_OFFSET + 1] << 8) | buffer[LZ4_IMAGE_SIZE_OFFSET];
+
+    sys_spi_flash_start_read_fast(0x27020, (unsigned char *)STAGING_ADDRESS, length);
+  }
+  else
   {
-    //At 600MHz CPU_CLK 1000 = ~200uS
-    for(i=0;i<1000;i++);
+    sys_spi_flash_start_read_fast(0x27020, (unsigned char *)PROGRAM_ADDRESS, length);
   }
   
+  //Display the bitmap while the DMA loads the program
+  display_bitmap(xpos, ypos, xsize, ysize, (unsigned short *)BITMAP_ADDRESS, (unsigned short *)0x81B00000);
+  
   //Wait and make sure FPGA is ready
   check_fpga_ready();
   
   //Set default brightness
   set_backlight_brightness(0xEA60);
   
-  //Load the main program from flash
-  //Get the header first
-  sys_spi_flash_read(0x27000, buffer, 32);
-
-  //Get the length from the header and take of the header
-  length = ((buffer[19] << 24) | (buffer[18] << 16) | (buffer[17] << 8) | buffer[16]) - 32;
-
-  //Read the main program into DRAM. 
-  sys_spi_flash_read(0x27020, (unsigned char *)0x80000000, length);
+  //Wait until the program is in DRAM
+  sys_spi_flash_wait_read_fast();
+  
+  //Unpack the program to where it needs to run
+  if(compressed)
+  {
+    //The program needs to fit below the staging area. Stop when the data is not valid
+    if((size > (STAGING_ADDRESS - PROGRAM_ADDRESS)) || (lz4_decompress((unsigned char *)STAGING_ADDRESS, length, (unsigned char *)PROGRAM_ADDRESS, size) != (int)size))
+    {
+      while(1);
+    }
+  }
   
   //Run the main program
   __asm__ __volatile__ ("mov pc, #0x80000000\n");  
@@ -0,0 +1,22 @@
+#ifndef LZ4_DECOMPRESS_H
+#define LZ4_DECOMPRESS_H
+
+//--------------------------------------------------------------------------------------
+//Header of a compressed main program as written by the flash file packer. It replaces
+//the normal 32 byte header and is followed by a single LZ4 block
+#define LZ4_IMAGE_MAGIC_OFFSET        4
+#define LZ4_IMAGE_MAGIC_SIZE          8
+#define LZ4_IMAGE_MAGIC               "FNLZ4IMG"
+
+//Total length of header plus compressed data and the length of the decompressed program
+#define LZ4_IMAGE_LENGTH_OFFSET      16
+#define LZ4_IMAGE_SIZE_OFFSET        20
+
+#define LZ4_IMAGE_HEADER_SIZE        32
+
+//--------------------------------------------------------------------------------------
+//Functions
+int lz4_is_compressed_image(unsigned char *header);
+int lz4_decompress(unsigned char *source, int length, unsigned char *dest, int size);
+
+#endif /* LZ4_DECOMPRESS_H */
@@ -40,6 +40,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/dram_control.o \
 	${OBJECTDIR}/fnirsi_1013d_bootloader.o \
 	${OBJECTDIR}/fpga_control.o \
+	${OBJECTDIR}/lz4_decompress.o \
 	${OBJECTDIR}/port_a_control.o \
 	${OBJECTDIR}/spi_control.o \
 	${OBJECTDIR}/start.o
@@ -94,6 +95,11 @@ ${OBJECTDIR}/fpga_control.o: fpga_control.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/fpga_control.o fpga_control.c
 
+${OBJECTDIR}/lz4_decompress.o: lz4_decompress.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/lz4_decompress.o lz4_decompress.c
+
 ${OBJECTDIR}/port_a_control.o: port_a_control.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
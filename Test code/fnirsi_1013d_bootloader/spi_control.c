@@ -1,6 +1,13 @@
 #include "spi_control.h"
 #include "ccu_control.h"
 #include "gpio_control.h"
+#include "dma_control.h"
+
+//State of the DMA read that is in progress
+int            spi_fast_read_addr;
+unsigned char *spi_fast_read_buffer;
+int            spi_fast_read_length;
+int            spi_fast_read_count;
 
 //Probleem is twee ledig.
 
@@ -23,6 +30,10 @@ void sys_spi_flash_init(void)
 
   //Open the SPI0 bus gate
   *CCU_BUS_CLK_GATE0 |= CCU_BCGR0_SPI0_EN;
+
+  //De-assert DMA reset and open the DMA bus gate for the fast reads
+  *CCU_BUS_SOFT_RST0 |= CCU_BSRR0_DMA_RST;
+  *CCU_BUS_CLK_GATE0 |= CCU_BCGR0_DMA_EN;
   
   //Set SPI0 clock rate control register to AHB_CLK divided by 6 = (2 * (2 + 1))
   *SPI0_CCR = SPI_CCR_DRS_DIV_2 | SPI_CCR_CDR2(2);
@@ -69,6 +80,61 @@ void sys_spi_flash_read(int addr, unsigned char *rxbuffer, int length)
   *SPI0_TCR |= SPI_TCR_SS_LEVEL_HIGH;
 }
 
+//--------------------------------------------------------------------------------------
+//Read from the flash with the dual output fast read command and let the DMA store the
+//data in DRAM. The buffer needs to be in DRAM. Waits until all the data is read.
+void sys_spi_flash_read_fast(int addr, unsigned char *rxbuffer, int length)
+{
+  //Start the read and wait for it to finish
+  sys_spi_flash_start_read_fast(addr, rxbuffer, length);
+  sys_spi_flash_wait_read_fast();
+}
+
+//--------------------------------------------------------------------------------------
+//Start a fast read without waiting for it to finish
+void sys_spi_flash_start_read_fast(int addr, unsigned char *rxbuffer, int length)
+{
+  //Remember what needs to be read
+  spi_fast_read_addr   = addr;
+  spi_fast_read_buffer = rxbuffer;
+  spi_fast_read_length = length;
+  
+  //Start the first burst when there is something to read
+  if(length)
+    sys_spi_start_dma_burst();
+}
+
+//--------------------------------------------------------------------------------------
+//Wait for the fast read to finish. Bursts that do not fit the counters are started here
+void sys_spi_flash_wait_read_fast(void)
+{
+  while(spi_fast_read_length)
+  {
+    //Wait until the DMA has stored all the bytes of the current burst
+    while((*DMA_INT_STA_REG & DMA_INT_STA_DDMA0_FULL) == 0);
+    
+    //Make sure the SPI is done with the burst
+    while(*SPI0_TCR & SPI_TCR_XCH_START);
+    
+    //De-assert the pre selected CS0 line to end the read command
+    *SPI0_TCR |= SPI_TCR_SS_LEVEL_HIGH;
+    
+    //Skip the bytes read
+    spi_fast_read_addr   += spi_fast_read_count;
+    spi_fast_read_buffer += spi_fast_read_count;
+    spi_fast_read_length -= spi_fast_read_count;
+
+    //Start on the next part when needed
+    if(spi_fast_read_length)
+      sys_spi_start_dma_burst();
+  }
+  
+  //Back to the normal mode for the single line functions
+  *SPI0_FCR &= ~SPI_FCR_RX_DRQ_EN;
+  *SPI0_BCC = 0;
+  *SPI0_TCR &= ~SPI_TCR_DHB_DISCARD;
+}
+
 //--------------------------------------------------------------------------------------
 //Send a buffer full of data to the SPI, but do it in chunks of max 64 bytes (FIFO length)
 void sys_spi_write(unsigned char *buffer, int length)
@@ -156,4 +222,59 @@ void sys_spi_read(unsigned char *buffer, int length)
   }
 }
 
+//--------------------------------------------------------------------------------------
+//Send the dual read command and let the DMA take the data from the receive FIFO. The
+//whole burst is done by the hardware, so only the command bytes go through the CPU
+void sys_spi_start_dma_burst(void)
+{
+  //Limit the burst to what the counters can handle
+  if(spi_fast_read_length <= SPI_FLASH_MAX_BURST)
+    spi_fast_read_count = spi_fast_read_length;
+  else
+    spi_fast_read_count = SPI_FLASH_MAX_BURST;
+
+  //Make sure the SPI is ready
+  while(*SPI0_TCR & SPI_TCR_XCH_START);
 
+  //Clear both FIFO's to drop what ever is left in there
+  *SPI0_FCR |= SPI_FCR_TX_FIFO_RST | SPI_FCR_RX_FIFO_RST;
+  
+  //Make sure they are cleared
+  while(*SPI0_FCR & (SPI_FCR_TX_FIFO_RST | SPI_FCR_RX_FIFO_RST));
+  
+  //Assert the pre selected CS0 line and only keep the bytes received after the command
+  *SPI0_TCR = (*SPI0_TCR & ~SPI_TCR_SS_LEVEL_HIGH) | SPI_TCR_DHB_DISCARD;
+  
+  //The burst holds the command bytes and the data bytes
+  *SPI0_MBC = SPI_FLASH_FAST_READ_SIZE + spi_fast_read_count;
+
+  //Only the command bytes are transmitted in single mode. The data comes in on two lines
+  *SPI0_MTC = SPI_FLASH_FAST_READ_SIZE;
+  *SPI0_BCC = SPI_BCC_DRM_DUAL | SPI_FLASH_FAST_READ_SIZE;
+
+  //Load the command, the address and the dummy byte into the FIFO
+  *SPI0_TXD_BYTE = SPI_FLASH_FAST_READ_DUAL;
+  *SPI0_TXD_BYTE = (unsigned char)(spi_fast_read_addr >> 16);
+  *SPI0_TXD_BYTE = (unsigned char)(spi_fast_read_addr >> 8);
+  *SPI0_TXD_BYTE = (unsigned char)(spi_fast_read_addr >> 0);
+  *SPI0_TXD_BYTE = 0;
+  
+  //Let the receive FIFO request the DMA
+  *SPI0_FCR |= SPI_FCR_RX_DRQ_EN;
+  
+  //Clear the status of the previous transfer
+  *DMA_INT_STA_REG = DMA_INT_STA_DDMA0_HALF | DMA_INT_STA_DDMA0_FULL;
+  
+  //Setup the dedicated DMA channel to move the received bytes into DRAM
+  *DDMA0_SRC_ADR_REG  = (unsigned int)SPI0_RXD_BYTE;
+  *DDMA0_DES_ADR_REG  = (unsigned int)spi_fast_read_buffer;
+  *DDMA0_BYTE_CNT_REG = spi_fast_read_count;
+  *DDMA0_PAR_REG      = DDMA_PAR_SPI;
+  
+  //Start the DMA channel. It waits for the requests from the SPI
+  *DDMA0_CFG_REG = DDMA_CFG_LOADING | DDMA_CFG_DST_WIDTH_8 | DDMA_CFG_DST_BURST_1 | DDMA_CFG_DST_LINEAR | DDMA_CFG_DST_DRQ_SDRAM |
+                   DDMA_CFG_SRC_WIDTH_8 | DDMA_CFG_SRC_BURST_1 | DDMA_CFG_SRC_IO | DDMA_CFG_SRC_DRQ_SPI0;
+  
+  //Start the transfer
+  *SPI0_TCR |= SPI_TCR_XCH_START;
+}
@@ -56,8 +56,13 @@
 #define SPI_FCR_TX_TRIG_LEV_64      0x00400000       //Trigger level for transmit FIFO
 
 #define SPI_FCR_RX_FIFO_RST         0x00008000       //Receive FIFO reset. Self clearing
+#define SPI_FCR_RX_DRQ_EN           0x00000100       //Receive FIFO DMA request enable
 #define SPI_FCR_RX_TRIG_LEV_1       0x00000001       //Trigger level for receive FIFO
 
+//--------------------------------------------------------------------------------------
+//Burst control settings
+#define SPI_BCC_DRM_DUAL            0x10000000       //Receive the data on both MOSI and MISO after the transmitted bytes
+
 //--------------------------------------------------------------------------------------
 //Clock control settings
 #define SPI_CCR_DRS_DIV_2           0x00001000       //Divide rate select. Clock divide rate 2
@@ -71,16 +76,33 @@
 //Divide factor CDR1 (0 -- 15)
 #define SPI_CCR_CDR2(x)            (x & 0xF)
 
+//--------------------------------------------------------------------------------------
+//Flash commands
+#define SPI_FLASH_READ              0x03             //Single line read
+#define SPI_FLASH_FAST_READ_DUAL    0x3B             //Fast read with data on two lines. Needs one dummy byte after the address
+
+//Command, three address bytes and the dummy byte
+#define SPI_FLASH_FAST_READ_SIZE    5
+
+//Largest part read in one go. Both the SPI master burst counter and the DMA byte counter are 24 bits
+#define SPI_FLASH_MAX_BURST         0x00FFFF00
+
 //--------------------------------------------------------------------------------------
 //Functions
 void sys_spi_flash_init(void);
 void sys_spi_flash_exit(void);
 void sys_spi_flash_read(int addr, unsigned char *rxbuffer, int length);
 
+//Dual line read with DMA into DRAM. The start function returns directly so the CPU can do other work while the data comes in
+void sys_spi_flash_read_fast(int addr, unsigned char *rxbuffer, int length);
+void sys_spi_flash_start_read_fast(int addr, unsigned char *rxbuffer, int length);
+void sys_spi_flash_wait_read_fast(void);
+
 //--------------------------------------------------------------------------------------
 //Support functions
 void sys_spi_write(unsigned char *buffer, int length);
 void sys_spi_read(unsigned char *buffer, int length);
+void sys_spi_start_dma_burst(void);
 
 #endif /* SPI_CONTROL_H */
 
@@ -7,6 +7,11 @@ extern "C" {
 
 #include <stdint.h>
 
+/*
+ * ARM926EJ-S data and instruction cache line size
+ */
+#define ARM32_CACHE_LINE_SIZE	32
+
 static inline uint32_t arm32_read_p15_c1(void)
 {
 	uint32_t value;
@@ -135,6 +140,87 @@ static inline void arm32_tlb_invalidate(void)
 		: "r0");
 }
 
+static inline void arm32_drain_write_buffer(void)
+{
+	__asm__ __volatile__(
+		"mcr p15, 0, %0, c7, c10, 4"
+		:
+		: "r" (0)
+		: "memory");
+}
+
+static inline void arm32_icache_invalidate_all(void)
+{
+	__asm__ __volatile__(
+		"mcr p15, 0, %0, c7, c5, 0"
+		:
+		: "r" (0)
+		: "memory");
+}
+
+static inline void arm32_dcache_invalidate_all(void)
+{
+	__asm__ __volatile__(
+		"mcr p15, 0, %0, c7, c6, 0"
+		:
+		: "r" (0)
+		: "memory");
+}
+
+/*
+ * Write back all dirty lines and invalidate the whole data cache with the test, clean and invalidate operation
+ */
+static inline void arm32_dcache_clean_invalidate_all(void)
+{
+	__asm__ __volatile__(
+		"1: mrc p15, 0, r15, c7, c14, 3\n"
+		"bne 1b\n"
+		"mcr p15, 0, %0, c7, c10, 4"
+		:
+		: "r" (0)
+		: "memory", "cc");
+}
+
+/*
+ * The range functions work on whole cache lines, so the start is rounded down and the end is rounded up
+ */
+static inline void arm32_dcache_clean_range(uint32_t start, uint32_t end)
+{
+	start &= ~(ARM32_CACHE_LINE_SIZE - 1);
+
+	while(start < end)
+	{
+		__asm__ __volatile__("mcr p15, 0, %0, c7, c10, 1" : : "r" (start) : "memory");
+		start += ARM32_CACHE_LINE_SIZE;
+	}
+
+	arm32_drain_write_buffer();
+}
+
+static inline void arm32_dcache_invalidate_range(uint32_t start, uint32_t end)
+{
+	start &= ~(ARM32_CACHE_LINE_SIZE - 1);
+
+	while(start < end)
+	{
+		__asm__ __volatile__("mcr p15, 0, %0, c7, c6, 1" : : "r" (start) : "memory");
+		start += ARM32_CACHE_LINE_SIZE;
+	}
+}
+
+static inline void arm32_dcache_clean_invalidate_range(uint32_t start, uint32_t end)
+{
+	start &= ~(ARM32_CACHE_LINE_SIZE - 1);
+
+	while(start < end)
+	{
+		__asm__ __volatile__("mcr p15, 0, %0, c7, c14, 1" : : "r" (start) : "memory");
+		start += ARM32_CACHE_LINE_SIZE;
+	}
+
+	arm32_drain_write_buffer();
+}
+
 #ifdef __cplusplus
 }
 #endif
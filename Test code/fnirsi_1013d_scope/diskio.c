@@ -11,6 +11,9 @@
 #include "diskio.h"    //Declarations of disk functions
 
 #include "sd_card_interface.h"
+#include "mmu_control.h"
+
+#include <string.h>
 
 //Definitions of physical drive number for each drive
 #define DEV_SD     0 
@@ -18,6 +21,14 @@
 //Number of sectors on the card
 extern uint32 cardsectors;
 
+//The file system object is needed to know where the file system area ends
+extern FATFS fs;
+
+//Sector cache. The data is aligned on a cache line, so the card can use DMA on it directly
+DISKCACHEENTRY diskcacheentries[DISK_CACHE_SECTORS];
+uint32         diskcachedata[DISK_CACHE_SECTORS][128] CACHE_LINE_ALIGNED;
+UINT           diskcacheuse = 0;
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //Get Drive Status                                
 //
@@ -84,12 +95,21 @@ DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
   //Check if the SD card device is addressed
   if(pdrv == DEV_SD)
   {
+    //Single sectors are the file system window accesses. These go through the cache
+    if(count == 1)
+    {
+      return(disk_cache_read(sector, buff));
+    }
+
     //Read the data from the card
     if(sd_card_read(sector, count, buff) != SD_OK)
     {
       //Error while reading
       return(RES_ERROR);
     }
+
+    //Cached sectors that are not written yet are newer than what is on the card
+    disk_cache_update(sector, count, buff, 1);
   }
   else
   {
@@ -123,12 +143,21 @@ DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
   //Check if the SD card device is addressed
   if(pdrv == DEV_SD)
   {
+    //Single sectors are the file system window accesses. These are kept in the cache and written back later
+    if(count == 1)
+    {
+      return(disk_cache_write(sector, buff));
+    }
+
     //Write the data to the card
     if(sd_card_write(sector, count, (BYTE *)buff) != SD_OK)
     {
       //Error while writing
       return(RES_ERROR);
     }
+
+    //Keep cached copies of these sectors the same as the card
+    disk_cache_update(sector, count, (BYTE *)buff, 0);
   }
   else
   {
@@ -167,6 +196,25 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
   {
     if(cmd == CTRL_SYNC)
     {
+      //Write the changed sectors in the cache to the card
+      if(disk_cache_flush() != RES_OK)
+      {
+        return(RES_ERROR);
+      }
+
+      //Make sure a transfer still in flight has finished
+      if(sd_card_wait_transfer() != SD_OK)
+      {
+        return(RES_ERROR);
+      }
+
+      return(RES_OK);
+    }
+    else if(cmd == CTRL_INVALIDATE)
+    {
+      //Forget about all the cached sectors
+      disk_cache_invalidate();
+
       return(RES_OK);
     }
     else if(cmd == GET_SECTOR_COUNT)
@@ -185,6 +233,300 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
   return(RES_PARERR);
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//Sector cache functions
+//----------------------------------------------------------------------------------------------------------------------------------
+//The cache holds the single sector accesses FatFs does through its window, which are the FAT, directory and partial file sectors.
+//Sectors in front of the data area (boot sector, FAT's and FAT12/16 root directory) are pinned, meaning they are only replaced by
+//other pinned sectors, so browsing through the files does not push them out. Written sectors are kept until they are replaced or a
+//sync is done. Multiple sector transfers go directly to the card, with the cache being kept consistent with them.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Read a sector through the cache
+//
+//Return:
+//  DRESULT
+//
+//Input:
+//  Sector in LBA
+//  Data buffer to store read data
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+DRESULT disk_cache_read(LBA_t sector, BYTE *buff)
+{
+  int index = disk_cache_find(sector);
+
+  //Check if the sector is not in the cache
+  if(index < 0)
+  {
+    //Get an entry for it, with pinning for the file system area
+    index = disk_cache_get_entry(sector < fs.database);
+
+    //Check if the entry could be freed
+    if(index < 0)
+    {
+      return(RES_ERROR);
+    }
+
+    //Read the data from the card into the cache
+    if(sd_card_read(sector, 1, (uint8 *)diskcachedata[index]) != SD_OK)
+    {
+      //Error while reading
+      return(RES_ERROR);
+    }
+
+    //Setup the entry for this sector
+    diskcacheentries[index].sector = sector;
+    diskcacheentries[index].flags |= DISK_CACHE_VALID;
+  }
+
+  //Mark it as most recently used
+  diskcacheentries[index].lastused = ++diskcacheuse;
+
+  //Hand out the data
+  memcpy(buff, diskcachedata[index], 512);
+
+  return(RES_OK);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Write a sector into the cache
+//
+//Return:
+//  DRESULT
+//
+//Input:
+//  Sector in LBA
+//  Data buffer to be written
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+DRESULT disk_cache_write(LBA_t sector, const BYTE *buff)
+{
+  int index = disk_cache_find(sector);
+
+  //Check if the sector is not in the cache
+  if(index < 0)
+  {
+    //Get an entry for it, with pinning for the file system area. There is no need to read it, since all of it is written
+    index = disk_cache_get_entry(sector < fs.database);
+
+    //Check if the entry could be freed
+    if(index < 0)
+    {
+      return(RES_ERROR);
+    }
+
+    //Setup the entry for this sector
+    diskcacheentries[index].sector = sector;
+  }
+
+  //Take the data and mark it as needing to be written to the card
+  memcpy(diskcachedata[index], buff, 512);
+
+  diskcacheentries[index].flags |= DISK_CACHE_VALID | DISK_CACHE_DIRTY;
+  diskcacheentries[index].lastused = ++diskcacheuse;
+
+  return(RES_OK);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Write all the changed sectors in the cache to the card
+//
+//Return:
+//  DRESULT
+//
+//Input:
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+DRESULT disk_cache_flush(void)
+{
+  int index;
+
+  //Check all the entries
+  for(index=0;index<DISK_CACHE_SECTORS;index++)
+  {
+    //Check if this one needs writing
+    if(diskcacheentries[index].flags & DISK_CACHE_DIRTY)
+    {
+      //Write the data to the card
+      if(sd_card_write(diskcacheentries[index].sector, 1, (uint8 *)diskcachedata[index]) != SD_OK)
+      {
+        //Error while writing
+        return(RES_ERROR);
+      }
+
+      //Same as on the card now
+      diskcacheentries[index].flags &= ~DISK_CACHE_DIRTY;
+    }
+  }
+
+  return(RES_OK);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Drop all the sectors from the cache
+//
+//Return:
+//
+//Input:
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+void disk_cache_invalidate(void)
+{
+  //Clearing the flags is enough to make all entries free
+  memset(diskcacheentries, 0, sizeof(diskcacheentries));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Keep the cache and a multiple sector transfer consistent
+//
+//Return:
+//
+//Input:
+//  Start sector in LBA
+//  Number of sectors transfered
+//  Data buffer of the transfer
+//  When set the buffer was read from the card and the not yet written cached sectors are copied into it, otherwise the cached
+//  sectors are updated with the written data
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+void disk_cache_update(LBA_t sector, UINT count, BYTE *buff, UINT fromcache)
+{
+  int   index;
+  LBA_t offset;
+
+  //Check all the entries
+  for(index=0;index<DISK_CACHE_SECTORS;index++)
+  {
+    //Get the position of this entry in the transfer. Sectors in front of the transfer wrap around to a big number
+    offset = diskcacheentries[index].sector - sector;
+
+    //Check if the entry is used and within the transfer
+    if((diskcacheentries[index].flags & DISK_CACHE_VALID) && (offset < count))
+    {
+      //Check on the direction of the transfer
+      if(fromcache)
+      {
+        //Only changed sectors differ from what was read
+        if(diskcacheentries[index].flags & DISK_CACHE_DIRTY)
+        {
+          memcpy(buff + (offset * 512), diskcachedata[index], 512);
+        }
+      }
+      else
+      {
+        //Take the new data, which is on the card now
+        memcpy(diskcachedata[index], buff + (offset * 512), 512);
+
+        diskcacheentries[index].flags &= ~DISK_CACHE_DIRTY;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Find a sector in the cache
+//
+//Return:
+//  Index of the entry or -1 when not found
+//
+//Input:
+//  Sector in LBA
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+int disk_cache_find(LBA_t sector)
+{
+  int index;
+
+  //Check all the entries
+  for(index=0;index<DISK_CACHE_SECTORS;index++)
+  {
+    //Check if this is the one
+    if((diskcacheentries[index].flags & DISK_CACHE_VALID) && (diskcacheentries[index].sector == sector))
+    {
+      return(index);
+    }
+  }
+
+  return(-1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Get a cache entry for a new sector
+//
+//Return:
+//  Index of the entry or -1 when the data in it could not be written to the card
+//
+//Input:
+//  When set the entry is for a sector in the file system area
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+int disk_cache_get_entry(UINT pinned)
+{
+  int  index;
+  int  oldest = -1;
+  int  oldestpinned = -1;
+  UINT pinnedcount = 0;
+
+  //Check all the entries
+  for(index=0;index<DISK_CACHE_SECTORS;index++)
+  {
+    //A free entry can be used directly
+    if((diskcacheentries[index].flags & DISK_CACHE_VALID) == 0)
+    {
+      oldest = index;
+      break;
+    }
+
+    //Check on a pinned entry
+    if(diskcacheentries[index].flags & DISK_CACHE_PINNED)
+    {
+      //Count them and keep track of the least recently used one
+      pinnedcount++;
+
+      if((oldestpinned < 0) || (diskcacheentries[index].lastused < diskcacheentries[oldestpinned].lastused))
+      {
+        oldestpinned = index;
+      }
+    }
+    //Keep track of the least recently used not pinned entry
+    else if((oldest < 0) || (diskcacheentries[index].lastused < diskcacheentries[oldest].lastused))
+    {
+      oldest = index;
+    }
+  }
+
+  //Pinned entries are only replaced by pinned ones when the limit is reached, or when there are no other entries
+  if((index == DISK_CACHE_SECTORS) && (oldestpinned >= 0) && (((pinned) && (pinnedcount >= DISK_CACHE_MAX_PINNED)) || (oldest < 0)))
+  {
+    oldest = oldestpinned;
+  }
+
+  //Check if the data in the entry still needs to be written to the card
+  if(diskcacheentries[oldest].flags & DISK_CACHE_DIRTY)
+  {
+    //Write the data to the card
+    if(sd_card_write(diskcacheentries[oldest].sector, 1, (uint8 *)diskcachedata[oldest]) != SD_OK)
+    {
+      //Error while writing
+      return(-1);
+    }
+  }
+
+  //Setup the entry as not yet valid, with the pinning as requested
+  if(pinned)
+  {
+    diskcacheentries[oldest].flags = DISK_CACHE_PINNED;
+  }
+  else
+  {
+    diskcacheentries[oldest].flags = 0;
+  }
+
+  return(oldest);
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //get a fixed value for the date and time                                            
 //
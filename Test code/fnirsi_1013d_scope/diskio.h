@@ -69,6 +69,40 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 #define ATA_GET_MODEL    21  //Get model name
 #define ATA_GET_SN       22  //Get serial number
 
+//Scope specific ioctl command
+#define CTRL_INVALIDATE  60  //Drop the cached sectors after the card has been changed without going through FatFs (USB connection)
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Sector cache
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Number of sectors kept in the cache
+#define DISK_CACHE_SECTORS        32
+
+//Limit on the entries used for the file system area sectors, so there is always room left for directory and file sectors
+#define DISK_CACHE_MAX_PINNED     16
+
+#define DISK_CACHE_VALID          0x01
+#define DISK_CACHE_DIRTY          0x02
+#define DISK_CACHE_PINNED         0x04
+
+typedef struct tagDiskCacheEntry   DISKCACHEENTRY, *PDISKCACHEENTRY;
+
+struct tagDiskCacheEntry
+{
+  LBA_t  sector;
+  UINT   flags;
+  UINT   lastused;
+};
+
+DRESULT disk_cache_read(LBA_t sector, BYTE *buff);
+DRESULT disk_cache_write(LBA_t sector, const BYTE *buff);
+DRESULT disk_cache_flush(void);
+void    disk_cache_invalidate(void);
+void    disk_cache_update(LBA_t sector, UINT count, BYTE *buff, UINT fromcache);
+int     disk_cache_find(LBA_t sector);
+int     disk_cache_get_entry(UINT pinned);
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 #endif
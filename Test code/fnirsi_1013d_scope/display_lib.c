@@ -20,6 +20,7 @@
 #include "sin_cos_math.h"
 
 #include <string.h>
+#include <stdint.h>
 
 
 #include <stdio.h>
@@ -97,6 +98,17 @@ void display_set_destination_buffer(uint16 *buffer)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void display_set_clip_window(uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+{
+  //Keep the window as the first and last pixel that can be drawn on
+  displaydata.clipxmin = xpos;
+  displaydata.clipymin = ypos;
+  displaydata.clipxmax = xpos + width - 1;
+  displaydata.clipymax = ypos + height - 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void display_save_screen_buffer(void)
 {
   displaydata.savebuffer = displaydata.screenbuffer;
@@ -729,41 +741,377 @@ void display_draw_arc(uint32 xpos, uint32 ypos, uint32 radius, uint32 startangle
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//Line drawing for the signal traces. Unlike display_draw_line the segments are clipped only once against the clip window, after
+//which the pixels are written without any further checks. Every x position on the line gets a single vertical span of pixels,
+//which is drawn with a stride pointer. The span lengths are done with run length Bresenham, so no division per pixel is needed.
 
-void display_fill_rect(uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+void display_draw_trace_line(uint32 xstart, uint32 ystart, uint32 xend, uint32 yend)
 {
-  uint16 *ptr;
-  uint32  y;
-  uint32  x;
+  DISPLAYPOINTS points[2];
 
-  //Calculate the last x and y position to compare against
-  width += xpos;
-  height += ypos;
+  //A single line is a polyline with two points
+  points[0].x = xstart;
+  points[0].y = ystart;
+  points[1].x = xend;
+  points[1].y = yend;
 
-  //Check on x bound
-  if(width > displaydata.width)
+  display_draw_trace_polyline(points, 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_draw_trace_polyline(PDISPLAYPOINTS points, uint32 count)
+{
+  register uint16 *ptr;
+  register uint32  color = displaydata.fg_color;
+  register uint32  pixels = displaydata.pixelsperline;
+  register int32   step;
+  register uint32  columns;
+  register uint32  column;
+  register uint32  run;
+  register uint32  delta;
+  register uint32  remainder;
+  register uint32  error;
+  int32  xs, ys, xe, ye;
+  int32  x1, y1, x2, y2, t;
+  uint32 code1, code2;
+
+  //Need at least two points for a line
+  if(count < 2)
   {
-    width = displaydata.width;
+    return;
   }
-  
-  //Check on y bound
-  if(height > displaydata.height)
+
+  //Get the first point and its position relative to the clip window
+  xe = points->x;
+  ye = points->y;
+  code2 = display_get_clip_code(xe, ye);
+
+  //Handle all the segments
+  while(--count)
   {
-    height = displaydata.height;
+    //The end of the previous segment is the start of this one
+    xs = xe;
+    ys = ye;
+    code1 = code2;
+
+    //Get the next point and its position relative to the clip window
+    points++;
+    xe = points->x;
+    ye = points->y;
+    code2 = display_get_clip_code(xe, ye);
+
+    //Use a copy for drawing, since the end point is needed unclipped for the next segment
+    x1 = xs;
+    y1 = ys;
+    x2 = xe;
+    y2 = ye;
+
+    //Check if the segment is not fully inside the window
+    if(code1 | code2)
+    {
+      //When both points are on the same outside of the window nothing needs to be drawn
+      if(code1 & code2)
+      {
+        continue;
+      }
+
+      //Clip the segment and skip it when nothing is left
+      if(display_clip_line(&x1, &y1, &x2, &y2) == 0)
+      {
+        continue;
+      }
+    }
+
+    //Draw from left to right
+    if(x1 > x2)
+    {
+      //Swap the points if needed
+      t  = x1;
+      x1 = x2;
+      x2 = t;
+      t  = y1;
+      y1 = y2;
+      y2 = t;
+    }
+
+    //Number of x positions the line covers
+    columns = x2 - x1 + 1;
+
+    //Vertical distance to cover
+    t = y2 - y1;
+
+    //Determine the direction to go in
+    if(t < 0)
+    {
+      //Going up so subtract a line
+      step  = -pixels;
+      delta = -t;
+    }
+    else
+    {
+      //Going down so add a line
+      step  = pixels;
+      delta = t;
+    }
+
+    //Split the vertical distance in a whole number of pixels per column and a remainder that is spread over the columns
+    if(columns == 1)
+    {
+      //Both points are in the same column, so the whole distance is a single vertical span and no division is needed
+      remainder = 0;
+    }
+    else
+    {
+      remainder = delta % columns;
+      delta     = delta / columns;
+    }
+
+    //Point to the first pixel of the line
+    ptr = displaydata.screenbuffer + ((y1 * pixels) + x1);
+
+    //Start without error
+    error = 0;
+
+    //Draw a vertical span for every column
+    for(column=0;column<columns;column++)
+    {
+      //Get the length of this span
+      run = delta;
+      error += remainder;
+
+      //Check if the error has become a full pixel
+      if(error >= columns)
+      {
+        run++;
+        error -= columns;
+      }
+
+      //Set the first pixel of the span, which is shared with the end of the previous span
+      *ptr = color;
+
+      //Set the rest of the span
+      while(run)
+      {
+        ptr += step;
+        *ptr = color;
+        run--;
+      }
+
+      //Next column on the same line
+      ptr++;
+    }
   }
-  
-  //Draw all the pixels
-  for(y=ypos;y<height;y++)
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 display_get_clip_code(int32 x, int32 y)
+{
+  uint32 code = DISPLAY_CLIP_INSIDE;
+
+  //Check against the left and right edges
+  if(x < displaydata.clipxmin)
   {
-    //Point to the first pixel of this line in the screen buffer
-    ptr = displaydata.screenbuffer + ((y * displaydata.pixelsperline) + xpos);
+    code = DISPLAY_CLIP_LEFT;
+  }
+  else if(x > displaydata.clipxmax)
+  {
+    code = DISPLAY_CLIP_RIGHT;
+  }
 
-    //Draw the pixels on the line
-    for(x=xpos;x<width;x++)
+  //Check against the top and bottom edges
+  if(y < displaydata.clipymin)
+  {
+    code |= DISPLAY_CLIP_TOP;
+  }
+  else if(y > displaydata.clipymax)
+  {
+    code |= DISPLAY_CLIP_BOTTOM;
+  }
+
+  return(code);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 display_clip_line(int32 *xstart, int32 *ystart, int32 *xend, int32 *yend)
+{
+  int32  xs = *xstart;
+  int32  ys = *ystart;
+  int32  xe = *xend;
+  int32  ye = *yend;
+  int32  x, y;
+  uint32 code1 = display_get_clip_code(xs, ys);
+  uint32 code2 = display_get_clip_code(xe, ye);
+  uint32 code;
+
+  //Cohen-Sutherland clipping. Keep moving points onto the window edges until the line is fully inside or fully outside
+  while(code1 | code2)
+  {
+    //When both points are on the same outside of the window the line is not visible
+    if(code1 & code2)
     {
-      //Set the current screen buffer pixel with the requested color
-      *ptr++ = displaydata.fg_color;
+      return(0);
     }
+
+    //Take a point that is outside the window
+    if(code1)
+    {
+      code = code1;
+    }
+    else
+    {
+      code = code2;
+    }
+
+    //Calculate the crossing with the edge it is outside of
+    if(code & DISPLAY_CLIP_TOP)
+    {
+      y = displaydata.clipymin;
+      x = xs + (((xe - xs) * (y - ys)) / (ye - ys));
+    }
+    else if(code & DISPLAY_CLIP_BOTTOM)
+    {
+      y = displaydata.clipymax;
+      x = xs + (((xe - xs) * (y - ys)) / (ye - ys));
+    }
+    else if(code & DISPLAY_CLIP_LEFT)
+    {
+      x = displaydata.clipxmin;
+      y = ys + (((ye - ys) * (x - xs)) / (xe - xs));
+    }
+    else
+    {
+      x = displaydata.clipxmax;
+      y = ys + (((ye - ys) * (x - xs)) / (xe - xs));
+    }
+
+    //Replace the outside point with the crossing
+    if(code == code1)
+    {
+      xs = x;
+      ys = y;
+      code1 = display_get_clip_code(xs, ys);
+    }
+    else
+    {
+      xe = x;
+      ye = y;
+      code2 = display_get_clip_code(xe, ye);
+    }
+  }
+
+  //Return the clipped line
+  *xstart = xs;
+  *ystart = ys;
+  *xend   = xe;
+  *yend   = ye;
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_fill_rect(uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+{
+  register uint16 *ptr;
+  register uint32  line;
+  register uint32  pixels = displaydata.pixelsperline;
+
+  //Clip the rectangle on the screen and quit when nothing is left
+  if(display_clip_rect(xpos, ypos, &width, &height) == 0)
+  {
+    return;
+  }
+
+  //Point to the first pixel of the rectangle in the screen buffer
+  ptr = displaydata.screenbuffer + ((ypos * pixels) + xpos);
+
+  //When full lines are filled the rectangle is one contiguous block of pixels
+  if(width == pixels)
+  {
+    //So fill it in one go
+    display_fill_pixels(ptr, displaydata.fg_color, width * height);
+  }
+  else
+  {
+    //Fill all the lines
+    for(line=0;line<height;line++)
+    {
+      //Fill the pixels on the line
+      display_fill_pixels(ptr, displaydata.fg_color, width);
+
+      //Point to the next line of pixels
+      ptr += pixels;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Fill a run of pixels with a single color. The pixels are written in pairs as 32 bit words, and the bulk of them is done in
+//full 32 byte cache lines with eight word stores, which the compiler turns into stmia bursts just like memset.s does.
+
+void display_fill_pixels(uint16 *ptr, uint32 color, uint32 count)
+{
+  register uint32 *wptr;
+  register uint32  pair;
+  register uint32  lines;
+
+  //Check if the first pixel is on an odd half word
+  if(((uintptr_t)ptr & 2) && count)
+  {
+    //Do a single pixel to get word aligned
+    *ptr++ = color;
+    count--;
+  }
+
+  //Word access from here on
+  wptr = (uint32 *)ptr;
+
+  //Make a pixel pair of the color
+  pair = (color & 0x0000FFFF) | (color << 16);
+
+  //Write single pairs until aligned on a cache line
+  while((count >= 2) && ((uintptr_t)wptr & 0x1F))
+  {
+    *wptr++ = pair;
+    count -= 2;
+  }
+
+  //Number of full cache lines to do (16 pixels each)
+  lines = count >> 4;
+
+  //Fill the cache lines
+  while(lines)
+  {
+    wptr[0] = pair;
+    wptr[1] = pair;
+    wptr[2] = pair;
+    wptr[3] = pair;
+    wptr[4] = pair;
+    wptr[5] = pair;
+    wptr[6] = pair;
+    wptr[7] = pair;
+
+    wptr += 8;
+    lines--;
+  }
+
+  //Pixels that are left over
+  count &= 0x0F;
+
+  //Do the remaining pairs
+  while(count >= 2)
+  {
+    *wptr++ = pair;
+    count -= 2;
+  }
+
+  //Check if there is a single pixel left
+  if(count)
+  {
+    *(uint16 *)wptr = color;
   }
 }
 
@@ -1033,16 +1381,30 @@ void display_copy_rect_from_screen(uint32 xpos, uint32 ypos, uint32 width, uint3
   register uint32  startpixel;
   register uint32  pixels = displaydata.pixelsperline;
 
+  //Clip the rectangle on the screen and quit when nothing is left
+  if(display_clip_rect(xpos, ypos, &width, &height) == 0)
+  {
+    return;
+  }
+
   //Start pixel for source and destination calculation
   startpixel = xpos + (ypos * pixels);
 
   //Setup destination and source pointers
   ptr1 = displaydata.destbuffer + startpixel;
   ptr2 = displaydata.screenbuffer + startpixel;
-  
+
+  //When full lines are copied the rectangle is one contiguous block
+  if(width == pixels)
+  {
+    //So copy it in one go. The memcpy does this in 32 byte ldmia/stmia bursts
+    memcpy(ptr1, ptr2, (width * height) << 1);
+    return;
+  }
+
   //For copying bytes instead of shorts the width doubles
   width <<=1;
-  
+
   //Copy the needed lines
   for(line=0;line<height;line++)
   {
@@ -1064,16 +1426,30 @@ void display_copy_rect_to_screen(uint32 xpos, uint32 ypos, uint32 width, uint32
   register uint32  startpixel;
   register uint32  pixels = displaydata.pixelsperline;
 
+  //Clip the rectangle on the screen and quit when nothing is left
+  if(display_clip_rect(xpos, ypos, &width, &height) == 0)
+  {
+    return;
+  }
+
   //Start pixel for source and destination calculation
   startpixel = xpos + (ypos * pixels);
 
   //Setup destination and source pointers
   ptr1 = displaydata.screenbuffer + startpixel;
   ptr2 = displaydata.sourcebuffer + startpixel;
-  
+
+  //When full lines are copied the rectangle is one contiguous block
+  if(width == pixels)
+  {
+    //So copy it in one go. The memcpy does this in 32 byte ldmia/stmia bursts
+    memcpy(ptr1, ptr2, (width * height) << 1);
+    return;
+  }
+
   //For copying bytes instead of shorts the width doubles
   width <<= 1;
-  
+
   //Copy the needed lines
   for(line=0;line<height;line++)
   {
@@ -1087,174 +1463,361 @@ void display_copy_rect_to_screen(uint32 xpos, uint32 ypos, uint32 width, uint32
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//Move the contents of a rectangle in the screen buffer the given number of pixels to the left. The pixels that come free on the
+//right are left as they are, so the caller can draw the new content there
 
-void display_copy_icon_use_colors(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+void display_scroll_rect_left(uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint32 distance)
 {
   register uint16 *ptr;
   register uint32  line;
-  register uint32  pixel;
-  register uint32  idx;
-  register uint32  pixeldata;
-  register uint32  bytesperrow = (width + 7) / 8;
   register uint32  pixels = displaydata.pixelsperline;
 
-  //Setup destination pointer
-  ptr = displaydata.screenbuffer + xpos + (ypos * pixels);
-  
-  //Copy the needed lines
+  //Clip the rectangle on the screen and quit when nothing is left or everything scrolls out
+  if((display_clip_rect(xpos, ypos, &width, &height) == 0) || (distance >= width))
+  {
+    return;
+  }
+
+  //Point to the first pixel of the rectangle in the screen buffer
+  ptr = displaydata.screenbuffer + ((ypos * pixels) + xpos);
+
+  //Number of bytes that stay in the rectangle per line
+  width = (width - distance) << 1;
+
+  //Move the needed lines
   for(line=0;line<height;line++)
   {
-    //Point the icon start byte for this line
-    idx = line * bytesperrow;
-    
-    //Get the data for per bit handling
-    pixeldata = icon[idx];
-    
-    //Copy a single line to the destination buffer
-    for(pixel=0;pixel<width;)
+    //The source and destination overlap, so memmove is needed
+    memmove(ptr, ptr + distance, width);
+
+    //Point to the next line of pixels
+    ptr += pixels;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 display_clip_rect(uint32 xpos, uint32 ypos, uint32 *width, uint32 *height)
+{
+  //Check if the rectangle starts on the screen
+  if((xpos > displaydata.width) || (ypos > displaydata.height))
+  {
+    //Nothing to draw
+    return(0);
+  }
+
+  //Clip the width on the right edge of the screen
+  if((xpos + *width) > (displaydata.width + 1))
+  {
+    *width = displaydata.width + 1 - xpos;
+  }
+
+  //Clip the height on the bottom edge of the screen
+  if((ypos + *height) > (displaydata.height + 1))
+  {
+    *height = displaydata.height + 1 - ypos;
+  }
+
+  //Signal if there is something left to draw
+  return(*width && *height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The hit buffer functions work on an 8 bit per pixel intensity buffer that has the same size as the given rectangle.
+//Four pixels are handled per 32 bit word, so the x position must be even and the width a multiple of four.
+
+void display_accumulate_hits(uint8 *hits, uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint32 increment)
+{
+  register uint32 *src;
+  register uint32 *dst = (uint32 *)hits;
+  register uint32  pixels = displaydata.pixelsperline;
+  register uint32  add = increment * 0x01010101;
+  register uint32  quads;
+  register uint32  line;
+  register uint32  p01, p23;
+  register uint32  hit, sum, low, carry;
+
+  //Four pixels per step
+  width >>= 2;
+
+  //Handle all the lines
+  for(line=0;line<height;line++)
+  {
+    //Point to the first two pixels of this line on the screen
+    src = (uint32 *)(displaydata.screenbuffer + (((ypos + line) * pixels) + xpos));
+
+    //Do four pixels at a time
+    for(quads=width;quads;quads--)
     {
-      //Select the pixel to check
-      pixeldata <<= 1;
-      
-      //Copy one pixel at a time with a check on being on
-      if(pixeldata & 0x0100)
-      {
-        //When on use the foreground color
-        ptr[pixel] = displaydata.fg_color;
-      }
-      else
-      {
-        //When off use the background color
-        ptr[pixel] = displaydata.bg_color;
-      }
-      
-      //Select next pixel
-      pixel++;
-      
-      //Check if pixel on multiple of 8 for next byte select
-      if((pixel & 0x07) == 0)
-      {
-        //Point to the next byte
-        idx++;
-    
-        //And get the data for it
-        pixeldata = icon[idx];
-      }
+      //Get two pixels per word
+      p01 = *src++;
+      p23 = *src++;
+
+      //Turn every non black pixel into a set top bit of its half word
+      p01 = (((p01 & 0x7FFF7FFF) + 0x7FFF7FFF) | p01) & 0x80008000;
+      p23 = (((p23 & 0x7FFF7FFF) + 0x7FFF7FFF) | p23) & 0x80008000;
+
+      //Move the four flags to the top bits of the four bytes
+      hit = ((p01 >> 8) & 0x00000080) | (p01 >> 16) | (p23 << 8) | (p23 & 0x80000000);
+
+      //Stretch the flags to full byte masks and select the increment for the hit pixels
+      hit = ((hit << 1) - (hit >> 7)) & add;
+
+      //Get the current intensities
+      sum = *dst;
+
+      //Add the lower seven bits of each byte without carry into the next byte
+      low = (sum & 0x7F7F7F7F) + (hit & 0x7F7F7F7F);
+
+      //Determine which bytes overflow
+      carry = ((sum & hit) | ((sum | hit) & low)) & 0x80808080;
+
+      //Finish the add with the top bits, and saturate the bytes that overflowed
+      sum = (low ^ ((sum ^ hit) & 0x80808080)) | ((carry << 1) - (carry >> 7));
+
+      //Store the new intensities
+      *dst++ = sum;
     }
+  }
+}
 
-    //Point to the next line of pixels in the destination
-    ptr += pixels;
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_decay_hits(uint8 *hits, uint32 count, uint32 shift)
+{
+  register uint32 *ptr = (uint32 *)hits;
+  register uint32  mask = (0xFF >> shift) * 0x01010101;
+
+  //Four pixels per step
+  count >>= 2;
+
+  //Scale down all the intensities. The mask stops bits from moving into the next byte
+  while(count)
+  {
+    *ptr = (*ptr >> shift) & mask;
+    ptr++;
+    count--;
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
-void display_copy_icon_fg_color(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+void display_copy_hits_to_screen(uint8 *hits, uint16 *colors, uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+{
+  register uint32 *src = (uint32 *)hits;
+  register uint32 *dst;
+  register uint32  pixels = displaydata.pixelsperline;
+  register uint32  quads;
+  register uint32  line;
+  register uint32  data;
+
+  //Four pixels per step
+  width >>= 2;
+
+  //Handle all the lines
+  for(line=0;line<height;line++)
+  {
+    //Point to the first two pixels of this line on the screen
+    dst = (uint32 *)(displaydata.screenbuffer + (((ypos + line) * pixels) + xpos));
+
+    //Do four pixels at a time
+    for(quads=width;quads;quads--)
+    {
+      //Get four intensities
+      data = *src++;
+
+      //Translate them into colors and write two pixels per word
+      *dst++ = colors[data & 0xFF] | (colors[(data >> 8) & 0xFF] << 16);
+      *dst++ = colors[(data >> 16) & 0xFF] | (colors[data >> 24] << 16);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The icons are one bit per pixel with the most significant bit being the left most pixel. Each line of the icon starts on a new byte.
+//The icon blitters handle a full byte of pixels per step, and skip the empty bytes when only the foreground is drawn.
+
+void display_copy_icon_use_colors(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height)
 {
   register uint16 *ptr;
+  register uint32 *wptr;
   register uint32  line;
   register uint32  pixel;
   register uint32  idx;
-  register uint32  pixeldata;
+  register uint32  pixeldata = 0;
+  register uint32  fullbytes;
   register uint32  bytesperrow = (width + 7) / 8;
   register uint32  pixels = displaydata.pixelsperline;
+  register uint32  fg = displaydata.fg_color;
+  register uint32  bg = displaydata.bg_color;
+  uint32 pairs[4];
+
+  //Clip the icon on the screen and quit when nothing is left
+  if(display_clip_rect(xpos, ypos, &width, &height) == 0)
+  {
+    return;
+  }
+
+  //Setup the pixel pairs for the four possible combinations of two bits. The first pixel is in the low half of the word.
+  pairs[0] = bg | (bg << 16);
+  pairs[1] = bg | (fg << 16);
+  pairs[2] = fg | (bg << 16);
+  pairs[3] = fg | (fg << 16);
+
+  //Number of icon bytes that are fully on the screen
+  fullbytes = width >> 3;
 
   //Setup destination pointer
   ptr = displaydata.screenbuffer + xpos + (ypos * pixels);
-  
+
   //Copy the needed lines
   for(line=0;line<height;line++)
   {
-    //Point the icon start byte for this line
-    idx = line * bytesperrow;
-    
-    //Get the data for per bit handling
-    pixeldata = icon[idx];
-    
-    //Copy a single line to the destination buffer
-    for(pixel=0;pixel<width;)
+    //Start with the first pixel for the single pixel handling
+    pixel = 0;
+
+    //Check if the destination is word aligned, which is the same for every line since the line width is even
+    if(((uintptr_t)ptr & 2) == 0)
     {
-      //Select the pixel to check
-      pixeldata <<= 1;
-      
-      //Copy one pixel at a time with a check on being on and only fill in the ones that are on
-      if(pixeldata & 0x0100)
+      //Word access for the pixel pairs
+      wptr = (uint32 *)ptr;
+
+      //Do the full bytes as four pixel pairs each
+      for(idx=0;idx<fullbytes;idx++)
       {
-        //When on use the foreground color
-        ptr[pixel] = displaydata.fg_color;
+        //Get the data for the next eight pixels
+        pixeldata = icon[idx];
+
+        //Write them as pairs
+        wptr[0] = pairs[(pixeldata >> 6) & 3];
+        wptr[1] = pairs[(pixeldata >> 4) & 3];
+        wptr[2] = pairs[(pixeldata >> 2) & 3];
+        wptr[3] = pairs[pixeldata & 3];
+
+        wptr += 4;
       }
-      
-      //Select next pixel
-      pixel++;
-      
-      //Check if pixel on multiple of 8 for next byte select
+
+      //Only the pixels of a partial last byte are left to do
+      pixel = fullbytes << 3;
+    }
+
+    //Do the remaining pixels one at a time
+    for(;pixel<width;pixel++)
+    {
+      //Get the data for the next eight pixels on a byte boundary
       if((pixel & 0x07) == 0)
       {
-        //Point to the next byte
-        idx++;
-    
-        //And get the data for it
-        pixeldata = icon[idx];
+        pixeldata = icon[pixel >> 3];
+      }
+
+      //When on use the foreground color, otherwise the background color
+      if(pixeldata & 0x80)
+      {
+        ptr[pixel] = fg;
       }
+      else
+      {
+        ptr[pixel] = bg;
+      }
+
+      //Select the next pixel
+      pixeldata <<= 1;
     }
 
-    //Point to the next line of pixels in the destination
+    //Point to the next line of pixels in the icon and the destination
+    icon += bytesperrow;
     ptr += pixels;
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void display_copy_icon_fg_color(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+{
+  //The plain foreground version is the gradient version with a single color for all the lines
+  display_copy_icon_fg_color_lines(icon, xpos, ypos, width, height, 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void display_copy_icon_fg_color_y_gradient(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height)
+{
+  //Use the gradient buffer for the color per line
+  display_copy_icon_fg_color_lines(icon, xpos, ypos, width, height, displaydata.ygradient);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_copy_icon_fg_color_lines(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint16 *gradient)
 {
   register uint16 *ptr;
+  register uint16 *dptr;
   register uint32  line;
   register uint32  pixel;
-  register uint32  idx;
   register uint32  pixeldata;
+  register uint32  color = displaydata.fg_color;
   register uint32  bytesperrow = (width + 7) / 8;
   register uint32  pixels = displaydata.pixelsperline;
-  
+  register uint32  bytes;
+
+  //Clip the icon on the screen and quit when nothing is left
+  if(display_clip_rect(xpos, ypos, &width, &height) == 0)
+  {
+    return;
+  }
+
+  //Number of icon bytes, full or partial, that are on the screen
+  bytes = (width + 7) >> 3;
+
   //Setup destination pointer
   ptr = displaydata.screenbuffer + xpos + (ypos * pixels);
-  
+
   //Copy the needed lines
   for(line=0;line<height;line++)
   {
-    //Point the icon start byte for this line
-    idx = line * bytesperrow;
-    
-    //Get the data for per bit handling
-    pixeldata = icon[idx];
-    
-    //Copy a single line to the destination buffer
-    for(pixel=0;pixel<width;)
+    //When a gradient is used take the color for this line from it
+    if(gradient)
     {
-      //Select the pixel to check
-      pixeldata <<= 1;
-      
-      //Copy one pixel at a time with a check on being on
-      if(pixeldata & 0x0100)
-      {
-        //When on use the foreground gradient
-        ptr[pixel] = displaydata.ygradient[ypos+line];
-      }
-      
-      //Select next pixel
-      pixel++;
-      
-      //Check if pixel on multiple of 8 for next byte select
-      if((pixel & 0x07) == 0)
+      color = gradient[ypos + line];
+    }
+
+    //Handle the bytes of this line
+    for(pixel=0;pixel<bytes;pixel++)
+    {
+      //Get the data for the next eight pixels
+      pixeldata = icon[pixel];
+
+      //Only the pixels that are on are drawn, so skip empty bytes completely
+      if(pixeldata)
       {
-        //Point to the next byte
-        idx++;
-    
-        //And get the data for it
-        pixeldata = icon[idx];
+        //Mask of the pixels that are not on the screen for a partial last byte
+        if(((pixel + 1) << 3) > width)
+        {
+          pixeldata &= 0xFF00 >> (width & 7);
+        }
+
+        //Point to the first pixel of this byte
+        dptr = &ptr[pixel << 3];
+
+        //Fill in the pixels that are on until no more bits are set
+        while(pixeldata & 0xFF)
+        {
+          //Check if the current pixel is on
+          if(pixeldata & 0x80)
+          {
+            //Use the foreground color when on
+            *dptr = color;
+          }
+
+          //Select the next pixel
+          pixeldata <<= 1;
+          dptr++;
+        }
       }
     }
 
-    //Point to the next line of pixels in the destination
+    //Point to the next line of pixels in the icon and the destination
+    icon += bytesperrow;
     ptr += pixels;
   }
 }
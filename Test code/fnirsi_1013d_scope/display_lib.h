@@ -13,9 +13,17 @@
 #define DISPLAY_DRAW_CLOCK_WISE             0
 #define DISPLAY_DRAW_COUNTER_CLOCK_WISE     1
 
+//Cohen-Sutherland out codes for the line clipping
+#define DISPLAY_CLIP_INSIDE                 0x00
+#define DISPLAY_CLIP_LEFT                   0x01
+#define DISPLAY_CLIP_RIGHT                  0x02
+#define DISPLAY_CLIP_TOP                    0x04
+#define DISPLAY_CLIP_BOTTOM                 0x08
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
-typedef struct tagDisplayData   DISPLAYDATA,  *PDISPLAYDATA;
+typedef struct tagDisplayData     DISPLAYDATA,    *PDISPLAYDATA;
+typedef struct tagDisplayPoints   DISPLAYPOINTS,  *PDISPLAYPOINTS;
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -35,6 +43,18 @@ struct tagDisplayData
   uint32     width;
   uint32     height;
   uint32     pixelsperline;
+  int32      clipxmin;             //Window the trace line functions clip against
+  int32      clipymin;
+  int32      clipxmax;
+  int32      clipymax;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagDisplayPoints
+{
+  uint16 x;
+  uint16 y;  
 };
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -47,6 +67,7 @@ void display_set_bg_color(uint32 color);
 void display_set_screen_buffer(uint16 *buffer);
 void display_set_source_buffer(uint16 *buffer);
 void display_set_destination_buffer(uint16 *buffer);
+void display_set_clip_window(uint32 xpos, uint32 ypos, uint32 width, uint32 height);
 
 void display_save_screen_buffer(void);
 void display_restore_screen_buffer(void);
@@ -68,9 +89,19 @@ void display_draw_arc(uint32 xpos, uint32 ypos, uint32 radius, uint32 startangle
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void display_draw_trace_line(uint32 xstart, uint32 ystart, uint32 xend, uint32 yend);
+void display_draw_trace_polyline(PDISPLAYPOINTS points, uint32 count);
+
+uint32 display_clip_line(int32 *xstart, int32 *ystart, int32 *xend, int32 *yend);
+uint32 display_get_clip_code(int32 x, int32 y);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void display_fill_rect(uint32 xpos, uint32 ypos, uint32 width, uint32 height);
 void display_fill_rounded_rect(uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint32 radius);
 
+void display_fill_pixels(uint16 *ptr, uint32 color, uint32 count);
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void display_slide_top_rect_onto_screen(uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint32 speed);
@@ -82,11 +113,22 @@ void display_slide_right_rect_onto_screen(uint32 xpos, uint32 ypos, uint32 width
 void display_copy_rect_from_screen(uint32 xpos, uint32 ypos, uint32 width, uint32 height);
 void display_copy_rect_to_screen(uint32 xpos, uint32 ypos, uint32 width, uint32 height);
 
+void display_scroll_rect_left(uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint32 distance);
+
+uint32 display_clip_rect(uint32 xpos, uint32 ypos, uint32 *width, uint32 *height);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void display_accumulate_hits(uint8 *hits, uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint32 increment);
+void display_decay_hits(uint8 *hits, uint32 count, uint32 shift);
+void display_copy_hits_to_screen(uint8 *hits, uint16 *colors, uint32 xpos, uint32 ypos, uint32 width, uint32 height);
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void display_copy_icon_use_colors(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height);
 void display_copy_icon_fg_color(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height);
 void display_copy_icon_fg_color_y_gradient(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height);
+void display_copy_icon_fg_color_lines(const uint8 *icon, uint32 xpos, uint32 ypos, uint32 width, uint32 height, uint16 *gradient);
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -96,6 +138,7 @@ void display_top_pointer(uint32 xpos, uint32 ypos, int8 id);
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+uint8 printhexnibble(uint8 nibble);
 void display_hex(uint32 xpos, uint32 ypos, uint32 digits, int32 value);
 void display_decimal(uint32 xpos, uint32 ypos, int32 value);
 void display_character(uint32 xpos, uint32 ypos, int8 text);
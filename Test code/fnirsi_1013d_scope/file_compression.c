@@ -0,0 +1,495 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Compression for the picture and waveform files
+//
+//Pictures are run length coded on 16 bit pixels. Most of the screen is made of just a few colors, so the color of a run is taken
+//from a palette that is build up while coding. A token byte holds the palette index in the lower six bits and the size of the run
+//length field in the upper two bits. Index 63 signals a new color that follows the token and is added to the palette, replacing
+//the entries in a round robin fashion.
+//
+//Waveform samples are coded as the difference with the previous sample, mapped to an unsigned value (zigzag) and rice coded. For
+//every block of 32 samples the rice parameter giving the smallest size is selected and stored in front of the block.
+//
+//The functions only work on memory buffers, so they are also used by the host side converter.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "file_compression.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void picture_compress_init(PPALETTECONTEXT context)
+{
+  uint32 index;
+
+  //Both the coder and the decoder start with an all black palette
+  for(index=0;index<COMPRESSION_PALETTE_SIZE;index++)
+  {
+    context->colors[index] = 0;
+  }
+
+  //Start replacing from the first entry
+  context->next = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Code pixels until the source is done or the buffer is full. Returns the number of bytes in the buffer and the source pointer is
+//moved to the first pixel not coded yet
+
+uint32 picture_compress_block(PPALETTECONTEXT context, uint16 **source, uint16 *end, uint8 *buffer, uint32 size)
+{
+  register uint16 *sptr = *source;
+  register uint16 *rptr;
+  register uint16 *rend;
+  register uint32  color;
+  register uint32  run;
+  register uint32  index = 0;
+  register uint32  entry;
+  register uint32  token;
+
+  //Code runs while there is room for the largest token
+  while((sptr < end) && ((index + COMPRESSION_MAX_TOKEN_SIZE) <= size))
+  {
+    //Get the color of this run
+    color = *sptr;
+
+    //Limit the run to what fits in the largest run length field
+    rend = sptr + 0x01000001;
+
+    if((rend > end) || (rend < sptr))
+    {
+      rend = end;
+    }
+
+    //Find the end of the run
+    rptr = sptr + 1;
+
+    while((rptr < rend) && (*rptr == color))
+    {
+      rptr++;
+    }
+
+    //Get the length and skip the pixels
+    run = rptr - sptr;
+    sptr = rptr;
+
+    //Look for the color in the palette
+    for(entry=0;entry<COMPRESSION_PALETTE_SIZE;entry++)
+    {
+      if(context->colors[entry] == color)
+      {
+        break;
+      }
+    }
+
+    //When not found the entry equals the new color index
+    token = entry;
+
+    //Select the size of the run length field. A single pixel does not need one, and for longer runs the minimum of two is taken off
+    if(run == 1)
+    {
+      token |= COMPRESSION_RUN_SINGLE;
+    }
+    else if((run - 2) < 0x100)
+    {
+      token |= COMPRESSION_RUN_BYTE;
+    }
+    else if((run - 2) < 0x10000)
+    {
+      token |= COMPRESSION_RUN_WORD;
+    }
+    else
+    {
+      token |= COMPRESSION_RUN_LONG;
+    }
+
+    buffer[index++] = token;
+
+    //A new color follows the token and replaces the oldest added palette entry
+    if(entry == COMPRESSION_NEW_COLOR)
+    {
+      buffer[index++] = color;
+      buffer[index++] = color >> 8;
+
+      context->colors[context->next] = color;
+
+      context->next++;
+
+      if(context->next >= COMPRESSION_PALETTE_SIZE)
+      {
+        context->next = 0;
+      }
+    }
+
+    //Add the run length bytes when needed
+    if(run > 1)
+    {
+      run -= 2;
+
+      buffer[index++] = run;
+
+      if((token & COMPRESSION_RUN_MASK) != COMPRESSION_RUN_BYTE)
+      {
+        buffer[index++] = run >> 8;
+
+        if((token & COMPRESSION_RUN_MASK) == COMPRESSION_RUN_LONG)
+        {
+          buffer[index++] = run >> 16;
+        }
+      }
+    }
+  }
+
+  //Signal where to continue
+  *source = sptr;
+
+  return(index);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Decode a block of coded bytes to the destination. The destination pointer is moved beyond the decoded pixels. Returns -1 when the
+//data is not valid
+
+int32 picture_decompress_block(PPALETTECONTEXT context, uint8 *buffer, uint32 size, uint16 **dest, uint16 *end)
+{
+  register uint16 *dptr = *dest;
+  register uint32  index = 0;
+  register uint32  token;
+  register uint32  color;
+  register uint32  run;
+
+  //Decode all the tokens in the block
+  while(index < size)
+  {
+    //Get the token
+    token = buffer[index++];
+
+    //Check if a new color follows
+    if((token & COMPRESSION_INDEX_MASK) == COMPRESSION_NEW_COLOR)
+    {
+      //Make sure the color is there
+      if((index + 2) > size)
+      {
+        return(-1);
+      }
+
+      color = buffer[index] | (buffer[index + 1] << 8);
+      index += 2;
+
+      //Keep the palette the same as the coder did
+      context->colors[context->next] = color;
+
+      context->next++;
+
+      if(context->next >= COMPRESSION_PALETTE_SIZE)
+      {
+        context->next = 0;
+      }
+    }
+    else
+    {
+      //Take the color from the palette
+      color = context->colors[token & COMPRESSION_INDEX_MASK];
+    }
+
+    //Get the run length based on the size of the field
+    switch(token & COMPRESSION_RUN_MASK)
+    {
+      case COMPRESSION_RUN_SINGLE:
+        run = 1;
+        break;
+
+      case COMPRESSION_RUN_BYTE:
+        if((index + 1) > size)
+        {
+          return(-1);
+        }
+
+        run = buffer[index] + 2;
+        index += 1;
+        break;
+
+      case COMPRESSION_RUN_WORD:
+        if((index + 2) > size)
+        {
+          return(-1);
+        }
+
+        run = (buffer[index] | (buffer[index + 1] << 8)) + 2;
+        index += 2;
+        break;
+
+      default:
+        if((index + 3) > size)
+        {
+          return(-1);
+        }
+
+        run = (buffer[index] | (buffer[index + 1] << 8) | (buffer[index + 2] << 16)) + 2;
+        index += 3;
+        break;
+    }
+
+    //The run may not go beyond the destination
+    if(run > (uint32)(end - dptr))
+    {
+      return(-1);
+    }
+
+    //Fill in the pixels
+    while(run--)
+    {
+      *dptr++ = color;
+    }
+  }
+
+  //Signal where to continue
+  *dest = dptr;
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Code the samples into the buffer. Returns the number of bytes used or 0 when the buffer is too small
+
+uint32 waveform_compress(uint8 *source, uint32 count, uint8 *buffer, uint32 size)
+{
+  BITSTREAM stream;
+  uint8     values[COMPRESSION_RICE_BLOCK];
+  uint32    previous = 0x80;
+  uint32    index;
+  uint32    samples;
+  uint32    sample;
+  uint32    value;
+  uint32    k;
+  uint32    bestk;
+  uint32    cost;
+  uint32    bestcost;
+  uint32    q;
+  int32     delta;
+
+  //Setup for writing bits to the buffer
+  stream.buffer = buffer;
+  stream.size   = size;
+  stream.index  = 0;
+  stream.bits   = 0;
+  stream.count  = 0;
+
+  //Process the samples in blocks
+  for(index=0;index<count;index+=COMPRESSION_RICE_BLOCK)
+  {
+    //The last block can be shorter
+    samples = count - index;
+
+    if(samples > COMPRESSION_RICE_BLOCK)
+    {
+      samples = COMPRESSION_RICE_BLOCK;
+    }
+
+    //Map the differences with the previous sample to unsigned values with the small differences first
+    for(sample=0;sample<samples;sample++)
+    {
+      delta = ((source[index + sample] - previous + 128) & 0xFF) - 128;
+      previous = source[index + sample];
+
+      values[sample] = ((delta << 1) ^ (delta >> 31)) & 0xFF;
+    }
+
+    //Find the rice parameter giving the least bits for this block
+    bestk = 0;
+    bestcost = 0xFFFFFFFF;
+
+    for(k=0;k<=COMPRESSION_RICE_MAX_K;k++)
+    {
+      for(sample=0,cost=0;sample<samples;sample++)
+      {
+        q = values[sample] >> k;
+
+        if(q < COMPRESSION_RICE_ESCAPE)
+        {
+          cost += q + 1 + k;
+        }
+        else
+        {
+          cost += COMPRESSION_RICE_ESCAPE + 8;
+        }
+      }
+
+      if(cost < bestcost)
+      {
+        bestcost = cost;
+        bestk = k;
+      }
+    }
+
+    //Store the parameter for the block
+    if(compression_put_bits(&stream, bestk, COMPRESSION_RICE_K_BITS) == 0)
+    {
+      return(0);
+    }
+
+    //Code the values
+    for(sample=0;sample<samples;sample++)
+    {
+      value = values[sample];
+      q = value >> bestk;
+
+      if(q < COMPRESSION_RICE_ESCAPE)
+      {
+        //Quotient in unary, ones closed with a zero, followed by the remainder
+        if((compression_put_bits(&stream, (1 << q) - 1, q + 1) == 0) || (compression_put_bits(&stream, value & ((1 << bestk) - 1), bestk) == 0))
+        {
+          return(0);
+        }
+      }
+      else
+      {
+        //Too big so the escape code followed by the value as is
+        if((compression_put_bits(&stream, (1 << COMPRESSION_RICE_ESCAPE) - 1, COMPRESSION_RICE_ESCAPE) == 0) || (compression_put_bits(&stream, value, 8) == 0))
+        {
+          return(0);
+        }
+      }
+    }
+  }
+
+  //Pad the last byte with zeros
+  if(compression_put_bits(&stream, 0, 7) == 0)
+  {
+    return(0);
+  }
+
+  return(stream.index);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Decode the samples from the buffer. Returns the number of bytes used or -1 when the data is not valid
+
+int32 waveform_decompress(uint8 *buffer, uint32 size, uint8 *dest, uint32 count)
+{
+  BITSTREAM stream;
+  uint32    previous = 0x80;
+  uint32    index;
+  uint32    q;
+  int32     k = 0;
+  int32     bit;
+  int32     value;
+
+  //Setup for reading bits from the buffer
+  stream.buffer = buffer;
+  stream.size   = size;
+  stream.index  = 0;
+  stream.bits   = 0;
+  stream.count  = 0;
+
+  //Process all the samples
+  for(index=0;index<count;index++)
+  {
+    //Get the rice parameter at the start of each block
+    if((index % COMPRESSION_RICE_BLOCK) == 0)
+    {
+      if((k = compression_get_bits(&stream, COMPRESSION_RICE_K_BITS)) < 0)
+      {
+        return(-1);
+      }
+    }
+
+    //Count the ones of the quotient
+    for(q=0;q<COMPRESSION_RICE_ESCAPE;q++)
+    {
+      if((bit = compression_get_bits(&stream, 1)) < 0)
+      {
+        return(-1);
+      }
+
+      if(bit == 0)
+      {
+        break;
+      }
+    }
+
+    //On the escape code the value follows as is, otherwise add in the remainder
+    if(q == COMPRESSION_RICE_ESCAPE)
+    {
+      value = compression_get_bits(&stream, 8);
+    }
+    else
+    {
+      value = compression_get_bits(&stream, k);
+
+      if(value >= 0)
+      {
+        value |= q << k;
+      }
+    }
+
+    if(value < 0)
+    {
+      return(-1);
+    }
+
+    //Undo the zigzag mapping and add the difference to the previous sample
+    previous = (previous + ((value >> 1) ^ -(value & 1))) & 0xFF;
+
+    dest[index] = previous;
+  }
+
+  //All the read bytes are used by the coded data, since the coder only padded the last byte
+  return(stream.index);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Add the given number of bits to the stream, least significant bit first. Up to 24 bits can be written at a time
+
+uint32 compression_put_bits(PBITSTREAM stream, uint32 value, uint32 count)
+{
+  //Add the bits above the ones still waiting
+  stream->bits |= value << stream->count;
+  stream->count += count;
+
+  //Write out the full bytes
+  while(stream->count >= 8)
+  {
+    //Check if there is room for it
+    if(stream->index >= stream->size)
+    {
+      return(0);
+    }
+
+    stream->buffer[stream->index++] = stream->bits;
+
+    stream->bits >>= 8;
+    stream->count -= 8;
+  }
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Get the given number of bits from the stream. Up to 16 bits can be read at a time. Returns -1 when there is no more data
+
+int32 compression_get_bits(PBITSTREAM stream, uint32 count)
+{
+  int32 value;
+
+  //Load bytes until there are enough bits
+  while(stream->count < count)
+  {
+    //Check if there is data left
+    if(stream->index >= stream->size)
+    {
+      return(-1);
+    }
+
+    stream->bits |= stream->buffer[stream->index++] << stream->count;
+    stream->count += 8;
+  }
+
+  //Take the bits off
+  value = stream->bits & ((1 << count) - 1);
+
+  stream->bits >>= count;
+  stream->count -= count;
+
+  return(value);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef FILE_COMPRESSION_H
+#define FILE_COMPRESSION_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "types.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Picture run length coding with a color palette that is build up on the fly
+#define COMPRESSION_PALETTE_SIZE        63
+#define COMPRESSION_NEW_COLOR           63
+
+#define COMPRESSION_RUN_SINGLE        0x00
+#define COMPRESSION_RUN_BYTE          0x40
+#define COMPRESSION_RUN_WORD          0x80
+#define COMPRESSION_RUN_LONG          0xC0
+
+#define COMPRESSION_RUN_MASK          0xC0
+#define COMPRESSION_INDEX_MASK        0x3F
+
+//Largest token is the token byte, a new color and a three byte run length
+#define COMPRESSION_MAX_TOKEN_SIZE       6
+
+//Maximum number of coded bytes in a picture block. Each block is preceded by its 16 bit length in the file
+#define COMPRESSION_BLOCK_SIZE        4096
+
+//Waveform delta and rice coding
+#define COMPRESSION_RICE_BLOCK          32
+#define COMPRESSION_RICE_K_BITS          3
+#define COMPRESSION_RICE_MAX_K           7
+#define COMPRESSION_RICE_ESCAPE         15
+
+//Size of the buffer for coding. Fits a picture block and the worst case coded sample data of both channels
+#define COMPRESSION_BUFFER_SIZE       8192
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct tagPaletteContext      PALETTECONTEXT,   *PPALETTECONTEXT;
+typedef struct tagBitStream           BITSTREAM,        *PBITSTREAM;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagPaletteContext
+{
+  uint16 colors[COMPRESSION_PALETTE_SIZE];
+  uint32 next;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagBitStream
+{
+  uint8  *buffer;
+  uint32  size;
+  uint32  index;
+  uint32  bits;
+  uint32  count;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void picture_compress_init(PPALETTECONTEXT context);
+
+uint32 picture_compress_block(PPALETTECONTEXT context, uint16 **source, uint16 *end, uint8 *buffer, uint32 size);
+int32 picture_decompress_block(PPALETTECONTEXT context, uint8 *buffer, uint32 size, uint16 **dest, uint16 *end);
+
+uint32 waveform_compress(uint8 *source, uint32 count, uint8 *buffer, uint32 size);
+int32 waveform_decompress(uint8 *buffer, uint32 size, uint8 *dest, uint32 count);
+
+uint32 compression_put_bits(PBITSTREAM stream, uint32 value, uint32 count);
+int32 compression_get_bits(PBITSTREAM stream, uint32 count);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* FILE_COMPRESSION_H */
+
@@ -23,6 +23,9 @@
 
 #include "arm32.h"
 
+#include "memory_pools.h"
+#include "mmu_control.h"
+
 #include "variables.h"
 
 #include <string.h>
@@ -38,10 +41,16 @@ int main(void)
   //Initialize data in BSS section
   memset(&BSS_START, 0, &BSS_END - &BSS_START);
 
+  //Setup the heap and the buffer pools on the free DRAM
+  memory_init();
+
   //Initialize the clock system
   sys_clock_init();
 
-  //Instead of full memory management just the caches enabled
+  //Map the memory with the cache attributes, so the data cache is actually used for the DRAM
+  mmu_init();
+
+  //Enable the caches
   arm32_icache_enable();
   arm32_dcache_enable();
 
@@ -111,6 +120,9 @@ int main(void)
   //Load configuration data from FLASH
   scope_load_configuration_data();
 
+  //Collect the setup writes so they are sent to the FPGA in one go
+  fpga_batch_begin();
+
   //Enable or disable the channels based on the scope loaded settings
   fpga_set_channel_enable(&scopesettings.channel1);
   fpga_set_channel_enable(&scopesettings.channel2);
@@ -138,6 +150,9 @@ int main(void)
   fpga_set_channel_offset(&scopesettings.channel1);
   fpga_set_channel_offset(&scopesettings.channel2);
 
+  //Send what is left of the setup
+  fpga_batch_end();
+
   //Some initialization of the FPGA??. Data written with command 0x3C
   fpga_set_battery_level();      //Only called here and in hardware check
 
@@ -146,18 +161,29 @@ int main(void)
 
   //Set screen brightness
   fpga_set_translated_brightness();
+
+#ifdef MMU_TIMING
+  //Show how long trace displaying takes with and without the cached memory setup, and redraw the screen after it
+  scope_show_mmu_timing();
+  scope_setup_main_screen();
+#endif
   
   //Monitor the battery, process and display trace data and handle user input until power is switched off
   while(1)
   {
+    //Scratch memory from the previous loop is no longer needed
+    memory_frame_reset();
+
     //Monitor the battery status
     battery_check_status();
 
     //Go through the trace data and make it ready for displaying
     scope_acquire_trace_data();
 
-    //Display the trace data
+    //Display the trace data. The FPGA bus is not used for this, so the timer interrupt can watch the pending conversion meanwhile
+    scope_watch_conversion(1);
     scope_display_trace_data();
+    scope_watch_conversion(0);
 
     //Handle the touch panel input
     touch_handler();
@@ -14,6 +14,119 @@
 
 #define SCREEN_SIZE     (SCREEN_WIDTH * SCREEN_HEIGHT)
 
+//Part of the screen used for displaying the traces
+#define TRACE_WINDOW_XPOS       2
+#define TRACE_WINDOW_YPOS      46
+#define TRACE_WINDOW_WIDTH    728
+#define TRACE_WINDOW_HEIGHT   434
+
+//Number of ADC counts the signal needs to be on the other side of the trigger level before a new crossing is accepted
+#define TRIGGER_HYSTERESIS              3
+
+//Persistence mode intensity added for every frame a pixel is hit, and the limit on the number of frames between decays
+#define PERSISTENCE_INCREMENT         0x20
+#define PERSISTENCE_MAX_DECAY_FRAMES   100
+
+//Number of frames between decays used when persistence is switched on from the system settings menu
+#define PERSISTENCE_DECAY_FRAMES         8
+
+//A stopped trace can be panned through the sample buffer, keeping at least this many pixels of it on the screen. The range of the
+//trace in pixels is limited to stay well within 32 bits when zoomed in far
+#define ZOOM_MIN_VISIBLE                50
+#define ZOOM_MAX_XRANGE            1000000.0
+
+//Point on the screen that is kept on the same part of the signal when the time per div setting changes on a panned trace
+#define ZOOM_CENTER_XPOS               364
+
+//Slowest time base settings (200mS/div, 100mS/div and 50mS/div) are shown in roll mode, one sample per screen column
+#define ROLL_MODE_TIME_PER_DIV           2
+#define ROLL_MODE_XSTART                 3
+#define ROLL_MODE_XEND                 725
+#define ROLL_MODE_SAMPLES              (ROLL_MODE_XEND - ROLL_MODE_XSTART + 1)
+
+//Number of samples the FPGA returns per channel for a roll mode read
+#define ROLL_BLOCK_SAMPLES              10
+
+//Acquisition modes. Averaging is done over 2^averageshift acquisitions, so from 2 up to 256
+#define ACQUISITION_MODE_NORMAL          0
+#define ACQUISITION_MODE_AVERAGE         1
+#define ACQUISITION_MODE_EXP_AVERAGE     2
+#define ACQUISITION_MODE_HIGH_RES        3
+#define ACQUISITION_MODE_SEGMENTED       4
+
+#define ACQUISITION_MAX_AVERAGE_SHIFT    8
+
+//Largest number of samples combined into one in high resolution mode
+#define HIGH_RES_MAX_WINDOW            256
+
+//Segmented capture uses short records, which keeps the FPGA read out and with that the time between captures short. The number of
+//segments is 16 << averageshift, so from 32 up to 4096
+#define SEGMENT_SAMPLES                750
+#define SEGMENT_NOF_SAMPLES            (SEGMENT_SAMPLES / 2)
+#define SEGMENT_COUNT_SHIFT              4
+
+//The ring is made of blocks from the sample buffer pool, each holding a few segments
+#define SEGMENTS_PER_BLOCK               4
+#define SEGMENT_MAX_COUNT             4096
+#define SEGMENT_MAX_BLOCKS             (SEGMENT_MAX_COUNT / SEGMENTS_PER_BLOCK)
+
+//Time in mS to wait for a next trigger before the screen is updated, so bursts of triggers are captured back to back
+#define SEGMENT_BURST_TIME              20
+//Time in mS a burst of segment captures may take before the display and touch panel get a turn
+#define SEGMENT_PASS_TIME               50
+
+//Number of trace displays timed per cache setting when build with MMU_TIMING
+#define MMU_TIMING_PASSES               50
+
+//The FPGA setting commands are all below 0x40, and are kept in a shadow copy to skip writes that do not change anything
+#define FPGA_SHADOW_SIZE              0x40
+
+//Number of setting writes that can be collected before they are sent to the FPGA
+#define FPGA_BATCH_SIZE                 16
+
+//Largest number of samples read from a single ADC in one go
+#define ADC_MAX_SAMPLES               1500
+
+//Auto setup starts with 2MSa/s (step 1 of samplerate_for_autosetup) on 500mV/div. Every conversion gives the sample rate for the
+//next one, and ranges both channels at once
+#define AUTOSET_START_STEP               1
+#define AUTOSET_START_VOLT_PER_DIV       3
+#define AUTOSET_MAX_CONVERSIONS          3
+
+//Peak peak ADC counts needed to trust the lack of a frequency reading
+#define AUTOSET_MIN_SIGNAL               8
+
+//Slowest sample rate (20KSa/s) a time base estimate is checked on. Conversions on the slower ones take too long
+#define AUTOSET_SLOWEST_CHECK_RATE      12
+
+//Math channel modes. The two channel modes need both channels enabled, the others work on channel 1
+#define MATH_MODE_OFF                    0
+#define MATH_MODE_ADD                    1
+#define MATH_MODE_SUBTRACT               2
+#define MATH_MODE_MULTIPLY               3
+#define MATH_MODE_INTEGRATE              4
+#define MATH_MODE_DIFFERENTIATE          5
+
+#define MATH_MODE_MAX                    MATH_MODE_DIFFERENTIATE
+
+//The ratio between the channel gains is kept with 16 fraction bits. A sum or difference is stored at half the channel 1 scale and the
+//product of two channel 1 scale samples is brought back to 8 bits with the multiply shift
+#define MATH_GAIN_SHIFT                 16
+#define MATH_ADD_SHIFT                   1
+#define MATH_MULTIPLY_SHIFT              7
+
+//The integral and the difference are shown on a fixed scale, so the trace does not change size with the signal. The integral is kept
+//with 8 fraction bits and is divided by 2^(MATH_INTEGRATE_SHIFT - 8), the difference is multiplied by 2^MATH_DIFFERENTIATE_SHIFT.
+//Both work per sample, so the factor is shown as per sample next to the math channel pointer
+#define MATH_MAX_SAMPLE                127
+#define MATH_INTEGRATE_SHIFT            14
+#define MATH_DIFFERENTIATE_SHIFT         4
+
+//The decoded bytes are shown as hexadecimal labels along the bottom of the trace window
+#define DECODER_LABEL_YPOS             430
+#define DECODER_LABEL_WIDTH             20
+#define DECODER_LABEL_HEIGHT            16
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 #define CHANNEL1_COLOR         0x00FFFF00
@@ -25,6 +138,12 @@
 
 #define XYMODE_COLOR           0x00FF00FF
 
+#define MATH_COLOR             0x00FF5050
+
+#define DECODER_COLOR          0x00C0C0C0
+#define DECODER_ADDRESS_COLOR  0x00FFA040
+#define DECODER_ERROR_COLOR    0x00FF0000
+
 #define CURSORS_COLOR          0x0000AA11
 
 #define ITEM_ACTIVE_COLOR      0x00EF9311
@@ -41,6 +160,7 @@
 #define TOUCH_STATE_MOVE_TIME_CURSOR_RIGHT   0x07
 #define TOUCH_STATE_MOVE_VOLT_CURSOR_TOP     0x08
 #define TOUCH_STATE_MOVE_VOLT_CURSOR_BOTTOM  0x09
+#define TOUCH_STATE_MOVE_MATH_CHANNEL        0x0A
 
 #define TOUCH_STATE_MASK                     0x0F
 
@@ -10,17 +10,39 @@
 
 void fpga_init(void)
 {
+  uint32 index;
+
   //First set pin high in data register to avoid spikes when changing from input to output
   FPGA_CLK_INIT();
   
   //Initialize the three control lines for output
   FPGA_CTRL_INIT();
+
+  //Nothing is known about the FPGA settings yet, so the first write of each one has to go through
+  fpga_invalidate_shadow();
+
+  fpgabatchcount = 0;
+  fpgabatchopen  = 0;
+
+  //Setup the table for compensating and limiting the ADC samples. Zero below the range, 255 above it and one to one in between
+  for(index=0;index<256;index++)
+  {
+    adcclamptable[index]       = 0;
+    adcclamptable[index + 256] = index;
+    adcclamptable[index + 512] = 255;
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void fpga_write_cmd(uint8 command)
 {
+  //Any collected setting writes need to go out before this command
+  if(fpgabatchcount)
+  {
+    fpga_batch_flush();
+  }
+
   //Set the control lines for writing a command
   FPGA_CMD_WRITE();
 
@@ -171,12 +193,148 @@ void fpga_write_int(uint32 data)
   FPGA_PULSE_CLK();
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//The settings written to the FPGA are kept in a shadow copy, so a write of a value the FPGA already holds can be skipped.
+//Between fpga_batch_begin and fpga_batch_end the writes are collected and sent in one go, with the bus direction set only once.
+
+void fpga_write_setting(uint8 command, uint32 size, uint32 data)
+{
+  //Only commands within the shadow range are cached
+  if(command < FPGA_SHADOW_SIZE)
+  {
+    //Skip the write when the FPGA already has this value
+    if(fpgashadowvalid[command] && (fpgashadowdata[command] == data))
+    {
+      return;
+    }
+
+    //Keep the new value
+    fpgashadowdata[command]  = data;
+    fpgashadowvalid[command] = 1;
+  }
+
+  //Signal a pending conversion it was started with different settings
+  fpgasettingschanges++;
+
+  //Check if the writes are being collected
+  if(fpgabatchopen)
+  {
+    //Send the collected writes when the batch is full
+    if(fpgabatchcount >= FPGA_BATCH_SIZE)
+    {
+      fpga_batch_flush();
+    }
+
+    //Add this write to the batch
+    fpgabatch[fpgabatchcount].command = command;
+    fpgabatch[fpgabatchcount].size    = size;
+    fpgabatch[fpgabatchcount].data    = data;
+
+    fpgabatchcount++;
+  }
+  else
+  {
+    //Write the command and the data directly
+    fpga_write_cmd(command);
+
+    switch(size)
+    {
+      case 1:
+        fpga_write_byte(data);
+        break;
+
+      case 2:
+        fpga_write_short(data);
+        break;
+
+      default:
+        fpga_write_int(data);
+        break;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void fpga_batch_begin(void)
+{
+  //Start collecting the setting writes
+  fpgabatchopen = 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void fpga_batch_end(void)
+{
+  //Send what has been collected and go back to direct writing
+  fpga_batch_flush();
+
+  fpgabatchopen = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void fpga_batch_flush(void)
+{
+  PFPGABATCHENTRY entry = fpgabatch;
+  PFPGABATCHENTRY end   = &fpgabatch[fpgabatchcount];
+  uint32 shift;
+
+  //Clear the count first, since fpga_write_cmd checks on it to keep the writes in order
+  fpgabatchcount = 0;
+
+  //Nothing to do when the batch is empty
+  if(entry == end)
+  {
+    return;
+  }
+
+  //Set the bus for writing only once for the whole batch
+  FPGA_BUS_DIR_OUT();
+
+  while(entry < end)
+  {
+    //Set the control lines for writing a command and clock it into the FPGA
+    FPGA_CMD_WRITE();
+    FPGA_SET_DATA(entry->command);
+    FPGA_PULSE_CLK();
+
+    //Set the control lines for writing data
+    FPGA_DATA_WRITE();
+
+    //Clock the data bytes into the FPGA, msb first
+    shift = entry->size * 8;
+
+    while(shift)
+    {
+      shift -= 8;
+
+      FPGA_SET_DATA(entry->data >> shift);
+      FPGA_PULSE_CLK();
+    }
+
+    entry++;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void fpga_invalidate_shadow(void)
+{
+  uint32 index;
+
+  //Force the next write of every setting to go to the FPGA
+  for(index=0;index<FPGA_SHADOW_SIZE;index++)
+  {
+    fpgashadowvalid[index] = 0;
+  }
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void fpga_set_backlight_brightness(uint16 brightness)
 {
-  fpga_write_cmd(0x38);
-  fpga_write_short(brightness);
+  fpga_write_setting(0x38, 2, brightness);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -232,19 +390,16 @@ void fpga_enable_system(void)
 
 void fpga_set_channel_enable(PCHANNELSETTINGS settings)
 {
-  //Send the command for channel enable to the FPGA
-  fpga_write_cmd(settings->enablecommand);
-  
   //Write the needed data based on the setting
   if(settings->enable == 0)
   {
     //Disable the channel
-    fpga_write_byte(0x00);
+    fpga_write_setting(settings->enablecommand, 1, 0x00);
   }
   else
   {
     //Enable the channel
-    fpga_write_byte(0x01);
+    fpga_write_setting(settings->enablecommand, 1, 0x01);
   }
 }
 
@@ -252,19 +407,16 @@ void fpga_set_channel_enable(PCHANNELSETTINGS settings)
 
 void fpga_set_channel_coupling(PCHANNELSETTINGS settings)
 {
-  //Send the command for channel 1 coupling to the FPGA
-  fpga_write_cmd(settings->couplingcommand);
-  
   //Write the needed data based on the setting
   if(settings->coupling == 0)
   {
     //Set the DC coupling for the channel
-    fpga_write_byte(0x01);
+    fpga_write_setting(settings->couplingcommand, 1, 0x01);
   }
   else
   {
     //Set the AC coupling for the channel
-    fpga_write_byte(0x00);
+    fpga_write_setting(settings->couplingcommand, 1, 0x00);
   }
 }
 
@@ -274,26 +426,20 @@ void fpga_set_channel_voltperdiv(PCHANNELSETTINGS settings)
 {
   register uint32 setting = settings->voltperdiv;
   
-  //Send the command for channel 1 volts per div to the FPGA
-  fpga_write_cmd(settings->voltperdivcommand);
-  
   //Check if setting in range of what is allowed
   if(setting > 5)
     setting = 5;
   
   //Write it to the FPGA
-  fpga_write_byte(setting);
+  fpga_write_setting(settings->voltperdivcommand, 1, setting);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void fpga_set_channel_offset(PCHANNELSETTINGS settings)
 {
-  //Send the command for channel DC offset to the FPGA
-  fpga_write_cmd(settings->offsetcommand);
-
   //Write the center offset data for this channel and volt per div setting
-  fpga_write_short(settings->dc_calibration_offset[settings->voltperdiv]);
+  fpga_write_setting(settings->offsetcommand, 2, settings->dc_calibration_offset[settings->voltperdiv]);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -310,11 +456,8 @@ void fpga_set_sample_rate(uint32 samplerate)
   //Make sure the setting is in range of the table
   if(samplerate < (sizeof(sample_rate_settings) / sizeof(uint32)))
   {
-    //Write the command to the FPGA
-    fpga_write_cmd(0x0D);
-
     //Write the time base clock setting to the FPGA
-    fpga_write_int(sample_rate_settings[samplerate]);
+    fpga_write_setting(0x0D, 4, sample_rate_settings[samplerate]);
   }
 }
 
@@ -322,19 +465,16 @@ void fpga_set_sample_rate(uint32 samplerate)
 
 void fpga_set_trigger_channel(void)
 {
-  //Send the command for selecting the trigger channel to the FPGA
-  fpga_write_cmd(0x15);
-  
   //Write the needed data based on the setting
   if(scopesettings.triggerchannel == 0)
   {
     //Set channel 1 as trigger input
-    fpga_write_byte(0x00);
+    fpga_write_setting(0x15, 1, 0x00);
   }
   else
   {
     //Set channel 2 as trigger input
-    fpga_write_byte(0x01);
+    fpga_write_setting(0x15, 1, 0x01);
   }
 }
 
@@ -342,19 +482,16 @@ void fpga_set_trigger_channel(void)
 
 void fpga_set_trigger_edge(void)
 {
-  //Send the command for selecting the trigger channel to the FPGA
-  fpga_write_cmd(0x16);
-  
   //Write the needed data based on the setting
   if(scopesettings.triggeredge == 0)
   {
     //Set trigger edge to rising
-    fpga_write_byte(0x00);
+    fpga_write_setting(0x16, 1, 0x00);
   }
   else
   {
     //Set trigger edge to falling
-    fpga_write_byte(0x01);
+    fpga_write_setting(0x16, 1, 0x01);
   }
 }
 
@@ -434,30 +571,24 @@ void fpga_set_trigger_level(void)
     level = 255;
   }
   
-  //Send the command for setting the trigger level to the FPGA
-  fpga_write_cmd(0x17);
-  
   //Write the actual level to the FPGA
-  fpga_write_byte(level);
+  fpga_write_setting(0x17, 1, level);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void fpga_set_trigger_mode(void)
 {
-  //Send the command for selecting the trigger mode to the FPGA
-  fpga_write_cmd(0x1A);
-  
   //Write the needed data based on the setting
   if(scopesettings.triggermode == 0)
   {
     //Set trigger mode to auto
-    fpga_write_byte(0x00);
+    fpga_write_setting(0x1A, 1, 0x00);
   }
   else
   {
     //Set trigger mode to single or normal
-    fpga_write_byte(0x01);
+    fpga_write_setting(0x1A, 1, 0x01);
   }
 }
 
@@ -465,20 +596,89 @@ void fpga_set_trigger_mode(void)
 
 void fpga_set_time_base(uint32 timebase)
 {
-  //Write the command to set the short time base data to the FPGA
-  fpga_write_cmd(0x0E);
-  
   //Make sure setting is in range
   if(timebase < (sizeof(timebase_settings) / sizeof(uint32)))
   {
+    //Write the short time base data to the FPGA
     //Table settings ranges from setting 0 (200mS/div) to 23 (5nS/div)
-    fpga_write_int(timebase_settings[timebase]);
+    fpga_write_setting(0x0E, 4, timebase_settings[timebase]);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The original firmware uses this for the roll mode time base settings, and always writes 2000 with it
+
+void fpga_set_long_time_base(void)
+{
+  //Write the long time base data to the FPGA. This uses the same register as the sample rate
+  fpga_write_setting(0x0D, 4, 2000);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//In long time base mode the FPGA keeps sampling, and returns a block of the ten most recent samples for a channel on command
+//0x24 (channel 1) or 0x26 (channel 2). The samples are returned as read, oldest first, so the caller can spread them over the screen
+//columns that are due.
+
+void fpga_read_roll_block(uint8 command, uint8 *buffer)
+{
+  register uint32 count = ROLL_BLOCK_SAMPLES;
+
+  //Send the command for getting the sample block
+  fpga_write_cmd(command);
+
+  //Set the bus for reading
+  FPGA_BUS_DIR_IN();
+
+  //Set the control lines for reading a command
+  FPGA_DATA_READ();
+
+  //Read the data as long as there is count
+  while(count)
+  {
+    //Clock the data to the output of the FPGA
+    FPGA_PULSE_CLK();
+
+    //Read and store the data
+    *buffer++ = FPGA_GET_DATA();
+
+    //One read done
+    count--;
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void fpga_do_conversion(void)
+{
+  //This takes over the sample system, so a conversion started for the next trace is no longer valid
+  conversionpending = 0;
+
+  //Arm the sample system
+  fpga_start_conversion();
+  
+  //Check if sampling with trigger system enabled
+  if(scopesettings.samplemode == 1)
+  {
+    //Wait for the FPGA to signal triggered or touch panel is touched
+    while(((fpga_read_byte() & 1) == 0) && (havetouch == 0))
+    {
+      //Check for touch events from the touch panel interrupt
+      tp_i2c_read_status();
+    }
+  }
+  else
+  {
+    //Wait for the FPGA to signal triggered or buffer full
+    while((fpga_read_byte() & 1) == 0);
+  }
+  
+  fpga_end_conversion();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Arm the sample system without waiting for the result, so the FPGA can sample while the cpu does other work
+
+void fpga_start_conversion(void)
 {
   //Check if sampling with trigger system enabled
   if(scopesettings.samplemode == 1)
@@ -517,26 +717,30 @@ void fpga_do_conversion(void)
   
   //Send check on triggered or buffer full command to the FPGA
   fpga_write_cmd(0x0A);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Check if the armed conversion is triggered or the buffer is full. Other commands might have been send in between, so the check command
+//is send again
+
+uint32 fpga_conversion_done(void)
+{
+  fpga_write_cmd(0x0A);
   
+  return(fpga_read_byte() & 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void fpga_end_conversion(void)
+{
   //Check if sampling with trigger system enabled
   if(scopesettings.samplemode == 1)
   {
-    //Wait for the FPGA to signal triggered or touch panel is touched
-    while(((fpga_read_byte() & 1) == 0) && (havetouch == 0))
-    {
-      //Scan the touch panel
-      tp_i2c_read_status();
-    }
-    
     //Disable trigger system???
     fpga_write_cmd(0x0F);
     fpga_write_byte(0x01);
   }
-  else
-  {
-    //Wait for the FPGA to signal triggered or buffer full
-    while((fpga_read_byte() & 1) == 0);
-  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -677,12 +881,24 @@ void fpga_read_sample_data(PCHANNELSETTINGS settings, uint32 triggerpoint)
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//The FPGA is read out with nothing else in the loop, four samples packed in a word per pass. The compensation, measurements and
+//frequency determination are done on the stored samples afterwards with fpga_process_adc_data
 
 void fpga_read_adc_data(PCHANNELSETTINGS settings)
 {
-  register int32  sample;
-  register uint32 count;
-  register uint32 sum = 0;
+  register uint32 *dptr = adcrawbuffer;
+  register uint8  *bptr;
+  register uint32  data;
+  register uint32  count;
+  register uint32  loops;
+  
+  //Get the number of samples to read and keep it within the raw sample buffer
+  count = scopesettings.nofsamples;
+  
+  if(count > ADC_MAX_SAMPLES)
+  {
+    count = ADC_MAX_SAMPLES;
+  }
   
   //Set the bus for reading
   FPGA_BUS_DIR_IN();
@@ -690,170 +906,208 @@ void fpga_read_adc_data(PCHANNELSETTINGS settings)
   //Set the control lines for reading a command
   FPGA_DATA_READ();
   
-  //Set the number of samples to read
-  count = scopesettings.nofsamples;
+  //Read four samples per loop and store them as a single word, first sample in the lowest byte
+  for(loops=count>>2;loops;loops--)
+  {
+    FPGA_PULSE_CLK();
+    data = FPGA_GET_DATA();
+    
+    FPGA_PULSE_CLK();
+    data |= FPGA_GET_DATA() << 8;
+    
+    FPGA_PULSE_CLK();
+    data |= FPGA_GET_DATA() << 16;
+    
+    FPGA_PULSE_CLK();
+    data |= FPGA_GET_DATA() << 24;
+    
+    *dptr++ = data;
+  }
   
-  //Read the data as long as there is count
-  while(count)
+  //Read the samples that are left one by one
+  bptr = (uint8 *)dptr;
+  
+  for(loops=count&3;loops;loops--)
   {
-    //Clock the data to the output of the FPGA
     FPGA_PULSE_CLK();
+    *bptr++ = FPGA_GET_DATA();
+  }
+  
+  //Process the samples into the trace buffer
+  fpga_process_adc_data(settings, count);
+}
 
-    //Read the data
-    sample = FPGA_GET_DATA();
-    
-    //Sum the raw data for ADC difference calibration
-    sum += sample;
+//----------------------------------------------------------------------------------------------------------------------------------
+//Takes the raw samples from the read out and stores them compensated in every other location of the trace buffer, while doing the
+//measurements. For the second ADC the readings are matched with the ones of the first ADC where one of them is out of range, and the
+//zero crossings are counted for the frequency determination
 
-    //Compensate the value for ADC in equality
-    sample += settings->compensation;
-    
-    //Check if sample became negative
-    if(sample < 0)
+void fpga_process_adc_data(PCHANNELSETTINGS settings, uint32 count)
+{
+  register uint8  *sptr = (uint8 *)adcrawbuffer;
+  register uint8  *buffer = settings->buffer;
+  register uint8  *clamp;
+  register uint32  raw;
+  register uint32  sample;
+  register uint32  sum = 0;
+  register uint32  total = 0;
+  register uint32  min = settings->min;
+  register uint32  max = settings->max;
+  register int32   compensation = settings->compensation;
+  register int32   adc1compensation;
+  register int32   adc2compensation;
+  register uint32  highlevel;
+  register uint32  lowlevel;
+  register uint32  state;
+  register uint32  previous;
+  uint32 samplecount[2];
+  uint32 divider[2];
+  
+  //Limit the compensation to the range of the clamp table. Beyond it the results are all zero or all 255 anyway
+  if(compensation < -256)
+  {
+    compensation = -256;
+  }
+  else if(compensation > 256)
+  {
+    compensation = 256;
+  }
+  
+  //Point into the clamp table such that indexing with the raw sample gives the compensated sample limited to 0 - 255
+  clamp = &adcclamptable[256 + compensation];
+  
+  //The first ADC only needs the measurements
+  if(settings->checkfirstadc == 0)
+  {
+    while(count)
     {
-      //Keep it on zero if so
-      sample = 0;
+      //Sum the raw data for ADC difference calibration
+      raw = *sptr++;
+      sum += raw;
+      
+      //Compensate the value for ADC in equality
+      sample = clamp[raw];
+      
+      //Keep the lowest and the highest value
+      min = (sample < min) ? sample : min;
+      max = (sample > max) ? sample : max;
+      
+      //Add the samples for average calculation
+      total += sample;
+      
+      //Store the data and skip a sample to allow for ADC2 data to be placed into
+      *buffer = sample;
+      buffer += 2;
+      
+      count--;
     }
+  }
+  else
+  {
+    adc1compensation = settings->adc1compensation;
+    adc2compensation = settings->adc2compensation;
+    highlevel = settings->highlevel;
+    lowlevel  = settings->lowlevel;
+    state     = settings->state;
+    previous  = settings->previousindex;
     
-    //Check if sample over its max
-    if(sample > 255)
+    //A sample above the high level never counts as going low, which matters when the low level wrapped around below zero
+    if(lowlevel > (highlevel + 1))
     {
-      //Keep it on max if so
-      sample = 255;
+      lowlevel = highlevel + 1;
     }
     
-    //Check if busy with second ADC data
-    if(settings->checkfirstadc)
+    //The time spent in the low state is kept on index 0 and in the high state on index 1
+    samplecount[0] = settings->lowsamplecount;
+    samplecount[1] = settings->highsamplecount;
+    divider[0]     = settings->lowdivider;
+    divider[1]     = settings->highdivider;
+    
+    while(count)
     {
+      //Sum the raw data for ADC difference calibration
+      raw = *sptr++;
+      sum += raw;
+      
+      //Compensate the value for ADC in equality
+      sample = clamp[raw];
+      
       //When ADC1 compensation is positive, ADC1 bottoms out on this value
       //Near the top ADC2 reaches the top value first, so same method is needed
-      if(settings->adc1compensation > 0)
+      if(adc1compensation > 0)
       {
         //So when the compensated ADC2 sample is below the ADC1 compensation value the reading needs to be matched
-        if(sample < settings->adc1compensation)
+        if((int32)sample < adc1compensation)
         {
-          //Match the two readings when within compensation range
-          settings->buffer[1] = sample;
+          buffer[1] = sample;
         }
-        //Or when the compensated ADC1 sample is above max value ADC2 can reach the reading also needs to be matched
-        else if(settings->buffer[1] > (255 + settings->adc2compensation))
+        //Or when the compensated ADC1 sample is above max value ADC2 can reach use the ADC1 sample
+        else if(buffer[1] > (255 + adc2compensation))
         {
-          //Use the compensated ADC1 sample in that case
-          sample = settings->buffer[1];
+          sample = buffer[1];
         }
       }
       //When ADC1 compensation is negative, ADC2 bottoms out on it's compensation value
-      else if(settings->adc1compensation < 0)
+      else if(adc1compensation < 0)
       {
-        //So when the compensated ADC1 sample is below the ADC2 compensation value the reading needs to be matched
-        if(settings->buffer[1] < settings->adc2compensation)
-        {
-          //Use the compensated ADC1 sample in that case
-          sample = settings->buffer[1];
-        }
-        //Or when the compensated ADC2 sample is above max value ADC1 can reach the reading also needs to be matched
-        else if(sample > (255 + settings->adc1compensation))
+        //So when the compensated ADC1 sample is below the ADC2 compensation value use the ADC1 sample
+        if(buffer[1] < adc2compensation)
         {
-          //Match the two readings when within compensation range
-          settings->buffer[1] = sample;
+          sample = buffer[1];
         }
-      }
-    }
-    
-    //Get the minimum value of the samples
-    if(sample < settings->min)
-    {
-      //Keep the lowest
-      settings->min = sample;
-    }
-    
-    //Get the maximum value of the samples
-    if(sample > settings->max)
-    {
-      //Keep the highest
-      settings->max = sample;
-    }
-    
-    //Add the samples for average calculation
-    settings->average += sample;
-    
-    //Store the data
-    *settings->buffer = sample;
-
-    //Check if busy with second ADC data to see if frequency determination can be done
-    if(settings->checkfirstadc)
-    {
-      //Check against the high level
-      if(sample > settings->highlevel)
-      {
-        //If above, check if in low state
-        if(settings->state == 0)
+        //Or when the compensated ADC2 sample is above max value ADC1 can reach the reading needs to be matched
+        else if((int32)sample > (255 + adc1compensation))
         {
-          //If so flip the state
-          settings->state = 1;
-          
-          //Check if first zero crossing detected
-          if(settings->zerocrossings == 0)
-          {
-            //Set the previous index if so
-            settings->previousindex = count;
-          }
-          else
-          {
-            //Calculate the total number of samples in the low parts of the signal
-            settings->lowsamplecount += settings->previousindex - count;
-            
-            //Add one to the low divider for average calculation
-            settings->lowdivider++;
-            
-            //Set the new previous index
-            settings->previousindex = count;
-          }
-
-          //Found a zero crossing
-          settings->zerocrossings++;
+          buffer[1] = sample;
         }
       }
-      //Check against the low level
-      else if(sample < settings->lowlevel)
+      
+      //Keep the lowest and the highest value
+      min = (sample < min) ? sample : min;
+      max = (sample > max) ? sample : max;
+      
+      //Add the samples for average calculation
+      total += sample;
+      
+      //Store the data and skip a sample to allow for ADC2 data to be placed into
+      *buffer = sample;
+      buffer += 2;
+      
+      //A zero crossing is found when a low signal goes above the high level or a high signal goes below the low level
+      if(state ? (sample < lowlevel) : (sample > highlevel))
       {
-        //If below check if in high state
-        if(settings->state == 1)
+        //Add the number of samples since the previous crossing to the state that is left, but only when there was one
+        if(settings->zerocrossings)
         {
-          //If so flip the state
-          settings->state = 0;
-
-          //Check if first zero crossing detected
-          if(settings->zerocrossings == 0)
-          {
-            //Set the previous index if so
-            settings->previousindex = count;
-          }
-          else
-          {
-            //Calculate the total number of samples in the high parts of the signal
-            settings->highsamplecount += settings->previousindex - count;
-            
-            //Add one to the low divider for average calculation
-            settings->highdivider++;
-            
-            //Set the new previous index
-            settings->previousindex = count;
-          }
-          
-          //Found a zero crossing
-          settings->zerocrossings++;
+          samplecount[state] += previous - count;
+          divider[state]++;
         }
+        
+        //Flip the state and remember where this crossing was found
+        state ^= 1;
+        previous = count;
+        
+        settings->zerocrossings++;
       }
-    }    
-    
-    //Skip a sample to allow for ADC2 data to be placed into
-    settings->buffer += 2;
+      
+      count--;
+    }
     
-    //One read done
-    count--;
+    //Save the frequency determination work variables
+    settings->state           = state;
+    settings->previousindex   = previous;
+    settings->lowsamplecount  = samplecount[0];
+    settings->highsamplecount = samplecount[1];
+    settings->lowdivider      = divider[0];
+    settings->highdivider     = divider[1];
   }
- 
+  
+  //Save the measurements
+  settings->min      = min;
+  settings->max      = max;
+  settings->average += total;
+  settings->buffer   = buffer;
+  
   //Calculate the raw average
   settings->rawaverage = sum / scopesettings.nofsamples;
 }
@@ -53,6 +53,12 @@ uint16 fpga_read_short(void);
 
 void   fpga_write_int(uint32 data);
 
+void   fpga_write_setting(uint8 command, uint32 size, uint32 data);
+void   fpga_batch_begin(void);
+void   fpga_batch_end(void);
+void   fpga_batch_flush(void);
+void   fpga_invalidate_shadow(void);
+
 void   fpga_set_backlight_brightness(uint16 brightness);
 void   fpga_set_translated_brightness(void);
 
@@ -70,6 +76,8 @@ void   fpga_set_channel_offset(PCHANNELSETTINGS settings);
 
 void   fpga_set_sample_rate(uint32 samplerate);
 void   fpga_set_time_base(uint32 timebase);
+void   fpga_set_long_time_base(void);
+void   fpga_read_roll_block(uint8 command, uint8 *buffer);
 
 void   fpga_set_trigger_channel(void);
 void   fpga_set_trigger_edge(void);
@@ -78,11 +86,15 @@ void   fpga_set_trigger_level(void);
 void   fpga_set_trigger_mode(void);
 
 void   fpga_do_conversion(void);
+void   fpga_start_conversion(void);
+uint32 fpga_conversion_done(void);
+void   fpga_end_conversion(void);
 
 uint16 fpga_prepare_for_transfer(void);
 
 void   fpga_read_sample_data(PCHANNELSETTINGS settings, uint32 triggerpoint);
 void   fpga_read_adc_data(PCHANNELSETTINGS settings);
+void   fpga_process_adc_data(PCHANNELSETTINGS settings, uint32 count);
 
 
 
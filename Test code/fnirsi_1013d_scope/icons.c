@@ -306,6 +306,68 @@ const uint8 confirmation_icon[] =
   0xFF, 0xFF, 0xFF
 };
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//24 x 24 pixels
+
+const uint8 persistence_icon[] =
+{
+  0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x01, 0xE3,
+  0xC0, 0x03, 0x33,
+  0xC0, 0x06, 0x13,
+  0xCC, 0x0D, 0xE3,
+  0xC6, 0x1B, 0x33,
+  0xC3, 0x36, 0x13,
+  0xCD, 0xED, 0xE3,
+  0xC6, 0x1B, 0x33,
+  0xC3, 0x36, 0x13,
+  0xCD, 0xEC, 0x03,
+  0xC6, 0x18, 0x03,
+  0xC3, 0x30, 0x03,
+  0xC1, 0xE0, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//24 x 24 pixels
+
+const uint8 file_compression_icon[] =
+{
+  0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC1, 0x00, 0x83,
+  0xC1, 0x81, 0x83,
+  0xC1, 0xC3, 0x83,
+  0xDF, 0xE7, 0xFB,
+  0xDF, 0xE7, 0xFB,
+  0xC1, 0xC3, 0x83,
+  0xC1, 0x81, 0x83,
+  0xC1, 0x00, 0x83,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xC0, 0x00, 0x03,
+  0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF
+};
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //41 x 27 pixels
 
@@ -2,7 +2,7 @@
  * lib/libc/malloc/malloc.c
  */
 
-#include <malloc.h>
+#include "malloc.h"
 
 static void * __heap_pool = NULL;
 
@@ -13,8 +13,10 @@ static void * __heap_pool = NULL;
 #define tlsf_min(a, b)			((a) < (b) ? (a) : (b))
 #define tlsf_max(a, b)			((a) > (b) ? (a) : (b))
 
-#define tlsf_assert				assert
-#define tlsf_insist(x)			{ tlsf_assert(x); if (!(x)) { status--; } }
+/*
+ * No assert support in the firmware, so the checks are left out
+ */
+#define tlsf_assert(x)
 
 #if defined(__ARM64__) || defined(__X64__)
 # define TLSF_64BIT
@@ -788,19 +790,16 @@ void * malloc(size_t size)
 {
 	return tlsf_malloc(__heap_pool, size);
 }
-EXPORT_SYMBOL(malloc);
 
 void * memalign(size_t align, size_t size)
 {
 	return tlsf_memalign(__heap_pool, align, size);
 }
-EXPORT_SYMBOL(memalign);
 
 void * realloc(void * ptr, size_t size)
 {
 	return tlsf_realloc(__heap_pool, ptr, size);
 }
-EXPORT_SYMBOL(realloc);
 
 void * calloc(size_t nmemb, size_t size)
 {
@@ -811,22 +810,57 @@ void * calloc(size_t nmemb, size_t size)
 
 	return ptr;
 }
-EXPORT_SYMBOL(calloc);
 
 void free(void * ptr)
 {
 	tlsf_free(__heap_pool, ptr);
 }
-EXPORT_SYMBOL(free);
+
+size_t mm_block_size(void * ptr)
+{
+	return ptr ? block_get_size(block_from_ptr(ptr)) : 0;
+}
+
+/*
+ * Walk the blocks of a pool to see how the memory is spread over used and free blocks
+ */
+void mm_get_pool_info(void * pool, size_t * used, size_t * unused, size_t * largest)
+{
+	block_header_t * block = offset_to_block(pool, -(int)block_header_overhead);
+	size_t size;
+
+	*used = 0;
+	*unused = 0;
+	*largest = 0;
+
+	while (block && !block_is_last(block))
+	{
+		size = block_get_size(block);
+
+		if (block_is_free(block))
+		{
+			*unused += size;
+
+			if (size > *largest)
+				*largest = size;
+		}
+		else
+		{
+			*used += size;
+		}
+
+		block = block_next(block);
+	}
+}
 
 void do_init_mem_pool(void)
 {
-#ifndef __SANDBOX__
 	extern unsigned char __heap_start;
 	extern unsigned char __heap_end;
 	__heap_pool = tlsf_create_with_pool((void *)&__heap_start, (size_t)(&__heap_end - &__heap_start));
-#else
-	static char __heap_buf[SZ_16M];
-	__heap_pool = tlsf_create_with_pool((void *)__heap_buf, (size_t)(sizeof(__heap_buf)));
-#endif
+}
+
+void * get_mem_pool(void)
+{
+	return __heap_pool;
 }
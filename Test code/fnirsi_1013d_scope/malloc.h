@@ -5,11 +5,8 @@
 extern "C" {
 #endif
 
-#include <core_types.h>
 #include <stddef.h>
 #include <string.h>
-#include <assert.h>
-#include <module.h>
 
 void * mm_create(void * mem, size_t bytes);
 void mm_destroy(void * mm);
@@ -20,6 +17,8 @@ void * mm_malloc(void * mm, size_t size);
 void * mm_memalign(void * mm, size_t align, size_t size);
 void * mm_realloc(void * mm, void * ptr, size_t size);
 void mm_free(void * mm, void * ptr);
+size_t mm_block_size(void * ptr);
+void mm_get_pool_info(void * pool, size_t * used, size_t * unused, size_t * largest);
 
 void * malloc(size_t size);
 void * memalign(size_t align, size_t size);
@@ -28,6 +27,7 @@ void * calloc(size_t nmemb, size_t size);
 void free(void * ptr);
 
 void do_init_mem_pool(void);
+void * get_mem_pool(void);
 
 #ifdef __cplusplus
 }
@@ -143,6 +143,10 @@ volatile uint8 *scsi_data_end_ptr;
 
 volatile uint32 scsi_available_blocks;
 
+volatile uint32 scsi_buffer_index;
+volatile uint32 scsi_next_blocks;
+volatile uint32 scsi_write_pending;
+
 uint8 scsi_capacity[8];
 
 volatile uint32 msc_state = MSC_WAIT_COMMAND;
@@ -152,6 +156,56 @@ MSC_Status_Wrapper  scsi_csw;
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+uint8 *scsi_get_buffer(uint32 index)
+{
+  //Align the start of the thumbnail buffer on a cache line so the card can use DMA directly on it
+  uint8 *buffer = (uint8 *)(((uint32)viewthumbnaildata + (ARM32_CACHE_LINE_SIZE - 1)) & ~(ARM32_CACHE_LINE_SIZE - 1));
+
+  //Select the requested half
+  return(buffer + (index * SCSI_BUFFER_SIZE));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 scsi_read_ahead(void)
+{
+  //Check if there is more to read
+  if(scsi_block_count == 0)
+  {
+    //Nothing being read ahead
+    scsi_next_blocks = 0;
+
+    return(0);
+  }
+
+  //Limit on what fits in a buffer
+  if(scsi_block_count > SCSI_BUFFER_BLOCKS)
+  {
+    scsi_next_blocks = SCSI_BUFFER_BLOCKS;
+  }
+  else
+  {
+    scsi_next_blocks = scsi_block_count;
+  }
+
+  //Start reading into the buffer that is not being send. This runs while the current buffer is send to the host
+  if(sd_card_start_read(scsi_start_lba, scsi_next_blocks, scsi_get_buffer(scsi_buffer_index ^ 1)) != SD_OK)
+  {
+    //Signal the failure
+    return(1);
+  }
+
+  //This part is taken care of
+  scsi_block_count -= scsi_next_blocks;
+
+  //Select the next sector to read
+  scsi_start_lba += scsi_next_blocks;
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 uint32 scsi_check_read10_write10(uint32 check)
 {
   //Check on possible no data transfer
@@ -332,14 +386,15 @@ void usb_mass_storage_out_ep_callback(void *fifo, int length)
                 break;
               }
             
-              //Use the thumbnail buffer for the SCSI data
-              scsi_data_in_ptr = (uint8 *)viewthumbnaildata;
+              //Start with the first half of the thumbnail buffer for the SCSI data
+              scsi_buffer_index = 0;
+              scsi_data_in_ptr = scsi_get_buffer(0);
 
               //Check if more data than what fits the buffer
-              if(scsi_block_count > SCSI_MAX_BLOCK_COUNT)
+              if(scsi_block_count > SCSI_BUFFER_BLOCKS)
               {
                 //Limit to the max
-                scsi_available_blocks = SCSI_MAX_BLOCK_COUNT;
+                scsi_available_blocks = SCSI_BUFFER_BLOCKS;
               }
               else
               {
@@ -347,8 +402,7 @@ void usb_mass_storage_out_ep_callback(void *fifo, int length)
                 scsi_available_blocks = scsi_block_count;
               }
 
-              //Read the data from the card
-              //Need to handle error here. Need to calculate the size already done
+              //Read the first part of the data from the card and wait for it, since it is needed right away
               if(sd_card_read(scsi_start_lba, scsi_available_blocks, (uint8 *)scsi_data_in_ptr) != SD_OK)
               {
                 //When the SD card fails send a FAIL
@@ -359,10 +413,10 @@ void usb_mass_storage_out_ep_callback(void *fifo, int length)
                 
                 //Send the status
                 usb_write_ep1_data((void *)&scsi_csw, MSC_CSW_LENGTH);
-              }
 
-              //Write the first block to the FIFO
-              usb_write_ep1_data((void *)scsi_data_in_ptr, cardsectorsize);
+                //Nothing more to do for this command
+                break;
+              }
 
               //One full buffer done
               scsi_block_count -= scsi_available_blocks;
@@ -370,6 +424,19 @@ void usb_mass_storage_out_ep_callback(void *fifo, int length)
               //select the next sector to read
               scsi_start_lba += scsi_available_blocks;
 
+              //Start reading the next part into the other half of the buffer
+              if(scsi_read_ahead())
+              {
+                //When the SD card fails signal a FAIL after the data already read has been send
+                scsi_csw.status = MSC_CSW_STATUS_FAIL;
+                scsi_csw.data_residue = scsi_block_count * 512;
+                scsi_block_count = 0;
+                scsi_next_blocks = 0;
+              }
+
+              //Write the first block to the FIFO
+              usb_write_ep1_data((void *)scsi_data_in_ptr, cardsectorsize);
+
               //Point to next data to transfer
               scsi_data_in_ptr += cardsectorsize;
 
@@ -400,9 +467,13 @@ void usb_mass_storage_out_ep_callback(void *fifo, int length)
               scsi_byte_count = scsi_block_count * 512;
               scsi_bytes_received = 0;
 
-              //Point to the start of the buffer to receive the payload data into
-              scsi_data_in_ptr = (uint8 *)viewthumbnaildata;
-              scsi_data_end_ptr = scsi_data_in_ptr + sizeof(viewthumbnaildata);
+              //Point to the start of the first half of the buffer to receive the payload data into
+              scsi_buffer_index = 0;
+              scsi_data_in_ptr = scsi_get_buffer(0);
+              scsi_data_end_ptr = scsi_data_in_ptr + SCSI_BUFFER_SIZE;
+
+              //No card write started yet for this command
+              scsi_write_pending = 0;
 
               //Next out transaction holds the payload data
               msc_state = MSC_RECEIVE_DATA;
@@ -435,96 +506,69 @@ void usb_mass_storage_out_ep_callback(void *fifo, int length)
       
     case MSC_RECEIVE_DATA:
     {
-      //Calculate the last location when this data is written to the buffer. Needs to stay below the end of the buffer
-      register uint8 *tptr = (uint8 *)scsi_data_in_ptr + length;
-      
-      //Check if there is still room in the buffer
-      if(tptr < scsi_data_end_ptr)
+      //Packets are never bigger than 512 bytes and the buffer is written to the card as soon as less than that is free, so the data always fits
+      usb_read_from_fifo(fifo, (void *)scsi_data_in_ptr, length);
+
+      //Point to the next location in the buffer to store the next load
+      scsi_data_in_ptr += length;
+      scsi_bytes_received += length;
+
+      //Check if this was the last data or if the buffer is full
+      if((length >= scsi_byte_count) || ((scsi_data_end_ptr - scsi_data_in_ptr) < 512))
       {
-        //Need to load the data into a buffer before writing to the card
-        usb_read_from_fifo(fifo, (void *)scsi_data_in_ptr, length);
+        //Get the number of sectors to write to the card, with one extra when there is a non full sector at the end
+        uint32 sectors = (scsi_bytes_received + 511) / 512;
 
-        scsi_bytes_received += length;
-        
-        //Need to determine here if this was the last data
-        if(length >= scsi_byte_count)
+        //The previous buffer needs to be written before this one can be started
+        if(scsi_write_pending && (sd_card_wait_transfer() != SD_OK))
         {
-          //Last payload data received so write it to the card and send the status
-          //Get the number of sectors to write to the card to free the buffer
-          uint32 sectors = scsi_bytes_received / 512;
-          uint32 bytesdone = sectors * 512;
+          //When there is an error signal it to the host
+          scsi_csw.status = MSC_CSW_STATUS_FAIL;
+        }
 
-          //Check if there is a non full sector at the end
-          if(bytesdone < scsi_bytes_received)
-          {
-            //If so do one sector extra
-            sectors++;
-          }
-          
-          //Write the data to the card and check on errors
-          if(sd_card_write(scsi_start_lba, sectors, (uint8 *)viewthumbnaildata) != SD_OK)
+        //Start writing this buffer to the card. The next payload data is received in the other buffer in the mean time
+        if(sd_card_start_write(scsi_start_lba, sectors, scsi_get_buffer(scsi_buffer_index)) != SD_OK)
+        {
+          //When there is an error signal it to the host
+          scsi_csw.status = MSC_CSW_STATUS_FAIL;
+        }
+
+        //Signal the write needs to be checked
+        scsi_write_pending = 1;
+
+        //Point to next logical block address to write to
+        scsi_start_lba += sectors;
+
+        //Switch to the other half of the buffer
+        scsi_buffer_index ^= 1;
+        scsi_data_in_ptr = scsi_get_buffer(scsi_buffer_index);
+        scsi_data_end_ptr = scsi_data_in_ptr + SCSI_BUFFER_SIZE;
+
+        //Reset the number of received bytes for this buffer
+        scsi_bytes_received = 0;
+
+        //Check if this was the last payload data
+        if(length >= scsi_byte_count)
+        {
+          //Wait for the last write to finish
+          if(sd_card_wait_transfer() != SD_OK)
           {
             //When there is an error signal it to the host
             scsi_csw.status = MSC_CSW_STATUS_FAIL;
           }
-          
+
           //Next action is send the status to the host
           usb_write_ep1_data((void *)&scsi_csw, MSC_CSW_LENGTH);
 
           //switch to wait for command state
           msc_state = MSC_WAIT_COMMAND;
-        }
-        else
-        {
-          //Take of the received bytes to see if more needs to come
-          scsi_byte_count -= length;
 
-          //Point to the next location in the buffer to store the next load
-          scsi_data_in_ptr = tptr;
-        }
-      }
-      else
-      {
-        //Get the number of sectors to write to the card to free the buffer
-        uint32 sectors = scsi_bytes_received / 512;
-        uint32 bytesdone = sectors * 512;
-        
-        //Start on the beginning of the buffer
-        scsi_data_in_ptr = (uint8 *)viewthumbnaildata;
-        
-        //Write the data to the card and check on errors
-        if(sd_card_write(scsi_start_lba, sectors, (uint8 *)scsi_data_in_ptr) != SD_OK)
-        {
-          //When there is an error signal it to the host
-          scsi_csw.status = MSC_CSW_STATUS_FAIL;
-            
-          //Calculate the residual data length
-          scsi_csw.data_residue = scsi_cbw.total_bytes - scsi_bytes_received; 
-        }
-        
-        //Point to next logical block address to write to
-        scsi_start_lba += sectors;
-        
-        //Check if there is data left
-        if(bytesdone < scsi_bytes_received)
-        {
-          uint32 bytesleft = scsi_bytes_received - bytesdone;
-          
-          //If so copy the remainder to the start of the buffer
-          memcpy((uint8 *)scsi_data_in_ptr, (uint8 *)scsi_data_in_ptr + bytesdone, bytesleft);
-          
-          //Set pointer to the end of this left over data
-          scsi_data_in_ptr += bytesleft;
-          
-          //At this moment still data received
-          scsi_bytes_received = bytesleft;
-        }
-        else
-        {
-          //Reset the number of received bytes for handling remainder of payload data
-          scsi_bytes_received = 0;
+          break;
         }
       }
+
+      //Take of the received bytes to see if more needs to come
+      scsi_byte_count -= length;
     } 
     break;
   }
@@ -538,6 +582,41 @@ void usb_mass_storage_in_ep_callback(void)
   switch(msc_state)
   {
     case MSC_SEND_DATA:
+      //Check if the current buffer is done and the other one is being read
+      if((scsi_available_blocks == 0) && scsi_next_blocks)
+      {
+        //Wait for the read ahead to finish. Normally it is already done, since sending the buffer takes longer than reading it
+        if(sd_card_wait_transfer() != SD_OK)
+        {
+          //When there is an error signal it to the host
+          scsi_csw.status = MSC_CSW_STATUS_FAIL;
+
+          //Calculate the residual data length
+          scsi_csw.data_residue = (scsi_block_count + scsi_next_blocks) * 512;
+
+          //Stop sending data
+          scsi_block_count = 0;
+          scsi_next_blocks = 0;
+        }
+        else
+        {
+          //Switch to the buffer that has just been read
+          scsi_buffer_index ^= 1;
+          scsi_data_in_ptr = scsi_get_buffer(scsi_buffer_index);
+          scsi_available_blocks = scsi_next_blocks;
+
+          //Start reading the next part into the buffer that has just been send
+          if(scsi_read_ahead())
+          {
+            //When the SD card fails signal a FAIL after the data already read has been send
+            scsi_csw.status = MSC_CSW_STATUS_FAIL;
+            scsi_csw.data_residue = scsi_block_count * 512;
+            scsi_block_count = 0;
+            scsi_next_blocks = 0;
+          }
+        }
+      }
+
       //Check if still more data to send to the host
       //Needs to be adapted to variable end point size!!
       if(scsi_available_blocks)
@@ -550,41 +629,6 @@ void usb_mass_storage_in_ep_callback(void)
 
         //Point to next data to transfer
         scsi_data_in_ptr += cardsectorsize;
-        
-        //Check if more data needs to be read from the SD card
-        if((scsi_available_blocks == 0) && scsi_block_count)
-        {
-          //Reset the pointer to the beginning of the buffer
-          scsi_data_in_ptr = (uint8 *)viewthumbnaildata;
-
-          //Check if that what still needs to be done is bigger then the buffer
-          if(scsi_block_count > SCSI_MAX_BLOCK_COUNT)
-          {
-            //Limit to the size of the buffer
-            scsi_available_blocks = SCSI_MAX_BLOCK_COUNT;
-          }
-          else
-          {
-            //Otherwise do the lot
-            scsi_available_blocks = scsi_block_count;
-          }
-          
-          //Read the next block as needed and check on errors
-          if(sd_card_read(scsi_start_lba, scsi_available_blocks, (uint8 *)scsi_data_in_ptr) != SD_OK)
-          {
-            //When there is an error signal it to the host
-            scsi_csw.status = MSC_CSW_STATUS_FAIL;
-
-            //Calculate the residual data length
-            scsi_csw.data_residue = scsi_block_count * 512; 
-          }
-          
-          //One full buffer done
-          scsi_block_count -= scsi_available_blocks;
-
-          //Select the next sector to read
-          scsi_start_lba += scsi_available_blocks;
-        }        
         break;
       }
       
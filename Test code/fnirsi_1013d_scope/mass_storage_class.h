@@ -8,6 +8,7 @@
 #include "types.h"
 #include "variables.h"
 #include "usb_interface.h"
+#include "arm32.h"
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -52,7 +53,9 @@ extern const uint8 scsi_sense_data[4];
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
-#define SCSI_MAX_BLOCK_COUNT        (VIEW_THUMBNAIL_DATA_SIZE / 512)
+//The thumbnail buffer is split in two cache line aligned halves. While one is handled on the USB side the card reads or writes the other
+#define SCSI_BUFFER_BLOCKS          (((VIEW_THUMBNAIL_DATA_SIZE - ARM32_CACHE_LINE_SIZE) / 2) / 512)
+#define SCSI_BUFFER_SIZE            (SCSI_BUFFER_BLOCKS * 512)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -99,6 +102,10 @@ typedef struct
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+uint8 *scsi_get_buffer(uint32 index);
+
+uint32 scsi_read_ahead(void);
+
 void usb_mass_storage_out_ep_callback(void *fifo, int length);
 
 void usb_mass_storage_in_ep_callback(void);
@@ -0,0 +1,284 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Memory allocation on top of the TLSF heap (malloc.c)
+//
+//The heap takes the DRAM between the end of the BSS section and the display configuration data (see fnirsi_1013d.ld). Buffers that
+//are needed over and over again come from fixed size pools and short lived buffers from the frame arena, so the heap itself is only
+//used on startup and the memory use stays predictable.
+//
+//None of these functions are allowed to be used from an interrupt handler.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "memory_pools.h"
+#include "malloc.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+MEMORYPOOL samplebufferpool;
+MEMORYPOOL filebufferpool;
+
+MEMORYARENA framearena;
+
+uint32 memoryheaphighwater;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_init(void)
+{
+  //Setup the heap on the free DRAM
+  do_init_mem_pool();
+
+  //Take the pools and the frame arena from it
+  memory_pool_create(&samplebufferpool, "sample", MEMORY_SAMPLE_BUFFER_SIZE, MEMORY_SAMPLE_BUFFER_COUNT);
+  memory_pool_create(&filebufferpool, "file", MEMORY_FILE_BUFFER_SIZE, MEMORY_FILE_BUFFER_COUNT);
+
+  memory_arena_create(&framearena, MEMORY_FRAME_ARENA_SIZE);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void *memory_alloc(uint32 size)
+{
+  void *ptr = malloc(size);
+
+  memory_check_heap_use();
+
+  return(ptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//For buffers used with DMA. The size is rounded up to full cache lines so no other data shares the last line
+
+void *memory_alloc_aligned(uint32 size)
+{
+  void *ptr = memalign(MEMORY_CACHE_LINE_SIZE, (size + MEMORY_CACHE_LINE_SIZE - 1) & ~(MEMORY_CACHE_LINE_SIZE - 1));
+
+  memory_check_heap_use();
+
+  return(ptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_check_heap_use(void)
+{
+  size_t used;
+  size_t unused;
+  size_t largest;
+
+  //Keep track of the most heap memory in use
+  mm_get_pool_info(mm_get_pool(get_mem_pool()), &used, &unused, &largest);
+
+  if(used > memoryheaphighwater)
+  {
+    memoryheaphighwater = used;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_free(void *ptr)
+{
+  free(ptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 memory_pool_create(PMEMORYPOOL pool, const char *name, uint32 blocksize, uint32 blockcount)
+{
+  uint8  *block;
+  uint32  i;
+
+  //Blocks need to be able to hold the free list link and stay cache line aligned
+  blocksize = (blocksize + MEMORY_CACHE_LINE_SIZE - 1) & ~(MEMORY_CACHE_LINE_SIZE - 1);
+
+  pool->name       = name;
+  pool->blocksize  = blocksize;
+  pool->blockcount = 0;
+  pool->used       = 0;
+  pool->highwater  = 0;
+  pool->failures   = 0;
+  pool->freelist   = 0;
+
+  //Get all the blocks in one go
+  pool->memory = memory_alloc_aligned(blocksize * blockcount);
+
+  if(pool->memory == 0)
+  {
+    return(-1);
+  }
+
+  pool->blockcount = blockcount;
+
+  //Link the blocks in the free list, with the first block on top
+  block = pool->memory + (blocksize * blockcount);
+
+  for(i=0;i<blockcount;i++)
+  {
+    block -= blocksize;
+
+    *(void **)block = pool->freelist;
+    pool->freelist = block;
+  }
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void *memory_pool_alloc(PMEMORYPOOL pool)
+{
+  void *block = pool->freelist;
+
+  //Check if there is a block left
+  if(block == 0)
+  {
+    pool->failures++;
+    return(0);
+  }
+
+  //Take it from the list
+  pool->freelist = *(void **)block;
+
+  pool->used++;
+
+  if(pool->used > pool->highwater)
+  {
+    pool->highwater = pool->used;
+  }
+
+  return(block);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_pool_free(PMEMORYPOOL pool, void *ptr)
+{
+  //Only blocks from this pool can be returned
+  if((ptr == 0) || ((uint8 *)ptr < pool->memory) || ((uint8 *)ptr >= (pool->memory + (pool->blocksize * pool->blockcount))))
+  {
+    return;
+  }
+
+  //Put it back on top of the list
+  *(void **)ptr = pool->freelist;
+  pool->freelist = ptr;
+
+  pool->used--;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 memory_arena_create(PMEMORYARENA arena, uint32 size)
+{
+  arena->used      = 0;
+  arena->highwater = 0;
+  arena->failures  = 0;
+  arena->memory    = memory_alloc_aligned(size);
+
+  if(arena->memory == 0)
+  {
+    arena->size = 0;
+    return(-1);
+  }
+
+  arena->size = size;
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void *memory_arena_alloc(PMEMORYARENA arena, uint32 size)
+{
+  void *ptr;
+
+  //Keep every allocation on a cache line of its own
+  size = (size + MEMORY_CACHE_LINE_SIZE - 1) & ~(MEMORY_CACHE_LINE_SIZE - 1);
+
+  if(size > (arena->size - arena->used))
+  {
+    arena->failures++;
+    return(0);
+  }
+
+  ptr = arena->memory + arena->used;
+
+  arena->used += size;
+
+  if(arena->used > arena->highwater)
+  {
+    arena->highwater = arena->used;
+  }
+
+  return(ptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_arena_reset(PMEMORYARENA arena)
+{
+  arena->used = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void *memory_frame_alloc(uint32 size)
+{
+  return(memory_arena_alloc(&framearena, size));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_frame_reset(void)
+{
+  memory_arena_reset(&framearena);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_get_pool_statistics(PMEMORYPOOL pool, PMEMORYPOOLSTATISTICS statistics)
+{
+  statistics->name       = pool->name;
+  statistics->blocksize  = pool->blocksize;
+  statistics->blockcount = pool->blockcount;
+  statistics->used       = pool->used;
+  statistics->highwater  = pool->highwater;
+  statistics->failures   = pool->failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_get_statistics(PMEMORYSTATISTICS statistics)
+{
+  size_t used;
+  size_t unused;
+  size_t largest;
+
+  //Walk the heap to see how it is used
+  mm_get_pool_info(mm_get_pool(get_mem_pool()), &used, &unused, &largest);
+
+  statistics->heapsize        = used + unused;
+  statistics->heapused        = used;
+  statistics->heapfree        = unused;
+  statistics->heaplargestfree = largest;
+  statistics->heaphighwater   = memoryheaphighwater;
+
+  //When all the free memory is in one block there is no fragmentation
+  if(unused)
+  {
+    statistics->heapfragmentation = 100 - ((largest * 100) / unused);
+  }
+  else
+  {
+    statistics->heapfragmentation = 0;
+  }
+
+  memory_get_pool_statistics(&samplebufferpool, &statistics->samplepool);
+  memory_get_pool_statistics(&filebufferpool, &statistics->filepool);
+
+  statistics->framesize      = framearena.size;
+  statistics->framehighwater = framearena.highwater;
+  statistics->framefailures  = framearena.failures;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef MEMORY_POOLS_H
+#define MEMORY_POOLS_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "types.h"
+#include "fnirsi_1013d_scope.h"
+#include "file_compression.h"
+#include "arm32.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Size of a data cache line. Buffers used with DMA are aligned on it
+#define MEMORY_CACHE_LINE_SIZE            ARM32_CACHE_LINE_SIZE
+
+//Fixed size pools on top of the heap. All the blocks are taken from the heap on startup, so allocating and freeing them takes
+//constant time and does not fragment the heap
+#define MEMORY_SAMPLE_BUFFER_SIZE       6144       //Fits the 1500 averaging accumulators of one channel, or SEGMENTS_PER_BLOCK segments
+#define MEMORY_SAMPLE_BUFFER_COUNT     (SEGMENT_MAX_BLOCKS + 4)       //The largest segment ring and the four averaging buffers
+
+#define MEMORY_FILE_BUFFER_SIZE         COMPRESSION_BUFFER_SIZE       //Fits the coded data buffer of the compressed file formats
+#define MEMORY_FILE_BUFFER_COUNT           4
+
+//Scratch memory for the main loop. It is reset at the start of every loop, so allocations from it do not have to be freed
+#define MEMORY_FRAME_ARENA_SIZE        32768
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct tagMemoryPool            MEMORYPOOL,        *PMEMORYPOOL;
+typedef struct tagMemoryArena           MEMORYARENA,       *PMEMORYARENA;
+typedef struct tagMemoryPoolStatistics  MEMORYPOOLSTATISTICS, *PMEMORYPOOLSTATISTICS;
+typedef struct tagMemoryStatistics      MEMORYSTATISTICS,  *PMEMORYSTATISTICS;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagMemoryPool
+{
+  const char *name;
+  uint8      *memory;         //Start of the blocks, used to check the pointers that are freed
+  void       *freelist;       //The first word of a free block points to the next free block
+  uint32      blocksize;
+  uint32      blockcount;
+  uint32      used;
+  uint32      highwater;
+  uint32      failures;
+};
+
+struct tagMemoryArena
+{
+  uint8  *memory;
+  uint32  size;
+  uint32  used;
+  uint32  highwater;
+  uint32  failures;
+};
+
+struct tagMemoryPoolStatistics
+{
+  const char *name;
+  uint32      blocksize;
+  uint32      blockcount;
+  uint32      used;
+  uint32      highwater;
+  uint32      failures;
+};
+
+struct tagMemoryStatistics
+{
+  uint32               heapsize;
+  uint32               heapused;
+  uint32               heapfree;
+  uint32               heaplargestfree;
+  uint32               heaphighwater;
+  uint32               heapfragmentation;   //Percentage of the free memory that is not in the largest free block
+
+  MEMORYPOOLSTATISTICS samplepool;
+  MEMORYPOOLSTATISTICS filepool;
+
+  uint32               framesize;
+  uint32               framehighwater;
+  uint32               framefailures;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+extern MEMORYPOOL samplebufferpool;
+extern MEMORYPOOL filebufferpool;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void memory_init(void);
+
+void *memory_alloc(uint32 size);
+void *memory_alloc_aligned(uint32 size);
+void memory_free(void *ptr);
+void memory_check_heap_use(void);
+
+int32 memory_pool_create(PMEMORYPOOL pool, const char *name, uint32 blocksize, uint32 blockcount);
+void *memory_pool_alloc(PMEMORYPOOL pool);
+void memory_pool_free(PMEMORYPOOL pool, void *ptr);
+
+int32 memory_arena_create(PMEMORYARENA arena, uint32 size);
+void *memory_arena_alloc(PMEMORYARENA arena, uint32 size);
+void memory_arena_reset(PMEMORYARENA arena);
+
+void *memory_frame_alloc(uint32 size);
+void memory_frame_reset(void);
+
+void memory_get_pool_statistics(PMEMORYPOOL pool, PMEMORYPOOLSTATISTICS statistics);
+void memory_get_statistics(PMEMORYSTATISTICS statistics);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* MEMORY_POOLS_H */
@@ -0,0 +1,113 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Memory management unit setup
+//
+//The address space is mapped one on one, so the MMU is only used to tell the cache which memory it is allowed to handle. Without it
+//the data cache on the ARM926 is not used at all.
+//
+//  - The peripherals and the internal SRAM are not cached and not buffered
+//  - The DRAM with code, data, heap and stacks is write back cached
+//  - The display buffer the display controller reads from is only bufferable
+//  - The DMA buffer section is not cached
+//
+//Buffers in the cached DRAM that are used with DMA need to be cleaned before and invalidated for the transfer. See the helpers below.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "mmu_control.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+extern uint8 FRAMEBUFFER_START;
+extern uint8 FRAMEBUFFER_END;
+extern uint8 DMABUFFER_START;
+extern uint8 DMABUFFER_END;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 mmu_translation_table[MMU_NUMBER_OF_SECTIONS] __attribute__ ((aligned (MMU_TABLE_ALIGNMENT)));
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void mmu_init(void)
+{
+  uint32 section;
+
+  //Start with everything as device memory
+  for(section=0;section<MMU_NUMBER_OF_SECTIONS;section++)
+  {
+    mmu_translation_table[section] = (section << MMU_SECTION_SHIFT) | MMU_DEVICE_MEMORY;
+  }
+
+  //The DRAM is cached
+  mmu_set_section_attributes(MMU_DRAM_START, MMU_DRAM_START + MMU_DRAM_SIZE, MMU_WRITE_BACK_MEMORY);
+
+  //Except for the display buffer and the DMA buffers
+  mmu_set_section_attributes((uint32)&FRAMEBUFFER_START, (uint32)&FRAMEBUFFER_END, MMU_BUFFERED_MEMORY);
+  mmu_set_section_attributes((uint32)&DMABUFFER_START, (uint32)&DMABUFFER_END, MMU_UNCACHED_MEMORY);
+
+  //Make sure nothing old is left in the caches and the TLB
+  arm32_dcache_clean_invalidate_all();
+  arm32_icache_invalidate_all();
+  arm32_tlb_invalidate();
+
+  //Load the table and the domain access
+  arm32_ttb_set((uint32)mmu_translation_table);
+  arm32_domain_set(MMU_DOMAIN_0_CLIENT);
+
+  //Switch the MMU on. The caches are enabled by the caller
+  arm32_mmu_enable();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Start and end need to be on a section boundary, which the linker script takes care of for the special sections
+
+void mmu_set_section_attributes(uint32 start, uint32 end, uint32 attributes)
+{
+  uint32 section;
+
+  for(section=(start >> MMU_SECTION_SHIFT);section<(end >> MMU_SECTION_SHIFT);section++)
+  {
+    mmu_translation_table[section] = (section << MMU_SECTION_SHIFT) | attributes;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Switch the caching of the DRAM off or back on. With it off the DRAM is used as it was without the MMU, which is used to time the gain
+//of the cached setup
+
+void mmu_set_dram_cached(uint32 cached)
+{
+  if(cached)
+  {
+    mmu_set_section_attributes(MMU_DRAM_START, MMU_DRAM_START + MMU_DRAM_SIZE, MMU_WRITE_BACK_MEMORY);
+    mmu_set_section_attributes((uint32)&FRAMEBUFFER_START, (uint32)&FRAMEBUFFER_END, MMU_BUFFERED_MEMORY);
+    mmu_set_section_attributes((uint32)&DMABUFFER_START, (uint32)&DMABUFFER_END, MMU_UNCACHED_MEMORY);
+  }
+  else
+  {
+    mmu_set_section_attributes(MMU_DRAM_START, MMU_DRAM_START + MMU_DRAM_SIZE, MMU_UNCACHED_MEMORY);
+  }
+
+  //The table walk reads the DRAM and not the cache, so the new descriptors and any dirty data need to be written out before the
+  //old translations are dropped
+  arm32_dcache_clean_invalidate_all();
+  arm32_tlb_invalidate();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Write the cached data to the DRAM before a DMA controller reads it
+
+void mmu_clean_for_dma(void *buffer, uint32 length)
+{
+  arm32_dcache_clean_range((uint32)buffer, (uint32)buffer + length);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Drop the cached data before a DMA controller writes to the DRAM, so the cpu reads the new data afterwards. The buffer needs to start
+//and end on a cache line, and the cpu is not allowed to use it while the transfer is in progress
+
+void mmu_invalidate_for_dma(void *buffer, uint32 length)
+{
+  arm32_dcache_invalidate_range((uint32)buffer, (uint32)buffer + length);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
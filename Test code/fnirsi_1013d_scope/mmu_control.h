@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef MMU_CONTROL_H
+#define MMU_CONTROL_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "types.h"
+#include "arm32.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//The whole address space is mapped one on one with 1MB sections
+#define MMU_NUMBER_OF_SECTIONS          4096
+#define MMU_SECTION_SHIFT                 20
+#define MMU_SECTION_SIZE          0x00100000
+
+//The translation table needs to be on a 16KB boundary
+#define MMU_TABLE_ALIGNMENT            16384
+
+//Section descriptor bits
+#define MMU_SECTION_TYPE          0x00000002
+#define MMU_SECTION_BUFFERABLE    0x00000004
+#define MMU_SECTION_CACHEABLE     0x00000008
+#define MMU_SECTION_BIT4          0x00000010      //Needs to be set on the ARM926
+#define MMU_SECTION_DOMAIN_0      0x00000000
+#define MMU_SECTION_AP_READ_WRITE 0x00000C00
+
+//Memory types build from the above bits
+#define MMU_DEVICE_MEMORY         (MMU_SECTION_TYPE | MMU_SECTION_BIT4 | MMU_SECTION_DOMAIN_0 | MMU_SECTION_AP_READ_WRITE)
+#define MMU_UNCACHED_MEMORY       (MMU_DEVICE_MEMORY)
+#define MMU_BUFFERED_MEMORY       (MMU_DEVICE_MEMORY | MMU_SECTION_BUFFERABLE)
+#define MMU_WRITE_THROUGH_MEMORY  (MMU_DEVICE_MEMORY | MMU_SECTION_CACHEABLE)
+#define MMU_WRITE_BACK_MEMORY     (MMU_DEVICE_MEMORY | MMU_SECTION_CACHEABLE | MMU_SECTION_BUFFERABLE)
+
+//Domain 0 is a client, so the access permissions in the descriptors are checked
+#define MMU_DOMAIN_0_CLIENT       0x00000001
+
+#define MMU_DRAM_START            0x80000000
+#define MMU_DRAM_SIZE             0x02000000
+
+//Variables placed in these sections get other attributes than the rest of the DRAM (see fnirsi_1013d.ld)
+//The frame buffer section is bufferable but not cacheable, so writes to it are combined in the write buffer and the display
+//controller always sees the latest data. The DMA buffer section is not cached at all.
+#define FRAMEBUFFER_SECTION       __attribute__ ((section (".framebuffer")))
+#define DMABUFFER_SECTION         __attribute__ ((section (".dmabuffer")))
+
+//For buffers used with DMA that can stay in the cached DRAM. They need to start on a cache line
+#define CACHE_LINE_ALIGNED        __attribute__ ((aligned (ARM32_CACHE_LINE_SIZE)))
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void mmu_init(void);
+
+void mmu_set_section_attributes(uint32 start, uint32 end, uint32 attributes);
+
+void mmu_set_dram_cached(uint32 cached);
+
+void mmu_clean_for_dma(void *buffer, uint32 length);
+void mmu_invalidate_for_dma(void *buffer, uint32 length);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* MMU_CONTROL_H */
@@ -41,6 +41,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/display_lib.o \
 	${OBJECTDIR}/ff.o \
 	${OBJECTDIR}/ffunicode.o \
+	${OBJECTDIR}/file_compression.o \
 	${OBJECTDIR}/fnirsi_1013d_scope.o \
 	${OBJECTDIR}/font_0.o \
 	${OBJECTDIR}/font_2.o \
@@ -50,12 +51,16 @@ OBJECTFILES= \
 	${OBJECTDIR}/fpga_control.o \
 	${OBJECTDIR}/icons.o \
 	${OBJECTDIR}/interrupt.o \
+	${OBJECTDIR}/malloc.o \
 	${OBJECTDIR}/mass_storage_class.o \
 	${OBJECTDIR}/memcmp.o \
 	${OBJECTDIR}/memcpy.o \
 	${OBJECTDIR}/memmove.o \
+	${OBJECTDIR}/memory_pools.o \
 	${OBJECTDIR}/memset.o \
+	${OBJECTDIR}/mmu_control.o \
 	${OBJECTDIR}/power_and_battery.o \
+	${OBJECTDIR}/protocol_decoder.o \
 	${OBJECTDIR}/scope_functions.o \
 	${OBJECTDIR}/sd_card_interface.o \
 	${OBJECTDIR}/sin_cos_math.o \
@@ -122,6 +127,11 @@ ${OBJECTDIR}/ffunicode.o: ffunicode.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ffunicode.o ffunicode.c
 
+${OBJECTDIR}/file_compression.o: file_compression.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/file_compression.o file_compression.c
+
 ${OBJECTDIR}/fnirsi_1013d_scope.o: fnirsi_1013d_scope.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -167,6 +177,11 @@ ${OBJECTDIR}/interrupt.o: interrupt.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/interrupt.o interrupt.c
 
+${OBJECTDIR}/malloc.o: malloc.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/malloc.o malloc.c
+
 ${OBJECTDIR}/mass_storage_class.o: mass_storage_class.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -184,15 +199,30 @@ ${OBJECTDIR}/memmove.o: memmove.s
 	${MKDIR} -p ${OBJECTDIR}
 	$(AS) $(ASFLAGS) -g -o ${OBJECTDIR}/memmove.o memmove.s
 
+${OBJECTDIR}/memory_pools.o: memory_pools.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/memory_pools.o memory_pools.c
+
 ${OBJECTDIR}/memset.o: memset.s
 	${MKDIR} -p ${OBJECTDIR}
 	$(AS) $(ASFLAGS) -g -o ${OBJECTDIR}/memset.o memset.s
 
+${OBJECTDIR}/mmu_control.o: mmu_control.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/mmu_control.o mmu_control.c
+
 ${OBJECTDIR}/power_and_battery.o: power_and_battery.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/power_and_battery.o power_and_battery.c
 
+${OBJECTDIR}/protocol_decoder.o: protocol_decoder.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/protocol_decoder.o protocol_decoder.c
+
 ${OBJECTDIR}/scope_functions.o: scope_functions.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
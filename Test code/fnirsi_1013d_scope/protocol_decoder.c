@@ -0,0 +1,436 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Protocol decoders for captured traces
+//
+//A channel is first sliced to logic levels with two levels for hysteresis, and the result is run length coded as the list of sample
+//positions where the level changes. The decoders only walk these lists, which are short compared to the sample buffers, so a full
+//buffer of samples is decoded in a small part of the time it takes to draw a trace.
+//
+//UART is decoded as 8 data bits, no parity and one stop bit on an idle high line. The bit time is found from the shortest run in the
+//trace and refined with the runs that are a whole number of bits long. This needs at least one single bit run in the trace.
+//
+//I2C needs a start condition in the trace to get in sync, and SPI uses pauses in the clock to find the start of a byte, since the
+//chip select line is not available on a two channel scope.
+//
+//The functions only work on memory buffers, so they also build for the host.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "protocol_decoder.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the number of level changes found. The level only changes when the signal passes the level on the other side, so noise
+//around a single threshold does not give extra edges
+
+uint32 decoder_slice_channel(uint8 *samples, uint32 count, uint32 lowlevel, uint32 highlevel, PDECODERSTREAM stream)
+{
+  register uint8  *sptr = samples;
+  register uint16 *eptr = stream->edges;
+  register uint32  level;
+  register uint32  index;
+  register uint32  sample;
+
+  //The edge list has room for a full sample buffer
+  if(count > DECODER_MAX_EDGES)
+  {
+    count = DECODER_MAX_EDGES;
+  }
+
+  stream->samples = count;
+  stream->count   = 0;
+
+  if(count == 0)
+  {
+    stream->startlevel = 0;
+    return(0);
+  }
+
+  //The first sample is taken on the center between the two levels
+  level = (sptr[0] > ((lowlevel + highlevel) / 2));
+
+  stream->startlevel = level;
+
+  for(index=1;index<count;index++)
+  {
+    sample = sptr[index];
+
+    if(level)
+    {
+      //High so check if it goes below the low level
+      if(sample < lowlevel)
+      {
+        level = 0;
+        *eptr++ = index;
+      }
+    }
+    else
+    {
+      //Low so check if it goes above the high level
+      if(sample > highlevel)
+      {
+        level = 1;
+        *eptr++ = index;
+      }
+    }
+  }
+
+  stream->count = eptr - stream->edges;
+
+  return(stream->count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the logic level on the given sample position. The edge index is kept by the caller, so walking through a stream with
+//increasing positions only needs a single pass over the edges
+
+uint32 decoder_get_level(PDECODERSTREAM stream, uint32 *edge, uint32 position)
+{
+  register uint32 index = *edge;
+
+  //Skip the changes up to and including the position
+  while((index < stream->count) && (stream->edges[index] <= position))
+  {
+    index++;
+  }
+
+  *edge = index;
+
+  //Every change flips the level
+  return(stream->startlevel ^ (index & 1));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the length of the shortest complete run, or zero when there is none. Runs shorter than a bit can be are skipped
+
+uint32 decoder_shortest_run(PDECODERSTREAM stream)
+{
+  uint32 shortest = 0;
+  uint32 index;
+  uint32 run;
+
+  //The runs before the first and after the last change are cut off by the buffer, so only the ones in between are complete
+  for(index=1;index<stream->count;index++)
+  {
+    run = stream->edges[index] - stream->edges[index - 1];
+
+    if((run >= DECODER_MIN_BIT_SAMPLES) && ((shortest == 0) || (run < shortest)))
+    {
+      shortest = run;
+    }
+  }
+
+  return(shortest);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the bit time in samples with DECODER_FRACTION_BITS fraction bits, or zero when it can not be determined
+
+uint32 decoder_uart_bit_time(PDECODERSTREAM stream)
+{
+  uint32 bittime = decoder_shortest_run(stream) << DECODER_FRACTION_BITS;
+  uint32 total;
+  uint32 bits;
+  uint32 pass;
+  uint32 index;
+  uint32 run;
+  uint32 count;
+  int32  error;
+
+  if(bittime == 0)
+  {
+    return(0);
+  }
+
+  //The shortest run is taken as a single bit. Averaging over the runs that are close to a whole number of bits gives the fraction of
+  //the bit time. Runs that include idle time are not, and the estimate gets better with every pass
+  for(pass=0;pass<DECODER_BAUD_PASSES;pass++)
+  {
+    total = 0;
+    bits  = 0;
+
+    for(index=1;index<stream->count;index++)
+    {
+      run = (stream->edges[index] - stream->edges[index - 1]) << DECODER_FRACTION_BITS;
+
+      //Number of bits in this run, rounded, and how far it is off
+      count = (run + (bittime / 2)) / bittime;
+      error = run - (count * bittime);
+
+      if((count > 0) && (count <= DECODER_MAX_FRAME_BITS) && (error <= (int32)(bittime / 4)) && (error >= -(int32)(bittime / 4)))
+      {
+        total += run;
+        bits  += count;
+      }
+    }
+
+    //The shortest run itself is always used, so there is at least one bit
+    bittime = total / bits;
+  }
+
+  return(bittime);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the number of decoded bytes. Every falling edge after a complete frame is taken as the start of a new frame, and the bits
+//are taken in the middle of their time
+
+uint32 decoder_uart(PDECODERSTREAM stream, PDECODERRESULT result)
+{
+  uint32 bittime;
+  uint32 edge = 0;
+  uint32 start;
+  uint32 stop;
+  uint32 end;
+  uint32 bit;
+  uint32 value;
+  uint32 flags;
+
+  result->count = 0;
+
+  //Find the baud rate from the trace itself
+  bittime = decoder_uart_bit_time(stream);
+
+  result->bittime = bittime;
+
+  if(bittime == 0)
+  {
+    return(0);
+  }
+
+  while(1)
+  {
+    //Look for a change to low, which is the start of a start bit on an idle high line
+    while((edge < stream->count) && (stream->startlevel ^ ((edge + 1) & 1)))
+    {
+      edge++;
+    }
+
+    if(edge >= stream->count)
+    {
+      break;
+    }
+
+    start = stream->edges[edge];
+
+    //The middle of the stop bit has to be in the buffer
+    stop = start + ((bittime * 19) >> (DECODER_FRACTION_BITS + 1));
+
+    if(stop >= stream->samples)
+    {
+      break;
+    }
+
+    //The start bit has to be low halfway, otherwise it was a glitch and the search goes on after it
+    if(decoder_get_level(stream, &edge, start + (bittime >> (DECODER_FRACTION_BITS + 1))))
+    {
+      continue;
+    }
+
+    //Take the data bits, least significant bit first
+    value = 0;
+
+    for(bit=0;bit<8;bit++)
+    {
+      value |= decoder_get_level(stream, &edge, start + ((bittime * ((bit * 2) + 3)) >> (DECODER_FRACTION_BITS + 1))) << bit;
+    }
+
+    //A low stop bit signals a framing error
+    if(decoder_get_level(stream, &edge, stop))
+    {
+      flags = 0;
+    }
+    else
+    {
+      flags = DECODER_FLAG_ERROR;
+    }
+
+    //The frame ends after the stop bit
+    end = start + ((bittime * 10) >> DECODER_FRACTION_BITS);
+
+    if(end > stream->samples)
+    {
+      end = stream->samples;
+    }
+
+    if(decoder_add_item(result, start, end, value, flags) == 0)
+    {
+      break;
+    }
+  }
+
+  return(result->count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the number of decoded bytes. The changes on both lines are taken in time order. A data change while the clock is high is a
+//start or stop condition, otherwise the data is taken on the rising clock edges
+
+uint32 decoder_i2c(PDECODERSTREAM scl, PDECODERSTREAM sda, PDECODERRESULT result)
+{
+  uint32 sclindex = 0;
+  uint32 sdaindex = 0;
+  uint32 scllevel = scl->startlevel;
+  uint32 sdalevel = sda->startlevel;
+  uint32 position;
+  uint32 started = 0;
+  uint32 bits = 0;
+  uint32 value = 0;
+  uint32 flags = 0;
+  uint32 start = 0;
+
+  result->count   = 0;
+  result->bittime = 0;
+
+  while((sclindex < scl->count) || (sdaindex < sda->count))
+  {
+    //When both lines change on the same sample a falling clock goes first, since the data is changed after the clock went low
+    if((sdaindex < sda->count) && ((sclindex >= scl->count) || (sda->edges[sdaindex] < scl->edges[sclindex]) ||
+       ((sda->edges[sdaindex] == scl->edges[sclindex]) && (scllevel == 0))))
+    {
+      sdaindex++;
+      sdalevel ^= 1;
+
+      //Check on a start or stop condition
+      if(scllevel)
+      {
+        if(sdalevel == 0)
+        {
+          //Start, or repeated start, so the next byte is an address
+          started = 1;
+          bits    = 0;
+          value   = 0;
+          flags   = DECODER_FLAG_ADDRESS;
+        }
+        else
+        {
+          //Stop, so wait for the next start
+          started = 0;
+        }
+      }
+    }
+    else
+    {
+      position = scl->edges[sclindex++];
+      scllevel ^= 1;
+
+      //Data is taken on the rising clock edge
+      if(scllevel && started)
+      {
+        if(bits < 8)
+        {
+          //Most significant bit first
+          if(bits == 0)
+          {
+            start = position;
+          }
+
+          value = (value << 1) | sdalevel;
+          bits++;
+        }
+        else
+        {
+          //The ninth bit is the acknowledge, which is a low from the receiver
+          if(sdalevel == 0)
+          {
+            flags |= DECODER_FLAG_ACK;
+          }
+
+          if(decoder_add_item(result, start, position, value, flags) == 0)
+          {
+            break;
+          }
+
+          bits  = 0;
+          value = 0;
+          flags = 0;
+        }
+      }
+    }
+  }
+
+  return(result->count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the number of decoded bytes. The data is taken on the selected clock edge, most significant bit first
+
+uint32 decoder_spi(PDECODERSTREAM clock, PDECODERSTREAM data, uint32 edge, PDECODERRESULT result)
+{
+  uint32 gap;
+  uint32 index;
+  uint32 dataedge = 0;
+  uint32 position;
+  uint32 previous = 0;
+  uint32 bits = 0;
+  uint32 value = 0;
+  uint32 start = 0;
+
+  result->count   = 0;
+  result->bittime = 0;
+
+  //A pause of a number of clock periods ends a transfer, so a byte that was cut off does not shift the next ones
+  gap = decoder_shortest_run(clock) * DECODER_SPI_GAP_FACTOR;
+
+  for(index=0;index<clock->count;index++)
+  {
+    //Only the changes to the selected level are used
+    if((clock->startlevel ^ ((index + 1) & 1)) != edge)
+    {
+      continue;
+    }
+
+    position = clock->edges[index];
+
+    //Start over on a pause in the clock
+    if(bits && ((position - previous) > gap))
+    {
+      bits  = 0;
+      value = 0;
+    }
+
+    previous = position;
+
+    if(bits == 0)
+    {
+      start = position;
+    }
+
+    value = (value << 1) | decoder_get_level(data, &dataedge, position);
+    bits++;
+
+    if(bits == 8)
+    {
+      if(decoder_add_item(result, start, position, value, 0) == 0)
+      {
+        break;
+      }
+
+      bits  = 0;
+      value = 0;
+    }
+  }
+
+  return(result->count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns zero when the result is full
+
+uint32 decoder_add_item(PDECODERRESULT result, uint32 start, uint32 end, uint32 value, uint32 flags)
+{
+  PDECODERITEM item;
+
+  if(result->count >= DECODER_MAX_ITEMS)
+  {
+    return(0);
+  }
+
+  item = &result->items[result->count++];
+
+  item->start = start;
+  item->end   = end;
+  item->value = value;
+  item->flags = flags;
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
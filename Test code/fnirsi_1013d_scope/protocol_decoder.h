@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef PROTOCOL_DECODER_H
+#define PROTOCOL_DECODER_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "types.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Decoder modes. UART works on channel 1, I2C uses channel 1 for SCL and channel 2 for SDA, SPI uses channel 1 for the clock and
+//channel 2 for the data line
+#define DECODER_MODE_OFF                 0
+#define DECODER_MODE_UART                1
+#define DECODER_MODE_I2C                 2
+#define DECODER_MODE_SPI                 3
+
+#define DECODER_MODE_MAX                 DECODER_MODE_SPI
+
+//A level change can happen on every sample, so the edge list needs room for a full sample buffer
+#define DECODER_MAX_EDGES             3000
+
+//Number of decoded bytes kept for a single trace
+#define DECODER_MAX_ITEMS              256
+
+//The UART bit time is kept in samples with 8 fraction bits
+#define DECODER_FRACTION_BITS            8
+
+//A bit needs at least two samples to be found back. Shorter runs are seen as glitches by the auto baud
+#define DECODER_MIN_BIT_SAMPLES          2
+
+//Longest run, in bits, that is used for refining the UART bit time. Longer runs are idle time
+#define DECODER_MAX_FRAME_BITS          10
+
+//Number of times the UART bit time is refined
+#define DECODER_BAUD_PASSES              2
+
+//A pause in the SPI clock of more than this number of the shortest clock half periods starts a new byte
+#define DECODER_SPI_GAP_FACTOR           8
+
+//SPI data is taken on the rising or on the falling clock edge
+#define DECODER_SPI_RISING_EDGE          1
+#define DECODER_SPI_FALLING_EDGE         0
+
+//Flags for the decoded bytes
+#define DECODER_FLAG_ERROR            0x01       //UART stop bit not found
+#define DECODER_FLAG_ADDRESS          0x02       //I2C byte following a (repeated) start condition
+#define DECODER_FLAG_ACK              0x04       //I2C byte acknowledged by the receiver
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct tagDecoderStream       DECODERSTREAM,    *PDECODERSTREAM;
+typedef struct tagDecoderItem         DECODERITEM,      *PDECODERITEM;
+typedef struct tagDecoderResult       DECODERRESULT,    *PDECODERRESULT;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A channel sliced to logic levels, run length coded as the sample positions where the level changes
+
+struct tagDecoderStream
+{
+  uint32 samples;                          //Number of samples the stream is made from
+  uint32 startlevel;                       //Logic level of the first sample
+  uint32 count;                            //Number of level changes
+  uint16 edges[DECODER_MAX_EDGES];         //First sample with the new level for every change
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagDecoderItem
+{
+  uint16 start;                            //First sample of the byte
+  uint16 end;                              //Sample where the byte ends
+  uint8  value;
+  uint8  flags;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagDecoderResult
+{
+  uint32      count;
+  uint32      bittime;                     //Bit time found by the UART auto baud
+  DECODERITEM items[DECODER_MAX_ITEMS];
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 decoder_slice_channel(uint8 *samples, uint32 count, uint32 lowlevel, uint32 highlevel, PDECODERSTREAM stream);
+uint32 decoder_get_level(PDECODERSTREAM stream, uint32 *edge, uint32 position);
+uint32 decoder_shortest_run(PDECODERSTREAM stream);
+
+uint32 decoder_uart_bit_time(PDECODERSTREAM stream);
+uint32 decoder_uart(PDECODERSTREAM stream, PDECODERRESULT result);
+uint32 decoder_i2c(PDECODERSTREAM scl, PDECODERSTREAM sda, PDECODERRESULT result);
+uint32 decoder_spi(PDECODERSTREAM clock, PDECODERSTREAM data, uint32 edge, PDECODERRESULT result);
+
+uint32 decoder_add_item(PDECODERRESULT result, uint32 start, uint32 end, uint32 value, uint32 flags);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* PROTOCOL_DECODER_H */
+
@@ -10,9 +10,12 @@
 #include "sd_card_interface.h"
 #include "display_lib.h"
 #include "ff.h"
+#include "diskio.h"
 
 #include "usb_interface.h"
 #include "variables.h"
+#include "memory_pools.h"
+#include "mmu_control.h"
 
 #include "sin_cos_math.h"
 
@@ -27,6 +30,60 @@ void scope_setup_display_lib(void)
   display_set_screen_buffer((uint16 *)maindisplaybuffer);
 
   display_set_dimensions(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+  //The trace lines are clipped on the trace part of the screen
+  display_set_clip_window(TRACE_WINDOW_XPOS, TRACE_WINDOW_YPOS, TRACE_WINDOW_WIDTH, TRACE_WINDOW_HEIGHT);
+
+  //Setup the intensity to color table for the persistence mode
+  scope_setup_persistence_colors();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_setup_persistence_colors(void)
+{
+  //Intensity levels with their colors to go from dark blue for a single hit up to white for the most hit pixels
+  const uint32 stops[][2] =
+  {
+    {   0, 0x00000000 },
+    {   1, 0x00000080 },
+    {  32, 0x000040FF },
+    {  64, 0x0000FFFF },
+    { 112, 0x0000FF00 },
+    { 160, 0x00FFFF00 },
+    { 208, 0x00FF0000 },
+    { 255, 0x00FFFFFF }
+  };
+
+  uint32 stop;
+  uint32 index;
+  uint32 steps;
+  uint32 step;
+  uint32 r, g, b;
+
+  //No hits is black
+  persistencecolors[0] = 0;
+
+  //Fill in the colors between every two stops
+  for(stop=1;stop<(sizeof(stops) / sizeof(stops[0]));stop++)
+  {
+    //Number of entries to go from the previous stop to this one
+    steps = stops[stop][0] - stops[stop - 1][0];
+
+    for(step=1;step<=steps;step++)
+    {
+      //Blend the colors of the two stops
+      r = ((((stops[stop - 1][1] >> 16) & 0xFF) * (steps - step)) + (((stops[stop][1] >> 16) & 0xFF) * step)) / steps;
+      g = ((((stops[stop - 1][1] >>  8) & 0xFF) * (steps - step)) + (((stops[stop][1] >>  8) & 0xFF) * step)) / steps;
+      b = ((((stops[stop - 1][1]      ) & 0xFF) * (steps - step)) + (((stops[stop][1]      ) & 0xFF) * step)) / steps;
+
+      //Entry in the table for this step
+      index = stops[stop - 1][0] + step;
+
+      //Convert to the RGB565 screen format
+      persistencecolors[index] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -222,6 +279,9 @@ void scope_setup_usb_screen(void)
   display_set_fg_color(0x00AAAAAA);
   display_text(125, 254, "ON / OFF");
 
+  //Make sure all the file system data is on the card before the host gets access to it
+  disk_ioctl(0, CTRL_SYNC, 0);
+
   //Start the USB interface
   usb_device_enable();
 
@@ -248,6 +308,10 @@ void scope_setup_usb_screen(void)
   //Stop the USB interface
   usb_device_disable();
 
+  //The host might have changed the card, so drop the cached sectors and mount the file system again
+  disk_ioctl(0, CTRL_INVALIDATE, 0);
+  f_mount(&fs, "0", 1);
+
   //Re-sync the system files
   scope_sync_thumbnail_files();
 }
@@ -2283,11 +2347,13 @@ void scope_open_channel_menu(PCHANNELSETTINGS settings)
   xstart = settings->menuxpos + 14;
   xend   = settings->menuxpos + CH_MENU_WIDTH - 14;
 
-  //Three black lines between the settings
+  //Five black lines between the settings
   display_set_fg_color(0x00000000);
   display_draw_horz_line(CH_MENU_YPOS +  62, xstart, xend);
   display_draw_horz_line(CH_MENU_YPOS + 124, xstart, xend);
   display_draw_horz_line(CH_MENU_YPOS + 188, xstart, xend);
+  display_draw_horz_line(CH_MENU_YPOS + 250, xstart, xend);
+  display_draw_horz_line(CH_MENU_YPOS + 312, xstart, xend);
 
   //Main texts in white
   display_set_fg_color(0x00FFFFFF);
@@ -2304,12 +2370,18 @@ void scope_open_channel_menu(PCHANNELSETTINGS settings)
   display_text(settings->menuxpos + 18, CH_MENU_YPOS + 154, "ling");
   display_text(settings->menuxpos + 15, CH_MENU_YPOS + 201, "probe");
   display_text(settings->menuxpos + 15, CH_MENU_YPOS + 219, "mode");
+  display_text(settings->menuxpos + 15, CH_MENU_YPOS + 263, "math");
+  display_text(settings->menuxpos + 15, CH_MENU_YPOS + 281, "mode");
+  display_text(settings->menuxpos + 15, CH_MENU_YPOS + 325, "bus");
+  display_text(settings->menuxpos + 15, CH_MENU_YPOS + 343, "decode");
 
   //Display the actual settings
   scope_channel_enable_select(settings);
   scope_channel_fft_show(settings);
   scope_channel_coupling_select(settings);
   scope_channel_probe_magnification_select(settings);
+  scope_channel_math_mode_select(settings);
+  scope_channel_decoder_mode_select(settings);
 
   //Set source and target for getting it on the actual screen
   display_set_source_buffer(displaybuffer1);
@@ -2671,6 +2743,62 @@ void scope_channel_probe_magnification_select(PCHANNELSETTINGS settings)
   display_text(settings->menuxpos + 149, CH_MENU_YPOS + 219, "X");
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//The math channel is shared by the two channel menus. Every touch on the setting selects the next function
+
+void scope_channel_math_mode_select(PCHANNELSETTINGS settings)
+{
+  //Select the font for the texts
+  display_set_font(&font_3);
+
+  //Check if the math channel is off
+  if(scopesettings.mathmode == MATH_MODE_OFF)
+  {
+    //Dark grey box with white text when off
+    display_set_fg_color(0x00181818);
+    display_fill_rect(settings->menuxpos + 78, CH_MENU_YPOS + 261, 84, 38);
+    display_set_fg_color(0x00FFFFFF);
+  }
+  else
+  {
+    //Math channel color box with black text when on
+    display_set_fg_color(MATH_COLOR);
+    display_fill_rect(settings->menuxpos + 78, CH_MENU_YPOS + 261, 84, 38);
+    display_set_fg_color(0x00000000);
+  }
+
+  //Display the function
+  display_text(settings->menuxpos + 90, CH_MENU_YPOS + 272, (int8 *)math_mode_texts[scopesettings.mathmode]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The protocol decoder is also shared by the two channel menus. Every touch on the setting selects the next protocol
+
+void scope_channel_decoder_mode_select(PCHANNELSETTINGS settings)
+{
+  //Select the font for the texts
+  display_set_font(&font_3);
+
+  //Check if the decoder is off
+  if(scopesettings.decodermode == DECODER_MODE_OFF)
+  {
+    //Dark grey box with white text when off
+    display_set_fg_color(0x00181818);
+    display_fill_rect(settings->menuxpos + 78, CH_MENU_YPOS + 323, 84, 38);
+    display_set_fg_color(0x00FFFFFF);
+  }
+  else
+  {
+    //Decoder color box with black text when on
+    display_set_fg_color(DECODER_COLOR);
+    display_fill_rect(settings->menuxpos + 78, CH_MENU_YPOS + 323, 84, 38);
+    display_set_fg_color(0x00000000);
+  }
+
+  //Display the protocol
+  display_text(settings->menuxpos + 90, CH_MENU_YPOS + 334, (int8 *)decoder_mode_texts[scopesettings.decodermode]);
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void scope_open_acquisition_menu(void)
@@ -2693,6 +2821,7 @@ void scope_open_acquisition_menu(void)
   //A black line between the settings
   display_set_fg_color(0x00000000);
   display_draw_horz_line(ACQ_MENU_YPOS +  158, ACQ_MENU_XPOS + 8, ACQ_MENU_XPOS + ACQ_MENU_WIDTH - 8);
+  display_draw_horz_line(ACQ_MENU_YPOS +  336, ACQ_MENU_XPOS + 8, ACQ_MENU_XPOS + ACQ_MENU_WIDTH - 8);
 
   //Main texts in white
   display_set_fg_color(0x00FFFFFF);
@@ -2703,10 +2832,12 @@ void scope_open_acquisition_menu(void)
   //Display the texts
   display_text(ACQ_MENU_XPOS + 111, ACQ_MENU_YPOS +   8, "Sample Rate");
   display_text(ACQ_MENU_XPOS +  97, ACQ_MENU_YPOS + 166, "Time per Division");
+  display_text(ACQ_MENU_XPOS +  96, ACQ_MENU_YPOS + 344, "Acquisition Mode");
 
   //Display the actual settings
   scope_acquisition_speed_select();
   scope_acquisition_timeperdiv_select();
+  scope_acquisition_mode_select();
 
   //Set source and target for getting it on the actual screen
   display_set_source_buffer(displaybuffer1);
@@ -2783,6 +2914,95 @@ void scope_acquisition_speed_select(void)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void scope_acquisition_mode_select(void)
+{
+  uint32 i,x;
+  const int8 **texts;
+  const int8  *offsets;
+
+  //Select the font for the texts
+  display_set_font(&font_2);
+
+  //Mode items on a single row
+  for(i=0;i<(sizeof(acquisition_mode_texts) / sizeof(int8 *));i++)
+  {
+    x = (i * 57) + 10;
+
+    //Highlight the selected item, the others on dark grey
+    if(i == scopesettings.acquisitionmode)
+    {
+      display_set_fg_color(TRIGGER_COLOR);
+    }
+    else
+    {
+      display_set_fg_color(0x00383838);
+    }
+
+    display_fill_rect(ACQ_MENU_XPOS + x, ACQ_MENU_YPOS + 369, 53, 20);
+
+    //Selected text in black, the others in white
+    if(i == scopesettings.acquisitionmode)
+    {
+      display_set_fg_color(0x00000000);
+    }
+    else
+    {
+      display_set_fg_color(0x00FFFFFF);
+    }
+
+    display_text(ACQ_MENU_XPOS + (i * 57) + acquisition_mode_text_x_offsets[i], ACQ_MENU_YPOS + 372, (int8 *)acquisition_mode_texts[i]);
+  }
+
+  //The row below sets the number of acquisitions to average, or the number of segments for segmented capture
+  if(scopesettings.acquisitionmode == ACQUISITION_MODE_SEGMENTED)
+  {
+    texts   = segment_count_texts;
+    offsets = segment_count_text_x_offsets;
+  }
+  else
+  {
+    texts   = average_count_texts;
+    offsets = average_count_text_x_offsets;
+  }
+
+  //Smaller boxes for these
+  for(i=0;i<ACQUISITION_MAX_AVERAGE_SHIFT;i++)
+  {
+    x = (i * 36) + 10;
+
+    if((i + 1) == scopesettings.averageshift)
+    {
+      display_set_fg_color(TRIGGER_COLOR);
+    }
+    else
+    {
+      display_set_fg_color(0x00383838);
+    }
+
+    display_fill_rect(ACQ_MENU_XPOS + x, ACQ_MENU_YPOS + 392, 32, 20);
+
+    if((i + 1) == scopesettings.averageshift)
+    {
+      //Selected text in black
+      display_set_fg_color(0x00000000);
+    }
+    else if((scopesettings.acquisitionmode == ACQUISITION_MODE_AVERAGE) || (scopesettings.acquisitionmode == ACQUISITION_MODE_EXP_AVERAGE) || (scopesettings.acquisitionmode == ACQUISITION_MODE_SEGMENTED))
+    {
+      //Not selected texts in white when the setting is used
+      display_set_fg_color(0x00FFFFFF);
+    }
+    else
+    {
+      //And in grey when it is not
+      display_set_fg_color(0x00686868);
+    }
+
+    display_text(ACQ_MENU_XPOS + (i * 36) + offsets[i], ACQ_MENU_YPOS + 395, (int8 *)texts[i]);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void scope_acquisition_timeperdiv_select(void)
 {
   uint32 c,i,x,y;
@@ -3222,18 +3442,18 @@ void scope_open_system_settings_menu(void)
   display_set_fg_color(0x00181818);
 
   //Fill the background
-  display_fill_rect(150, 46, 244, 353);
+  display_fill_rect(150, 46, 244, 425);
 
   //Draw the edge in a lighter grey
   display_set_fg_color(0x00333333);
 
   //Draw the edge
-  display_draw_rect(150, 46, 244, 353);
+  display_draw_rect(150, 46, 244, 425);
 
-  //Five black lines between the settings
+  //Seven black lines between the settings
   display_set_fg_color(0x00000000);
 
-  for(y=104;y<350;y+=59)
+  for(y=98;y<420;y+=53)
   {
     display_draw_horz_line(y, 159, 385);
   }
@@ -3245,13 +3465,15 @@ void scope_open_system_settings_menu(void)
   scope_system_settings_calibration_item(0);
   scope_system_settings_x_y_mode_item();
   scope_system_settings_confirmation_item();
+  scope_system_settings_persistence_item();
+  scope_system_settings_file_compression_item();
 
   //Set source and target for getting it on the actual screen
   display_set_source_buffer(displaybuffer1);
   display_set_screen_buffer((uint16 *)maindisplaybuffer);
 
   //Slide the image onto the actual screen. The speed factor makes it start fast and end slow, Smaller value makes it slower.
-  display_slide_left_rect_onto_screen(150, 46, 244, 353, 63039);
+  display_slide_left_rect_onto_screen(150, 46, 244, 425, 63039);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3271,7 +3493,7 @@ void scope_system_settings_screen_brightness_item(int mode)
   }
 
   //Draw the background
-  display_fill_rect(159, 59, 226, 36);
+  display_fill_rect(159, 56, 226, 36);
 
   //Check if inactive or active
   if(mode == 0)
@@ -3288,12 +3510,12 @@ void scope_system_settings_screen_brightness_item(int mode)
   }
 
   //Display the icon with the set colors
-  display_copy_icon_use_colors(screen_brightness_icon, 171, 63, 24, 24);
+  display_copy_icon_use_colors(screen_brightness_icon, 171, 60, 24, 24);
 
   //Display the text
   display_set_font(&font_3);
-  display_text(231, 60, "Screen");
-  display_text(220, 76, "brightness");
+  display_text(231, 57, "Screen");
+  display_text(220, 73, "brightness");
 
   //Show the actual setting
   scope_system_settings_screen_brightness_value();
@@ -3305,12 +3527,12 @@ void scope_system_settings_screen_brightness_value(void)
 {
   //Draw the yellow background
   display_set_fg_color(0x00FFFF00);
-  display_fill_rect(332, 67, 32, 15);
+  display_fill_rect(332, 64, 32, 15);
 
   //Display the number with fixed width font and black color
   display_set_font(&font_0);
   display_set_fg_color(0x00000000);
-  display_decimal(337, 68, scopesettings.screenbrightness);
+  display_decimal(337, 65, scopesettings.screenbrightness);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3330,7 +3552,7 @@ void scope_system_settings_grid_brightness_item(int mode)
   }
 
   //Draw the background
-  display_fill_rect(159, 116, 226, 36);
+  display_fill_rect(159, 109, 226, 36);
 
   //Check if inactive or active
   if(mode == 0)
@@ -3347,12 +3569,12 @@ void scope_system_settings_grid_brightness_item(int mode)
   }
 
   //Display the icon with the set colors
-  display_copy_icon_use_colors(grid_brightness_icon, 171, 122, 24, 24);
+  display_copy_icon_use_colors(grid_brightness_icon, 171, 113, 24, 24);
 
   //Display the text
   display_set_font(&font_3);
-  display_text(240, 119, "Grid");
-  display_text(220, 135, "brightness");
+  display_text(240, 110, "Grid");
+  display_text(220, 126, "brightness");
 
   //Show the actual setting
   scope_system_settings_grid_brightness_value();
@@ -3364,12 +3586,12 @@ void scope_system_settings_grid_brightness_value(void)
 {
   //Draw the yellow background
   display_set_fg_color(0x00FFFF00);
-  display_fill_rect(332, 124, 32, 15);
+  display_fill_rect(332, 117, 32, 15);
 
   //Display the number with fixed width font and black color
   display_set_font(&font_0);
   display_set_fg_color(0x00000000);
-  display_decimal(337, 125, scopesettings.gridbrightness);
+  display_decimal(337, 118, scopesettings.gridbrightness);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3381,15 +3603,15 @@ void scope_system_settings_trigger_50_item(void)
   display_set_bg_color(0x00181818);
 
   //Display the icon with the set colors
-  display_copy_icon_use_colors(trigger_50_percent_icon, 171, 181, 24, 24);
+  display_copy_icon_use_colors(trigger_50_percent_icon, 171, 166, 24, 24);
 
   //Display the text
   display_set_font(&font_3);
-  display_text(229, 178, "Always");
-  display_text(217, 194, "trigger 50%");
+  display_text(229, 163, "Always");
+  display_text(217, 179, "trigger 50%");
 
   //Show the state
-  scope_display_slide_button(326, 183, scopesettings.alwaystrigger50);
+  scope_display_slide_button(326, 168, scopesettings.alwaystrigger50);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3409,7 +3631,7 @@ void scope_system_settings_calibration_item(int mode)
   }
 
   //Draw the background
-  display_fill_rect(159, 235, 226, 36);
+  display_fill_rect(159, 215, 226, 36);
 
   //Check if inactive or active
   if(mode == 0)
@@ -3426,12 +3648,12 @@ void scope_system_settings_calibration_item(int mode)
   }
 
   //Display the icon with the set colors
-  display_copy_icon_use_colors(baseline_calibration_icon, 171, 239, 24, 25);
+  display_copy_icon_use_colors(baseline_calibration_icon, 171, 219, 24, 25);
 
   //Display the text
   display_set_font(&font_3);
-  display_text(225, 237, "Baseline");
-  display_text(219, 253, "calibration");
+  display_text(225, 216, "Baseline");
+  display_text(219, 232, "calibration");
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3443,15 +3665,15 @@ void scope_system_settings_x_y_mode_item(void)
   display_set_bg_color(0x00181818);
 
   //Display the icon with the set colors
-  display_copy_icon_use_colors(x_y_mode_display_icon, 171, 297, 24, 24);
+  display_copy_icon_use_colors(x_y_mode_display_icon, 171, 272, 24, 24);
 
   //Display the text
   display_set_font(&font_3);
-  display_text(223, 295, "X-Y mode");
-  display_text(231, 311, "display");
+  display_text(223, 269, "X-Y mode");
+  display_text(231, 285, "display");
 
   //Show the state
-  scope_display_slide_button(326, 299, scopesettings.xymodedisplay);
+  scope_display_slide_button(326, 274, scopesettings.xymodedisplay);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3463,15 +3685,55 @@ void scope_system_settings_confirmation_item(void)
   display_set_bg_color(0x00181818);
 
   //Display the icon with the set colors
-  display_copy_icon_use_colors(confirmation_icon, 171, 356, 24, 24);
+  display_copy_icon_use_colors(confirmation_icon, 171, 325, 24, 24);
+
+  //Display the text
+  display_set_font(&font_3);
+  display_text(217, 322, "Notification");
+  display_text(213, 338, "confirmation");
+
+  //Show the state
+  scope_display_slide_button(326, 327, scopesettings.confirmationmode);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_system_settings_persistence_item(void)
+{
+  //Set the colors for white foreground and grey background
+  display_set_fg_color(0x00FFFFFF);
+  display_set_bg_color(0x00181818);
+
+  //Display the icon with the set colors
+  display_copy_icon_use_colors(persistence_icon, 171, 378, 24, 24);
+
+  //Display the text
+  display_set_font(&font_3);
+  display_text(222, 375, "Persistence");
+  display_text(231, 391, "display");
+
+  //Show the state
+  scope_display_slide_button(326, 380, scopesettings.persistence != 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_system_settings_file_compression_item(void)
+{
+  //Set the colors for white foreground and grey background
+  display_set_fg_color(0x00FFFFFF);
+  display_set_bg_color(0x00181818);
+
+  //Display the icon with the set colors
+  display_copy_icon_use_colors(file_compression_icon, 171, 431, 24, 24);
 
   //Display the text
   display_set_font(&font_3);
-  display_text(217, 354, "Notification");
-  display_text(213, 370, "confirmation");
+  display_text(233, 428, "Compress");
+  display_text(216, 444, "saved files");
 
   //Show the state
-  scope_display_slide_button(326, 358, scopesettings.confirmationmode);
+  scope_display_slide_button(326, 433, scopesettings.filecompression);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3480,35 +3742,35 @@ void scope_open_calibration_start_text(void)
 {
   //Save the screen under the baseline calibration start text
   display_set_destination_buffer(displaybuffer2);
-  display_copy_rect_from_screen(395, 222, 199, 59);
+  display_copy_rect_from_screen(395, 204, 199, 59);
 
   //Setup the text in a separate buffer to be able to slide it onto the screen
   display_set_screen_buffer(displaybuffer1);
 
   //Draw the background in dark grey
   display_set_fg_color(0x00181818);
-  display_fill_rect(395, 222, 199, 59);
+  display_fill_rect(395, 204, 199, 59);
 
   //Draw the edge in a lighter grey
   display_set_fg_color(0x00333333);
-  display_draw_rect(395, 222, 199, 59);
+  display_draw_rect(395, 204, 199, 59);
 
   //Display the text in white
   display_set_fg_color(0x00FFFFFF);
   display_set_font(&font_3);
-  display_text(409, 227, "Please unplug");
-  display_text(409, 243, "the probe and");
-  display_text(409, 259, "USB first !");
+  display_text(409, 209, "Please unplug");
+  display_text(409, 225, "the probe and");
+  display_text(409, 241, "USB first !");
 
   //Add the ok button
-  scope_display_ok_button(517, 230, 0);
+  scope_display_ok_button(517, 212, 0);
 
   //Set source and target for getting it on the actual screen
   display_set_source_buffer(displaybuffer1);
   display_set_screen_buffer((uint16 *)maindisplaybuffer);
 
   //Slide the image onto the actual screen. The speed factor makes it start fast and end slow, Smaller value makes it slower.
-  display_slide_left_rect_onto_screen(395, 222, 199, 59, 63039);
+  display_slide_left_rect_onto_screen(395, 204, 199, 59, 63039);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3517,20 +3779,20 @@ void scope_show_calibrating_text(void)
 {
   //Restore the screen from under the calibration start text to get rid of it
   display_set_source_buffer(displaybuffer2);
-  display_copy_rect_to_screen(395, 222, 199, 59);
+  display_copy_rect_to_screen(395, 204, 199, 59);
 
   //Draw the background in dark grey
   display_set_fg_color(0x00181818);
-  display_fill_rect(395, 222, 110, 59);
+  display_fill_rect(395, 204, 110, 59);
 
   //Draw the edge in a lighter grey
   display_set_fg_color(0x00333333);
-  display_draw_rect(395, 222, 110, 59);
+  display_draw_rect(395, 204, 110, 59);
 
   //Display the text in white
   display_set_fg_color(0x00FFFFFF);
   display_set_font(&font_3);
-  display_text(409, 243, "Calibrating...");
+  display_text(409, 225, "Calibrating...");
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -3539,17 +3801,17 @@ void scope_show_calibration_done_text(void)
 {
   //Draw the background in dark grey
   display_set_fg_color(0x00181818);
-  display_fill_rect(395, 222, 110, 59);
+  display_fill_rect(395, 204, 110, 59);
 
   //Draw the edge in a lighter grey
   display_set_fg_color(0x00333333);
-  display_draw_rect(395, 222, 110, 59);
+  display_draw_rect(395, 204, 110, 59);
 
   //Display the text in white
   display_set_fg_color(0x00FFFFFF);
   display_set_font(&font_3);
-  display_text(414, 235, "Calibration");
-  display_text(416, 251, "successful");
+  display_text(414, 217, "Calibration");
+  display_text(416, 233, "successful");
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -4032,6 +4294,8 @@ void scope_draw_grid(void)
 void scope_draw_pointers(void)
 {
   uint32 position;
+  int32  xpos;
+  char   text[16];
 
   //Draw channel 1 pointer when it is enabled
   if(scopesettings.channel1.enable)
@@ -4112,26 +4376,80 @@ void scope_draw_pointers(void)
     display_left_pointer(2, position, '2');
   }
 
+  //Draw the math channel pointer when it is shown
+  if(scope_math_channel_active())
+  {
+    //y position for the math channel trace center pointer
+    position = 441 - scopesettings.mathchannel.traceposition;
+
+    //Limit on the top of the displayable region
+    if(position < 46)
+    {
+      position = 46;
+    }
+    //Limit on the bottom of the displayable region
+    else if(position > 441)
+    {
+      position = 441;
+    }
+
+    //Set the colors for drawing
+    display_set_fg_color(MATH_COLOR);
+    display_set_bg_color(0x00000000);
+
+    //Select the font for this pointer id
+    display_set_font(&font_3);
+
+    //Draw the pointer
+    display_left_pointer(2, position, 'M');
+
+    //The integral and the difference are on a fixed scale that differs from the channel 1 scale, so show the factor next to the pointer.
+    //The scale is per sample, so the time it stands for changes with the sample rate, which is why it is labeled as such
+    if(scopesettings.mathmode == MATH_MODE_INTEGRATE)
+    {
+      text[0] = '/';
+      strcpy(scope_print_decimal(&text[1], 1 << (MATH_INTEGRATE_SHIFT - 8), 0), " per sample");
+    }
+    else if(scopesettings.mathmode == MATH_MODE_DIFFERENTIATE)
+    {
+      text[0] = 'x';
+      strcpy(scope_print_decimal(&text[1], 1 << MATH_DIFFERENTIATE_SHIFT, 0), " per sample");
+    }
+    else
+    {
+      text[0] = 0;
+    }
+
+    if(text[0])
+    {
+      display_set_font(&font_0);
+      display_set_fg_color(MATH_COLOR);
+      display_text(25, position, (int8 *)text);
+    }
+  }
+
   //Need to think about trigger position in 200mS - 20mS/div settings. Not sure if they work or need to be done in software
   //The original scope does not show them for 50mS and 20mS/div
 
   //Draw trigger position and level pointer when in normal display mode
   if(scopesettings.xymodedisplay == 0)
   {
-    //x position for the trigger position pointer
-    position = scopesettings.triggerhorizontalposition + 2;
+    //x position for the trigger position pointer. On a panned trace it moves with the trace and stays on the edge when off screen
+    xpos = scopesettings.triggerhorizontalposition + 2 + zoomoffset;
 
     //Limit on the left of the displayable region
-    if(position < 2)
+    if(xpos < 2)
     {
-      position = 2;
+      xpos = 2;
     }
     //Limit on the right of the displayable region
-    else if(position > 712)
+    else if(xpos > 712)
     {
-      position = 712;
+      xpos = 712;
     }
 
+    position = xpos;
+
     //Set the colors for drawing
     display_set_fg_color(TRIGGER_COLOR);
     display_set_bg_color(0x00000000);
@@ -4241,27 +4559,60 @@ void scope_calculate_trigger_vertical_position()
 
 void scope_acquire_trace_data(void)
 {
-  uint32 data;
+  uint32 ticks;
+
+  //The slow time base settings are handled in roll mode, which does not wait on a full buffer of samples
+  if(scope_check_roll_mode())
+  {
+    //Only take in new samples when running and not in a trace or cursor displacement state
+    if((scopesettings.runstate == 0) && (touchstate == 0))
+    {
+      scope_acquire_roll_data();
+    }
+    else
+    {
+      //No samples are taken for the time in between, so continue from now when running again
+      rollnextticks = timer0_get_ticks();
+    }
+
+    return;
+  }
 
   //Check if running and not in a trace or cursor displacement state
   if((scopesettings.runstate == 0) && (touchstate == 0))
   {
-    //Set the trigger level
-    fpga_set_trigger_level();
+    //Normally the conversion is already started after reading the previous trace, so the FPGA samples while that trace is displayed.
+    //Start one when this is not the case, when the time base changed or when any FPGA setting was changed since it was started
+    if((conversionpending == 0) || (conversiontimeperdiv != scopesettings.timeperdiv) || (conversionsettingschanges != fpgasettingschanges))
+    {
+      scope_start_conversion();
+    }
+
+    //Wait until the conversion is done or touch panel active
+    while(fpga_conversion_done() == 0)
+    {
+      //Check for touch events from the touch panel interrupt
+      tp_i2c_read_status();
 
-    //Write the time base setting to the FPGA
-    fpga_set_time_base(scopesettings.timeperdiv);
+      //Skip the rest when touched. The conversion keeps going and is picked up on the next call
+      if(havetouch)
+      {
+        return;
+      }
+    }
 
-    //Sampling with trigger circuit enabled
-    scopesettings.samplemode = 1;
+    //Time the conversion is done. The timer interrupt notes it when it happened while the previous trace was displayed, otherwise it
+    //is the time it is seen to be done here
+    ticks = conversiondone ? conversiondoneticks : timer0_get_ticks();
 
-    //Start the conversion and wait until done or touch panel active
-    fpga_do_conversion();
+    //Done sampling
+    fpga_end_conversion();
+    conversionpending = 0;
 
-    //Check if cut short with touch
-    if(havetouch)
+    //Segmented capture handles the read out and the captures that follow itself
+    if(scopesettings.acquisitionmode == ACQUISITION_MODE_SEGMENTED)
     {
-      //If so skip the rest
+      scope_acquire_segments(ticks);
       return;
     }
 
@@ -4275,144 +4626,1460 @@ void scope_acquire_trace_data(void)
       scope_run_stop_text();
     }
 
-    //Get trigger point information
-    //Later on used to send to the FPGA with command 0x1F
-    data = fpga_prepare_for_transfer();
-
-    //Just using the same calculation for every setting solves the frequency calculation error
-    //The signal representation still is correct and the trigger point seems to be more valid also
-    //The original uses time base dependent processing here, but this seems to do the trick on all ranges
-    //The software needs to verify the trigger to make it more stable
-    if(data < 750)
-    {
-      //Less then 750 make it bigger
-      data = data + 3345;
-    }
-    else
-    {
-      //More then 750 make it smaller
-      data = data - 750;
-    }
-
     //Only need a single count variable for both channels, since they run on the same sample rate
     //This can be changed to a global define
     scopesettings.nofsamples  = 1500;
     scopesettings.samplecount = 3000;
 
-    //Check if channel 1 is enabled
-    if(scopesettings.channel1.enable)
-    {
-      //Get the samples for channel 1
-      fpga_read_sample_data(&scopesettings.channel1, data);
+    //Read the samples of the enabled channels
+    scope_read_trace_data();
 
-      //Check if always 50% trigger is enabled and the trigger is on this channel
-      if(scopesettings.alwaystrigger50 && (scopesettings.triggerchannel == 0))
-      {
-        //Use the channel 1 center value as trigger level
-        scopesettings.triggerlevel = scopesettings.channel1.center;
+    //Apply averaging or high resolution filtering when enabled
+    scope_process_acquisition_mode();
 
-        //Set the trigger vertical position position to match the new trigger level
-        scope_calculate_trigger_vertical_position();
-      }
-    }
+    //Compute the math channel and decode the protocol from the processed samples
+    scope_process_math_channel();
+    scope_process_decoder();
 
-    //Check if channel 2 is enabled
-    if(scopesettings.channel2.enable)
+    //The samples are out of the FPGA, so let it sample the next trace while this one is processed and displayed
+    //Not when in single mode, since the scope is stopped now
+    if(scopesettings.runstate == 0)
     {
-      //Get the samples for channel 2
-      fpga_read_sample_data(&scopesettings.channel2, data);
-
-      //Check if always 50% trigger is enabled and the trigger is on this channel
-      if(scopesettings.alwaystrigger50 && scopesettings.triggerchannel)
-      {
-        //Use the channel 2 center value as trigger level
-        scopesettings.triggerlevel = scopesettings.channel2.center;
-
-        //Set the trigger vertical position position to match the new trigger level
-        scope_calculate_trigger_vertical_position();
-      }
+      scope_start_conversion();
     }
 
-
-    //Need to improve on this for a more stable displaying. On the low sample rate settings it seems to flip between two positions.
     //Determine the trigger position based on the selected trigger channel
     scope_process_trigger(scopesettings.nofsamples);
+  }
+  else
+  {
+    //Stopped or moving a trace or cursor, so the started conversion is not used
+    if(conversionpending)
+    {
+      fpga_end_conversion();
+      conversionpending = 0;
+    }
 
+    //A segmented capture starts a new sequence when running again
+    segmentcapturing = 0;
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//Read scopesettings.nofsamples samples per ADC for the enabled channels, with the trigger point in the middle
 
-void scope_process_trigger(uint32 count)
+void scope_read_trace_data(void)
 {
-  uint8  *buffer;
-  uint32  index;
-  uint32  level = scopesettings.triggerlevel;
-  uint32  sample1;
-  uint32  sample2;
+  uint32 data;
+  uint32 offset = scopesettings.nofsamples / 2;
 
-  //Select the trace buffer to process based on the trigger channel
-  if(scopesettings.triggerchannel == 0)
+  //Get trigger point information
+  //Later on used to send to the FPGA with command 0x1F
+  data = fpga_prepare_for_transfer();
+
+  //Just using the same calculation for every setting solves the frequency calculation error
+  //The signal representation still is correct and the trigger point seems to be more valid also
+  //The original uses time base dependent processing here, but this seems to do the trick on all ranges
+  //The software needs to verify the trigger to make it more stable
+  //The read out starts half the number of samples before the trigger point, wrapping round in the 4K FPGA sample memory
+  if(data < offset)
   {
-    //Channel 1 buffer
-    buffer = (uint8 *)channel1tracebuffer;
+    //Less then the offset make it bigger
+    data = data + 4095 - offset;
   }
   else
   {
-    //Channel 2 buffer
-    buffer = (uint8 *)channel2tracebuffer;
+    //More then the offset make it smaller
+    data = data - offset;
   }
 
-  disp_have_trigger = 0;
+  //Keep the volts per div settings the samples are taken with
+  scopesettings.channel1.sampledvoltperdiv = scopesettings.channel1.voltperdiv;
+  scopesettings.channel2.sampledvoltperdiv = scopesettings.channel2.voltperdiv;
+
+  //Check if channel 1 is enabled
+  if(scopesettings.channel1.enable)
+  {
+    //Get the samples for channel 1
+    fpga_read_sample_data(&scopesettings.channel1, data);
 
-  //Set a starting point for checking on trigger
-  //Count is half a sample buffer!!
-  index = count - 10;
-  count = 20;
+    //Check if always 50% trigger is enabled and the trigger is on this channel
+    if(scopesettings.alwaystrigger50 && (scopesettings.triggerchannel == 0))
+    {
+      //Use the channel 1 center value as trigger level
+      scopesettings.triggerlevel = scopesettings.channel1.center;
 
-  //Need a better check here, maybe over a wider range of samples
+      //Set the trigger vertical position position to match the new trigger level
+      scope_calculate_trigger_vertical_position();
+    }
+  }
 
-  while(count--)
+  //Check if channel 2 is enabled
+  if(scopesettings.channel2.enable)
   {
-    sample1 = buffer[index];
-    sample2 = buffer[index + 1];
+    //Get the samples for channel 2
+    fpga_read_sample_data(&scopesettings.channel2, data);
 
-    if(((scopesettings.triggeredge == 0) && (sample1 < level) && (sample2 >= level)) ||
-       ((scopesettings.triggeredge == 1) && (sample1 >= level) && (sample2 < level)))
+    //Check if always 50% trigger is enabled and the trigger is on this channel
+    if(scopesettings.alwaystrigger50 && scopesettings.triggerchannel)
     {
-      //Set the current index as trigger point
-      disp_trigger_index = index;
+      //Use the channel 2 center value as trigger level
+      scopesettings.triggerlevel = scopesettings.channel2.center;
 
-      //Signal trigger has been found
-      disp_have_trigger = 1;
-
-      //Done with checking
-      break;
+      //Set the trigger vertical position position to match the new trigger level
+      scope_calculate_trigger_vertical_position();
     }
-
-    //Select next sample to check
-    index++;
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//Called with the new samples in the trace buffers. The measurements are done on the raw samples, but the trigger processing and the
+//display work on the result of this
 
-uint32 scope_do_baseline_calibration(void)
+void scope_process_acquisition_mode(void)
 {
-  uint32 flag = 1;
-  uint32 voltperdiv;
+  uint32 window;
 
-  //Disable the trigger circuit
-  scopesettings.samplemode = 0;
+  switch(scopesettings.acquisitionmode)
+  {
+    case ACQUISITION_MODE_AVERAGE:
+    case ACQUISITION_MODE_EXP_AVERAGE:
+      //Without the buffers the scope falls back to normal acquisition
+      if(scope_setup_average_buffers() == 0)
+      {
+        scopesettings.acquisitionmode = ACQUISITION_MODE_NORMAL;
+        break;
+      }
 
-  //Set number of samples
+      //Start over when a setting that changes the sample data has been changed
+      if((averagesettings[0] != scopesettings.timeperdiv) || (averagesettings[1] != scopesettings.samplerate) ||
+         (averagesettings[2] != scopesettings.channel1.voltperdiv) || (averagesettings[3] != scopesettings.channel1.traceposition) ||
+         (averagesettings[4] != scopesettings.channel2.voltperdiv) || (averagesettings[5] != scopesettings.channel2.traceposition))
+      {
+        averagesettings[0] = scopesettings.timeperdiv;
+        averagesettings[1] = scopesettings.samplerate;
+        averagesettings[2] = scopesettings.channel1.voltperdiv;
+        averagesettings[3] = scopesettings.channel1.traceposition;
+        averagesettings[4] = scopesettings.channel2.voltperdiv;
+        averagesettings[5] = scopesettings.channel2.traceposition;
+
+        averagecount       = 0;
+        averageresultvalid = 0;
+      }
+
+      //The FPGA does not trigger on the same sample every time, so find the trigger point in this acquisition and move it to the
+      //nominal point. Without this the acquisitions are added unaligned and the signal is smeared out
+      scope_process_trigger(scopesettings.nofsamples);
+
+      if(disp_have_trigger)
+      {
+        //Both channels are sampled at the same time, so they get the same shift
+        if(scopesettings.channel1.enable)
+        {
+          scope_align_trace_data((uint8 *)channel1tracebuffer, (int32)disp_trigger_index - (int32)scopesettings.nofsamples);
+        }
+
+        if(scopesettings.channel2.enable)
+        {
+          scope_align_trace_data((uint8 *)channel2tracebuffer, (int32)disp_trigger_index - (int32)scopesettings.nofsamples);
+        }
+      }
+
+      //Process the enabled channels
+      if(scopesettings.channel1.enable)
+      {
+        scope_average_trace_data(channel1tracebuffer, channel1averagebuffer, channel1averageresult);
+      }
+
+      if(scopesettings.channel2.enable)
+      {
+        scope_average_trace_data(channel2tracebuffer, channel2averagebuffer, channel2averageresult);
+      }
+
+      //One more acquisition done. For block averaging start a new block when this one is complete
+      averagecount++;
+
+      if((scopesettings.acquisitionmode == ACQUISITION_MODE_AVERAGE) && (averagecount >= (1 << scopesettings.averageshift)))
+      {
+        averagecount = 0;
+      }
+      break;
+
+    case ACQUISITION_MODE_HIGH_RES:
+      //Combine the samples that end up on a single screen column. Only when there are at least two of them
+      window = sample_rate[scopesettings.samplerate] / (50 * frequency_per_div[scopesettings.timeperdiv]);
+
+      if(window > HIGH_RES_MAX_WINDOW)
+      {
+        window = HIGH_RES_MAX_WINDOW;
+      }
+
+      if(window > 1)
+      {
+        if(scopesettings.channel1.enable)
+        {
+          scope_high_resolution_filter((uint8 *)channel1tracebuffer, scopesettings.samplecount, window);
+        }
+
+        if(scopesettings.channel2.enable)
+        {
+          scope_high_resolution_filter((uint8 *)channel2tracebuffer, scopesettings.samplecount, window);
+        }
+      }
+
+      //Fall through to signal the averaging needs to start over when switched on again
+
+    default:
+      averagecount       = 0;
+      averageresultvalid = 0;
+
+      //The averaging buffers are not needed in the other modes
+      scope_release_average_buffers();
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Take the accumulator and result buffers from the sample buffer pool. Returns zero when they are not available
+
+uint32 scope_setup_average_buffers(void)
+{
+  //Check if they are already there
+  if(channel1averagebuffer)
+  {
+    return(1);
+  }
+
+  channel1averagebuffer = memory_pool_alloc(&samplebufferpool);
+  channel2averagebuffer = memory_pool_alloc(&samplebufferpool);
+  channel1averageresult = memory_pool_alloc(&samplebufferpool);
+  channel2averageresult = memory_pool_alloc(&samplebufferpool);
+
+  //Need all four of them
+  if((channel1averagebuffer == 0) || (channel2averagebuffer == 0) || (channel1averageresult == 0) || (channel2averageresult == 0))
+  {
+    scope_release_average_buffers();
+    return(0);
+  }
+
+  //New buffers hold no average yet
+  averagecount       = 0;
+  averageresultvalid = 0;
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_release_average_buffers(void)
+{
+  //Freeing a null pointer is ignored by the pool
+  memory_pool_free(&samplebufferpool, channel1averagebuffer);
+  memory_pool_free(&samplebufferpool, channel2averagebuffer);
+  memory_pool_free(&samplebufferpool, channel1averageresult);
+  memory_pool_free(&samplebufferpool, channel2averageresult);
+
+  channel1averagebuffer = 0;
+  channel2averagebuffer = 0;
+  channel1averageresult = 0;
+  channel2averageresult = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Averaging is done on two samples at a time. Each trace buffer word holds four samples, which are split into two accumulator words
+//with a 16 bit lane per sample. Averaging 256 acquisitions of at most 255 fits such a lane, so there is no carry into the next sample
+//and plain 32 bit adds, subtracts and shifts do the work for both lanes.
+//The result is written back into the trace buffer
+
+void scope_average_trace_data(uint32 *tracebuffer, uint32 *accumulator, uint32 *result)
+{
+  register uint32 *sptr = tracebuffer;
+  register uint32 *aptr = accumulator;
+  register uint32 *rptr = result;
+  register uint32  shift = scopesettings.averageshift;
+  register uint32  mask = (0x0000FFFF >> shift) * 0x00010001;
+  register uint32  round = (1 << (shift - 1)) * 0x00010001;
+  register uint32  count = 750;
+  register uint32  data;
+  register uint32  even;
+  register uint32  odd;
+
+  //Check on the type of averaging
+  if(scopesettings.acquisitionmode == ACQUISITION_MODE_EXP_AVERAGE)
+  {
+    //The accumulators hold the average times the number of acquisitions. Each new acquisition replaces one of those
+    while(count--)
+    {
+      //Split the four samples in the two lane pairs
+      data = *sptr;
+      even = data & 0x00FF00FF;
+      odd  = (data >> 8) & 0x00FF00FF;
+
+      //The first acquisition is taken as the average so far
+      if(averagecount == 0)
+      {
+        aptr[0] = even << shift;
+        aptr[1] = odd << shift;
+      }
+      else
+      {
+        //Take of the average and add the new sample. The average is never more than the lane so there is no borrow
+        aptr[0] = aptr[0] - ((aptr[0] >> shift) & mask) + even;
+        aptr[1] = aptr[1] - ((aptr[1] >> shift) & mask) + odd;
+      }
+
+      //Put the rounded averages back in the trace buffer
+      *sptr++ = (((aptr[0] + round) >> shift) & 0x00FF00FF) | ((((aptr[1] + round) >> shift) & 0x00FF00FF) << 8);
+
+      aptr += 2;
+    }
+  }
+  else
+  {
+    //Block averaging. Add the acquisition to the sums, where a new block starts with the current acquisition
+    if(averagecount == 0)
+    {
+      while(count--)
+      {
+        data = *sptr++;
+        aptr[0] = data & 0x00FF00FF;
+        aptr[1] = (data >> 8) & 0x00FF00FF;
+        aptr += 2;
+      }
+    }
+    else
+    {
+      while(count--)
+      {
+        data = *sptr++;
+        aptr[0] += data & 0x00FF00FF;
+        aptr[1] += (data >> 8) & 0x00FF00FF;
+        aptr += 2;
+      }
+    }
+
+    //When the block is complete the sums are turned into the new result
+    if((averagecount + 1) == (1 << shift))
+    {
+      aptr  = accumulator;
+      count = 750;
+
+      while(count--)
+      {
+        *rptr++ = (((aptr[0] + round) >> shift) & 0x00FF00FF) | ((((aptr[1] + round) >> shift) & 0x00FF00FF) << 8);
+        aptr += 2;
+      }
+
+      averageresultvalid = 1;
+    }
+
+    //Show the last completed average. Until there is one the acquired samples are shown as is
+    if(averageresultvalid)
+    {
+      memcpy(tracebuffer, result, 3000);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Move the samples by the given offset, so the sample at the offset from the nominal trigger point ends up on it. The samples moved
+//in at the end are copies of the last one that is kept
+
+void scope_align_trace_data(uint8 *buffer, int32 offset)
+{
+  uint32 count = scopesettings.samplecount;
+
+  //Check on the direction to move the samples in
+  if(offset > 0)
+  {
+    //Trigger point is after the nominal point, so move the samples towards the start
+    memmove(buffer, &buffer[offset], count - offset);
+    memset(&buffer[count - offset], buffer[count - offset - 1], offset);
+  }
+  else if(offset < 0)
+  {
+    //Trigger point is before the nominal point, so move the samples towards the end
+    offset = -offset;
+
+    memmove(&buffer[offset], buffer, count - offset);
+    memset(buffer, buffer[offset], offset);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Box car filter over the samples that fall on a single screen column. Averaging these reduces the noise, like a higher resolution
+//ADC would. Each output is the rounded average of the window of samples around it. The first and last half window of samples are
+//kept as is
+
+void scope_high_resolution_filter(uint8 *buffer, uint32 count, uint32 window)
+{
+  uint8  history[HIGH_RES_MAX_WINDOW];
+  uint32 reciprocal = (65536 + (window / 2)) / window;
+  uint32 half = window / 2;
+  uint32 sum = 0;
+  uint32 slot = 0;
+  uint32 index;
+
+  if(window > count)
+  {
+    return;
+  }
+
+  //Fill the first window. The original samples are kept, since the buffer is overwritten behind the window
+  for(index=0;index<window;index++)
+  {
+    history[index] = buffer[index];
+    sum += buffer[index];
+  }
+
+  //Slide the window through the buffer
+  for(;index<count;index++)
+  {
+    //Output for the center of the current window. Dividing is done with a multiply by the reciprocal
+    buffer[index - window + half] = ((sum * reciprocal) + 32768) >> 16;
+
+    //Replace the oldest sample in the window with the next one
+    sum -= history[slot];
+    history[slot] = buffer[index];
+    sum += buffer[index];
+
+    slot++;
+
+    if(slot >= window)
+    {
+      slot = 0;
+    }
+  }
+
+  //Output for the last window
+  buffer[count - window + half] = ((sum * reciprocal) + 32768) >> 16;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The math channel is a virtual third channel, computed from the samples of the real channels after every acquisition. Its samples are
+//kept on the channel 1 scale around the same center value, so it is drawn with the same trace functions as the real channels
+
+uint32 scope_math_channel_active(void)
+{
+  //Not shown in x-y and roll mode, and channel 1 is needed for all the functions
+  if((scopesettings.mathmode == MATH_MODE_OFF) || scopesettings.xymodedisplay || rollactive || (scopesettings.channel1.enable == 0))
+  {
+    return(0);
+  }
+
+  //The two channel functions also need channel 2
+  if((scopesettings.mathmode <= MATH_MODE_MULTIPLY) && (scopesettings.channel2.enable == 0))
+  {
+    return(0);
+  }
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The volts per ADC count of a channel follow from the volts per pixel (volt_calc_data), the pixels per count (signal_adjusters) and
+//the probe magnification. Returns the factor that brings a channel 2 sample to the channel 1 scale, with MATH_GAIN_SHIFT fraction bits
+
+int32 scope_math_channel_gain(void)
+{
+  uint32 voltperdiv1 = scopesettings.channel1.sampledvoltperdiv;
+  uint32 voltperdiv2 = scopesettings.channel2.sampledvoltperdiv;
+  int64  gain1;
+  int64  gain2;
+
+  gain1 = (int64)signal_adjusters[voltperdiv1] * volt_calc_data[0][voltperdiv1].mul_factor * probe_magnification_factors[scopesettings.channel1.magnification];
+  gain2 = (int64)signal_adjusters[voltperdiv2] * volt_calc_data[0][voltperdiv2].mul_factor * probe_magnification_factors[scopesettings.channel2.magnification];
+
+  return(((gain2 << MATH_GAIN_SHIFT) + (gain1 / 2)) / gain1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_process_math_channel(void)
+{
+  register uint8  *channel1 = (uint8 *)channel1tracebuffer;
+  register uint8  *channel2 = (uint8 *)channel2tracebuffer;
+  register uint8  *result   = (uint8 *)mathtracebuffer;
+  register uint32  count    = scopesettings.samplecount;
+  register uint32  index;
+  register int32   sample;
+  register int32   sum;
+  int32            gain;
+  int32            average;
+
+  //Only computed when it is shown
+  if(scope_math_channel_active() == 0)
+  {
+    return;
+  }
+
+  switch(scopesettings.mathmode)
+  {
+    case MATH_MODE_ADD:
+    case MATH_MODE_SUBTRACT:
+    case MATH_MODE_MULTIPLY:
+      //Get the factor for the channel 2 samples. The channels can be on different volts per div and probe settings
+      gain = scope_math_channel_gain();
+
+      for(index=0;index<count;index++)
+      {
+        //Channel 2 sample on the channel 1 scale, limited to keep the product within 32 bits
+        sample = ((int64)((int32)channel2[index] - 128) * gain) >> MATH_GAIN_SHIFT;
+
+        if(sample > 65535)
+        {
+          sample = 65535;
+        }
+        else if(sample < -65535)
+        {
+          sample = -65535;
+        }
+
+        //Combine it with the channel 1 sample
+        if(scopesettings.mathmode == MATH_MODE_ADD)
+        {
+          sample = ((int32)channel1[index] - 128 + sample) >> MATH_ADD_SHIFT;
+        }
+        else if(scopesettings.mathmode == MATH_MODE_SUBTRACT)
+        {
+          sample = ((int32)channel1[index] - 128 - sample) >> MATH_ADD_SHIFT;
+        }
+        else
+        {
+          sample = (((int32)channel1[index] - 128) * sample) >> MATH_MULTIPLY_SHIFT;
+        }
+
+        //Keep it within the sample range
+        if(sample > MATH_MAX_SAMPLE)
+        {
+          sample = MATH_MAX_SAMPLE;
+        }
+        else if(sample < -MATH_MAX_SAMPLE)
+        {
+          sample = -MATH_MAX_SAMPLE;
+        }
+
+        result[index] = sample + 128;
+      }
+
+      //A sum or difference is stored on half the scale, so it is shown twice as large to get it on the channel 1 scale
+      if(scopesettings.mathmode == MATH_MODE_MULTIPLY)
+      {
+        mathdisplayshift = 0;
+      }
+      else
+      {
+        mathdisplayshift = MATH_ADD_SHIFT;
+      }
+      break;
+
+    case MATH_MODE_INTEGRATE:
+      //The average is taken out first, otherwise any dc level makes the integral run off. Kept with 8 fraction bits
+      sum = 0;
+
+      for(index=0;index<count;index++)
+      {
+        sum += channel1[index];
+      }
+
+      average = (sum << 8) / count;
+
+      //Store the scaled running sum
+      sum = 0;
+
+      for(index=0;index<count;index++)
+      {
+        sum += ((int32)channel1[index] << 8) - average;
+
+        sample = sum >> MATH_INTEGRATE_SHIFT;
+
+        //Keep it within the sample range
+        if(sample > MATH_MAX_SAMPLE)
+        {
+          sample = MATH_MAX_SAMPLE;
+        }
+        else if(sample < -MATH_MAX_SAMPLE)
+        {
+          sample = -MATH_MAX_SAMPLE;
+        }
+
+        result[index] = sample + 128;
+      }
+
+      mathdisplayshift = 0;
+      break;
+
+    case MATH_MODE_DIFFERENTIATE:
+      //There is no difference for the first sample
+      result[0] = 128;
+
+      for(index=1;index<count;index++)
+      {
+        sample = ((int32)channel1[index] - (int32)channel1[index - 1]) << MATH_DIFFERENTIATE_SHIFT;
+
+        //A step over the full range does not fit
+        if(sample > MATH_MAX_SAMPLE)
+        {
+          sample = MATH_MAX_SAMPLE;
+        }
+        else if(sample < -MATH_MAX_SAMPLE)
+        {
+          sample = -MATH_MAX_SAMPLE;
+        }
+
+        result[index] = sample + 128;
+      }
+
+      mathdisplayshift = 0;
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The protocol decoder works on the same traces as the display, so only when they are shown in normal mode
+
+uint32 scope_decoder_active(void)
+{
+  //Not in x-y and roll mode, and channel 1 is needed for all the protocols
+  if((scopesettings.decodermode == DECODER_MODE_OFF) || scopesettings.xymodedisplay || rollactive || (scopesettings.channel1.enable == 0))
+  {
+    return(0);
+  }
+
+  //I2C and SPI also need channel 2
+  if((scopesettings.decodermode != DECODER_MODE_UART) && (scopesettings.channel2.enable == 0))
+  {
+    return(0);
+  }
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The levels for slicing are the same as the ones for the zero crossing detection in the read out, but calculated from the minimum and
+//maximum here, since these are also available for a loaded trace
+
+void scope_decoder_slice_channel(PCHANNELSETTINGS settings, PDECODERSTREAM stream)
+{
+  uint32 center = (settings->max + settings->min) / 2;
+  uint32 threshold = ((settings->max - settings->min) / 10) + 2;
+  uint32 lowlevel = 0;
+
+  if(center > threshold)
+  {
+    lowlevel = center - threshold;
+  }
+
+  decoder_slice_channel(settings->tracebuffer, scopesettings.samplecount, lowlevel, center + threshold, stream);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_process_decoder(void)
+{
+  PDECODERSTREAM streams;
+
+  //Nothing to show when not active
+  decoderresult.count = 0;
+
+  if(scope_decoder_active() == 0)
+  {
+    return;
+  }
+
+  //The edge lists are only needed while decoding, so they come from the frame arena
+  streams = memory_frame_alloc(2 * sizeof(DECODERSTREAM));
+
+  if(streams == 0)
+  {
+    return;
+  }
+
+  //Channel 1 is the data line for UART, and the clock line for I2C and SPI
+  scope_decoder_slice_channel(&scopesettings.channel1, &streams[0]);
+
+  switch(scopesettings.decodermode)
+  {
+    case DECODER_MODE_UART:
+      decoder_uart(&streams[0], &decoderresult);
+      break;
+
+    case DECODER_MODE_I2C:
+      scope_decoder_slice_channel(&scopesettings.channel2, &streams[1]);
+      decoder_i2c(&streams[0], &streams[1], &decoderresult);
+      break;
+
+    case DECODER_MODE_SPI:
+      scope_decoder_slice_channel(&scopesettings.channel2, &streams[1]);
+      decoder_spi(&streams[0], &streams[1], DECODER_SPI_RISING_EDGE, &decoderresult);
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Called when a conversion is done in segmented mode. Every capture is stored with its time stamp in a ring of segments.
+//The FPGA is armed again right after the read out, and as long as the next trigger follows within a short time it is read out here
+//too, so a burst of triggers is captured without the display work in between. A pass is limited to SEGMENT_PASS_TIME to keep the user
+//interface going. The given ticks are the time the first conversion was done
+
+void scope_acquire_segments(uint32 ticks)
+{
+  uint32 timeout;
+  uint32 done;
+  uint32 captured = 0;
+  uint32 passend  = timer0_get_ticks() + SEGMENT_PASS_TIME;
+
+  //Make sure there is a ring for the segments. Without it the scope falls back to normal acquisition
+  if(scope_setup_segment_buffer() == 0)
+  {
+    scopesettings.acquisitionmode = ACQUISITION_MODE_NORMAL;
+    return;
+  }
+
+  //Start a new sequence when the capture has just been started
+  if(segmentcapturing == 0)
+  {
+    segmentcount     = 0;
+    segmentindex     = 0;
+    segmentsequence  = 0;
+    segmentcapturing = 1;
+  }
+
+  //Short records for the segments
+  scopesettings.nofsamples  = SEGMENT_NOF_SAMPLES;
+  scopesettings.samplecount = SEGMENT_SAMPLES;
+
+  while(1)
+  {
+    //Get the samples out of the FPGA
+    scope_read_trace_data();
+
+    //In single mode the sequence ends when the ring is full
+    if((scopesettings.triggermode == 1) && ((segmentcount + 1) >= segmentsize))
+    {
+      scope_store_segment(ticks);
+
+      //Switch to stopped and show this on the screen
+      scopesettings.runstate = 1;
+      scope_run_stop_text();
+      break;
+    }
+
+    //Arm the FPGA again before storing, to keep the time without sampling as short as possible
+    scope_start_conversion();
+
+    scope_store_segment(ticks);
+
+    //Give the display and the touch panel a turn after a full ring of captures or when the time for this pass is used up
+    captured++;
+
+    if((captured >= segmentsize) || ((int32)(timer0_get_ticks() - passend) >= 0))
+    {
+      break;
+    }
+
+    //Wait a short time for the next trigger. When it does not come, the conversion is picked up on the next pass
+    timeout = timer0_get_ticks() + SEGMENT_BURST_TIME;
+
+    while(((done = fpga_conversion_done()) == 0) && ((int32)(timer0_get_ticks() - timeout) < 0));
+
+    if(done == 0)
+    {
+      break;
+    }
+
+    //Time of the trigger
+    ticks = timer0_get_ticks();
+
+    //Done sampling
+    fpga_end_conversion();
+    conversionpending = 0;
+  }
+
+  //Show the newest segment, which is still in the trace buffers
+  segmentview = segmentcount - 1;
+
+  scope_process_math_channel();
+  scope_process_decoder();
+
+  //The trigger position of the newest segment has been determined when it was stored
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Take the blocks for the number of segments set by the user from the sample buffer pool. Returns zero when they are not available
+
+uint32 scope_setup_segment_buffer(void)
+{
+  uint32 size = 1 << (SEGMENT_COUNT_SHIFT + scopesettings.averageshift);
+  uint32 blocks = size / SEGMENTS_PER_BLOCK;
+
+  //Check if the ring already has the needed size
+  if(segmentblockcount && (segmentsize == size))
+  {
+    return(1);
+  }
+
+  //Give back the previous ring
+  scope_release_segment_buffer();
+
+  //A new ring starts empty
+  segmentsize      = size;
+  segmentcount     = 0;
+  segmentindex     = 0;
+  segmentview      = 0;
+  segmentcapturing = 0;
+
+  while(segmentblockcount < blocks)
+  {
+    segmentblocks[segmentblockcount] = memory_pool_alloc(&samplebufferpool);
+
+    //Without all the blocks there is no ring
+    if(segmentblocks[segmentblockcount] == 0)
+    {
+      scope_release_segment_buffer();
+      return(0);
+    }
+
+    segmentblockcount++;
+  }
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_release_segment_buffer(void)
+{
+  while(segmentblockcount)
+  {
+    segmentblockcount--;
+
+    memory_pool_free(&samplebufferpool, segmentblocks[segmentblockcount]);
+  }
+
+  segmentsize  = 0;
+  segmentcount = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the segment on the given location in the ring
+
+PSEGMENT scope_get_segment_slot(uint32 index)
+{
+  return(&segmentblocks[index / SEGMENTS_PER_BLOCK][index % SEGMENTS_PER_BLOCK]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_store_segment(uint32 timestamp)
+{
+  PSEGMENT segment = scope_get_segment_slot(segmentindex);
+
+  //Fill in the header
+  segment->timestamp          = timestamp;
+  segment->sequence           = segmentsequence++;
+  segment->timeperdiv         = scopesettings.timeperdiv;
+  segment->samplerate         = scopesettings.samplerate;
+  segment->triggerchannel     = scopesettings.triggerchannel;
+  segment->triggeredge        = scopesettings.triggeredge;
+  segment->triggerlevel       = scopesettings.triggerlevel;
+  segment->channel1voltperdiv = scopesettings.channel1.voltperdiv;
+  segment->channel2voltperdiv = scopesettings.channel2.voltperdiv;
+
+  //The FPGA does not trigger on the same sample every time, so each segment keeps its own trigger position to align the overlay on
+  scope_process_trigger(scopesettings.nofsamples);
+
+  segment->havetrigger     = disp_have_trigger;
+  segment->triggerindex    = disp_trigger_index;
+  segment->triggerfraction = disp_trigger_fraction;
+
+  //Copy the samples
+  memcpy(segment->channel1data, channel1tracebuffer, SEGMENT_SAMPLES);
+  memcpy(segment->channel2data, channel2tracebuffer, SEGMENT_SAMPLES);
+
+  //Move to the next segment in the ring
+  segmentindex++;
+
+  if(segmentindex >= segmentsize)
+  {
+    segmentindex = 0;
+  }
+
+  if(segmentcount < segmentsize)
+  {
+    segmentcount++;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the segment for the given number, counted from the oldest one in the ring
+
+PSEGMENT scope_get_segment(uint32 number)
+{
+  return(scope_get_segment_slot((segmentindex + segmentsize - segmentcount + number) % segmentsize));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//When stopped in segmented mode the captured segments can be browsed
+
+uint32 scope_segment_view_active(void)
+{
+  return((scopesettings.acquisitionmode == ACQUISITION_MODE_SEGMENTED) && scopesettings.runstate && (scopesettings.waveviewmode == 0) && segmentblockcount && segmentcount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_copy_segment_samples(uint32 number)
+{
+  PSEGMENT segment = scope_get_segment(number);
+
+  memcpy(channel1tracebuffer, segment->channel1data, SEGMENT_SAMPLES);
+  memcpy(channel2tracebuffer, segment->channel2data, SEGMENT_SAMPLES);
+
+  //The segment can have been taken with other volts per div settings than the ones shown
+  scopesettings.channel1.sampledvoltperdiv = segment->channel1voltperdiv;
+  scopesettings.channel2.sampledvoltperdiv = segment->channel2voltperdiv;
+
+  //Traces are drawn around the trigger position of the segment itself
+  disp_have_trigger     = segment->havetrigger;
+  disp_trigger_index    = segment->triggerindex;
+  disp_trigger_fraction = segment->triggerfraction;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A short touch on the left third of the trace window shows the previous segment, on the right third the next segment, and in the
+//middle it switches between a single segment and all the segments on top of each other
+
+void scope_browse_segments(uint32 xpos)
+{
+  if(xpos < (TRACE_WINDOW_XPOS + (TRACE_WINDOW_WIDTH / 3)))
+  {
+    if(segmentview)
+    {
+      segmentview--;
+    }
+  }
+  else if(xpos > (TRACE_WINDOW_XPOS + ((TRACE_WINDOW_WIDTH * 2) / 3)))
+  {
+    if((segmentview + 1) < segmentcount)
+    {
+      segmentview++;
+    }
+  }
+  else
+  {
+    segmentoverlay ^= 1;
+  }
+
+  //Load the selected segment with its trigger point
+  scopesettings.nofsamples  = SEGMENT_NOF_SAMPLES;
+  scopesettings.samplecount = SEGMENT_SAMPLES;
+
+  scope_copy_segment_samples(segmentview);
+  scope_process_math_channel();
+  scope_process_decoder();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Draw the traces of all the segments. The first sample to draw is set up for the browsed segment, and is moved by the distance between
+//the trigger point of each segment and that of the browsed one, so they line up on the trigger
+
+void scope_display_segment_overlay(void)
+{
+  uint32 number;
+  int32  firstsample = disp_first_sample;
+  int32  triggerindex = disp_trigger_index;
+  double triggerfraction = disp_trigger_fraction;
+
+  for(number=0;number<segmentcount;number++)
+  {
+    scope_copy_segment_samples(number);
+
+    //A segment without a trigger point is drawn from the center of its samples, like a single trace
+    if(disp_have_trigger == 0)
+    {
+      disp_trigger_index    = scopesettings.samplecount / 2;
+      disp_trigger_fraction = 0.0;
+    }
+
+    disp_first_sample = firstsample + (int32)disp_trigger_index - triggerindex;
+
+    //Keep it within the samples of the segment
+    if(disp_first_sample < 0)
+    {
+      disp_first_sample = 0;
+    }
+    else if(disp_first_sample >= (int32)scopesettings.samplecount)
+    {
+      disp_first_sample = scopesettings.samplecount - 1;
+    }
+
+    if(scopesettings.channel1.enable)
+    {
+      scope_display_channel_trace(&scopesettings.channel1);
+    }
+
+    if(scopesettings.channel2.enable)
+    {
+      scope_display_channel_trace(&scopesettings.channel2);
+    }
+  }
+
+  //Put the browsed segment back
+  scope_copy_segment_samples(segmentview);
+
+  disp_first_sample     = firstsample;
+  disp_trigger_index    = triggerindex;
+  disp_trigger_fraction = triggerfraction;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Show the number of the browsed segment and the time of its trigger relative to the oldest segment
+
+void scope_display_segment_info(void)
+{
+  char  text[40];
+  char *ptr;
+
+  if(segmentoverlay)
+  {
+    ptr = strcpy(text, "All ");
+    scope_print_decimal(ptr, segmentcount, 0);
+  }
+  else
+  {
+    ptr = strcpy(text, "Seg ");
+    ptr = scope_print_decimal(ptr, segmentview + 1, 0);
+    ptr = strcpy(ptr, "  +");
+    ptr = scope_print_decimal(ptr, scope_get_segment(segmentview)->timestamp - scope_get_segment(0)->timestamp, 0);
+    strcpy(ptr, "ms");
+  }
+
+  //Use white text and font_0 on the same place as the file name in waveform view
+  display_set_fg_color(0x00FFFFFF);
+  display_set_font(&font_0);
+  display_text(550, 48, (int8 *)text);
+}
+
+#ifdef MEMORY_STATISTICS
+//Show the use of the heap, the pools and the frame arena, to check the memory use while the scope is running. Sizes are in KB
+
+void scope_display_memory_statistics(void)
+{
+  MEMORYSTATISTICS statistics;
+  char  text[80];
+  char *ptr;
+
+  memory_get_statistics(&statistics);
+
+  ptr = strcpy(text, "heap ");
+  ptr = scope_print_decimal(ptr, statistics.heapused >> 10, 0);
+  ptr = strcpy(ptr, " used, ");
+  ptr = scope_print_decimal(ptr, statistics.heapfree >> 10, 0);
+  ptr = strcpy(ptr, " free, ");
+  ptr = scope_print_decimal(ptr, statistics.heaplargestfree >> 10, 0);
+  ptr = strcpy(ptr, " largest, ");
+  ptr = scope_print_decimal(ptr, statistics.heaphighwater >> 10, 0);
+  ptr = strcpy(ptr, " high, ");
+  ptr = scope_print_decimal(ptr, statistics.heapfragmentation, 0);
+  strcpy(ptr, "% fragmented");
+
+  display_set_fg_color(0x00FFFFFF);
+  display_set_font(&font_0);
+  display_text(10, 60, (int8 *)text);
+
+  scope_print_pool_statistics(text, &statistics.samplepool);
+  display_text(10, 75, (int8 *)text);
+
+  scope_print_pool_statistics(text, &statistics.filepool);
+  display_text(10, 90, (int8 *)text);
+
+  ptr = strcpy(text, "frame ");
+  ptr = scope_print_decimal(ptr, statistics.framehighwater >> 10, 0);
+  ptr = strcpy(ptr, " of ");
+  ptr = scope_print_decimal(ptr, statistics.framesize >> 10, 0);
+  ptr = strcpy(ptr, " high, ");
+  ptr = scope_print_decimal(ptr, statistics.framefailures, 0);
+  strcpy(ptr, " failed");
+
+  display_text(10, 105, (int8 *)text);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_print_pool_statistics(char *buffer, PMEMORYPOOLSTATISTICS statistics)
+{
+  buffer = strcpy(buffer, statistics->name);
+  buffer = strcpy(buffer, " ");
+  buffer = scope_print_decimal(buffer, statistics->used, 0);
+  buffer = strcpy(buffer, " of ");
+  buffer = scope_print_decimal(buffer, statistics->blockcount, 0);
+  buffer = strcpy(buffer, " used, ");
+  buffer = scope_print_decimal(buffer, statistics->highwater, 0);
+  buffer = strcpy(buffer, " high, ");
+  buffer = scope_print_decimal(buffer, statistics->failures, 0);
+  strcpy(buffer, " failed");
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Roll mode is used for the slow time base settings in auto trigger mode. It is started when running, and stays active when the scope
+//is stopped so the last roll picture stays on screen. Returns one when the traces are to be handled in roll mode
+
+uint32 scope_check_roll_mode(void)
+{
+  //Check if the settings allow roll mode
+  if((scopesettings.timeperdiv <= ROLL_MODE_TIME_PER_DIV) && (scopesettings.triggermode == 0) && (scopesettings.xymodedisplay == 0) && (scopesettings.waveviewmode == 0) &&
+     (scopesettings.acquisitionmode != ACQUISITION_MODE_SEGMENTED))
+  {
+    //Start it when not active yet and the scope is running. A different time base needs a restart since the samples in the buffers
+    //no longer match the screen
+    if(((rollactive == 0) || (rolltimeperdiv != scopesettings.timeperdiv)) && (scopesettings.runstate == 0))
+    {
+      scope_start_roll_mode();
+    }
+  }
+  else
+  {
+    //Back to normal trace handling. The short time base mode is set again with the next conversion
+    rollactive = 0;
+  }
+
+  return(rollactive);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A stopped or loaded trace is re-rendered from the sample buffer on every display pass, so it can be zoomed with the time and volts
+//per div settings and panned by dragging, without a new acquisition
+
+uint32 scope_zoom_active(void)
+{
+  return((scopesettings.runstate || scopesettings.waveviewmode) && (scopesettings.xymodedisplay == 0) && (rollactive == 0));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_start_roll_mode(void)
+{
+  //A conversion started for the normal trace handling is not used
+  if(conversionpending)
+  {
+    fpga_end_conversion();
+    conversionpending = 0;
+  }
+
+  //Switch the FPGA to long time base mode, in which it samples continuously
+  fpga_set_long_time_base();
+
+  //Start with empty sample buffers
+  rollindex      = 0;
+  rollcount      = 0;
+  rollnewsamples = 0;
+  rollnextticks  = timer0_get_ticks();
+  rolltimeperdiv = scopesettings.timeperdiv;
+
+  //Make sure the old trace picture is cleared
+  rollredraw = 1;
+  rollactive = 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Read a new sample for every screen column worth of time passed since the previous one. With 50 pixels per division this is every
+//1mS for 50mS/div up to every 4mS for 200mS/div. A main loop pass takes longer than that, so the columns that are due are filled
+//from a single block of samples read from the FPGA
+
+void scope_acquire_roll_data(void)
+{
+  uint8  channel1block[ROLL_BLOCK_SAMPLES];
+  uint8  channel2block[ROLL_BLOCK_SAMPLES];
+  uint32 interval;
+  uint32 count;
+  uint32 column;
+  uint32 ticks = timer0_get_ticks();
+
+  //1000mS / (frequency per division * 50 pixels per division) gives the time per screen column in milliseconds
+  interval = 20 / frequency_per_div[scopesettings.timeperdiv];
+
+  //When the main loop has been held up for more than a screen width of samples, the missed time can not be filled in anymore
+  if((int32)(ticks - rollnextticks) > (int32)(interval * ROLL_MODE_SAMPLES))
+  {
+    rollnextticks = ticks;
+  }
+
+  //Roll mode samples are always shown on the settings they are taken with
+  scopesettings.channel1.sampledvoltperdiv = scopesettings.channel1.voltperdiv;
+  scopesettings.channel2.sampledvoltperdiv = scopesettings.channel2.voltperdiv;
+
+  //Nothing to do when the next sample is not due yet
+  if((int32)(ticks - rollnextticks) < 0)
+  {
+    return;
+  }
+
+  //Number of columns that are due. More than one when the main loop took longer than the time per column
+  count = ((ticks - rollnextticks) / interval) + 1;
+
+  if(count > ROLL_MODE_SAMPLES)
+  {
+    count = ROLL_MODE_SAMPLES;
+  }
+
+  //Select long time base mode for this read sequence
+  fpga_write_cmd(0x28);
+  fpga_write_byte(0x01);
+
+  //Get the most recent samples for both channels
+  fpga_read_roll_block(0x24, channel1block);
+  fpga_read_roll_block(0x26, channel2block);
+
+  //Spread the samples over the due columns, so each column shows its own part of the block instead of the same average
+  for(column=0;column<count;column++)
+  {
+    rollchannel1buffer[rollindex] = scope_get_roll_block_sample(channel1block, column, count);
+    rollchannel2buffer[rollindex] = scope_get_roll_block_sample(channel2block, column, count);
+
+    //Move to the next location in the circular buffers
+    rollindex++;
+
+    if(rollindex >= ROLL_MODE_SAMPLES)
+    {
+      rollindex = 0;
+    }
+
+    //Keep track of the number of samples in the buffers and the number still to draw
+    if(rollcount < ROLL_MODE_SAMPLES)
+    {
+      rollcount++;
+    }
+
+    if(rollnewsamples < ROLL_MODE_SAMPLES)
+    {
+      rollnewsamples++;
+    }
+
+    //Set the time for the next sample
+    rollnextticks += interval;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the sample for the given column out of count columns that share a block. With up to a block of columns each one gets the
+//average of its own part of the block, with more columns the samples are interpolated
+
+uint8 scope_get_roll_block_sample(uint8 *block, uint32 column, uint32 count)
+{
+  uint32 start;
+  uint32 end;
+  uint32 sum;
+  uint32 position;
+  uint32 fraction;
+
+  if(count <= ROLL_BLOCK_SAMPLES)
+  {
+    //Part of the block for this column
+    start = (column * ROLL_BLOCK_SAMPLES) / count;
+    end   = ((column + 1) * ROLL_BLOCK_SAMPLES) / count;
+
+    sum = 0;
+
+    for(position=start;position<end;position++)
+    {
+      sum += block[position];
+    }
+
+    return(sum / (end - start));
+  }
+
+  //Position in the block in 8 bit fixed point, with the first column on the oldest and the last column on the newest sample
+  position = (column * (ROLL_BLOCK_SAMPLES - 1) * 256) / (count - 1);
+  fraction = position & 0xFF;
+  position >>= 8;
+
+  //Exactly on a sample, which is always the case for the last column where there is no next sample
+  if(fraction == 0)
+  {
+    return(block[position]);
+  }
+
+  return(((block[position] * (256 - fraction)) + (block[position + 1] * fraction)) >> 8);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_start_conversion(void)
+{
+  //Collect the setting writes. Only the ones that changed since the previous conversion are sent to the FPGA
+  fpga_batch_begin();
+
+  //Make sure the sample rate is in the FPGA, since roll mode uses the same register for its long time base setting
+  fpga_set_sample_rate(scopesettings.samplerate);
+
+  //Set the trigger level
+  fpga_set_trigger_level();
+
+  //Write the time base setting to the FPGA
+  fpga_set_time_base(scopesettings.timeperdiv);
+
+  //Send them before the conversion is started
+  fpga_batch_end();
+
+  //Sampling with trigger circuit enabled
+  scopesettings.samplemode = 1;
+
+  //Arm the sample system without waiting for it
+  fpga_start_conversion();
+
+  //Remember what it was started with
+  conversiondone            = 0;
+  conversionpending         = 1;
+  conversiontimeperdiv      = scopesettings.timeperdiv;
+  conversionsettingschanges = fpgasettingschanges;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Let the timer interrupt watch for the end of the pending conversion. Only to be switched on while the FPGA bus is not used. The time
+//is only needed for the segment time stamps
+
+void scope_watch_conversion(uint32 on)
+{
+  if(on && conversionpending && (conversiondone == 0) && (scopesettings.acquisitionmode == ACQUISITION_MODE_SEGMENTED))
+  {
+    conversionwatch = 1;
+  }
+  else
+  {
+    conversionwatch = 0;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_process_trigger(uint32 count)
+{
+  register uint8  *buffer;
+  register uint32  index;
+  register uint32  last = scopesettings.samplecount;
+  register uint32  invert = 0;
+  register uint32  armed = 0;
+  register uint32  distance;
+  register uint32  bestdistance = 0xFFFFFFFF;
+  register int32   level = scopesettings.triggerlevel;
+  register int32   edgelevel;
+  register int32   armlevel;
+  register int32   sample1;
+  register int32   sample2;
+
+  //Select the trace buffer to process based on the trigger channel
+  if(scopesettings.triggerchannel == 0)
+  {
+    //Channel 1 buffer
+    buffer = (uint8 *)channel1tracebuffer;
+  }
+  else
+  {
+    //Channel 2 buffer
+    buffer = (uint8 *)channel2tracebuffer;
+  }
+
+  disp_have_trigger = 0;
+  disp_trigger_fraction = 0.0;
+
+  //Count is half a sample buffer and is the nominal trigger point
+  //The whole buffer is searched for the crossing closest to it, since checking only a few samples around it made the trace flip between two positions on the low sample rates
+
+  //A falling edge is handled as a rising edge on inverted samples. For sample >= level and next sample < level this gives a level of 256 - level.
+  if(scopesettings.triggeredge == 0)
+  {
+    edgelevel = level;
+  }
+  else
+  {
+    invert = 0xFF;
+    edgelevel = 256 - level;
+  }
+
+  //The signal needs to have been below the level by more than the hysteresis before an edge is accepted, so noise on a slow edge does not give extra crossings
+  armlevel = edgelevel - TRIGGER_HYSTERESIS;
+
+  //Check all the sample pairs
+  for(index=1;index<last;index++)
+  {
+    //Stop when the samples are too far past the nominal point for a closer crossing to be found
+    if((index > count) && ((index - 1 - count) >= bestdistance))
+    {
+      break;
+    }
+
+    //Get the sample with the edge direction applied
+    sample2 = buffer[index] ^ invert;
+
+    //Check if the signal is below the hysteresis band
+    if(sample2 < armlevel)
+    {
+      //Allow the next crossing to be used
+      armed = 1;
+    }
+    //Check if the signal crossed the level after having been below the band
+    else if(armed && (sample2 >= edgelevel))
+    {
+      //Needs to go below the band again before the next crossing is accepted
+      armed = 0;
+
+      //Trigger index is the sample before the crossing. Get the distance to the nominal trigger point
+      if((index - 1) < count)
+      {
+        distance = count - (index - 1);
+      }
+      else
+      {
+        distance = (index - 1) - count;
+      }
+
+      //Check if this crossing is closer than the previous one
+      if(distance < bestdistance)
+      {
+        //Set it as trigger point
+        bestdistance = distance;
+        disp_trigger_index = index - 1;
+
+        //Signal trigger has been found
+        disp_have_trigger = 1;
+      }
+    }
+  }
+
+  //Check if a trigger point has been found
+  if(disp_have_trigger)
+  {
+    //Get the samples on both sides of the crossing
+    sample1 = buffer[disp_trigger_index];
+    sample2 = buffer[disp_trigger_index + 1];
+
+    //Determine where between the two samples the signal crosses the level. Used to shift the trace by a fraction of a sample to avoid jitter
+    disp_trigger_fraction = (double)(level - sample1) / (double)(sample2 - sample1);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+uint32 scope_do_baseline_calibration(void)
+{
+  uint32 flag = 1;
+  uint32 voltperdiv;
+
+  //Disable the trigger circuit
+  scopesettings.samplemode = 0;
+
+  //Set number of samples
   //This can be changed to a global define
   scopesettings.samplecount = 3000;
   scopesettings.nofsamples  = 1500;
 
   //Send the command for setting the trigger level to the FPGA
-  fpga_write_cmd(0x17);
-  fpga_write_byte(0);
+  fpga_write_setting(0x17, 1, 0);
 
   //Clear the compensation values before doing the calibration
   calibrationsettings.adc1compensation = 0;
@@ -4666,12 +6333,18 @@ void scope_do_auto_setup(void)
 {
   PCHANNELSETTINGS settings;
 
-  int32  screentime;
-  int32  timeperdiv;
-  int32  samplerate;
+  uint32 conversions;
+  uint32 searchstep = AUTOSET_START_STEP;
+  uint32 samplerate = samplerate_for_autosetup[AUTOSET_START_STEP];
+  uint32 timeperdiv;
+  uint32 candidate = 0;
+  uint32 havecandidate = 0;
+  uint32 havetimebase = 0;
+  uint32 relayswitched;
+  uint32 trigvoltperdiv;
 
   uint32 dochannel1 = scopesettings.channel1.enable;
-  uint32 dochannel2 = scopesettings.channel1.enable;
+  uint32 dochannel2 = scopesettings.channel2.enable;
 
   //No need to do auto setup if no channel is enabled
   if((dochannel1 == 0) && (dochannel2 == 0))
@@ -4688,27 +6361,49 @@ void scope_do_auto_setup(void)
   scopesettings.nofsamples  = 1500;
 
   //Send the command for setting the trigger level to the FPGA
-  fpga_write_cmd(0x17);
-  fpga_write_byte(0);
+  fpga_write_setting(0x17, 1, 0);
+
+  //Check on which bottom check level needs to be used
+  //When both channels are enabled and in normal display mode use separate sections of the screen for each channel.
+  if(dochannel1 && dochannel2 && (scopesettings.xymodedisplay == 0))
+  {
+    //Both channels enabled then use a lower level. Smaller section of the display available per channel so lower value
+    scopesettings.channel1.maxscreenspace = 1900;
+    scopesettings.channel2.maxscreenspace = 1900;
+
+    //Give both traces it's own location on screen
+    scopesettings.channel1.traceposition = 300;
+    scopesettings.channel2.traceposition = 100;
+  }
+  else
+  {
+    //Only one channel enabled then more screen space available for it so higher value
+    scopesettings.channel1.maxscreenspace = 3900;
+    scopesettings.channel2.maxscreenspace = 3900;
+
+    //Used channel will be set on the middle of the display
+    scopesettings.channel1.traceposition = 200;
+    scopesettings.channel2.traceposition = 200;
+  }
 
   //Setup channel 1 if enabled
   if(dochannel1)
   {
-    //Use the most sensitive hardware setting and set it in the FPGA
-    scopesettings.channel1.voltperdiv = 5;
+    //Start on a mid range setting, from which the needed setting can be calculated for most signals
+    scopesettings.channel1.voltperdiv = AUTOSET_START_VOLT_PER_DIV;
     fpga_set_channel_voltperdiv(&scopesettings.channel1);
   }
 
   //Setup channel 2 if enabled
   if(dochannel2)
   {
-    //Use the most sensitive hardware setting and set it in the FPGA
-    scopesettings.channel2.voltperdiv = 5;
+    //Start on a mid range setting, from which the needed setting can be calculated for most signals
+    scopesettings.channel2.voltperdiv = AUTOSET_START_VOLT_PER_DIV;
     fpga_set_channel_voltperdiv(&scopesettings.channel2);
   }
 
-  //Select the channel to work with
-  if(scopesettings.triggerchannel == 0)
+  //Select the channel to work with. Use the trigger channel unless it is disabled
+  if(((scopesettings.triggerchannel == 0) && dochannel1) || (dochannel2 == 0))
   {
     settings = &scopesettings.channel1;
   }
@@ -4720,234 +6415,114 @@ void scope_do_auto_setup(void)
   //Wait 50ms to allow the relays to settle
   timer0_delay(50);
 
-  //Do the measurements on four sample rates. 200MSa/s, 2MSa/s, 20KSa/s and 1000Sa/s
-  for(samplerate=0;samplerate<4;samplerate++)
+  //Each conversion ranges both channels and gives a period estimate, from which the sample rate for the next one is chosen
+  for(conversions=0;conversions<AUTOSET_MAX_CONVERSIONS;conversions++)
   {
-    //Set the selected sample rate
-    fpga_set_sample_rate(samplerate_for_autosetup[samplerate]);
-
-    //Set the matching time base
-    fpga_set_time_base(sample_rate_time_per_div[samplerate_for_autosetup[samplerate]]);
+    //Set the selected sample rate and the matching time base
+    fpga_set_sample_rate(samplerate);
+    fpga_set_time_base(sample_rate_time_per_div[samplerate]);
 
-    //Start the conversion and wait until done or touch panel active
+    //Start the conversion and wait until done
     fpga_do_conversion();
 
-    //Get the data from a sample run
-    fpga_read_sample_data(settings, 100);
+    //Get the data of both channels from the one conversion
+    if(dochannel1)
+    {
+      fpga_read_sample_data(&scopesettings.channel1, 100);
+    }
 
-    //Check if there is a frequency reading and break the loop if so
-    if(settings->frequencyvalid)
+    if(dochannel2)
     {
-      break;
+      fpga_read_sample_data(&scopesettings.channel2, 100);
     }
-  }
 
-  //When there is a frequency reading determine the needed time per division setting
-  if(settings->frequencyvalid)
-  {
-    //Can't use the frequency here since it is based on the scopesettings.samplerate variable, which is not used here
-    //Calculate the time in nanoseconds for getting three periods on the screen
-    screentime = (float)settings->periodtime * sample_time_converters[samplerate_for_autosetup[samplerate]];
+    //Remember the setting the trigger channel was measured with
+    trigvoltperdiv = settings->voltperdiv;
+
+    //Calculate the volts per division settings from the readings
+    relayswitched = 0;
 
-    //Match the found time to the nearest time per division setting
-    for(timeperdiv=0;timeperdiv<24;timeperdiv++)
+    if(dochannel1)
     {
-      //When the found time is higher than the selected time per division quit the search
-      if(screentime > time_per_div_matching[timeperdiv])
-      {
-        break;
-      }
+      relayswitched |= scope_auto_range_channel(&scopesettings.channel1);
     }
 
-    //Check if not on the first setting
-    if(timeperdiv)
+    if(dochannel2)
     {
-      //If so take one of to get to the right one to use. Also ensures not selecting a non existing setting if none found
-      timeperdiv--;
+      relayswitched |= scope_auto_range_channel(&scopesettings.channel2);
     }
 
-    //Select the found time per division
-    scopesettings.timeperdiv = timeperdiv;
-    scopesettings.samplerate = time_per_div_sample_rate[timeperdiv];
-  }
-  else
-  {
-    //Set a default sample rate and time per division setting
-    scopesettings.timeperdiv = 12;
-    scopesettings.samplerate = time_per_div_sample_rate[12];
-  }
-
-  //Range the input sensitivity on the enabled channels
-  //Check on which bottom check level needs to be used
-  //When both channels are enabled and in normal display mode use separate sections of the screen for each channel.
-  if(dochannel1 && dochannel2 && (scopesettings.xymodedisplay == 0))
-  {
-    //Both channels enabled then use a lower level. Smaller section of the display available per channel so lower value
-    scopesettings.channel1.maxscreenspace = 1900;
-    scopesettings.channel2.maxscreenspace = 1900;
-
-    //Give both traces it's own location on screen
-    scopesettings.channel1.traceposition = 300;
-    scopesettings.channel2.traceposition = 100;
-
-    //Get the sample data for the not trigger source channel when a valid frequency has been determined
+    //Check if there is a frequency reading
     if(settings->frequencyvalid)
     {
-      //Check which channel is the trigger source
-      if(scopesettings.triggerchannel == 0)
-      {
-        //Channel 1 is trigger source so get channel 2 data
-        fpga_read_sample_data(&scopesettings.channel2, 100);
-      }
-      else
+      //Get the time per division setting that fits the found period
+      timeperdiv = scope_auto_setup_time_per_div(settings, samplerate);
+
+      //Done when the conversion was done on the sample rate belonging to it, or when it confirms the previous estimate. When the
+      //sample rate is slow the estimate is taken as is, since a conversion on it takes too long
+      if((time_per_div_sample_rate[timeperdiv] == samplerate) || (havecandidate && (timeperdiv == candidate)) || (time_per_div_sample_rate[timeperdiv] > AUTOSET_SLOWEST_CHECK_RATE))
       {
-        //Channel 2 is trigger source so get channel 1 data
-        fpga_read_sample_data(&scopesettings.channel1, 100);
+        scopesettings.timeperdiv = timeperdiv;
+        havetimebase = 1;
+        break;
       }
-    }
-  }
-  else
-  {
-    //Only one channel enabled then more screen space available for it so higher value
-    scopesettings.channel1.maxscreenspace = 3900;
-    scopesettings.channel2.maxscreenspace = 3900;
-
-    //Used channel will be set on the middle of the display
-    scopesettings.channel1.traceposition = 200;
-    scopesettings.channel2.traceposition = 200;
-  }
-
-  //Set the new sample rate in the FPGA
-  fpga_set_sample_rate(scopesettings.samplerate);
 
-  //Show the new settings
-  scope_acqusition_settings(0);
-
-  //Check the channels on valid voltage readings with the already done conversion, but only when valid frequency
-  if(settings->frequencyvalid)
-  {
-    //Check if channel 1 is enabled and check its range if so
-    if(dochannel1)
+      //Check the estimate with a conversion on the sample rate that belongs to it. An aliased signal will not give the same result
+      candidate = timeperdiv;
+      havecandidate = 1;
+      samplerate = time_per_div_sample_rate[timeperdiv];
+    }
+    else if(havecandidate)
     {
-      dochannel1 = scope_check_channel_range(&scopesettings.channel1);
+      //The check failed, which means the signal was too fast for the sample rate it was found on, so use the fastest one
+      havecandidate = 0;
+      searchstep = 0;
+      samplerate = samplerate_for_autosetup[0];
     }
-
-    //Check if channel 2 is enabled and check its range if so
-    if(dochannel2)
+    else if((settings->peakpeak < AUTOSET_MIN_SIGNAL) && (settings->voltperdiv > trigvoltperdiv))
     {
-      dochannel2 = scope_check_channel_range(&scopesettings.channel2);
+      //The signal was too small to find a frequency, so try again on the same sample rate with the more sensitive setting
     }
-  }
-
-  //If one or either channel not in range another conversion is needed
-  if(dochannel1 || dochannel2)
-  {
-    //Check if channel 1 still needs to be done
-    if(dochannel1)
+    else if(((searchstep + 1) < (sizeof(samplerate_for_autosetup) / sizeof(uint32))) && ((searchstep < AUTOSET_START_STEP) || (settings->peakpeak >= AUTOSET_MIN_SIGNAL)))
     {
-      //Use the 500mV/div setting and set it in the FPGA
-      scopesettings.channel1.voltperdiv = 3;
-      fpga_set_channel_voltperdiv(&scopesettings.channel1);
+      //No crossings in the sample buffer, so the signal is slower. Only go to the slowest sample rate when there is a signal
+      searchstep++;
+      samplerate = samplerate_for_autosetup[searchstep];
     }
-
-    //Check if channel 2 still needs to be done
-    if(dochannel2)
+    else
     {
-      //Use the 500mV/div setting and set it in the FPGA
-      scopesettings.channel2.voltperdiv = 3;
-      fpga_set_channel_voltperdiv(&scopesettings.channel2);
+      //Nothing left to try
+      break;
     }
 
-    //Wait 50ms to allow the relays to settle
-    timer0_delay(50);
-
-    //Start the conversion and wait until done
-    fpga_do_conversion();
-
-    //Check if channel 1 still needs to be done
-    if(dochannel1)
+    //Wait 50ms to allow the relays to settle when a volts per division setting changed
+    if(relayswitched)
     {
-      //Get the data from a sample run
-      fpga_read_sample_data(&scopesettings.channel1, 100);
-
-      //Check the range again
-      dochannel1 = scope_check_channel_range(&scopesettings.channel1);
+      timer0_delay(50);
     }
+  }
 
-    //Check if channel 2 still needs to be done
-    if(dochannel2)
+  //When the check conversions ran out use the last estimate, otherwise use a default setting when nothing was found
+  if(havetimebase == 0)
+  {
+    if(havecandidate)
     {
-      //Get the data from a sample run
-      fpga_read_sample_data(&scopesettings.channel2, 100);
-
-      //Check the range again
-      dochannel2 = scope_check_channel_range(&scopesettings.channel2);
+      scopesettings.timeperdiv = candidate;
     }
-
-    //If one or either channel not in range another conversion is needed
-    if(dochannel1 || dochannel2)
+    else
     {
-      //Check if channel 1 still needs to be done
-      if(dochannel1)
-      {
-        //Use the 2.5V/div setting and set it in the FPGA
-        scopesettings.channel1.voltperdiv = 1;
-        fpga_set_channel_voltperdiv(&scopesettings.channel1);
-      }
-
-      //Check if channel 2 still needs to be done
-      if(dochannel2)
-      {
-        //Use the 2.5V/div setting and set it in the FPGA
-        scopesettings.channel2.voltperdiv = 1;
-        fpga_set_channel_voltperdiv(&scopesettings.channel2);
-      }
-
-      //Wait 50ms to allow the relays to settle
-      timer0_delay(50);
-
-      //Start the conversion and wait until done
-      fpga_do_conversion();
-
-      //Check if channel 1 still needs to be done
-      if(dochannel1)
-      {
-        //Get the data from a sample run
-        fpga_read_sample_data(&scopesettings.channel1, 100);
-
-        //Check the range again
-        dochannel1 = scope_check_channel_range(&scopesettings.channel1);
-      }
-
-      //Check if channel 2 still needs to be done
-      if(dochannel2)
-      {
-        //Get the data from a sample run
-        fpga_read_sample_data(&scopesettings.channel2, 100);
+      scopesettings.timeperdiv = 12;
+    }
+  }
 
-        //Check the range again
-        dochannel2 = scope_check_channel_range(&scopesettings.channel2);
-      }
+  //Select the sample rate for the found time per division
+  scopesettings.samplerate = time_per_div_sample_rate[scopesettings.timeperdiv];
 
-      //If one or either channel not in range the least sensitive setting needs to be used
-      if(dochannel1 || dochannel2)
-      {
-        //Check if channel 1 still not done
-        if(dochannel1)
-        {
-          //Set the lowest sensitivity for this channel
-          scopesettings.channel1.voltperdiv = 0;
-        }
+  //Set the new sample rate in the FPGA
+  fpga_set_sample_rate(scopesettings.samplerate);
 
-        //Check if channel 2 still not done
-        if(dochannel2)
-        {
-          //Set the lowest sensitivity for this channel
-          scopesettings.channel2.voltperdiv = 0;
-        }
-      }
-    }
-  }
+  //Show the new settings
+  scope_acqusition_settings(0);
 
   //Check if channel 1 is enabled and set the new settings if so
   if(scopesettings.channel1.enable)
@@ -4969,66 +6544,91 @@ void scope_do_auto_setup(void)
     scope_channel_settings(&scopesettings.channel2, 0);
   }
 
-  //Adjust the trigger level to 50% setting
-  scope_do_50_percent_trigger_setup();
+  //Adjust the trigger level to 50% setting
+  scope_do_50_percent_trigger_setup();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Match the period found in the last conversion to the time per division setting that shows a few periods on the screen
+
+uint32 scope_auto_setup_time_per_div(PCHANNELSETTINGS settings, uint32 samplerate)
+{
+  int32  screentime;
+  uint32 timeperdiv;
+
+  //Can't use the frequency here since it is based on the scopesettings.samplerate variable, which is not used here
+  //Calculate the time in nanoseconds for getting three periods on the screen
+  screentime = (float)settings->periodtime * sample_time_converters[samplerate];
+
+  //Match the found time to the nearest time per division setting
+  for(timeperdiv=0;timeperdiv<24;timeperdiv++)
+  {
+    //When the found time is higher than the selected time per division quit the search
+    if(screentime > time_per_div_matching[timeperdiv])
+    {
+      break;
+    }
+  }
+
+  //Check if not on the first setting
+  if(timeperdiv)
+  {
+    //If so take one of to get to the right one to use. Also ensures not selecting a non existing setting if none found
+    timeperdiv--;
+  }
+
+  return(timeperdiv);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//Set the volts per division setting of a channel based on the peak peak reading of the last conversion. The size of the signal on
+//the screen scales with the volts per pixel of the settings (volt_calc_data), so the best setting can be calculated from a reading
+//on any setting, as long as it is not clipped. Returns one when the hardware setting changed and the relays need to settle
 
-uint32 scope_check_channel_range(PCHANNELSETTINGS settings)
+uint32 scope_auto_range_channel(PCHANNELSETTINGS settings)
 {
+  uint32 previous = settings->voltperdiv;
+  uint32 voltperdiv;
   uint32 screenpixels;
-  uint32 range;
-  uint32 notdone = 0;
-
-  //Convert the peak peak reading to screen pixels
-  screenpixels = (settings->peakpeak * signal_adjusters[settings->voltperdiv]) >> 22;
 
-  //Check if there is any signal at all to avoid divide by zero
-  if(screenpixels)
+  //Check if the signal is clipped on either side
+  if((settings->min == 0) || (settings->max == 255))
   {
-    //Calculate a fixed point range to determine the volts per division setting, based on the available screen space
-    range = settings->maxscreenspace / screenpixels;
+    //The size is unknown then, so use the least sensitive setting
+    voltperdiv = 0;
+  }
+  else
+  {
+    //Convert the peak peak reading to screen pixels on the setting it was taken with
+    screenpixels = (settings->peakpeak * signal_adjusters[previous]) >> 22;
 
-    //Check if signal is at least 10 times smaller then the max range
-    if(range >= 100)
-    {
-      //If so go three sensitivity settings up. (e.g. 500mV/div ==> 50mV/div)
-      settings->voltperdiv = 3;
-    }
-    //Else check if signal is at least 5 times smaller then the max range
-    else if(range >= 50)
-    {
-      //If so go two sensitivity settings up. (e.g. 500mV/div ==> 100mV/div)
-      settings->voltperdiv += 2;
-    }
-    //Else check if signal is at least 2.5 times smaller then the max range
-    else if(range >= 25)
-    {
-      //If so go one sensitivity setting up. (e.g. 500mV/div ==> 200mV/div)
-      settings->voltperdiv += 1;
-    }
-    //Else check if signal is bigger then the max range
-    else if(range < 10)
+    //Find the most sensitive setting on which the signal is at least 10 times smaller than the available screen space
+    //When there is no signal at all this ends on the most sensitive setting
+    for(voltperdiv=6;voltperdiv>0;voltperdiv--)
     {
-      //Out of range so not done
-      notdone = 1;
+      if((((screenpixels * volt_calc_data[0][previous].mul_factor) / volt_calc_data[0][voltperdiv].mul_factor) * 10) <= settings->maxscreenspace)
+      {
+        break;
+      }
     }
+  }
 
-    //Check if volt per division not out of range
-    if(settings->voltperdiv > 6)
-    {
-      //Keep it on max if so
-      settings->voltperdiv = 6;
-    }
+  //Set the new setting in the FPGA
+  settings->voltperdiv = voltperdiv;
+  fpga_set_channel_voltperdiv(settings);
+
+  //The two most sensitive settings use the same hardware setting
+  if(previous > 5)
+  {
+    previous = 5;
   }
-  else
+
+  if(voltperdiv > 5)
   {
-    //When there is no signal use the most sensitive setting
-    settings->voltperdiv = 6;
+    voltperdiv = 5;
   }
 
-  return(notdone);
+  return(previous != voltperdiv);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -5049,13 +6649,36 @@ void scope_display_trace_data(void)
 
 
   //Need to compensate for the position being on the left side of the pointer
-  uint32 triggerposition = scopesettings.triggerhorizontalposition + 7;
+  int32 triggerposition = scopesettings.triggerhorizontalposition + 7;
+
+  //Get the factors for showing the samples on the set volts per div settings
+  scope_set_sample_scaling(&scopesettings.channel1);
+  scope_set_sample_scaling(&scopesettings.channel2);
+
+  //The math samples are kept on the channel 1 scale, so they follow its setting
+  scopesettings.mathchannel.displayadjuster = scopesettings.channel1.displayadjuster << mathdisplayshift;
+
+  //Check if the traces are shown in roll mode
+  if(scope_check_roll_mode())
+  {
+    //Only the newly sampled part of the traces needs to be drawn, and the result is the background for the rest
+    scope_display_roll_data();
+
+    //Draw the grid lines and dots on top of the traces
+    display_set_screen_buffer(displaybuffer1);
+    scope_draw_grid();
+
+    //Add the cursors, pointers and measurements and show it on the screen
+    scope_finish_trace_display();
+    return;
+  }
 
   //Check if a trigger position has been found
   if(disp_have_trigger == 0)
   {
     //When not use the center of the sample buffer
     disp_trigger_index = scopesettings.samplecount / 2;
+    disp_trigger_fraction = 0.0;
   }
 
   //Make sure the two settings are in range of the tables!!!!
@@ -5077,12 +6700,44 @@ void scope_display_trace_data(void)
   {
     xrange = 1.0;
   }
-  else if(xrange > 725.0)
+  else if(xrange > ZOOM_MAX_XRANGE)
   {
     //Limit on max screen pixels to avoid disp_xend becoming 0x80000000 due to overflow
-    xrange = 725.0;
+    //A stopped trace can be panned, so the range can go well beyond the screen width
+    xrange = ZOOM_MAX_XRANGE;
   }
 
+  //Check if a stopped trace is being viewed
+  if(scope_zoom_active())
+  {
+    //When the time per div setting is changed on a panned trace keep the same part of the signal in the center of the screen
+    if(zoomoffset && (disp_xpos_per_sample != zoomxpospersample))
+    {
+      zoomoffset = (ZOOM_CENTER_XPOS - (((ZOOM_CENTER_XPOS - (triggerposition + zoomoffset)) * disp_xpos_per_sample) / zoomxpospersample)) - triggerposition;
+    }
+
+    //Keep at least a part of the trace on the screen
+    if((triggerposition + zoomoffset + xrange) < (3 + ZOOM_MIN_VISIBLE))
+    {
+      zoomoffset = (3 + ZOOM_MIN_VISIBLE) - xrange - triggerposition;
+    }
+    else if((triggerposition + zoomoffset - xrange) > (725 - ZOOM_MIN_VISIBLE))
+    {
+      zoomoffset = (725 - ZOOM_MIN_VISIBLE) + xrange - triggerposition;
+    }
+
+    //Move the trace with the panning
+    triggerposition += zoomoffset;
+  }
+  else
+  {
+    //A running trace is always shown on the set trigger position
+    zoomoffset = 0;
+  }
+
+  //Keep the scale the offset belongs to
+  zoomxpospersample = disp_xpos_per_sample;
+
   //Calculate the start and end x coordinates
   disp_xstart = triggerposition - xrange;
   disp_xend = triggerposition + xrange;
@@ -5117,7 +6772,7 @@ void scope_display_trace_data(void)
 
 
 
-  //If samplestep > 1 might be an idea to draw the in between samples on the same x position to avoid aliasing
+  //If samplestep > 1 the in between samples are drawn on the same x position as a min/max span to avoid aliasing
   //If sample step < 1 then skip drawing on x positions. The draw line function does the linear interpolation
 
 
@@ -5129,8 +6784,8 @@ void scope_display_trace_data(void)
   display_set_fg_color(0x00000000);
   display_fill_rect(2, 46, 728, 434);
 
-  //Check if not in waveform view mode with grid disabled
-  if((scopesettings.waveviewmode == 0) || scopesettings.gridenable == 0)
+  //Check if not in waveform view mode with grid disabled. In persistence mode the grid is drawn after the traces have been accumulated
+  if((scopesettings.persistence == 0) && ((scopesettings.waveviewmode == 0) || scopesettings.gridenable == 0))
   {
     //Draw the grid lines and dots based on the grid brightness setting
     scope_draw_grid();
@@ -5142,20 +6797,35 @@ void scope_display_trace_data(void)
     //The calculations done above need to go here??
 
 
-    //Check if channel1 is enabled
-    if(scopesettings.channel1.enable)
+    //Check if all the segments of a segmented capture need to be shown
+    if(segmentoverlay && scope_segment_view_active())
     {
-      //This can be reduced in parameters by using the channel structure as input and add the color as item in the structure
-
-      //Go and do the actual trace drawing
-      scope_display_channel_trace(&scopesettings.channel1);
+      scope_display_segment_overlay();
     }
-
-    //Check if channel2 is enabled
-    if(scopesettings.channel2.enable)
+    else
     {
-      //Go and do the actual trace drawing
-      scope_display_channel_trace(&scopesettings.channel2);
+      //Check if channel1 is enabled
+      if(scopesettings.channel1.enable)
+      {
+        //This can be reduced in parameters by using the channel structure as input and add the color as item in the structure
+
+        //Go and do the actual trace drawing
+        scope_display_channel_trace(&scopesettings.channel1);
+      }
+
+      //Check if channel2 is enabled
+      if(scopesettings.channel2.enable)
+      {
+        //Go and do the actual trace drawing
+        scope_display_channel_trace(&scopesettings.channel2);
+      }
+
+      //Check if the math channel is shown
+      if(scope_math_channel_active())
+      {
+        //It is drawn like the real channels
+        scope_display_channel_trace(&scopesettings.mathchannel);
+      }
     }
 
     //Displaying of FFT needs to be added here.
@@ -5169,14 +6839,6 @@ void scope_display_trace_data(void)
 
     uint32 index;
 
-    //Need two samples per buffer
-    uint32 x1,x2;
-    uint32 y1,y2;
-
-
-    index = disp_trigger_index - 325;
-
-
     //This bit needs to be adapted to the new sample handling!!!!!
 
     //Also needs the positions to be handled differently
@@ -5188,28 +6850,57 @@ void scope_display_trace_data(void)
     //Channel 1 is x and channel 2 is y
     //The offsets do not put it on center screen so needs adjusting
 
-    x1 = 401 - scope_get_sample(&scopesettings.channel1, index) + 210;
-    y1 = scope_get_sample(&scopesettings.channel2, index);
+    //Fill the points buffer with the sample pairs
+    for(index=0;index<750;index++)
+    {
+      xymodepointsbuffer[index].x = 401 - scope_get_sample(&scopesettings.channel1, index) + 210;
+      xymodepointsbuffer[index].y = scope_get_sample(&scopesettings.channel2, index);
+    }
 
-    
     //Not sure if this needs to draw lines.
     //Maybe just placing dots
-    
+
     //Het is ook zaak hier de points in het thumbnail trace buffer te zetten
-    
 
-    for(index=1;index<750;index++)
-    {
-      x2 = 401 - scope_get_sample(&scopesettings.channel1, index) + 210;
-      y2 = scope_get_sample(&scopesettings.channel2, index);
+    //Draw all the lines in one go
+    display_draw_trace_polyline(xymodepointsbuffer, 750);
+  }
 
-      display_draw_line(x1, y1, x2, y2);
+  //Check if persistence mode is enabled
+  if(scopesettings.persistence)
+  {
+    //Add the new traces to the persistence buffer and show the result instead
+    scope_display_persistence();
 
-      x1 = x2;
-      y1 = y2;
+    //Check if not in waveform view mode with grid disabled
+    if((scopesettings.waveviewmode == 0) || scopesettings.gridenable == 0)
+    {
+      //Draw the grid lines and dots on top of the persistence display
+      scope_draw_grid();
     }
   }
+  else
+  {
+    //Signal the persistence buffer needs to be cleared when the mode is switched on again
+    persistenceactive = 0;
+  }
+
+  //Put the decoded bytes on top of the traces
+  scope_display_decoded_data();
+
+#ifdef MEMORY_STATISTICS
+  //Show the memory use on top of the traces
+  scope_display_memory_statistics();
+#endif
+
+  //Add the cursors, pointers and measurements and show it on the screen
+  scope_finish_trace_display();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
 
+void scope_finish_trace_display(void)
+{
   //Draw the cursors with their measurement displays
   scope_draw_time_cursors();
   scope_draw_volt_cursors();
@@ -5230,33 +6921,209 @@ void scope_display_trace_data(void)
     display_set_font(&font_0);
     display_text(550, 48, viewfilename);
   }
+  //Check if browsing the segments of a segmented capture
+  else if(scope_segment_view_active())
+  {
+    scope_display_segment_info();
+  }
   
   //Copy it to the actual screen buffer
   display_set_source_buffer(displaybuffer1);
   display_set_screen_buffer((uint16 *)maindisplaybuffer);
   display_copy_rect_to_screen(2, 46, 728, 434);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The roll mode traces are kept in a separate buffer without the grid and pointers. When new samples come in the picture is moved
+//to the left and only the new part is drawn, so the traces scroll instead of being redrawn on every pass
+
+void scope_display_roll_data(void)
+{
+  uint32 count;
+
+  //When the settings that determine the trace positions are changed the whole picture has to be drawn again
+  if((rolldisplaysettings[0] != scopesettings.channel1.enable) || (rolldisplaysettings[1] != scopesettings.channel1.voltperdiv) || (rolldisplaysettings[2] != scopesettings.channel1.traceposition) ||
+     (rolldisplaysettings[3] != scopesettings.channel2.enable) || (rolldisplaysettings[4] != scopesettings.channel2.voltperdiv) || (rolldisplaysettings[5] != scopesettings.channel2.traceposition))
+  {
+    rolldisplaysettings[0] = scopesettings.channel1.enable;
+    rolldisplaysettings[1] = scopesettings.channel1.voltperdiv;
+    rolldisplaysettings[2] = scopesettings.channel1.traceposition;
+    rolldisplaysettings[3] = scopesettings.channel2.enable;
+    rolldisplaysettings[4] = scopesettings.channel2.voltperdiv;
+    rolldisplaysettings[5] = scopesettings.channel2.traceposition;
+
+    rollredraw = 1;
+  }
+
+  //Draw in the roll mode buffer
+  display_set_screen_buffer(rolldisplaybuffer);
+  display_set_fg_color(0x00000000);
+
+  if(rollredraw)
+  {
+    //Clear the trace portion of the screen and draw all the samples there are
+    display_fill_rect(TRACE_WINDOW_XPOS, TRACE_WINDOW_YPOS, TRACE_WINDOW_WIDTH, TRACE_WINDOW_HEIGHT);
+
+    count = rollcount;
+    rollredraw = 0;
+  }
+  else
+  {
+    //Only the samples that came in since the previous pass
+    count = rollnewsamples;
+
+    if(count)
+    {
+      //Scroll the traces to the left to make room for the new samples and clear that part
+      display_scroll_rect_left(ROLL_MODE_XSTART, TRACE_WINDOW_YPOS, ROLL_MODE_SAMPLES, TRACE_WINDOW_HEIGHT, count);
+      display_fill_rect(ROLL_MODE_XEND + 1 - count, TRACE_WINDOW_YPOS, count, TRACE_WINDOW_HEIGHT);
+    }
+  }
+
+  rollnewsamples = 0;
+
+  //Draw the new part of the enabled traces
+  if(count)
+  {
+    if(scopesettings.channel1.enable)
+    {
+      scope_display_roll_trace(&scopesettings.channel1, rollchannel1buffer, count);
+    }
+
+    if(scopesettings.channel2.enable)
+    {
+      scope_display_roll_trace(&scopesettings.channel2, rollchannel2buffer, count);
+    }
+  }
+
+  //Use the traces as background for the rest of the display
+  display_set_source_buffer(rolldisplaybuffer);
+  display_set_screen_buffer(displaybuffer1);
+  display_copy_rect_to_screen(TRACE_WINDOW_XPOS, TRACE_WINDOW_YPOS, TRACE_WINDOW_WIDTH, TRACE_WINDOW_HEIGHT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The newest sample is on the right edge of the trace window. Draws the given number of most recent samples, connected to the one
+//before them when it is there
+
+void scope_display_roll_trace(PCHANNELSETTINGS settings, uint8 *buffer, uint32 count)
+{
+  uint32 index;
+  uint32 xpos;
+  uint32 ypos;
+  uint32 nextypos;
+  uint32 sample;
+
+  //Set the trace color for the current channel
+  display_set_fg_color(settings->color);
+
+  //Get the x position and the buffer index of the first sample to draw. Start one earlier to connect to the already drawn part
+  if(count < rollcount)
+  {
+    count++;
+  }
+
+  xpos  = ROLL_MODE_XEND + 1 - count;
+  index = (rollindex + ROLL_MODE_SAMPLES - count) % ROLL_MODE_SAMPLES;
+
+  //Position of the first sample
+  ypos = scope_scale_sample(settings, buffer[index]);
+
+  //A single sample can only be shown as a dot
+  if(count == 1)
+  {
+    display_draw_line(xpos, ypos, xpos, ypos);
+    return;
+  }
+
+  //Connect the samples with lines
+  for(sample=1;sample<count;sample++)
+  {
+    //Next sample in the circular buffer
+    index++;
+
+    if(index >= ROLL_MODE_SAMPLES)
+    {
+      index = 0;
+    }
+
+    //Draw from the previous position to the new one
+    nextypos = scope_scale_sample(settings, buffer[index]);
+
+    display_draw_line(xpos, ypos, xpos + 1, nextypos);
+
+    xpos++;
+    ypos = nextypos;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_display_persistence(void)
+{
+  //Start with an empty buffer when the mode has just been switched on
+  if(persistenceactive == 0)
+  {
+    memset(persistencebuffer, 0, sizeof(persistencebuffer));
+    persistenceframes = 0;
+    persistenceactive = 1;
+  }
 
+  //Fade the older traces by halving the intensities every set number of frames
+  persistenceframes++;
 
+  if(persistenceframes >= scopesettings.persistence)
+  {
+    display_decay_hits((uint8 *)persistencebuffer, sizeof(persistencebuffer), 1);
+    persistenceframes = 0;
+  }
 
+  //Add the pixels of the traces just drawn to the buffer
+  display_accumulate_hits((uint8 *)persistencebuffer, TRACE_WINDOW_XPOS, TRACE_WINDOW_YPOS, TRACE_WINDOW_WIDTH, TRACE_WINDOW_HEIGHT, PERSISTENCE_INCREMENT);
 
+  //Replace the traces with the intensity graded colors
+  display_copy_hits_to_screen((uint8 *)persistencebuffer, persistencecolors, TRACE_WINDOW_XPOS, TRACE_WINDOW_YPOS, TRACE_WINDOW_WIDTH, TRACE_WINDOW_HEIGHT);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
 int32 scope_get_sample(PCHANNELSETTINGS settings, int32 index)
 {
-  register int32 sample;
+  //Scale the raw sample to a screen y position
+  return(scope_scale_sample(settings, settings->tracebuffer[index]));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//In run mode the samples are taken with the volts per div setting that is shown. On a stopped or loaded trace the setting can be
+//changed to zoom in or out vertically. The screen size of a signal scales with the volts per pixel of the settings (volt_calc_data),
+//so the samples are scaled with the ratio between the setting they were taken with and the shown one
+
+void scope_set_sample_scaling(PCHANNELSETTINGS settings)
+{
+  uint32 sampled = settings->sampledvoltperdiv;
+  uint32 shown   = settings->voltperdiv;
 
-  //At this point a setup for varying the scaling can be added to make it possible to switch volt per div on a stopped or saved waveform
-  //Need a variable to hold the volt/div setting on which the buffer has been sampled and a volt/div setting the display is set on
-  //In run mode these need to be the same. Only in stop mode there can be a diff between the two.
+  if(sampled == shown)
+  {
+    //Same setting so just the adjuster for it
+    settings->displayadjuster = signal_adjusters[shown];
+  }
+  else
+  {
+    //Adjuster of the sampled setting translated to the shown one
+    settings->displayadjuster = ((int64)signal_adjusters[sampled] * volt_calc_data[0][sampled].mul_factor) / volt_calc_data[0][shown].mul_factor;
+  }
+}
 
+//----------------------------------------------------------------------------------------------------------------------------------
 
+int32 scope_scale_sample(PCHANNELSETTINGS settings, int32 sample)
+{
   //Center adjust the sample
-  sample = (int32)settings->tracebuffer[index] - 128;
+  sample = sample - 128;
 
-  //Get the sample and adjust the data for the correct voltage per div setting
-  sample = (sample * signal_adjusters[settings->voltperdiv]) >> 22;
+  //Get the sample and adjust the data for the volts per div setting it is shown on. Zoomed in far this no longer fits in 32 bits
+  sample = ((int64)sample * settings->displayadjuster) >> 22;
 
   //Offset the sample on the screen
   sample = settings->traceposition + sample;
@@ -5292,6 +7159,13 @@ void scope_display_channel_trace(PCHANNELSETTINGS settings)
 
   register PDISPLAYPOINTS tracepoints = settings->tracepoints;
 
+  //When more than one sample falls on a single x position use the min/max path to show all the samples
+  if(disp_sample_step > 1.0)
+  {
+    scope_display_channel_trace_peak(settings);
+    return;
+  }
+
   //Set the trace color for the current channel
   display_set_fg_color(settings->color);
 
@@ -5306,8 +7180,8 @@ void scope_display_channel_trace(PCHANNELSETTINGS settings)
   //Start with one tracepoint
   settings->noftracepoints = 1;
 
-  //Step to the next input index
-  inputindex = disp_first_sample + disp_sample_step;
+  //Step to the next input index. The sub sample trigger offset shifts the trace to keep the crossing on the same screen position
+  inputindex = disp_first_sample + disp_trigger_fraction + disp_sample_step;
 
   //The previous index is the index of the first sample
   previousindex = disp_first_sample;
@@ -5318,54 +7192,208 @@ void scope_display_channel_trace(PCHANNELSETTINGS settings)
     //Get the current integer index into the sample buffer
     currentindex = inputindex;
 
-    //Check if linear approximation needs to be done. (Only when step < 1) pixels are skipped if so.
-    if(currentindex != previousindex)
+    //Check if linear approximation needs to be done. (Only when step < 1) pixels are skipped if so.
+    if(currentindex != previousindex)
+    {
+      //Set new previous index
+      previousindex = currentindex;
+
+      //Get the processed sample
+      sample2 = scope_get_sample(settings, currentindex);
+
+      //Store the second sample in the screen buffer
+      tracepoints->x = xpos;
+      tracepoints->y = sample2;
+      tracepoints++;
+
+      //One more tracepoint
+      settings->noftracepoints++;
+
+      sample1 = sample2;
+
+      lastx = xpos;
+    }
+  }
+
+  //When step less then 1 the last pixel needs to be interpolated between current sample and next sample.
+  if(disp_sample_step < 1.0)
+  {
+    //Calculate the scaler for the last y value based on the x distance from the last drawn position to the end of the screen
+    //divided by the x distance it takes to where the next position should be drawn (Number of x steps per sample)
+    double scaler =  (725.0 - lastx) / disp_xpos_per_sample;    // (1 / samplestep);
+
+    //Get the processed sample
+    sample2 = scope_get_sample(settings, inputindex);
+
+    sample2 = sample1 + ((double)((double)sample2 - (double)sample1) / scaler);
+
+    //Store the last sample in the screen buffer
+    tracepoints->x = xpos;
+    tracepoints->y = sample2;
+    tracepoints++;
+
+    //One more tracepoint
+    settings->noftracepoints++;
+  }
+
+  //Draw the lines between all the trace points in one go
+  display_draw_trace_polyline(settings->tracepoints, settings->noftracepoints);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void scope_display_channel_trace_peak(PCHANNELSETTINGS settings)
+{
+  double inputindex;
+
+  register uint8  *buffer = settings->tracebuffer;
+  register uint32  index = disp_first_sample;
+  register uint32  endindex;
+  register uint32  sample;
+  register uint32  minimum;
+  register uint32  maximum;
+  register uint32  last;
+  register uint32  xpos = disp_xstart;
+  register uint32  samplecount = scopesettings.samplecount;
+
+  register PDISPLAYPOINTS tracepoints = settings->tracepoints;
+
+  //Set the trace color for the current channel
+  display_set_fg_color(settings->color);
+
+  //Start with the first sample as the last one of a virtual previous column
+  last = buffer[index];
+
+  //Step through the samples in one pass, shifted by the sub sample trigger offset
+  inputindex = disp_first_sample + disp_trigger_fraction;
+
+  //No trace points yet
+  settings->noftracepoints = 0;
+
+  //Process the sample data one x position at a time
+  for(; xpos < disp_xend; xpos++)
+  {
+    //Stop when all the samples have been used
+    if(index >= samplecount)
+    {
+      break;
+    }
+
+    //Determine the end of the samples for this x position
+    inputindex += disp_sample_step;
+    endindex = inputindex;
+
+    //Make sure no reading outside the buffer can occur
+    if(endindex > samplecount)
+    {
+      endindex = samplecount;
+    }
+
+    //Store the first sample of the column for the thumbnail trace
+    tracepoints->x = xpos;
+    tracepoints->y = scope_scale_sample(settings, buffer[index]);
+    tracepoints++;
+
+    //One more tracepoint
+    settings->noftracepoints++;
+
+    //Include the last sample of the previous column so the spans connect into a continuous trace
+    minimum = last;
+    maximum = last;
+
+    //Find the extremes of the samples that fall on this x position
+    while(index < endindex)
     {
-      //Set new previous index
-      previousindex = currentindex;
+      //Get the next sample
+      sample = buffer[index++];
 
-      //Get the processed sample
-      sample2 = scope_get_sample(settings, currentindex);
+      //Check if it is a new minimum
+      if(sample < minimum)
+      {
+        minimum = sample;
+      }
 
-      //Store the second sample in the screen buffer
-      tracepoints->x = xpos;
-      tracepoints->y = sample2;
-      tracepoints++;
+      //Check if it is a new maximum
+      if(sample > maximum)
+      {
+        maximum = sample;
+      }
+    }
 
-      //One more tracepoint
-      settings->noftracepoints++;
+    //Keep the last sample of this column for connecting the next one
+    last = buffer[index - 1];
 
-      //Need to draw a line here
-      display_draw_line(lastx, sample1, xpos, sample2);
+    //Display y coordinates are inverted so the maximum gives the top of the span
+    display_draw_vert_line(xpos, scope_scale_sample(settings, maximum), scope_scale_sample(settings, minimum));
+  }
+}
 
-      sample1 = sample2;
+//----------------------------------------------------------------------------------------------------------------------------------
+//Every decoded byte is shown as a hexadecimal label on the screen position of its first sample, using the same sample to screen
+//mapping as the trace drawing. Labels that would overlap the previous one are skipped
 
-      lastx = xpos;
-    }
+void scope_display_decoded_data(void)
+{
+  PDECODERITEM item = decoderresult.items;
+  uint32       count = decoderresult.count;
+  int32        xpos;
+  int32        nextxpos = disp_xstart;
+  int8         text[3];
+
+  //Only when the traces are shown normally
+  if((scope_decoder_active() == 0) || (segmentoverlay && scope_segment_view_active()))
+  {
+    return;
   }
 
-  //When step less then 1 the last pixel needs to be interpolated between current sample and next sample.
-  if(disp_sample_step < 1.0)
+  //Select the font for the labels
+  display_set_font(&font_0);
+
+  text[2] = 0;
+
+  for(; count; count--, item++)
   {
-    //Calculate the scaler for the last y value based on the x distance from the last drawn position to the end of the screen
-    //divided by the x distance it takes to where the next position should be drawn (Number of x steps per sample)
-    double scaler =  (725.0 - lastx) / disp_xpos_per_sample;    // (1 / samplestep);
+    //Screen position of the first sample of the byte
+    xpos = disp_xstart + (((double)item->start - disp_first_sample - disp_trigger_fraction) * disp_xpos_per_sample);
 
-    //Get the processed sample
-    sample2 = scope_get_sample(settings, inputindex);
+    //Skip the bytes left of the trace and the ones that do not fit next to the previous label
+    if(xpos < nextxpos)
+    {
+      continue;
+    }
 
-    sample2 = sample1 + ((double)((double)sample2 - (double)sample1) / scaler);
+    //Done when the rest is right of the trace
+    if((xpos + DECODER_LABEL_WIDTH) > (int32)disp_xend)
+    {
+      break;
+    }
 
-    //Store the last sample in the screen buffer
-    tracepoints->x = xpos;
-    tracepoints->y = sample2;
-    tracepoints++;
+    //The color signals a framing error or a missing acknowledge, or an I2C address
+    if((item->flags & DECODER_FLAG_ERROR) || ((scopesettings.decodermode == DECODER_MODE_I2C) && ((item->flags & DECODER_FLAG_ACK) == 0)))
+    {
+      display_set_fg_color(DECODER_ERROR_COLOR);
+    }
+    else if(item->flags & DECODER_FLAG_ADDRESS)
+    {
+      display_set_fg_color(DECODER_ADDRESS_COLOR);
+    }
+    else
+    {
+      display_set_fg_color(DECODER_COLOR);
+    }
 
-    //One more tracepoint
-    settings->noftracepoints++;
+    //Draw the label box
+    display_fill_rect(xpos, DECODER_LABEL_YPOS, DECODER_LABEL_WIDTH, DECODER_LABEL_HEIGHT);
 
-    //Draw the last line
-    display_draw_line(lastx, sample1, xpos, sample2);
+    //Value in black on the box
+    text[0] = printhexnibble(item->value >> 4);
+    text[1] = printhexnibble(item->value & 0x0F);
+
+    display_set_fg_color(0x00000000);
+    display_text(xpos + 2, DECODER_LABEL_YPOS, text);
+
+    //Leave a pixel between the labels
+    nextxpos = xpos + DECODER_LABEL_WIDTH + 1;
   }
 }
 
@@ -5675,13 +7703,19 @@ void scope_prepare_setup_for_file(void)
 
   //Put in a version number for the waveform view file
   ptr[1] = WAVEFORM_FILE_VERSION;
+
+  //Signal if the sample data is written in the compressed format
+  if(scopesettings.filecompression)
+  {
+    ptr[2] = WAVEFORM_COMPRESSED_DATA;
+  }
   
   //Leave space for file version and checksum data
   index = CHANNEL1_SETTING_OFFSET;
   
   //Copy the needed channel 1 settings and measurements
   ptr[index++] = scopesettings.channel1.enable;
-  ptr[index++] = scopesettings.channel1.voltperdiv;
+  ptr[index++] = scopesettings.channel1.sampledvoltperdiv;
   ptr[index++] = scopesettings.channel1.fftenable;
   ptr[index++] = scopesettings.channel1.coupling;
   ptr[index++] = scopesettings.channel1.magnification;
@@ -5702,7 +7736,7 @@ void scope_prepare_setup_for_file(void)
   
   //Copy the needed channel 2 settings and measurements
   ptr[index++] = scopesettings.channel2.enable;
-  ptr[index++] = scopesettings.channel2.voltperdiv;
+  ptr[index++] = scopesettings.channel2.sampledvoltperdiv;
   ptr[index++] = scopesettings.channel2.fftenable;
   ptr[index++] = scopesettings.channel2.coupling;
   ptr[index++] = scopesettings.channel2.magnification;
@@ -5732,6 +7766,7 @@ void scope_prepare_setup_for_file(void)
   ptr[index++] = scopesettings.triggerverticalposition;
   ptr[index++] = disp_have_trigger;
   ptr[index++] = disp_trigger_index;
+  ptr[index++] = disp_trigger_fraction * 65536.0;
 
   //Leave some space for trigger information changes
   index = OTHER_SETTING_OFFSET;
@@ -5839,6 +7874,10 @@ void scope_restore_setup_from_file(void)
   scopesettings.channel2.hightime       = ptr[index++];
   scopesettings.channel2.periodtime     = ptr[index++];
 
+  //The samples in the file are taken with the saved volts per div settings
+  scopesettings.channel1.sampledvoltperdiv = scopesettings.channel1.voltperdiv;
+  scopesettings.channel2.sampledvoltperdiv = scopesettings.channel2.voltperdiv;
+
   //Leave some space for channel 2 settings changes
   index = TRIGGER_SETTING_OFFSET;
   
@@ -5853,6 +7892,7 @@ void scope_restore_setup_from_file(void)
   scopesettings.triggerverticalposition   = ptr[index++];
   disp_have_trigger                       = ptr[index++];
   disp_trigger_index                      = ptr[index++];
+  disp_trigger_fraction                   = ptr[index++] / 65536.0;
 
   //Leave some space for trigger information changes
   index = OTHER_SETTING_OFFSET;
@@ -5965,10 +8005,32 @@ void scope_print_file_name(uint32 filenumber)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void scope_setup_fast_seek(void)
+{
+  //Setup the link map buffer for the file just opened for reading
+  viewfp.cltbl = viewlinkmap;
+  viewlinkmap[0] = VIEW_LINK_MAP_SIZE;
+
+  //Have FatFs create the cluster link map, so seeking does not need to follow the FAT chain
+  if(f_lseek(&viewfp, CREATE_LINKMAP) != FR_OK)
+  {
+    //When the file is too fragmented for the buffer the normal seek method is used
+    viewfp.cltbl = 0;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 int32 scope_load_thumbnail_file(void)
 {
   int32  result;
-  uint32 size;
+  uint32 count;
+  uint32 slot;
+  uint32 bits;
+  uint32 index;
+  uint32 i;
+  uint32 sequence;
+  uint32 filenumber;
 
   //Set the name in the global buffer for message display
   strcpy(viewfilename, view_file_path[viewtype & VIEW_TYPE_MASK].name);
@@ -5994,41 +8056,8 @@ int32 scope_load_thumbnail_file(void)
         return(-1);
       }
 
-      //Set the name in the global buffer for message display
-      strcpy(viewfilename, thumbnail_file_names[viewtype & VIEW_TYPE_MASK]);
-
       //With the directory created it is also needed to create the thumbnail file
-      result = f_open(&viewfp, viewfilename, FA_CREATE_ALWAYS | FA_WRITE);
-
-      if(result != FR_OK)
-      {
-        //Show a message stating creating the file failed
-        scope_display_file_status_message(MESSAGE_FILE_CREATE_FAILED, 0);
-
-        //No sense to continue, so return with an error
-        return(-1);
-      }
-
-      //Reset the number of available items
-      viewavailableitems = 0;
-
-      //Write the no thumbnails yet data
-      result = f_write(&viewfp, &viewavailableitems, sizeof(viewavailableitems), 0);
-
-      //Close the file
-      f_close(&viewfp);
-
-      if(result != FR_OK)
-      {
-        //Show a message stating writing the file failed
-        scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
-
-        //No sense to continue, so return with an error
-        return(-1);
-      }
-
-      //No items to be loaded so done
-      return(0);
+      return(scope_create_thumbnail_file());
     }
     else
     {
@@ -6043,6 +8072,9 @@ int32 scope_load_thumbnail_file(void)
   //Clear the file number list to avoid errors when swapping between the two types
   memset(viewfilenumberdata, 0, sizeof(viewfilenumberdata));
 
+  //Nothing loaded yet
+  viewavailableitems = 0;
+
   //Set the name in the global buffer for message display
   strcpy(viewfilename, thumbnail_file_names[viewtype & VIEW_TYPE_MASK]);
 
@@ -6052,8 +8084,11 @@ int32 scope_load_thumbnail_file(void)
   //Check the result
   if(result == FR_OK)
   {
-    //Opened ok, so read the number of items
-    result = f_read(&viewfp, &viewavailableitems, sizeof(viewavailableitems), 0);
+    //Use the cluster link map for seeking in the file
+    scope_setup_fast_seek();
+
+    //Opened ok, so read the header with the slot bitmap
+    result = f_read(&viewfp, &viewthumbnailheader, sizeof(viewthumbnailheader), 0);
 
     if(result != FR_OK)
     {
@@ -6067,140 +8102,305 @@ int32 scope_load_thumbnail_file(void)
       return(-1);
     }
 
-    //Based on the number of available items load the rest of the data
-    if(viewavailableitems)
+    //A file without the signature is from the previous firmware, which only kept a list. It is converted, so the items saved with it
+    //are not lost
+    if((viewthumbnailheader.signature != VIEW_THUMBNAIL_SIGNATURE) || (viewthumbnailheader.version != VIEW_THUMBNAIL_VERSION))
     {
-      //Calculate the number of bytes to read for the file number list
-      size = viewavailableitems * sizeof(uint16);
+      //The file is closed in here
+      return(scope_convert_thumbnail_file());
+    }
 
-      //Check if there is an error
-      if(size > VIEW_FILE_NUMBER_DATA_SIZE)
+    //Count the used slots to check the header against
+    for(i=0,count=0;i<VIEW_SLOT_BITMAP_WORDS;i++)
+    {
+      //Count the set bits in this word
+      for(bits=viewthumbnailheader.slotbitmap[i];bits;bits&=bits-1)
       {
-        //Show a message stating that the thumbnail file is corrupt
-        scope_display_file_status_message(MESSAGE_THUMBNAIL_FILE_CORRUPT, 0);
+        count++;
+      }
+    }
 
-        //Reset the number of available items
-        viewavailableitems = 0;
+    //Check if there is an error
+    if((count != viewthumbnailheader.items) || (count > VIEW_MAX_ITEMS))
+    {
+      //Show a message stating that the thumbnail file is corrupt
+      scope_display_file_status_message(MESSAGE_THUMBNAIL_FILE_CORRUPT, 0);
 
-        //Write the no thumbnails yet data
-        result = f_write(&viewfp, &viewavailableitems, sizeof(viewavailableitems), 0);
+      //Close the file
+      f_close(&viewfp);
 
-        //Close the file
-        f_close(&viewfp);
+      //No items to be loaded any more, so start with a new file
+      return(scope_create_thumbnail_file());
+    }
+
+    //Items are added in the lowest free slot, so mostly the slot order is the save order. The list is newest first, so fill it from the end
+    index = count;
+
+    //Read the records in chunks, skipping the chunks without used slots
+    for(slot=0;(slot<VIEW_MAX_ITEMS) && index;slot+=VIEW_THUMBNAIL_CHUNK_RECORDS)
+    {
+      //Get the bits for the slots in this chunk
+      bits = (viewthumbnailheader.slotbitmap[slot >> 5] >> (slot & 31)) & ((1 << VIEW_THUMBNAIL_CHUNK_RECORDS) - 1);
+
+      //Only read when there is something to load
+      if(bits)
+      {
+        //Go to the record of the first slot of the chunk. The header takes up the first record position
+        result = f_lseek(&viewfp, (slot + 1) * VIEW_THUMBNAIL_RECORD_SIZE);
+
+        if(result == FR_OK)
+        {
+          //Read the records. The last chunk in the file might be shorter, but then the missing slots are not used
+          result = f_read(&viewfp, viewthumbnailrecords, sizeof(viewthumbnailrecords), 0);
+        }
 
         if(result != FR_OK)
         {
-          //Show a message stating writing the file failed
-          scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
+          //Show a message stating reading the file failed
+          scope_display_file_status_message(MESSAGE_FILE_READ_FAILED, 0);
+
+          //Close the file
+          f_close(&viewfp);
 
           //No sense to continue, so return with an error
           return(-1);
         }
 
-        //No items to be loaded any more so done
-        return(0);
+        //Take the used records out of the chunk
+        for(i=0;(i<VIEW_THUMBNAIL_CHUNK_RECORDS) && index;i++)
+        {
+          //Check if this slot is in use
+          if(bits & (1 << i))
+          {
+            //Fill in the next list entry
+            index--;
+
+            memcpy(&viewthumbnaildata[index], &viewthumbnailrecords[i].thumbnail, sizeof(THUMBNAILDATA));
+
+            viewfilenumberdata[index] = slot + i + 1;
+            viewthumbnailsequence[index] = viewthumbnailrecords[i].sequence;
+          }
+        }
       }
+    }
 
-      //Read the file number data
-      result = f_read(&viewfp, viewfilenumberdata, size, 0);
+    //Close the file
+    f_close(&viewfp);
 
-      if(result != FR_OK)
+    //All the items are in the list now
+    viewavailableitems = count;
+
+    //Sort the list newest first. After deleting items the free slots get reused, so some items can be out of order
+    for(index=1;index<count;index++)
+    {
+      //Only when the item is newer than the one before it, it needs to be moved
+      if(viewthumbnailsequence[index] > viewthumbnailsequence[index - 1])
       {
-        //Show a message stating reading the file failed
-        scope_display_file_status_message(MESSAGE_FILE_READ_FAILED, 0);
+        //Take the item out of the list
+        sequence = viewthumbnailsequence[index];
+        filenumber = viewfilenumberdata[index];
+        memcpy(&viewthumbnailrecords[0].thumbnail, &viewthumbnaildata[index], sizeof(THUMBNAILDATA));
 
-        //Close the file
-        f_close(&viewfp);
+        //Move the older items up until the position for it is found
+        for(i=index;(i>0) && (viewthumbnailsequence[i - 1] < sequence);i--)
+        {
+          viewthumbnailsequence[i] = viewthumbnailsequence[i - 1];
+          viewfilenumberdata[i] = viewfilenumberdata[i - 1];
+          memcpy(&viewthumbnaildata[i], &viewthumbnaildata[i - 1], sizeof(THUMBNAILDATA));
+        }
 
-        //No sense to continue, so return with an error
-        return(-1);
+        //Put the item in its position
+        viewthumbnailsequence[i] = sequence;
+        viewfilenumberdata[i] = filenumber;
+        memcpy(&viewthumbnaildata[i], &viewthumbnailrecords[0].thumbnail, sizeof(THUMBNAILDATA));
       }
+    }
+  }
+  //Failure then check if file does not exist
+  else if(result == FR_NO_FILE)
+  {
+    //Need the file so create it
+    return(scope_create_thumbnail_file());
+  }
+
+  //Signal all went well
+  return(0);
+}
 
-      //Calculate the number of bytes to read for the thumbnail data
-      size = viewavailableitems * sizeof(THUMBNAILDATA);
+//----------------------------------------------------------------------------------------------------------------------------------
+//The old thumbnail file holds the number of items, the list of file numbers and the list of thumbnails, all newest first. The first
+//part of it is already read into the header buffer
 
-      //Check if there is an error
-      if(size > VIEW_THUMBNAIL_DATA_SIZE)
-      {
-        //Show a message stating that the thumbnail file is corrupt
-        scope_display_file_status_message(MESSAGE_THUMBNAIL_FILE_CORRUPT, 0);
+int32 scope_convert_thumbnail_file(void)
+{
+  int32  result;
+  uint32 count;
+  uint32 index;
+  uint32 slot;
 
-        //Reset the number of available items
-        viewavailableitems = 0;
+  //Get the number of items from the start of the file
+  count = *(uint16 *)&viewthumbnailheader;
 
-        //Write the no thumbnails yet data
-        result = f_write(&viewfp, &viewavailableitems, sizeof(viewavailableitems), 0);
+  //Check if the number of items is valid and the file holds all the data for them
+  if((count > VIEW_MAX_ITEMS) || (f_size(&viewfp) < (sizeof(uint16) + (count * (sizeof(uint16) + sizeof(THUMBNAILDATA))))))
+  {
+    //Show a message stating that the thumbnail file is corrupt
+    scope_display_file_status_message(MESSAGE_THUMBNAIL_FILE_CORRUPT, 0);
 
-        //Close the file
-        f_close(&viewfp);
+    //Close the file
+    f_close(&viewfp);
 
-        if(result != FR_OK)
-        {
-          //Show a message stating writing the file failed
-          scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
+    //No items to be loaded, so start with a new file
+    return(scope_create_thumbnail_file());
+  }
 
-          //No sense to continue, so return with an error
-          return(-1);
-        }
+  //Read the file number list and the thumbnails directly into the lists
+  result = f_lseek(&viewfp, sizeof(uint16));
 
-        //No items to be loaded any more so done
-        return(0);
-      }
+  if(result == FR_OK)
+  {
+    result = f_read(&viewfp, viewfilenumberdata, count * sizeof(uint16), 0);
+  }
 
-      //Read the thumbnail data
-      result = f_read(&viewfp, viewthumbnaildata, size, 0);
+  if(result == FR_OK)
+  {
+    result = f_read(&viewfp, viewthumbnaildata, count * sizeof(THUMBNAILDATA), 0);
+  }
 
-      if(result != FR_OK)
-      {
-        //Show a message stating reading the file failed
-        scope_display_file_status_message(MESSAGE_FILE_READ_FAILED, 0);
+  //Close the file
+  f_close(&viewfp);
 
-        //Close the file
-        f_close(&viewfp);
+  if(result != FR_OK)
+  {
+    //Show a message stating reading the file failed
+    scope_display_file_status_message(MESSAGE_FILE_READ_FAILED, 0);
 
-        //No sense to continue, so return with an error
-        return(-1);
-      }
+    //No sense to continue, so return with an error
+    return(-1);
+  }
+
+  //Setup a header without used slots
+  memset(&viewthumbnailheader, 0, sizeof(viewthumbnailheader));
+
+  viewthumbnailheader.signature = VIEW_THUMBNAIL_SIGNATURE;
+  viewthumbnailheader.version   = VIEW_THUMBNAIL_VERSION;
+  viewthumbnailheader.sequence  = count + 1;
+  viewthumbnailheader.items     = count;
+
+  //Each item gets the slot of its file number. The list is newest first, so the sequence numbers count down
+  for(index=0;index<count;index++)
+  {
+    slot = viewfilenumberdata[index] - 1;
+
+    //The file numbers need to be in range and can only be used once
+    if((slot >= VIEW_MAX_ITEMS) || (viewthumbnailheader.slotbitmap[slot >> 5] & (1 << (slot & 31))))
+    {
+      //Show a message stating that the thumbnail file is corrupt
+      scope_display_file_status_message(MESSAGE_THUMBNAIL_FILE_CORRUPT, 0);
+
+      //Start with a new file
+      return(scope_create_thumbnail_file());
     }
 
-    //Close the file
-    f_close(&viewfp);
+    viewthumbnailheader.slotbitmap[slot >> 5] |= 1 << (slot & 31);
+
+    viewthumbnailsequence[index] = count - index;
   }
-  //Failure then check if file does not exist
-  else if(result == FR_NO_FILE)
+
+  //Replace the old file with the new format
+  result = f_open(&viewfp, viewfilename, FA_CREATE_ALWAYS | FA_WRITE);
+
+  if(result != FR_OK)
   {
-    //Need the file so create it
-    result = f_open(&viewfp, viewfilename, FA_CREATE_ALWAYS | FA_WRITE);
+    //Show a message stating creating the file failed
+    scope_display_file_status_message(MESSAGE_FILE_CREATE_FAILED, 0);
+
+    //No sense to continue, so return with an error
+    return(-1);
+  }
+
+  //Write the header with the slot bitmap
+  result = f_write(&viewfp, &viewthumbnailheader, sizeof(viewthumbnailheader), 0);
+
+  //Write a record for every item in the sector of its slot
+  for(index=0;(index<count) && (result == FR_OK);index++)
+  {
+    memset(&viewthumbnailrecords[0], 0, sizeof(THUMBNAILRECORD));
+
+    viewthumbnailrecords[0].sequence = viewthumbnailsequence[index];
+    memcpy(&viewthumbnailrecords[0].thumbnail, &viewthumbnaildata[index], sizeof(THUMBNAILDATA));
+
+    result = f_lseek(&viewfp, viewfilenumberdata[index] * VIEW_THUMBNAIL_RECORD_SIZE);
 
-    //Check if file is created ok
     if(result == FR_OK)
     {
-      //Reset the number of available items
-      viewavailableitems = 0;
+      result = f_write(&viewfp, &viewthumbnailrecords[0], sizeof(THUMBNAILRECORD), 0);
+    }
+  }
 
-      //Write the no thumbnails yet data
-      result = f_write(&viewfp, &viewavailableitems, sizeof(viewavailableitems), 0);
+  //Close the file
+  f_close(&viewfp);
 
-      //Close the file
-      f_close(&viewfp);
+  if(result != FR_OK)
+  {
+    //Show a message stating writing the file failed
+    scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
 
-      if(result != FR_OK)
-      {
-        //Show a message stating writing the file failed
-        scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
+    //No sense to continue, so return with an error
+    return(-1);
+  }
 
-        //No sense to continue, so return with an error
-        return(-1);
-      }
-    }
-    else
-    {
-      //Show a message stating creating the file failed
-      scope_display_file_status_message(MESSAGE_FILE_CREATE_FAILED, 0);
+  //The converted items are in the list now
+  viewavailableitems = count;
 
-      //No sense to continue, so return with an error
-      return(-1);
-    }
+  //Signal all went well
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 scope_create_thumbnail_file(void)
+{
+  int32 result;
+
+  //Setup an empty header
+  memset(&viewthumbnailheader, 0, sizeof(viewthumbnailheader));
+
+  viewthumbnailheader.signature = VIEW_THUMBNAIL_SIGNATURE;
+  viewthumbnailheader.version   = VIEW_THUMBNAIL_VERSION;
+  viewthumbnailheader.sequence  = 1;
+
+  //Reset the number of available items
+  viewavailableitems = 0;
+
+  //Set the name in the global buffer for message display
+  strcpy(viewfilename, thumbnail_file_names[viewtype & VIEW_TYPE_MASK]);
+
+  //Create the file, replacing an existing one
+  result = f_open(&viewfp, viewfilename, FA_CREATE_ALWAYS | FA_WRITE);
+
+  if(result != FR_OK)
+  {
+    //Show a message stating creating the file failed
+    scope_display_file_status_message(MESSAGE_FILE_CREATE_FAILED, 0);
+
+    //No sense to continue, so return with an error
+    return(-1);
+  }
+
+  //Write the no thumbnails yet header
+  result = f_write(&viewfp, &viewthumbnailheader, sizeof(viewthumbnailheader), 0);
+
+  //Close the file
+  f_close(&viewfp);
+
+  if(result != FR_OK)
+  {
+    //Show a message stating writing the file failed
+    scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
+
+    //No sense to continue, so return with an error
+    return(-1);
   }
 
   //Signal all went well
@@ -6209,77 +8409,69 @@ int32 scope_load_thumbnail_file(void)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
-int32 scope_save_thumbnail_file(void)
+int32 scope_save_thumbnail_file(void)
+{
+  //Only the header with the slot bitmap changes when items are removed, so no record needs to be written
+  return(scope_write_thumbnail_file(0, 0));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 scope_write_thumbnail_file(uint32 filenumber, PTHUMBNAILDATA thumbnaildata)
 {
-  int32  result;
-  uint32 size;
+  int32 result;
 
   //Set the name in the global buffer for message display
   strcpy(viewfilename, thumbnail_file_names[viewtype & VIEW_TYPE_MASK]);
 
-  //Try to open the thumbnail file for this view type
-  result = f_open(&viewfp, viewfilename, FA_CREATE_ALWAYS | FA_WRITE);
+  //Open the existing thumbnail file for this view type
+  result = f_open(&viewfp, viewfilename, FA_WRITE);
 
   //Only if the file is opened write to it
   if(result == FR_OK)
   {
-    //Write the number of available items to the file
-    result = f_write(&viewfp, &viewavailableitems, sizeof(viewavailableitems), 0);
-
-    if(result != FR_OK)
+    //Check if there is a record to write
+    if(thumbnaildata)
     {
-      //Show a message stating writing the file failed
-      scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
-
-      //Close the file
-      f_close(&viewfp);
-
-      //No sense to continue, so return with an error
-      return(-1);
-    }
+      //Setup the record for the slot of the file number
+      memset(&viewthumbnailrecords[0], 0, sizeof(THUMBNAILRECORD));
 
-    //Based on the number of available items write the rest of the data
-    if(viewavailableitems)
-    {
-      //Calculate the number of bytes to write for the file number list
-      size = viewavailableitems * sizeof(uint16);
+      viewthumbnailrecords[0].sequence = viewthumbnailheader.sequence++;
+      memcpy(&viewthumbnailrecords[0].thumbnail, thumbnaildata, sizeof(THUMBNAILDATA));
 
-      //Write the file number list to the file
-      result = f_write(&viewfp, viewfilenumberdata, size, 0);
+      //Go to the sector of the slot. The file is extended when the slot is beyond the end of it
+      result = f_lseek(&viewfp, filenumber * VIEW_THUMBNAIL_RECORD_SIZE);
 
-      if(result != FR_OK)
+      if(result == FR_OK)
       {
-        //Show a message stating writing the file failed
-        scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
-
-        //Close the file
-        f_close(&viewfp);
-
-        //No sense to continue, so return with an error
-        return(-1);
+        //Write only this record
+        result = f_write(&viewfp, &viewthumbnailrecords[0], sizeof(THUMBNAILRECORD), 0);
       }
 
-      //Calculate the number of bytes to write for the thumbnail data
-      size = viewavailableitems * sizeof(THUMBNAILDATA);
-
-      //Write the thumbnail data to the file
-      result = f_write(&viewfp, viewthumbnaildata, size, 0);
-
-      if(result != FR_OK)
+      if(result == FR_OK)
       {
-        //Show a message stating writing the file failed
-        scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
-
-        //Close the file
-        f_close(&viewfp);
-
-        //No sense to continue, so return with an error
-        return(-1);
+        //Back to the header
+        result = f_lseek(&viewfp, 0);
       }
     }
 
+    if(result == FR_OK)
+    {
+      //Write the header with the slot bitmap
+      result = f_write(&viewfp, &viewthumbnailheader, sizeof(viewthumbnailheader), 0);
+    }
+
     //Close the file
     f_close(&viewfp);
+
+    if(result != FR_OK)
+    {
+      //Show a message stating writing the file failed
+      scope_display_file_status_message(MESSAGE_FILE_WRITE_FAILED, 0);
+
+      //No sense to continue, so return with an error
+      return(-1);
+    }
   }
   else
   {
@@ -6300,8 +8492,8 @@ void scope_save_view_item_file(int32 type)
 {
   uint32  newnumber;
   uint32  result;
-  uint16 *fnptr;
-  uint16 *eptr;
+  uint32  index;
+  uint32  bits;
 
   //Save the current view type to be able to determine if the thumbnail file need to be reloaded
   uint32 currentviewtype = viewtype;
@@ -6326,38 +8518,30 @@ void scope_save_view_item_file(int32 type)
     return;
   }
 
-  //Set the end pointer
-  eptr = &viewfilenumberdata[viewavailableitems];
-
-  //Find the first free file number
-  //Most likely a more efficient solution for this problem exists, but this beats the original code where they try if a file number is free on the SD card with f_open
-  for(newnumber=1;newnumber<VIEW_MAX_ITEMS;newnumber++)
+  //Find the first word in the slot bitmap with a free slot
+  for(index=0;index<VIEW_SLOT_BITMAP_WORDS;index++)
   {
-    //Start at the beginning of the list
-    fnptr = viewfilenumberdata;
-
-    //Go through the list to see if the current number is in the list
-    while(fnptr < eptr)
-    {
-      //Check if this number is in the list
-      if(*fnptr == newnumber)
-      {
-        //Found it, so quit the loop
-        break;
-      }
-
-      //Select the next number entry
-      fnptr++;
-    }
-
-    //Check if not found
-    if(*fnptr != newnumber)
+    //Check if not all slots are used
+    if(viewthumbnailheader.slotbitmap[index] != 0xFFFFFFFF)
     {
-      //Can use this number since it is not in the list
       break;
     }
   }
 
+  //Find the first free slot in this word. There is a free one since the number of items is below the maximum
+  bits = viewthumbnailheader.slotbitmap[index];
+
+  for(newnumber=index*32;bits&1;newnumber++)
+  {
+    bits >>= 1;
+  }
+
+  //Take the slot
+  viewthumbnailheader.slotbitmap[index] |= 1 << (newnumber & 31);
+
+  //The file number is one higher than the slot, since zero is used for signaling an unused entry
+  newnumber++;
+
   //Bump all the entries in the list up
   memmove(&viewfilenumberdata[1], &viewfilenumberdata[0], viewavailableitems * sizeof(uint16));
 
@@ -6375,9 +8559,10 @@ void scope_save_view_item_file(int32 type)
 
   //One more item in the list
   viewavailableitems++;
+  viewthumbnailheader.items = viewavailableitems;
 
-  //save the amended thumbnail file
-  scope_save_thumbnail_file();
+  //Write the new record and the amended header to the thumbnail file
+  scope_write_thumbnail_file(newnumber, &viewthumbnaildata[0]);
 
   //Copy the filename from the thumbnail filename, since the global one got written over in the saving of the thumbnail
   //Might need a re write of the message setup
@@ -6392,14 +8577,23 @@ void scope_save_view_item_file(int32 type)
     //For pictures the bitmap header and the screen data needs to be written
     if(type == VIEW_TYPE_PICTURE)
     {
-      //Write the bitmap header
-      result = f_write(&viewfp, bmpheader, sizeof(bmpheader), 0);
-
-      //Check if still ok to proceed
-      if(result == FR_OK)
+      //Check if the compressed format needs to be used
+      if(scopesettings.filecompression)
+      {
+        //Write the compressed header and the coded screen data
+        result = scope_write_compressed_picture();
+      }
+      else
       {
-        //Write the pixel data
-        result = f_write(&viewfp, (uint8 *)maindisplaybuffer, PICTURE_DATA_SIZE, 0);
+        //Write the bitmap header
+        result = f_write(&viewfp, bmpheader, sizeof(bmpheader), 0);
+
+        //Check if still ok to proceed
+        if(result == FR_OK)
+        {
+          //Write the pixel data
+          result = f_write(&viewfp, (uint8 *)maindisplaybuffer, PICTURE_DATA_SIZE, 0);
+        }
       }
     }
     else
@@ -6411,9 +8605,15 @@ void scope_save_view_item_file(int32 type)
       //Write the setup data to the file
       if((result = f_write(&viewfp, viewfilesetupdata, sizeof(viewfilesetupdata), 0)) == FR_OK)
       {
+        //Check if the compressed format needs to be used
+        if(scopesettings.filecompression)
+        {
+          //Write the coded sample data of both channels
+          result = scope_write_compressed_waveform();
+        }
         //Write the trace data to the file
         //Save the channel 1 raw sample data
-        if((result = f_write(&viewfp, (uint8 *)channel1tracebuffer, 3000, 0)) == FR_OK)
+        else if((result = f_write(&viewfp, (uint8 *)channel1tracebuffer, 3000, 0)) == FR_OK)
         {
           //Save the channel 2 raw sample data
           result = f_write(&viewfp, (uint8 *)channel2tracebuffer, 3000, 0);
@@ -6463,6 +8663,9 @@ void scope_remove_item_from_thumbnails(uint32 delete)
   //Calculate the number of items to move
   uint32 count = (viewavailableitems - nextindex);
 
+  //Get the slot of the item
+  uint32 slot = viewfilenumberdata[viewcurrentindex] - 1;
+
   //Only delete the file when requested
   if(delete)
   {
@@ -6488,6 +8691,14 @@ void scope_remove_item_from_thumbnails(uint32 delete)
 
   //Clear the freed up slot
   viewfilenumberdata[viewavailableitems] = 0;
+
+  //Free the slot in the thumbnail file. Only the header needs to be written for this
+  if(slot < VIEW_MAX_ITEMS)
+  {
+    viewthumbnailheader.slotbitmap[slot >> 5] &= ~(1 << (slot & 31));
+  }
+
+  viewthumbnailheader.items = viewavailableitems;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -6507,6 +8718,9 @@ int32 scope_load_trace_data(void)
   //Check if file opened ok
   if(result == FR_OK)
   {
+    //Use the cluster link map for seeking in the file
+    scope_setup_fast_seek();
+
     //Checks on correct number of bytes read might be needed
     //Load the setup data to the file setup data buffer
     if((result = f_read(&viewfp, (uint8 *)viewfilesetupdata, sizeof(viewfilesetupdata), 0)) == FR_OK)
@@ -6525,33 +8739,46 @@ int32 scope_load_trace_data(void)
       }
       else
       {
+        //Check if the sample data is compressed
+        if(viewfilesetupdata[2] == WAVEFORM_COMPRESSED_DATA)
+        {
+          //Decode the sample data of both channels
+          result = scope_read_compressed_waveform();
+        }
         //Load the channel 1 sample data      
-        if((result = f_read(&viewfp, (uint8 *)channel1tracebuffer, 3000, 0)) == FR_OK)
+        else if((result = f_read(&viewfp, (uint8 *)channel1tracebuffer, 3000, 0)) == FR_OK)
         {
           //Load the channel 2 sample data
-          if((result = f_read(&viewfp, (uint8 *)channel2tracebuffer, 3000, 0)) == FR_OK)
+          result = f_read(&viewfp, (uint8 *)channel2tracebuffer, 3000, 0);
+        }
+
+        //Check if the sample data is loaded
+        if(result == FR_OK)
+        {
+          //Do a check on file validity
+          if((result = scope_check_waveform_file()) == 0)
+          {
+            //Switch to stopped and waveform viewing mode
+            scopesettings.runstate = 1;
+            scopesettings.waveviewmode = 1;
+
+            //Compute the math channel and decode the protocol for the loaded samples
+            scope_process_math_channel();
+            scope_process_decoder();
+
+            //Show the normal scope screen
+            scope_setup_main_screen();
+
+            //display the trace data
+            scope_display_trace_data();
+          }
+          else
           {
-            //Do a check on file validity
-            if((result = scope_check_waveform_file()) == 0)
-            {
-              //Switch to stopped and waveform viewing mode
-              scopesettings.runstate = 1;
-              scopesettings.waveviewmode = 1;
-
-              //Show the normal scope screen
-              scope_setup_main_screen();
-
-              //display the trace data
-              scope_display_trace_data();
-            }
-            else
-            {
-              //Checksum error so signal that to the user
-              result = WAVEFORM_FILE_ERROR;
-
-              //Show the user the file is not correct
-              scope_display_file_status_message(MESSAGE_WAV_CHECKSUM_ERROR, 0);
-            }
+            //Checksum error so signal that to the user
+            result = WAVEFORM_FILE_ERROR;
+
+            //Show the user the file is not correct
+            scope_display_file_status_message(MESSAGE_WAV_CHECKSUM_ERROR, 0);
           }
         }
       }
@@ -6604,6 +8831,9 @@ int32 scope_load_bitmap_data(void)
   //Check if file opened ok
   if(result == FR_OK)
   {
+    //Use the cluster link map for seeking in the file
+    scope_setup_fast_seek();
+
     //Read the bitmap header to verify if the bitmap can be displayed
     result = f_read(&viewfp, viewbitmapheader, PICTURE_HEADER_SIZE, 0);
 
@@ -6616,6 +8846,16 @@ int32 scope_load_bitmap_data(void)
         //Load the bitmap data directly onto the screen
         result = f_read(&viewfp, (uint8 *)maindisplaybuffer, PICTURE_DATA_SIZE, 0);
       }
+      //Check if it is a compressed picture
+      else if(memcmp(viewbitmapheader, bmpcompressedheader, PICTURE_COMPRESSED_HEADER_SIZE) == 0)
+      {
+        //The coded data starts directly after the shorter header
+        if((result = f_lseek(&viewfp, PICTURE_COMPRESSED_HEADER_SIZE)) == FR_OK)
+        {
+          //Decode the data onto the screen
+          result = scope_read_compressed_picture();
+        }
+      }
       else
       {
         //Signal a header mismatch detected
@@ -6660,16 +8900,189 @@ int32 scope_load_bitmap_data(void)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+int32 scope_write_compressed_picture(void)
+{
+  PALETTECONTEXT context;
+  uint16 *sptr = (uint16 *)maindisplaybuffer;
+  uint16 *eptr = sptr + (PICTURE_DATA_SIZE / 2);
+  uint8  *buffer = memory_pool_alloc(&filebufferpool);
+  uint32  size;
+  int32   result;
+
+  if(buffer == 0)
+  {
+    return(FR_NOT_ENOUGH_CORE);
+  }
+
+  //Start with a fresh palette
+  picture_compress_init(&context);
+
+  //Write the compressed picture header
+  result = f_write(&viewfp, bmpcompressedheader, sizeof(bmpcompressedheader), 0);
+
+  //Code the screen data in blocks
+  while((result == FR_OK) && (sptr < eptr))
+  {
+    //Code as much as fits in a block, leaving room for the length in front of it
+    size = picture_compress_block(&context, &sptr, eptr, &buffer[2], COMPRESSION_BLOCK_SIZE);
+
+    buffer[0] = size;
+    buffer[1] = size >> 8;
+
+    //Write the block to the file
+    result = f_write(&viewfp, buffer, size + 2, 0);
+  }
+
+  memory_pool_free(&filebufferpool, buffer);
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 scope_read_compressed_picture(void)
+{
+  PALETTECONTEXT context;
+  uint16 *dptr = (uint16 *)maindisplaybuffer;
+  uint16 *eptr = dptr + (PICTURE_DATA_SIZE / 2);
+  uint8  *buffer = memory_pool_alloc(&filebufferpool);
+  uint32  size;
+  UINT    bytesread;
+  int32   result = FR_OK;
+
+  if(buffer == 0)
+  {
+    return(FR_NOT_ENOUGH_CORE);
+  }
+
+  //Start with a fresh palette
+  picture_compress_init(&context);
+
+  //Decode blocks until the screen is filled
+  while((result == FR_OK) && (dptr < eptr))
+  {
+    //Get the length of the block
+    if(((result = f_read(&viewfp, buffer, 2, &bytesread)) == FR_OK) && (bytesread == 2))
+    {
+      size = buffer[0] | (buffer[1] << 8);
+
+      //Check if the length is valid and read the block
+      if((size <= COMPRESSION_BLOCK_SIZE) && ((result = f_read(&viewfp, buffer, size, &bytesread)) == FR_OK) && (bytesread == size))
+      {
+        //Decode it onto the screen
+        if(picture_decompress_block(&context, buffer, size, &dptr, eptr) != 0)
+        {
+          //Coded data is not valid
+          result = FR_INT_ERR;
+        }
+      }
+      else if(result == FR_OK)
+      {
+        //Block is too big or the file is too short
+        result = FR_INT_ERR;
+      }
+    }
+    else if(result == FR_OK)
+    {
+      //The file ended before the screen was filled
+      result = FR_INT_ERR;
+    }
+  }
+
+  memory_pool_free(&filebufferpool, buffer);
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 scope_write_compressed_waveform(void)
+{
+  uint8  *buffer = memory_pool_alloc(&filebufferpool);
+  uint32  size;
+  uint32  size2;
+  int32   result;
+
+  if(buffer == 0)
+  {
+    return(FR_NOT_ENOUGH_CORE);
+  }
+
+  //Code the channel 1 samples after the room for the total length
+  size = waveform_compress((uint8 *)channel1tracebuffer, 3000, &buffer[4], COMPRESSION_BUFFER_SIZE - 4);
+
+  //Code the channel 2 samples directly after it
+  size2 = waveform_compress((uint8 *)channel2tracebuffer, 3000, &buffer[4 + size], COMPRESSION_BUFFER_SIZE - 4 - size);
+
+  //The buffer fits the worst case, but check it anyway
+  if((size == 0) || (size2 == 0))
+  {
+    result = FR_INT_ERR;
+  }
+  else
+  {
+    //Put the length of the coded data in front of it
+    *(uint32 *)buffer = size + size2;
+
+    //Write it all to the file
+    result = f_write(&viewfp, buffer, size + size2 + 4, 0);
+  }
+
+  memory_pool_free(&filebufferpool, buffer);
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 scope_read_compressed_waveform(void)
+{
+  uint8  *buffer = memory_pool_alloc(&filebufferpool);
+  uint32  size;
+  int32   used;
+  UINT    bytesread;
+  int32   result = FR_INT_ERR;
+
+  if(buffer == 0)
+  {
+    return(FR_NOT_ENOUGH_CORE);
+  }
+
+  //Get the length of the coded data
+  if((f_read(&viewfp, buffer, 4, &bytesread) == FR_OK) && (bytesread == 4))
+  {
+    size = *(uint32 *)buffer;
+
+    //Check if the length is valid and read the coded data
+    if((size <= (COMPRESSION_BUFFER_SIZE - 4)) && (f_read(&viewfp, &buffer[4], size, &bytesread) == FR_OK) && (bytesread == size))
+    {
+      //Decode the channel 1 samples and the channel 2 samples from the rest of the data
+      if(((used = waveform_decompress(&buffer[4], size, (uint8 *)channel1tracebuffer, 3000)) >= 0) &&
+         (waveform_decompress(&buffer[4 + used], size - used, (uint8 *)channel2tracebuffer, 3000) >= 0))
+      {
+        result = FR_OK;
+      }
+    }
+  }
+
+  memory_pool_free(&filebufferpool, buffer);
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void scope_sync_thumbnail_files(void)
 {
   uint32  t;
-  uint32  save = 0;
-  uint16 *fnptr;
-  uint16 *eptr;
+  uint32  save;
 
   //Handle the two types of list files
   for(t=0;t<VIEW_MAX_TYPES;t++)
   {
+    //No changes yet
+    save = 0;
+
     //Set the current type to handle
     viewtype = t;
 
@@ -6680,26 +9093,19 @@ void scope_sync_thumbnail_files(void)
       return;
     }
 
-    //Point to the file numbers
-    fnptr = (uint16 *)viewfilenumberdata;
-
-    //Set the end pointer
-    eptr = &fnptr[viewavailableitems];
+    //Start with the first item
+    viewcurrentindex = 0;
 
     //Go through the items in the system file and check if the files still exist on the SD card
-    while((*fnptr) && (fnptr < eptr))
+    while(viewcurrentindex < viewavailableitems)
     {
       //Setup the filename
-      scope_print_file_name(*fnptr);
+      scope_print_file_name(viewfilenumberdata[viewcurrentindex]);
 
       //Try to open the file. On failure remove it from the lists
       if(f_open(&viewfp, viewfilename, FA_READ) == FR_NO_FILE)
       {
-        //Set the file index
-//        viewcurrentindex = ((uint32)fnptr - (uint32)viewfilenumberdata) / sizeof(uint16);
-        viewcurrentindex = (fnptr - (uint16 *)viewfilenumberdata) / sizeof(uint16);
-
-        //Remove the current item from the thumbnails without delete, since it is already removed from the SD card
+        //Remove the current item from the thumbnails without delete, since it is already removed from the SD card. The next item moves into its place
         scope_remove_item_from_thumbnails(0);
 
         //Signal saving of the list files is needed
@@ -6709,10 +9115,10 @@ void scope_sync_thumbnail_files(void)
       {
         //File exists so close it
         f_close(&viewfp);
-      }
 
-      //Select the next file number
-      fnptr++;
+        //Select the next item
+        viewcurrentindex++;
+      }
     }
 
     //Check if there was a change
@@ -7677,6 +10083,11 @@ void scope_load_configuration_data(void)
 
   scopesettings.channel2.tracebuffer = (uint8 *)channel2tracebuffer;
   scopesettings.channel2.tracepoints = channel2pointsbuffer;
+
+  scopesettings.mathchannel.color = MATH_COLOR;
+
+  scopesettings.mathchannel.tracebuffer = (uint8 *)mathtracebuffer;
+  scopesettings.mathchannel.tracepoints = mathpointsbuffer;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -7755,6 +10166,23 @@ void scope_reset_config_data(void)
   scopesettings.alwaystrigger50  = 1;
   scopesettings.xymodedisplay    = 0;
 
+  //Persistence display off
+  scopesettings.persistence = 0;
+
+  //Save files in the standard formats
+  scopesettings.filecompression = 0;
+
+  //Normal acquisition, and average over 16 acquisitions when switched to one of the average modes
+  scopesettings.acquisitionmode = ACQUISITION_MODE_NORMAL;
+  scopesettings.averageshift    = 4;
+
+  //Math channel off, with its trace in the center of the screen
+  scopesettings.mathmode                  = MATH_MODE_OFF;
+  scopesettings.mathchannel.traceposition = 200;
+
+  //Protocol decoder off
+  scopesettings.decodermode = DECODER_MODE_OFF;
+
   //Set the settings integrity check flag
   system_ok = 0x1432;
 }
@@ -7811,6 +10239,23 @@ void scope_save_config_data(void)
   settingsworkbuffer[62] = scopesettings.alwaystrigger50;
   settingsworkbuffer[63] = scopesettings.xymodedisplay;
 
+  //Save the persistence mode (not in the original code)
+  settingsworkbuffer[64] = scopesettings.persistence;
+
+  //Save the file compression mode (not in the original code)
+  settingsworkbuffer[65] = scopesettings.filecompression;
+
+  //Save the acquisition mode and number of acquisitions to average (not in the original code)
+  settingsworkbuffer[66] = scopesettings.acquisitionmode;
+  settingsworkbuffer[67] = scopesettings.averageshift;
+
+  //Save the math channel settings (not in the original code)
+  settingsworkbuffer[68] = scopesettings.mathmode;
+  settingsworkbuffer[69] = scopesettings.mathchannel.traceposition;
+
+  //Save the protocol decoder setting (not in the original code)
+  settingsworkbuffer[70] = scopesettings.decodermode;
+
   //Save the time cursor settings
   settingsworkbuffer[161] = scopesettings.timecursorsenable;
   settingsworkbuffer[162] = scopesettings.timecursor1position;
@@ -7919,6 +10364,58 @@ void scope_restore_config_data(void)
   scopesettings.alwaystrigger50  = settingsworkbuffer[62];
   scopesettings.xymodedisplay    = settingsworkbuffer[63];
 
+  //Restore the persistence mode and make sure it is in range, since this position was not used in the original code
+  scopesettings.persistence = settingsworkbuffer[64];
+
+  if(scopesettings.persistence > PERSISTENCE_MAX_DECAY_FRAMES)
+  {
+    scopesettings.persistence = 0;
+  }
+
+  //Restore the file compression mode, also with a range check
+  scopesettings.filecompression = settingsworkbuffer[65];
+
+  if(scopesettings.filecompression > 1)
+  {
+    scopesettings.filecompression = 0;
+  }
+
+  //Restore the acquisition mode settings, also with range checks
+  scopesettings.acquisitionmode = settingsworkbuffer[66];
+  scopesettings.averageshift    = settingsworkbuffer[67];
+
+  if(scopesettings.acquisitionmode > ACQUISITION_MODE_SEGMENTED)
+  {
+    scopesettings.acquisitionmode = ACQUISITION_MODE_NORMAL;
+  }
+
+  if((scopesettings.averageshift == 0) || (scopesettings.averageshift > ACQUISITION_MAX_AVERAGE_SHIFT))
+  {
+    scopesettings.averageshift = 4;
+  }
+
+  //Restore the math channel settings, also with range checks
+  scopesettings.mathmode                  = settingsworkbuffer[68];
+  scopesettings.mathchannel.traceposition = settingsworkbuffer[69];
+
+  if(scopesettings.mathmode > MATH_MODE_MAX)
+  {
+    scopesettings.mathmode = MATH_MODE_OFF;
+  }
+
+  if((scopesettings.mathchannel.traceposition < 6) || (scopesettings.mathchannel.traceposition > 394))
+  {
+    scopesettings.mathchannel.traceposition = 200;
+  }
+
+  //Restore the protocol decoder setting, also with a range check
+  scopesettings.decodermode = settingsworkbuffer[70];
+
+  if(scopesettings.decodermode > DECODER_MODE_MAX)
+  {
+    scopesettings.decodermode = DECODER_MODE_OFF;
+  }
+
   //Restore the time cursor settings
   scopesettings.timecursorsenable   = settingsworkbuffer[161];
   scopesettings.timecursor1position = settingsworkbuffer[162];
@@ -7972,6 +10469,78 @@ void scope_restore_config_data(void)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+#ifdef MMU_TIMING
+//Time the processing and displaying of a trace with the DRAM not cached, as it was without the MMU, and with the cached setup. The
+//result is shown until the screen is touched
+
+void scope_show_mmu_timing(void)
+{
+  uint8  *channel1 = (uint8 *)channel1tracebuffer;
+  uint8  *channel2 = (uint8 *)channel2tracebuffer;
+  uint32  uncached;
+  uint32  cached;
+  uint32  index;
+  char    text[40];
+  char   *ptr;
+
+  //A triangle and a square wave to have something to draw
+  for(index=0;index<3000;index++)
+  {
+    channel1[index] = 28 + (((index % 400) < 200) ? (index % 200) : (200 - (index % 200)));
+    channel2[index] = ((index % 300) < 150) ? 60 : 190;
+  }
+
+  scopesettings.nofsamples  = 1500;
+  scopesettings.samplecount = 3000;
+
+  mmu_set_dram_cached(0);
+  uncached = scope_time_trace_display();
+
+  mmu_set_dram_cached(1);
+  cached = scope_time_trace_display();
+
+  //Show the times in mS for all the passes
+  ptr = scope_print_decimal(text, uncached, 0);
+  ptr = strcpy(ptr, " mS uncached, ");
+  ptr = scope_print_decimal(ptr, cached, 0);
+  strcpy(ptr, " mS cached");
+
+  display_set_fg_color(0x00000000);
+  display_fill_rect(200, 220, 400, 40);
+  display_set_fg_color(0x00FFFFFF);
+  display_set_font(&font_3);
+  display_text(210, 232, text);
+
+  //Wait for a touch to continue with the normal start up
+  havetouch = 0;
+
+  while(havetouch == 0)
+  {
+    tp_i2c_read_status();
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the time in mS of MMU_TIMING_PASSES trace displays
+
+uint32 scope_time_trace_display(void)
+{
+  uint32 start = timer0_get_ticks();
+  uint32 pass;
+
+  for(pass=0;pass<MMU_TIMING_PASSES;pass++)
+  {
+    scope_process_trigger(scopesettings.nofsamples);
+    scope_display_trace_data();
+  }
+
+  return(timer0_get_ticks() - start);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif
+
 #ifndef USE_TP_CONFIG
 #ifdef SAVE_TP_CONFIG
 void save_tp_config(void)
@@ -7,10 +7,12 @@
 
 #include "fnirsi_1013d_scope.h"
 #include "variables.h"
+#include "memory_pools.h"
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void scope_setup_display_lib(void);
+void scope_setup_persistence_colors(void);
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -96,10 +98,13 @@ void scope_channel_enable_select(PCHANNELSETTINGS settings);
 void scope_channel_fft_show(PCHANNELSETTINGS settings);
 void scope_channel_coupling_select(PCHANNELSETTINGS settings);
 void scope_channel_probe_magnification_select(PCHANNELSETTINGS settings);
+void scope_channel_math_mode_select(PCHANNELSETTINGS settings);
+void scope_channel_decoder_mode_select(PCHANNELSETTINGS settings);
 
 void scope_open_acquisition_menu(void);
 void scope_acquisition_speed_select(void);
 void scope_acquisition_timeperdiv_select(void);
+void scope_acquisition_mode_select(void);
 
 void scope_open_trigger_menu(void);
 void scope_trigger_mode_select(void);
@@ -115,6 +120,8 @@ void scope_system_settings_trigger_50_item(void);
 void scope_system_settings_calibration_item(int mode);
 void scope_system_settings_x_y_mode_item(void);
 void scope_system_settings_confirmation_item(void);
+void scope_system_settings_persistence_item(void);
+void scope_system_settings_file_compression_item(void);
 
 void scope_open_calibration_start_text(void);
 void scope_show_calibrating_text(void);
@@ -153,6 +160,47 @@ void scope_draw_volt_cursors(void);
 void scope_calculate_trigger_vertical_position();
 
 void scope_acquire_trace_data(void);
+void scope_start_conversion(void);
+void scope_watch_conversion(uint32 on);
+
+void scope_process_acquisition_mode(void);
+uint32 scope_setup_average_buffers(void);
+void scope_release_average_buffers(void);
+void scope_average_trace_data(uint32 *tracebuffer, uint32 *accumulator, uint32 *result);
+void scope_align_trace_data(uint8 *buffer, int32 offset);
+void scope_high_resolution_filter(uint8 *buffer, uint32 count, uint32 window);
+
+void scope_read_trace_data(void);
+
+uint32 scope_math_channel_active(void);
+int32 scope_math_channel_gain(void);
+void scope_process_math_channel(void);
+
+uint32 scope_decoder_active(void);
+void scope_decoder_slice_channel(PCHANNELSETTINGS settings, PDECODERSTREAM stream);
+void scope_process_decoder(void);
+
+void scope_acquire_segments(uint32 ticks);
+uint32 scope_setup_segment_buffer(void);
+void scope_release_segment_buffer(void);
+PSEGMENT scope_get_segment_slot(uint32 index);
+void scope_store_segment(uint32 timestamp);
+PSEGMENT scope_get_segment(uint32 number);
+uint32 scope_segment_view_active(void);
+
+#ifdef MEMORY_STATISTICS
+void scope_display_memory_statistics(void);
+void scope_print_pool_statistics(char *buffer, PMEMORYPOOLSTATISTICS statistics);
+#endif
+
+void scope_copy_segment_samples(uint32 number);
+void scope_browse_segments(uint32 xpos);
+
+uint32 scope_check_roll_mode(void);
+uint32 scope_zoom_active(void);
+void scope_start_roll_mode(void);
+void scope_acquire_roll_data(void);
+uint8 scope_get_roll_block_sample(uint8 *block, uint32 column, uint32 count);
 
 void scope_process_trigger(uint32 count);
 
@@ -163,17 +211,31 @@ void scope_do_50_percent_trigger_setup(void);
 
 void scope_do_auto_setup(void);
 
-uint32 scope_check_channel_range(PCHANNELSETTINGS settings);
+uint32 scope_auto_setup_time_per_div(PCHANNELSETTINGS settings, uint32 samplerate);
+uint32 scope_auto_range_channel(PCHANNELSETTINGS settings);
 
 //----------------------------------------------------------------------------------------------------------------------------------
 // Signal data display functions
 //----------------------------------------------------------------------------------------------------------------------------------
 
 void scope_display_trace_data(void);
+void scope_finish_trace_display(void);
+
+void scope_display_segment_overlay(void);
+void scope_display_segment_info(void);
+
+void scope_display_roll_data(void);
+void scope_display_roll_trace(PCHANNELSETTINGS settings, uint8 *buffer, uint32 count);
+
+void scope_display_persistence(void);
 
 int32 scope_get_sample(PCHANNELSETTINGS settings, int32 index);
+void scope_set_sample_scaling(PCHANNELSETTINGS settings);
+int32 scope_scale_sample(PCHANNELSETTINGS settings, int32 sample);
 
 void scope_display_channel_trace(PCHANNELSETTINGS settings);
+void scope_display_channel_trace_peak(PCHANNELSETTINGS settings);
+void scope_display_decoded_data(void);
 
 void scope_display_cursor_measurements(void);
 
@@ -198,8 +260,13 @@ int32 scope_check_waveform_file(void);
 
 void scope_print_file_name(uint32 filenumber);
 
+void scope_setup_fast_seek(void);
+
 int32 scope_load_thumbnail_file(void);
+int32 scope_convert_thumbnail_file(void);
+int32 scope_create_thumbnail_file(void);
 int32 scope_save_thumbnail_file(void);
+int32 scope_write_thumbnail_file(uint32 filenumber, PTHUMBNAILDATA thumbnaildata);
 
 void scope_save_view_item_file(int32 type);
 
@@ -209,6 +276,11 @@ int32 scope_load_trace_data(void);
 
 int32 scope_load_bitmap_data(void);
 
+int32 scope_write_compressed_picture(void);
+int32 scope_read_compressed_picture(void);
+int32 scope_write_compressed_waveform(void);
+int32 scope_read_compressed_waveform(void);
+
 void scope_sync_thumbnail_files(void);                 //Check this function!!!
 
 void scope_initialize_and_display_thumbnails(void);
@@ -243,6 +315,13 @@ void scope_restore_config_data(void);
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+#ifdef MMU_TIMING
+void scope_show_mmu_timing(void);
+uint32 scope_time_trace_display(void);
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 #ifndef USE_TP_CONFIG
 #ifdef SAVE_TP_CONFIG
 void save_tp_config(void);
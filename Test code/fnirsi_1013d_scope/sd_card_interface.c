@@ -3,6 +3,7 @@
 #include "sd_card_interface.h"
 #include "ccu_control.h"
 #include "timer.h"
+#include "mmu_control.h"
 
 #include <string.h>
 
@@ -27,7 +28,10 @@ uint32 cardcsd[4] = { 0, 0, 0, 0 };
 SD_CARD_COMMAND sd_command;
 SD_CARD_DATA    sd_data;
 
-uint32 sd_buffer[1024];  //4KB data buffer. Defined as uint32 to assure dword alignment
+uint32 sd_buffer[1024] DMABUFFER_SECTION;  //4KB data buffer. In the not cached DMA section, so it can be used for the not aligned buffers without cache handling
+
+SD_CARD_TRANSFER    sd_transfer;
+SD_IDMA_DESCRIPTOR  sd_descriptors[SD_DMA_DESCRIPTORS] DMABUFFER_SECTION;   //Read by the DMA controller, so not cached
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -312,16 +316,79 @@ int32 sd_card_init(void)
 int32 sd_card_read(uint32 sector, uint32 blocks, uint8 *buffer)
 {
   int32 result;
-  
+
+  //Start the transfer
+  if((result = sd_card_start_read(sector, blocks, buffer)) != SD_OK)
+  {
+    return(result);
+  }
+
+  //Wait for it to finish
+  return(sd_card_wait_transfer());
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_write(uint32 sector, uint32 blocks, uint8 *buffer)
+{
+  int32 result;
+
+  //Start the transfer
+  if((result = sd_card_start_write(sector, blocks, buffer)) != SD_OK)
+  {
+    return(result);
+  }
+
+  //Wait for it to finish
+  return(sd_card_wait_transfer());
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//The sector transfers are done with the internal DMA controller of the SD interface in the background.
+//A transfer is started with one of the start functions, and then moved along with sd_card_transfer_busy until it is done.
+//This allows the caller to prepare the next request while the current one is in flight. Starting a new transfer waits for the previous one.
+//The error of a transfer is reported once, either by sd_card_wait_transfer or by the start of the next transfer.
+//Transfers are split into multiple block commands of at most SD_DMA_MAX_BLOCKS. Buffers that do not start on a cache line go through sd_buffer.
+//The other buffers are cleaned from or invalidated in the data cache before the transfer. The cpu is not allowed to use them until it is done.
+
+int32 sd_card_start_read(uint32 sector, uint32 blocks, uint8 *buffer)
+{
+  return(sd_card_start_transfer(SD_DATA_READ, sector, blocks, buffer));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_start_write(uint32 sector, uint32 blocks, uint8 *buffer)
+{
+  return(sd_card_start_transfer(SD_DATA_WRITE, sector, blocks, buffer));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_start_transfer(uint32 flags, uint32 sector, uint32 blocks, uint8 *buffer)
+{
+  int32 result;
+
+  //Only one transfer can be in flight, so finish the previous one first. When it failed and nobody waited for it, the error is
+  //returned here instead of starting the new transfer
+  if((result = sd_card_wait_transfer()) != SD_OK)
+  {
+    return(result);
+  }
+
   //Check if valid buffer given
   if(buffer == 0)
+  {
     return(SD_ERROR_INVALID_BUFFER);
-  
+  }
+
   //This might be wrong. Need testing with last sector!!!!!
-  //Check if last bytes to read in range of the card sectors
-  if((sector + blocks - 1) > cardsectors)
+  //Check if last bytes to read or write in range of the card sectors
+  if((blocks == 0) || ((sector + blocks - 1) > cardsectors))
+  {
     return(SD_ERROR_SECTOR_OUT_OF_RANGE);
-  
+  }
+
   //Send card select command
   sd_command.cmdidx    = 7;
   sd_command.cmdarg    = cardrca;
@@ -329,129 +396,345 @@ int32 sd_card_read(uint32 sector, uint32 blocks, uint8 *buffer)
   result = sd_card_send_command(&sd_command, 0);
 
   //Only continue when card selected without errors
-  if(result == SD_OK)
+  if(result != SD_OK)
   {
-    //Prepare data buffer for reading
-    sd_data.blocks    = blocks;
-    sd_data.blocksize = 512;
-    sd_data.flags     = SD_DATA_READ;
-    sd_data.data      = buffer;
-    
-    //Send read command based on number of blocks
-    if(blocks == 1)
+    return(result);
+  }
+
+  //Setup the transfer
+  sd_transfer.flags  = flags;
+  sd_transfer.sector = sector;
+  sd_transfer.blocks = blocks;
+  sd_transfer.buffer = buffer;
+  sd_transfer.result = SD_OK;
+  sd_transfer.active = 1;
+
+  //Start the first command
+  result = sd_card_start_chunk();
+
+  //On failure end the transfer
+  if(result != SD_OK)
+  {
+    sd_card_end_transfer(result);
+  }
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_start_chunk(void)
+{
+  uint8 *buffer = sd_transfer.buffer;
+  uint32 blocks = sd_transfer.blocks;
+  uint32 timeout;
+
+  //Check if the buffer starts on a cache line. Otherwise the cache handling could affect the data next to it
+  if((uint32)buffer & (ARM32_CACHE_LINE_SIZE - 1))
+  {
+    //Not aligned so the data needs to go through the aligned bounce buffer
+    if(blocks > SD_BOUNCE_MAX_BLOCKS)
     {
-      //Set read single block command
-      sd_command.cmdidx = 17;
+      blocks = SD_BOUNCE_MAX_BLOCKS;
     }
-    else
+
+    //For writing the data needs to be in the bounce buffer before the transfer starts
+    if(sd_transfer.flags & SD_DATA_WRITE)
     {
-      //Set read multiple blocks command
-      sd_command.cmdidx = 18;
+      memcpy(sd_buffer, buffer, blocks * 512);
     }
-    
-    //Indicate which sector to start reading from
-    if(cardtype != SD_CARD_TYPE_SDHC)
+
+    //Transfer from or to the bounce buffer
+    buffer = (uint8 *)sd_buffer;
+  }
+  else
+  {
+    //Limit on what the descriptor table can handle
+    if(blocks > SD_DMA_MAX_BLOCKS)
     {
-      //For non HC type cards use the byte address
-      sd_command.cmdarg = sector << 9;
+      blocks = SD_DMA_MAX_BLOCKS;
     }
-    else
+
+    //Make sure the DMA controller reads the latest data, or the cpu reads the new data after the transfer
+    if(sd_transfer.flags & SD_DATA_WRITE)
     {
-      //For HC type card use the sector address
-      sd_command.cmdarg = sector;
+      mmu_clean_for_dma(buffer, blocks * 512);
     }
-    
-    //Card allowed to be busy.
-    sd_command.resp_type = SD_RESPONSE_BUSY | SD_RESPONSE_CRC | SD_RESPONSE_PRESENT;
-    result = sd_card_send_command(&sd_command, &sd_data);
-    
-    //Deselect the card if all went well
-    if(result == SD_OK)
+    else
     {
-      //Send deselect card command to the card
-      sd_command.cmdidx    = 7;
-      sd_command.cmdarg    = 0;
-      sd_command.resp_type = SD_RESPONSE_NONE;
-      result = sd_card_send_command(&sd_command, 0);
+      mmu_invalidate_for_dma(buffer, blocks * 512);
     }
   }
-  
-  return(result);
+
+  //Remember the size of this command for when it is done
+  sd_transfer.chunk = blocks;
+
+  //Setup the descriptors and the controller for the transfer
+  sd_card_setup_dma(buffer, blocks * 512);
+
+  //Prepare data information for the transfer
+  sd_data.blocks    = blocks;
+  sd_data.blocksize = 512;
+  sd_data.flags     = sd_transfer.flags | SD_DATA_DMA;
+  sd_data.data      = buffer;
+
+  //Select the command based on direction and number of blocks
+  if(sd_transfer.flags & SD_DATA_READ)
+  {
+    //Set read single block command
+    sd_command.cmdidx = 17;
+  }
+  else
+  {
+    //Set write single block command
+    sd_command.cmdidx = 24;
+  }
+
+  //The multiple blocks commands follow the single block ones
+  if(blocks > 1)
+  {
+    sd_command.cmdidx++;
+  }
+
+  //Indicate which sector to start from
+  if(cardtype != SD_CARD_TYPE_SDHC)
+  {
+    //For non HC type cards use the byte address
+    sd_command.cmdarg = sd_transfer.sector << 9;
+  }
+  else
+  {
+    //For HC type card use the sector address
+    sd_command.cmdarg = sd_transfer.sector;
+  }
+
+  //Data is transfered in words. Set the timeout based on the number of 256 byte blocks
+  timeout = (blocks * 128) >> 6;
+
+  //Make sure it is not less then 2 seconds
+  if(timeout < 2000)
+  {
+    timeout = 2000;
+  }
+
+  //Setup timeout for checking against the timer ticks
+  sd_transfer.timeout = timer0_get_ticks() + timeout;
+
+  //Card allowed to be busy. Only the command is handled here, the data is moved by the DMA controller
+  sd_command.resp_type = SD_RESPONSE_BUSY | SD_RESPONSE_CRC | SD_RESPONSE_PRESENT;
+  return(sd_card_send_command(&sd_command, &sd_data));
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
-int32 sd_card_write(uint32 sector, uint32 blocks, uint8 *buffer)
+void sd_card_setup_dma(uint8 *buffer, uint32 length)
 {
-  int32 result;
-  
-  //Check if valid buffer given
-  if(buffer == 0)
-    return(SD_ERROR_INVALID_BUFFER);
-  
-  //Check if last bytes to read in range of the card sectors
-  if((sector + blocks - 1) > cardsectors)
-    return(SD_ERROR_SECTOR_OUT_OF_RANGE);
-  
-  //Send card select command
-  sd_command.cmdidx    = 7;
-  sd_command.cmdarg    = cardrca;
-  sd_command.resp_type = SD_RESPONSE_BUSY | SD_RESPONSE_CRC | SD_RESPONSE_PRESENT;
-  result = sd_card_send_command(&sd_command, 0);
+  PSD_IDMA_DESCRIPTOR descriptor = sd_descriptors;
+  uint32 size;
 
-  //Only continue when card selected without errors
-  if(result == SD_OK)
+  //Fill in a descriptor for every part of the buffer
+  while(length)
   {
-    //Prepare data buffer for writing
-    sd_data.blocks    = blocks;
-    sd_data.blocksize = 512;
-    sd_data.flags     = SD_DATA_WRITE;
-    sd_data.data      = buffer;
-    
-    //Send write command based on number of blocks
-    if(blocks == 1)
-    {
-      //Set write single block command
-      sd_command.cmdidx = 24;
-    }
-    else
+    //Limit on the size one descriptor can handle
+    size = length;
+
+    if(size > SD_DMA_DESCRIPTOR_SIZE)
     {
-      //Set write multiple blocks command
-      sd_command.cmdidx = 25;
+      size = SD_DMA_DESCRIPTOR_SIZE;
     }
-    
-    //Indicate which sector to start reading from
-    if(cardtype != SD_CARD_TYPE_SDHC)
+
+    //Chained descriptor owned by the DMA controller, without interrupt on completion
+    descriptor->config = SD_IDMA_DES_OWN | SD_IDMA_DES_CH | SD_IDMA_DES_DIC;
+    descriptor->size   = size;
+    descriptor->buffer = (uint32)buffer;
+    descriptor->next   = (uint32)(descriptor + 1);
+
+    //Next part of the buffer
+    buffer += size;
+    length -= size;
+
+    //Check if there is more to do
+    if(length)
     {
-      //For non HC type cards use the byte address
-      sd_command.cmdarg = sector << 9;
+      descriptor++;
     }
-    else
+  }
+
+  //Mark the first and the last descriptor
+  sd_descriptors[0].config |= SD_IDMA_DES_FD;
+  descriptor->config |= SD_IDMA_DES_LD | SD_IDMA_DES_ER;
+  descriptor->config &= ~SD_IDMA_DES_DIC;
+  descriptor->next = 0;
+
+  //Let the DMA controller access the FIFO instead of the cpu and reset it
+  *SD0_GCTL = (*SD0_GCTL & ~SD_GCTL_FIFO_ACCESS_AHB) | SD_GCTL_DMA_ENB | SD_GCTL_DMA_RST;
+
+  //Reset the internal DMA controller
+  *SD0_DMAC = SD_DMAC_SOFT_RST;
+
+  //Clear the status and don't use interrupts
+  *SD0_IDST = SD_IDST_CLEAR_ALL;
+  *SD0_IDIE = 0;
+
+  //Set the descriptor list and start the controller with fixed bursts
+  *SD0_DLBA = (uint32)sd_descriptors;
+  *SD0_DMAC = SD_DMAC_FIX_BURST | SD_DMAC_IDMA_ON;
+
+  //Burst size and FIFO thresholds for the DMA transfers
+  *SD0_FWLR = SD_FWLR_DMA_SETTING;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_transfer_busy(void)
+{
+  uint32 status;
+  uint32 done;
+  int32  result;
+
+  //Nothing to do when no transfer is in flight
+  if(sd_transfer.active == 0)
+  {
+    return(0);
+  }
+
+  //Get the current interrupt status
+  status = *SD0_RISR;
+
+  //Depending on the number of blocks either auto command done or data transfered signals the end of the command
+  if(sd_transfer.chunk > 1)
+  {
+    done = SD_RINT_AUTO_COMMAND_DONE;
+  }
+  else
+  {
+    done = SD_RINT_DATA_OVER;
+  }
+
+  //Check on errors
+  if(status & SD_RINT_INTERRUPT_ERROR_BITS)
+  {
+    sd_card_end_transfer(SD_ERROR);
+    return(0);
+  }
+
+  //Check if the command is done and the card is no longer busy programming the data
+  if(((status & done) == 0) || (*SD0_STAR & SD_STATUS_CARD_DATA_BUSY))
+  {
+    //Check on timeout
+    if(timer0_get_ticks() > sd_transfer.timeout)
     {
-      //For HC type card use the sector address
-      sd_command.cmdarg = sector;
+      sd_card_end_transfer(SD_ERROR_TIMEOUT);
+      return(0);
     }
-    
-    //Card allowed to be busy.
-    sd_command.resp_type = SD_RESPONSE_BUSY | SD_RESPONSE_CRC | SD_RESPONSE_PRESENT;
-    result = sd_card_send_command(&sd_command, &sd_data);
-    
-    //Deselect the card if all went well
-    if(result == SD_OK)
+
+    //Still busy
+    return(1);
+  }
+
+  //Stop the DMA controller and give the FIFO back to the cpu
+  sd_card_stop_dma();
+
+  //Clear all raw interrupts
+  *SD0_RISR = 0xFFFFFFFF;
+
+  //When the data went through the bounce buffer it needs to be copied to the actual buffer for reading
+  if(((uint32)sd_transfer.buffer & (ARM32_CACHE_LINE_SIZE - 1)) && (sd_transfer.flags & SD_DATA_READ))
+  {
+    memcpy(sd_transfer.buffer, sd_buffer, sd_transfer.chunk * 512);
+  }
+
+  //Move on to the next part of the transfer
+  sd_transfer.buffer += sd_transfer.chunk * 512;
+  sd_transfer.sector += sd_transfer.chunk;
+  sd_transfer.blocks -= sd_transfer.chunk;
+
+  //Check if there is more to do
+  if(sd_transfer.blocks)
+  {
+    //Start the next command
+    if((result = sd_card_start_chunk()) != SD_OK)
     {
-      //Send deselect card command to the card
-      sd_command.cmdidx    = 7;
-      sd_command.cmdarg    = 0;
-      sd_command.resp_type = SD_RESPONSE_NONE;
-      result = sd_card_send_command(&sd_command, 0);
+      sd_card_end_transfer(result);
+      return(0);
     }
+
+    //Still busy
+    return(1);
   }
-  
+
+  //All done
+  sd_card_end_transfer(SD_OK);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_wait_transfer(void)
+{
+  int32 result;
+
+  //Keep the transfer going until it is done. The timeout is handled in the busy check
+  while(sd_card_transfer_busy());
+
+  //Take the result and clear it, so a failed transfer is only reported once
+  result = sd_transfer.result;
+  sd_transfer.result = SD_OK;
+
   return(result);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void sd_card_end_transfer(int32 result)
+{
+  //Check if there was an error
+  if(result < 0)
+  {
+    //Stop the DMA controller
+    sd_card_stop_dma();
+
+    //Reset the DMA, FIFO and controller
+    *SD0_GCTL |= (SD_GCTL_DMA_RST | SD_GCTL_FIFO_RST | SD_GCTL_SOFT_RST);
+
+    sd_card_update_clock();
+
+    //Clear all raw interrupts
+    *SD0_RISR = 0xFFFFFFFF;
+  }
+
+  //Transfer no longer in flight
+  sd_transfer.active = 0;
+
+  //Send deselect card command to the card
+  sd_command.cmdidx    = 7;
+  sd_command.cmdarg    = 0;
+  sd_command.resp_type = SD_RESPONSE_NONE;
+
+  //Keep the first error
+  if((sd_card_send_command(&sd_command, 0) != SD_OK) && (result == SD_OK))
+  {
+    result = SD_ERROR;
+  }
+
+  sd_transfer.result = result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void sd_card_stop_dma(void)
+{
+  //Stop the internal DMA controller and clear its status
+  *SD0_DMAC = 0;
+  *SD0_IDST = SD_IDST_CLEAR_ALL;
+
+  //Give the FIFO back to the cpu
+  *SD0_GCTL = (*SD0_GCTL & ~SD_GCTL_DMA_ENB) | SD_GCTL_FIFO_ACCESS_AHB | SD_GCTL_FIFO_RST;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 int32 sd_card_get_specifications(void)
 {
   int32 result;
@@ -968,10 +1251,24 @@ int32 sd_card_send_command(PSD_CARD_COMMAND command, PSD_CARD_DATA data)
   //See if data needs to be written or read
   if(data)
   {
-    //The original code is different!!!!!
-    //For larger blobs of data it uses DMA
-    
-    //Send or receive the data using the cpu
+    //Check if the DMA controller handles the data
+    if(data->flags & SD_DATA_DMA)
+    {
+      //Only wait for the command to finish. The data is handled in the background and checked with sd_card_transfer_busy
+      if((error = sd_rint_wait(1000, SD_RINT_COMMAND_DONE)) == SD_OK)
+      {
+        //Only clear the command done flag, since the data flags are needed to see when the transfer is done
+        *SD0_RISR = SD_RINT_COMMAND_DONE;
+
+        return(SD_OK);
+      }
+
+      //Stop the DMA controller on an error
+      sd_card_stop_dma();
+      goto out;
+    }
+
+    //Send or receive small amounts of data using the cpu
     if((error = sd_send_data(data)))
     {
       goto out;
@@ -1094,16 +1391,7 @@ int32 sd_send_data(PSD_CARD_DATA data)
   //Setup timeout for checking against the timer ticks
   timeout += timer0_get_ticks();
 
-    //To solve buffer alignment problem this part needs to be improved upon
-    //The original code used malloc to get a really big buffer and copy the data into that
-    //Another way of doing it would be to modify the code here to have three handling parts
-    //1 for if the data is byte aligned (bit 1 being either 0 or 1 and bit 0 being 1)
-    //2 for if the data is short aligned (bit 1 being 1 and bit 0 being 0)
-    //3 for if the data is dword aligned (bit 1 being 0 and bit 0 being 0)
-    
-    //This can be done in the sd_card_send_command function calling three different send_data functions
-  
-  
+  //This cpu path is only used for the small card register reads. The sector transfers use the DMA controller
   //Handle the data based on alignment
   switch((int32)data->data & 3)
   {
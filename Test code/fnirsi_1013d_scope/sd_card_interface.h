@@ -57,6 +57,8 @@
 #define SD_GCTL_FIFO_RST                 0x00000002
 #define SD_GCTL_DMA_RST                  0x00000004
 
+#define SD_GCTL_DMA_ENB                  0x00000020
+
 #define SD_GCTL_CD_DBC_ENB               0x00000100
 
 #define SD_GCTL_FIFO_ACCESS_AHB          0x80000000
@@ -72,6 +74,32 @@
 #define SD_BWDR_4_BIT_WIDTH              0x00000001
 
 
+#define SD_FWLR_DMA_SETTING              0x20070008      //Burst size of 8 words, receive trigger level 7 and transmit trigger level 8
+
+
+#define SD_DMAC_SOFT_RST                 0x00000001
+#define SD_DMAC_FIX_BURST                0x00000002
+#define SD_DMAC_IDMA_ON                  0x00000080
+
+#define SD_IDST_CLEAR_ALL                0x00000337
+
+
+#define SD_IDMA_DES_DIC                  0x00000002      //Disable interrupt on completion
+#define SD_IDMA_DES_LD                   0x00000004      //Last descriptor
+#define SD_IDMA_DES_FD                   0x00000008      //First descriptor
+#define SD_IDMA_DES_CH                   0x00000010      //Chained mode
+#define SD_IDMA_DES_ER                   0x00000020      //End of ring
+#define SD_IDMA_DES_CES                  0x40000000      //Card error summary
+#define SD_IDMA_DES_OWN                  0x80000000      //Descriptor owned by the DMA controller
+
+#define SD_DMA_DESCRIPTOR_SIZE                 4096
+#define SD_DMA_DESCRIPTORS                       64
+#define SD_DMA_MAX_BLOCKS                ((SD_DMA_DESCRIPTORS * SD_DMA_DESCRIPTOR_SIZE) / 512)
+
+//Blocks that fit in the 4KB sd_buffer used for buffers that do not start on a cache line
+#define SD_BOUNCE_MAX_BLOCKS                      8
+
+
 
 
 
@@ -130,6 +158,7 @@
 
 #define SD_DATA_READ                              1
 #define SD_DATA_WRITE                             2
+#define SD_DATA_DMA                               4
 
 #define SD_CARD_TYPE_NONE                         0
 #define SD_CARD_TYPE_SDHC                         1
@@ -148,6 +177,8 @@
 
 typedef struct tagSD_CARD_COMMAND   SD_CARD_COMMAND, *PSD_CARD_COMMAND;
 typedef struct tagSD_CARD_DATA      SD_CARD_DATA,    *PSD_CARD_DATA;
+typedef struct tagSD_CARD_TRANSFER  SD_CARD_TRANSFER, *PSD_CARD_TRANSFER;
+typedef struct tagSD_IDMA_DESCRIPTOR SD_IDMA_DESCRIPTOR, *PSD_IDMA_DESCRIPTOR;
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -167,6 +198,27 @@ struct tagSD_CARD_DATA
   uint32  blocksize;
 };
 
+struct tagSD_CARD_TRANSFER
+{
+  uint8  *buffer;         //Where the next command reads or writes its data
+  uint32  flags;
+  uint32  sector;         //First sector of the next command
+  uint32  blocks;         //Number of blocks still to transfer
+  uint32  chunk;          //Number of blocks in the command in flight
+  uint32  timeout;
+  uint32  active;
+  int32   result;
+};
+
+//Layout used by the internal DMA controller of the SD interface
+struct tagSD_IDMA_DESCRIPTOR
+{
+  uint32 config;
+  uint32 size;
+  uint32 buffer;
+  uint32 next;
+};
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 int32 sd_card_init(void);
@@ -175,6 +227,17 @@ int32 sd_card_read(uint32 sector, uint32 blocks, uint8 *buffer);
 
 int32 sd_card_write(uint32 sector, uint32 blocks, uint8 *buffer);
 
+int32 sd_card_start_read(uint32 sector, uint32 blocks, uint8 *buffer);
+int32 sd_card_start_write(uint32 sector, uint32 blocks, uint8 *buffer);
+int32 sd_card_start_transfer(uint32 flags, uint32 sector, uint32 blocks, uint8 *buffer);
+int32 sd_card_start_chunk(void);
+int32 sd_card_transfer_busy(void);
+int32 sd_card_wait_transfer(void);
+void  sd_card_end_transfer(int32 result);
+
+void sd_card_setup_dma(uint8 *buffer, uint32 length);
+void sd_card_stop_dma(void);
+
 int32 sd_card_get_specifications(void);
 
 int32 sd_card_set_clock_and_bus(int32 usewidebus);
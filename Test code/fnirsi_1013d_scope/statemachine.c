@@ -38,6 +38,9 @@ void touch_handler(void)
       {
         //Save the current position for it
         previous_trigger_point_position = scopesettings.triggerhorizontalposition;
+
+        //On a stopped trace the same movement pans the trace instead
+        previous_zoom_offset = zoomoffset;
       }
 
       //Save the data for the selected object
@@ -68,6 +71,10 @@ void touch_handler(void)
           }
           break;
 
+        case TOUCH_STATE_MOVE_MATH_CHANNEL:
+          previous_math_channel_offset = scopesettings.mathchannel.traceposition;
+          break;
+
         case TOUCH_STATE_MOVE_TRIGGER_LEVEL:
           previous_trigger_level_offset = scopesettings.triggerverticalposition;
           break;
@@ -144,6 +151,10 @@ void touch_handler(void)
         }
         break;
 
+      case TOUCH_STATE_MOVE_MATH_CHANNEL:
+        change_math_channel_offset();
+        break;
+
       case TOUCH_STATE_MOVE_TRIGGER_LEVEL:
         change_trigger_level_offset();
         break;
@@ -461,8 +472,16 @@ void scan_for_touch(void)
       //See if it was short touch for time base change. Needs to be less then 200mS for that
       if((timer0_get_ticks() - previoustimerticks) < 200)
       {
-        //Change the time base setting
-        scope_adjust_timebase();
+        //When browsing the segments of a segmented capture the touch selects the segment instead
+        if(scope_segment_view_active())
+        {
+          scope_browse_segments(previousxtouch);
+        }
+        else
+        {
+          //Change the time base setting
+          scope_adjust_timebase();
+        }
       }
 
       //Done for now.
@@ -507,11 +526,44 @@ void scan_for_touch(void)
           distance_channel_2 =  ytouch - offset;
         }
 
+        //The math channel is only in reach when it is shown
+        if(scope_math_channel_active())
+        {
+          //Need to make the trace offset in the same orientation as the touch
+          offset = 449 - scopesettings.mathchannel.traceposition;
+
+          //Check if touch point below the trace
+          if(ytouch < offset)
+          {
+            //If so take the touch point of the offset for the distance
+            distance_math_channel = offset - ytouch;
+          }
+          else
+          {
+            //Otherwise take the offset of the touch point for the distance
+            distance_math_channel =  ytouch - offset;
+          }
+        }
+        else
+        {
+          //Out of range when not shown
+          distance_math_channel = 0xFFFF;
+        }
+
         //Check on x below 60 to decide early on which trace to move
         if(xtouch < 60)
         {
+          //Check if touch closer to the math channel center then the real channel centers
+          if((distance_math_channel < 30) && (distance_math_channel < distance_channel_1) && (distance_math_channel < distance_channel_2))
+          {
+            //Signal the math channel trace is being moved and that the trigger point position can also be moved
+            touchstate = TOUCH_STATE_MOVE_MATH_CHANNEL | TOUCH_STATE_MOVE_TRIGGER_POINT;
+
+            //Go and handle it
+            return;
+          }
           //Check if touch closer to channel 1 center then channel 2 center
-          if((distance_channel_1 < 30) && (distance_channel_1 < distance_channel_2))
+          else if((distance_channel_1 < 30) && (distance_channel_1 < distance_channel_2))
           {
             //Signal channel 1 trace is being moved and that the trigger point position can also be moved
             touchstate = TOUCH_STATE_MOVE_CHANNEL_1 | TOUCH_STATE_MOVE_TRIGGER_POINT;
@@ -717,7 +769,7 @@ void handle_main_menu_touch(void)
 
             //Save the screen under the menu
             display_set_destination_buffer(displaybuffer2);
-            display_copy_rect_from_screen(150, 46, 244, 353);
+            display_copy_rect_from_screen(150, 46, 244, 425);
 
             //Show the system settings menu
             scope_open_system_settings_menu();
@@ -800,10 +852,10 @@ void handle_main_menu_touch(void)
         }
       }
       //Check on system settings menu opened and being touched
-      else if(systemsettingsmenuopen && (xtouch >= 150) && (xtouch <= 394) && (ytouch >= 46) && (ytouch <= 399))
+      else if(systemsettingsmenuopen && (xtouch >= 150) && (xtouch <= 394) && (ytouch >= 46) && (ytouch <= 471))
       {
         //Check if on screen brightness
-        if((ytouch >= 47) && (ytouch <= 103))
+        if((ytouch >= 47) && (ytouch <= 98))
         {
           //Check if already open
           if(screenbrightnessopen == 0)
@@ -825,7 +877,7 @@ void handle_main_menu_touch(void)
           }
         }
         //Check if on grid brightness
-        else if((ytouch >= 105) && (ytouch <= 162))
+        else if((ytouch >= 100) && (ytouch <= 151))
         {
           //Check if already open
           if(gridbrightnessopen == 0)
@@ -840,14 +892,14 @@ void handle_main_menu_touch(void)
             tp_i2c_wait_for_touch_release();
 
             //Show the screen brightness slider
-            scope_open_slider(395, 104, scopesettings.gridbrightness);
+            scope_open_slider(395, 99, scopesettings.gridbrightness);
 
             //Signal the screen brightness slider is opened
             gridbrightnessopen = 1;
           }
         }
         //Check if on always trigger 50%
-        else if((ytouch >= 164) && (ytouch <= 221))
+        else if((ytouch >= 153) && (ytouch <= 204))
         {
           //Close any of the sub menus if open
           close_open_menus(0);
@@ -859,10 +911,10 @@ void handle_main_menu_touch(void)
           scopesettings.alwaystrigger50 ^= 1;
 
           //Show the state
-          scope_display_slide_button(326, 183, scopesettings.alwaystrigger50);
+          scope_display_slide_button(326, 168, scopesettings.alwaystrigger50);
         }
         //Check if on baseline calibration
-        else if((ytouch >= 223) && (ytouch <= 280))
+        else if((ytouch >= 206) && (ytouch <= 257))
         {
           //Check if already open
           if(calibrationopen == 0)
@@ -884,7 +936,7 @@ void handle_main_menu_touch(void)
           }
         }
         //Check if on x-y mode display
-        else if((ytouch >= 282) && (ytouch <= 339))
+        else if((ytouch >= 259) && (ytouch <= 310))
         {
           //Close any of the sub menus if open
           close_open_menus(0);
@@ -896,10 +948,10 @@ void handle_main_menu_touch(void)
           scopesettings.xymodedisplay ^= 1;
 
           //Show the state
-          scope_display_slide_button(326, 299, scopesettings.xymodedisplay);
+          scope_display_slide_button(326, 274, scopesettings.xymodedisplay);
         }
         //check on notification confirmation
-        else if((ytouch >= 341) && (ytouch <= 398))
+        else if((ytouch >= 312) && (ytouch <= 363))
         {
           //Close any of the sub menus if open
           close_open_menus(0);
@@ -911,11 +963,48 @@ void handle_main_menu_touch(void)
           scopesettings.confirmationmode ^= 1;
 
           //Show the state
-          scope_display_slide_button(326, 358, scopesettings.confirmationmode);
+          scope_display_slide_button(326, 327, scopesettings.confirmationmode);
+        }
+        //Check on persistence display
+        else if((ytouch >= 365) && (ytouch <= 416))
+        {
+          //Close any of the sub menus if open
+          close_open_menus(0);
+
+          //Wait until touch is released
+          tp_i2c_wait_for_touch_release();
+
+          //Toggle the persistence mode. When switched on the intensities are halved every few frames
+          if(scopesettings.persistence)
+          {
+            scopesettings.persistence = 0;
+          }
+          else
+          {
+            scopesettings.persistence = PERSISTENCE_DECAY_FRAMES;
+          }
+
+          //Show the state
+          scope_display_slide_button(326, 380, scopesettings.persistence != 0);
+        }
+        //Check on file compression
+        else if((ytouch >= 418) && (ytouch <= 470))
+        {
+          //Close any of the sub menus if open
+          close_open_menus(0);
+
+          //Wait until touch is released
+          tp_i2c_wait_for_touch_release();
+
+          //Toggle the use of the compressed picture and waveform file formats
+          scopesettings.filecompression ^= 1;
+
+          //Show the state
+          scope_display_slide_button(326, 433, scopesettings.filecompression);
         }
       }
       //Check on screen brightness slider opened and being touched
-      else if(screenbrightnessopen && (xtouch >= 395) && (xtouch <= 726) && (ytouch >= 46) && (ytouch <= 104))
+      else if(screenbrightnessopen && (xtouch >= 395) && (xtouch <= 726) && (ytouch >= 46) && (ytouch <= 98))
       {
         //Move the slider to a new position and check if there was a change in position
         if(scope_move_slider(395, 46, &scopesettings.screenbrightness))
@@ -928,10 +1017,10 @@ void handle_main_menu_touch(void)
         }
       }
       //Check on grid brightness slider opened and being touched
-      else if(gridbrightnessopen && (xtouch >= 395) && (xtouch <= 726) && (ytouch >= 105) && (ytouch <= 163))
+      else if(gridbrightnessopen && (xtouch >= 395) && (xtouch <= 726) && (ytouch >= 99) && (ytouch <= 157))
       {
         //Move the slider to a new position and check if there was a change in position
-        if(scope_move_slider(395, 104, &scopesettings.gridbrightness))
+        if(scope_move_slider(395, 99, &scopesettings.gridbrightness))
         {
           //Update the setting in the system settings menu
           scope_system_settings_grid_brightness_value();
@@ -940,13 +1029,13 @@ void handle_main_menu_touch(void)
         }
       }
       //Check on calibration start text opened and being touched
-      else if((calibrationopen == 1) && (xtouch >= 395) && (xtouch <= 594) && (ytouch >= 223) && (ytouch <= 280))
+      else if((calibrationopen == 1) && (xtouch >= 395) && (xtouch <= 594) && (ytouch >= 205) && (ytouch <= 262))
       {
         //Check if touch is on the button
-        if((xtouch >= 517) && (xtouch <= 583) && (ytouch >= 230) && (ytouch <= 272))
+        if((xtouch >= 517) && (xtouch <= 583) && (ytouch >= 212) && (ytouch <= 254))
         {
           //Highlight the button
-          scope_display_ok_button(517, 230, 1);
+          scope_display_ok_button(517, 212, 1);
 
           //Wait until touch is released
           tp_i2c_wait_for_touch_release();
@@ -971,7 +1060,7 @@ void handle_main_menu_touch(void)
         }
       }
       //Check on calibration done text opened and being touched
-      else if((calibrationopen == 2) && (xtouch >= 395) && (xtouch <= 505) && (ytouch >= 223) && (ytouch <= 280))
+      else if((calibrationopen == 2) && (xtouch >= 395) && (xtouch <= 505) && (ytouch >= 205) && (ytouch <= 262))
       {
         //Nothing to do here so wait until touch is released
         tp_i2c_wait_for_touch_release();
@@ -1136,6 +1225,44 @@ void handle_channel_menu_touch(PCHANNELSETTINGS settings)
             scope_channel_settings(settings, 0);
           }
         }
+        //Check on the math channel function
+        else if((ytouch >= CH_MENU_YPOS + 261) && (ytouch <= CH_MENU_YPOS + 299) && (xtouch >= settings->menuxpos + 78) && (xtouch <= settings->menuxpos + 162))
+        {
+          //Select the next function, and back to off after the last one
+          if(scopesettings.mathmode < MATH_MODE_MAX)
+          {
+            scopesettings.mathmode++;
+          }
+          else
+          {
+            scopesettings.mathmode = MATH_MODE_OFF;
+          }
+
+          //Compute it for the samples in the buffers, so a stopped trace shows it too
+          scope_process_math_channel();
+
+          //Display this
+          scope_channel_math_mode_select(settings);
+        }
+        //Check on the protocol decoder
+        else if((ytouch >= CH_MENU_YPOS + 323) && (ytouch <= CH_MENU_YPOS + 361) && (xtouch >= settings->menuxpos + 78) && (xtouch <= settings->menuxpos + 162))
+        {
+          //Select the next protocol, and back to off after the last one
+          if(scopesettings.decodermode < DECODER_MODE_MAX)
+          {
+            scopesettings.decodermode++;
+          }
+          else
+          {
+            scopesettings.decodermode = DECODER_MODE_OFF;
+          }
+
+          //Decode the samples in the buffers, so a stopped trace shows it too
+          scope_process_decoder();
+
+          //Display this
+          scope_channel_decoder_mode_select(settings);
+        }
 
         //Wait until touch is released before checking on a new position
         tp_i2c_wait_for_touch_release();
@@ -1228,6 +1355,46 @@ void handle_acquisition_menu_touch(void)
             }
           }
         }
+        //Check on acquisition mode being set
+        else if((ytouch >= ACQ_MENU_YPOS + 368) && (ytouch <= ACQ_MENU_YPOS + 390))
+        {
+          for(i=0;i<(sizeof(acquisition_mode_texts) / sizeof(int8 *));i++)
+          {
+            x = (i * 57) + 10 + ACQ_MENU_XPOS;
+
+            if((xtouch >= x) && (xtouch <= x + 53))
+            {
+              //Set the new mode. Averaging always starts over
+              scopesettings.acquisitionmode = i;
+              averagecount       = 0;
+              averageresultvalid = 0;
+
+              //Display the new setting
+              scope_acquisition_mode_select();
+              break;
+            }
+          }
+        }
+        //Check on number of acquisitions to average being set
+        else if((ytouch >= ACQ_MENU_YPOS + 391) && (ytouch <= ACQ_MENU_YPOS + 413))
+        {
+          for(i=0;i<ACQUISITION_MAX_AVERAGE_SHIFT;i++)
+          {
+            x = (i * 36) + 10 + ACQ_MENU_XPOS;
+
+            if((xtouch >= x) && (xtouch <= x + 32))
+            {
+              //Set the new number as power of two, and start over with averaging. For segmented capture this sets the ring size
+              scopesettings.averageshift = i + 1;
+              averagecount       = 0;
+              averageresultvalid = 0;
+
+              //Display the new setting
+              scope_acquisition_mode_select();
+              break;
+            }
+          }
+        }
 
         //Wait until touch is released before checking on a new position
         tp_i2c_wait_for_touch_release();
@@ -2710,7 +2877,7 @@ void close_open_menus(uint32 closemain)
 
     //Restore the screen under the grid brightness slider
     display_set_source_buffer(displaybuffer2);
-    display_copy_rect_to_screen(395, 104, 331, 58);
+    display_copy_rect_to_screen(395, 99, 331, 58);
 
     //Signal it is closed
     gridbrightnessopen = 0;
@@ -2723,7 +2890,7 @@ void close_open_menus(uint32 closemain)
 
     //Restore the screen under the calibration text
     display_set_source_buffer(displaybuffer2);
-    display_copy_rect_to_screen(395, 222, 199, 59);
+    display_copy_rect_to_screen(395, 204, 199, 59);
 
     //Signal it is closed
     calibrationopen = 0;
@@ -2734,7 +2901,7 @@ void close_open_menus(uint32 closemain)
   {
     //Restore the screen under the system settings menu when done
     display_set_source_buffer(displaybuffer2);
-    display_copy_rect_to_screen(150, 46, 244, 353);
+    display_copy_rect_to_screen(150, 46, 244, 425);
 
     //Clear the flag so it will be opened next time
     systemsettingsmenuopen = 0;
@@ -2758,6 +2925,13 @@ void move_trigger_point_position(void)
     diff /= 5;
   }
 
+  //On a stopped trace pan through the sample buffer instead. The display limits it to keep a part of the trace on the screen
+  if(scope_zoom_active())
+  {
+    zoomoffset = previous_zoom_offset + diff;
+    return;
+  }
+
   //Calculate the new position
   position = (int32)previous_trigger_point_position + diff;
 
@@ -2866,6 +3040,42 @@ void change_channel_2_offset(void)
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void change_math_channel_offset(void)
+{
+  int32 diff;
+  int32 position;
+
+  //Calculate the distance to move the setting with
+  diff = ytouch - previousytouch;
+
+  //Make it based on move speed
+  if(scopesettings.movespeed)
+  {
+    //For slow divide by 5
+    diff /= 5;
+  }
+
+  //Calculate the new position
+  position = (int32)previous_math_channel_offset - diff;
+
+  //Limit it on the trace portion of the screen
+  if(position < 6)
+  {
+    //So not below 6
+    position = 6;
+  }
+  else if(position > 394)
+  {
+    //And not above 394;
+    position = 394;
+  }
+
+  //Update the current position. The math channel has no FPGA setting, it only moves on the screen
+  scopesettings.mathchannel.traceposition = position;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void change_trigger_level_offset(void)
 {
   int32 diff;
@@ -41,6 +41,7 @@ void move_trigger_point_position(void);
 
 void change_channel_1_offset(void);
 void change_channel_2_offset(void);
+void change_math_channel_offset(void);
 
 void change_trigger_level_offset(void);
 
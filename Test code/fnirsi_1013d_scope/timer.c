@@ -3,6 +3,7 @@
 #include "timer.h"
 #include "interrupt.h"
 #include "variables.h"
+#include "fpga_control.h"
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
@@ -31,11 +32,20 @@ void timer0_setup(void)
 
 void timer0_irq_handler(void)
 {
-  //Clear the interrupt
-  *TMR_IRQ_STA_REG |= 1;
+  //Clear the interrupt. The status bits are cleared by writing a one, so only this timers bit is written to not lose a pending
+  //timer 1 interrupt of the touch panel scan
+  *TMR_IRQ_STA_REG = 1;
   
   //Add one more milli second to the ticks
   timer0ticks++;
+
+  //While the main loop is not using the FPGA bus, check if the pending conversion is done to note the time it happened
+  if(conversionwatch && fpga_conversion_done())
+  {
+    conversiondoneticks = timer0ticks;
+    conversiondone      = 1;
+    conversionwatch     = 0;
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -9,10 +9,26 @@
 //
 //The touch panel uses a GT911 controller and has a special startup sequence to set the I2C device address
 //
+//PA1 has no external interrupt function on the F1C100s, so the panel is scanned from the timer 1 interrupt instead of the main loop.
+//The interrupt handler puts the touch events in a queue that is read by the main loop without any I2C traffic.
+//
 //----------------------------------------------------------------------------------------------------------------------------------
 
 #include "variables.h"
 #include "touchpanel.h"
+#include "timer.h"
+#include "interrupt.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Queue with a single writer and a single reader. Only the interrupt handler moves the head and only the main loop moves the tail,
+//so no locking is needed
+
+volatile TOUCHEVENT tp_event_queue[TP_EVENT_QUEUE_SIZE];
+
+volatile uint32 tp_event_head = 0;
+volatile uint32 tp_event_tail = 0;
+
+volatile uint32 tp_events_dropped = 0;
 
 //----------------------------------------------------------------------------------------------------------------------------------
 //Touch panel configuration for the GT9157 set to 800x480 resolution
@@ -137,6 +153,9 @@ void tp_i2c_setup(void)
   //Start scanning by sending 0 to the command register
   command = 0;
   tp_i2c_send_data(TP_CMD_REG, &command, 1);
+
+  //From here on the panel is only read from the timer interrupt
+  tp_scan_start();
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -152,16 +171,75 @@ void tp_i2c_wait_for_touch_release(void)
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
+//Take the touch state from the event queue. Touch moves are combined into the latest position, but a change between touched and released
+//is always seen by at least one call, so a short tap is not missed.
 
 void tp_i2c_read_status(void)
+{
+  TOUCHEVENT event;
+
+  while(tp_get_event(&event))
+  {
+    //Store the result in the global coordinate variables
+    xtouch = event.x;
+    ytouch = event.y;
+
+    //Check if the touch state changes
+    if(havetouch != event.type)
+    {
+      havetouch = event.type;
+
+      //Leave the rest of the events for the next call
+      break;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void tp_scan_start(void)
+{
+  //Set the reload value for the scan interval
+  *TMR1_INTV_VALUE_REG = TP_SCAN_INTERVAL;
+
+  //Reset the counter
+  *TMR1_CUR_VALUE_REG = 0;
+
+  //Setup the interrupt for this timer
+  setup_interrupt(TMR1_IRQ_NUM, tp_scan_irq_handler, 0);
+
+  //Configure and enable the timer with auto reload
+  *TMR1_CTRL_REG = TMR_CLK_SRC_OSC24M | TMR_RELOAD | TMR_ENABLE;
+
+  //Enable this timers interrupt
+  *TMR_IRQ_EN_REG |= 2;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void tp_scan_irq_handler(void)
+{
+  //Clear the interrupt. Only this timers bit, to not lose a pending timer 0 interrupt
+  *TMR_IRQ_STA_REG = 2;
+
+  //Check the panel for new coordinates
+  tp_i2c_scan();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Only called from the timer 1 interrupt, so the I2C lines are not used by anything else while the scanning runs
+
+void tp_i2c_scan(void)
 {
   uint8  status;
   uint8  data[4];
+  uint32 x;
+  uint32 y;
 
   //Read the status of the touch panel
   tp_i2c_read_data(TP_STATUS_REG, &status, 1);
   
-  //Check if there is touch
+  //Check if there is new coordinate data
   if(status & 0x80)
   {
     //Clear the status
@@ -176,34 +254,75 @@ void tp_i2c_read_status(void)
       //Get the touch point data
       tp_i2c_read_data(TP_COORD1_REG, data, 4);
 
-      //Store the result in the global coordinate variables
-      xtouch = data[0] | (data[1] << 8);
-      ytouch = data[2] | (data[3] << 8);
+      x = data[0] | (data[1] << 8);
+      y = data[2] | (data[3] << 8);
       
 #ifndef USE_TP_CONFIG
       //Scale the coordinates based on the x and y max values
-      xtouch = (xscaler * xtouch) >> 20;
-      ytouch = (yscaler * ytouch) >> 20;
+      x = (xscaler * x) >> 20;
+      y = (yscaler * y) >> 20;
 #endif
       
       //Signal touch active
-      havetouch = 1;
+      tp_post_event(TP_EVENT_TOUCH, x, y);
     }
     else
     {
       //Original code checks on a second touch point active, but not sure if it does anything with it.
-      //No or to many points so set out of range touch
-      xtouch = 800;
-      ytouch = 480;
-      
-      //Signal no touch active
-      havetouch = 0;
+      //No or to many points so set out of range touch and signal no touch active
+      tp_post_event(TP_EVENT_RELEASE, 800, 480);
     }
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+void tp_post_event(uint32 type, uint16 x, uint16 y)
+{
+  uint32 head = tp_event_head;
+  volatile TOUCHEVENT *event;
+
+  //When the main loop is too far behind the event is lost
+  if((head - tp_event_tail) >= TP_EVENT_QUEUE_SIZE)
+  {
+    tp_events_dropped++;
+    return;
+  }
+
+  event = &tp_event_queue[head & (TP_EVENT_QUEUE_SIZE - 1)];
+
+  event->type = type;
+  event->x    = x;
+  event->y    = y;
+
+  //Only make it visible to the main loop when it is filled in
+  tp_event_head = head + 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 tp_get_event(PTOUCHEVENT event)
+{
+  uint32 tail = tp_event_tail;
+
+  //Check if there is an event waiting
+  if(tail == tp_event_head)
+  {
+    return(0);
+  }
+
+  event->type = tp_event_queue[tail & (TP_EVENT_QUEUE_SIZE - 1)].type;
+  event->x    = tp_event_queue[tail & (TP_EVENT_QUEUE_SIZE - 1)].x;
+  event->y    = tp_event_queue[tail & (TP_EVENT_QUEUE_SIZE - 1)].y;
+
+  //Give the entry back to the interrupt handler
+  tp_event_tail = tail + 1;
+
+  return(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void tp_i2c_send_data(uint16 reg_addr, uint8 *buffer, uint32 size)
 {
   //Start a communication sequence
@@ -34,10 +34,41 @@
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+//The panel is scanned from the timer 1 interrupt. The controller updates its coordinates about every 10mS
+#define TP_SCAN_INTERVAL        240000      //10mS on the 24MHz oscillator
+
+//Number of touch events that can be waiting for the main loop. Needs to be a power of two
+#define TP_EVENT_QUEUE_SIZE     32
+
+#define TP_EVENT_TOUCH          1           //Panel touched or touch moved
+#define TP_EVENT_RELEASE        0           //No longer touched
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct tagTouchEvent            TOUCHEVENT,     *PTOUCHEVENT;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagTouchEvent
+{
+  uint16 type;
+  uint16 x;
+  uint16 y;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 void tp_i2c_setup(void);
 
 void tp_i2c_read_status(void);
 
+void tp_scan_start(void);
+void tp_scan_irq_handler(void);
+void tp_i2c_scan(void);
+
+void tp_post_event(uint32 type, uint16 x, uint16 y);
+int32 tp_get_event(PTOUCHEVENT event);
+
 void tp_i2c_wait_for_touch_release(void);
 
 void tp_i2c_send_data(uint16 reg_addr, uint8 *buffer, uint32 size);
@@ -1,6 +1,7 @@
 //----------------------------------------------------------------------------------------------------------------------------------
 
 #include "variables.h"
+#include "mmu_control.h"
 
 //----------------------------------------------------------------------------------------------------------------------------------
 //Timer data
@@ -49,13 +50,21 @@ uint8 calibrationopen = 0;
 //----------------------------------------------------------------------------------------------------------------------------------
 
 //This first buffer is defined as 32 bits to be able to write it to file
-uint32 maindisplaybuffer[SCREEN_SIZE / 2];
+uint32 maindisplaybuffer[SCREEN_SIZE / 2] FRAMEBUFFER_SECTION;
 
 uint16 displaybuffer1[SCREEN_SIZE];
 uint16 displaybuffer2[SCREEN_SIZE];
 
 uint16 gradientbuffer[SCREEN_HEIGHT];
 
+//Defined as 32 bits to keep it word aligned for handling four pixels at a time
+uint32 persistencebuffer[(TRACE_WINDOW_WIDTH * TRACE_WINDOW_HEIGHT) / 4];
+
+uint16 persistencecolors[256];
+
+uint32 persistenceframes = 0;
+uint8  persistenceactive = 0;
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //Scope data
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -69,6 +78,64 @@ CHANNELSETTINGS calibrationsettings;
 SCOPESETTINGS savedscopesettings1;
 SCOPESETTINGS savedscopesettings2;
 
+uint8  conversionpending = 0;         //Signals the FPGA is sampling the next trace while the current one is processed and displayed
+uint8  conversiontimeperdiv;          //Settings the pending conversion was started with
+uint32 conversionsettingschanges;
+
+volatile uint8  conversionwatch = 0;  //Set while the FPGA bus is free, so the timer interrupt can note when the pending conversion is done
+volatile uint8  conversiondone  = 0;
+volatile uint32 conversiondoneticks;
+
+uint32 fpgasettingschanges = 0;       //Counts the setting writes that changed a value in the FPGA
+
+uint32 fpgashadowdata[FPGA_SHADOW_SIZE];     //Last value written to the FPGA for each setting command
+uint8  fpgashadowvalid[FPGA_SHADOW_SIZE];
+
+FPGABATCHENTRY fpgabatch[FPGA_BATCH_SIZE];   //Setting writes collected to be sent in one go
+uint32 fpgabatchcount = 0;
+uint8  fpgabatchopen = 0;
+
+uint32 adcrawbuffer[ADC_MAX_SAMPLES / 4];   //Samples as read from the FPGA, four to a word
+uint8  adcclamptable[768];                  //Compensated sample lookup, indexed with the raw sample plus 256 plus the compensation
+
+uint8  rollactive = 0;                //Signals the traces are shown in roll mode
+uint8  rolltimeperdiv;                //Time base setting roll mode is running on
+uint8  rollredraw;                    //Signals the roll mode trace picture needs to be drawn from the sample buffers again
+uint32 rollindex;                     //Location in the sample buffers for the next sample
+uint32 rollcount;                     //Number of valid samples in the sample buffers
+uint32 rollnewsamples;                //Number of samples not drawn yet
+uint32 rollnextticks;                 //Timer ticks at which the next sample is due
+
+uint8  rollchannel1buffer[ROLL_MODE_SAMPLES];
+uint8  rollchannel2buffer[ROLL_MODE_SAMPLES];
+
+uint16 rolldisplaybuffer[SCREEN_SIZE];         //Only holds the traces, so they can be scrolled without the grid and pointers
+
+uint32 rolldisplaysettings[6];        //Channel settings the roll mode trace picture is drawn with
+
+uint32 averagecount = 0;              //Number of acquisitions in the accumulators, zero to start over
+uint8  averageresultvalid = 0;        //Signals there is a completed block average
+uint32 averagesettings[6];            //Settings the accumulated acquisitions were taken with
+
+//The accumulators hold the samples as two 16 bit lanes per word. Even words have the samples on buffer positions 0 and 2 of a group of
+//four, odd words the samples on positions 1 and 3. Only taken from the sample buffer pool while averaging
+uint32 *channel1averagebuffer = 0;
+uint32 *channel2averagebuffer = 0;
+
+//Last completed block average, shown while the next block is accumulated
+uint32 *channel1averageresult = 0;
+uint32 *channel2averageresult = 0;
+
+PSEGMENT segmentblocks[SEGMENT_MAX_BLOCKS];   //Ring of segments in blocks from the sample buffer pool
+uint32   segmentblockcount = 0;
+uint32   segmentsize = 0;             //Number of segments the ring holds
+uint32   segmentcount;                //Number of valid segments in the ring
+uint32   segmentindex;                //Location in the ring for the next segment
+uint32   segmentview;                 //Segment shown when stopped, counted from the oldest one
+uint32   segmentsequence;
+uint8    segmentcapturing = 0;        //Signals a sequence of captures is in progress
+uint8    segmentoverlay = 0;          //Signals all the segments are shown on top of each other
+
 uint32 channel1tracebuffer[750];
 
 DISPLAYPOINTS channel1pointsbuffer[730];      //Buffer to store the x,y positions of the trace on the display
@@ -77,6 +144,16 @@ uint32 channel2tracebuffer[750];
 
 DISPLAYPOINTS channel2pointsbuffer[730];      //Buffer to store the x,y positions of the trace on the display
 
+uint32 mathtracebuffer[750];
+
+DISPLAYPOINTS mathpointsbuffer[730];          //Buffer to store the x,y positions of the trace on the display
+
+uint32 mathdisplayshift;                      //Scale of the math samples relative to the channel 1 samples as power of two
+
+DECODERRESULT decoderresult;                  //Bytes found by the protocol decoder in the current trace
+
+DISPLAYPOINTS xymodepointsbuffer[750];        //Buffer to store the x,y positions of the x-y mode trace on the display
+
 
 uint16 thumbnailtracedata[730];
 
@@ -104,10 +181,14 @@ int32 disp_first_sample;
 
 uint32 disp_have_trigger;
 uint32 disp_trigger_index;            //Trigger point in the sample buffers
+double disp_trigger_fraction;         //Position of the level crossing between the trigger point and the next sample
 
 int32 disp_xstart;
 int32 disp_xend;
 
+int32  zoomoffset = 0;                //Horizontal shift in pixels of a stopped trace panned through the sample buffer
+double zoomxpospersample;             //Horizontal scale the offset belongs to
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //Distances of touch point to traces and cursors
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -115,6 +196,8 @@ int32 disp_xend;
 uint16 distance_channel_1;
 uint16 distance_channel_2;
 
+uint16 distance_math_channel;
+
 uint16 distance_trigger_level;
 
 uint16 distance_time_cursor_left;
@@ -129,10 +212,12 @@ uint16 distance_volt_cursor_bottom;
 
 uint16 previous_channel_1_offset;
 uint16 previous_channel_2_offset;
+uint16 previous_math_channel_offset;
 
 uint16 previous_trigger_level_offset;
 
 uint16 previous_trigger_point_position;
+int32  previous_zoom_offset;
 
 uint16 previous_left_time_cursor_position;
 uint16 previous_right_time_cursor_position;
@@ -153,6 +238,8 @@ uint16 prevxtouch = 0;
 FIL     viewfp;                         //Since files are not opened concurrent using a global file pointer
 DIR     viewdir;
 FILINFO viewfileinfo;
+
+DWORD viewlinkmap[VIEW_LINK_MAP_SIZE];  //Cluster link map for fast seeking in the file opened for reading
   
 char viewfilename[32];              //The original code uses a large buffer to create all the needed file names in. Here the file name is created when needed
 
@@ -176,6 +263,11 @@ THUMBNAILDATA viewthumbnaildata[VIEW_MAX_ITEMS];
 
 uint16 viewfilenumberdata[VIEW_MAX_ITEMS];
 
+uint32 viewthumbnailsequence[VIEW_MAX_ITEMS];       //Sequence numbers of the loaded items, only needed for sorting them on load
+
+THUMBNAILHEADER viewthumbnailheader;                //Header of the thumbnail file of the current view type, with the free slot bitmap
+THUMBNAILRECORD viewthumbnailrecords[VIEW_THUMBNAIL_CHUNK_RECORDS];  //Buffer for reading and writing the thumbnail records
+
 uint8 viewbitmapheader[PICTURE_HEADER_SIZE];
 
 uint32 viewfilesetupdata[VIEW_NUMBER_OF_SETTINGS];
@@ -351,6 +443,42 @@ const int8 acquisition_speed_text_x_offsets[18] =
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
+const int8 *acquisition_mode_texts[5] =
+{
+  "Normal",
+  "Average",
+  "Exp Avg",
+  "Hi-Res",
+  "Segment"
+};
+
+const int8 acquisition_mode_text_x_offsets[5] =
+{
+  18, 15, 16, 19, 14
+};
+
+const int8 *average_count_texts[ACQUISITION_MAX_AVERAGE_SHIFT] =
+{
+  "2", "4", "8", "16", "32", "64", "128", "256"
+};
+
+const int8 average_count_text_x_offsets[ACQUISITION_MAX_AVERAGE_SHIFT] =
+{
+  22, 22, 22, 19, 19, 19, 15, 15
+};
+
+const int8 *segment_count_texts[ACQUISITION_MAX_AVERAGE_SHIFT] =
+{
+  "32", "64", "128", "256", "512", "1K", "2K", "4K"
+};
+
+const int8 segment_count_text_x_offsets[ACQUISITION_MAX_AVERAGE_SHIFT] =
+{
+  19, 19, 15, 15, 15, 19, 19, 19
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
 const int8 *volt_div_texts[3][7] =
 {
   { "5V/div", "2.5V/div", "1V/div", "500mV/div", "200mV/div", "100mV/div", "50mV/div" },
@@ -365,6 +493,12 @@ const int8 *volt_div_texts[3][7] =
 //                                       5V     2.5V       1V    500mV    200mV    100mV      50mV
 const int32 signal_adjusters[7] = { 7258042, 7341950, 7551720, 7551720, 7719536, 7719536, 15439072 };
 
+const uint32 probe_magnification_factors[3] = { 1, 10, 100 };
+
+const int8 *math_mode_texts[MATH_MODE_MAX + 1] = { "OFF", "A+B", "A-B", "AxB", "INT A", "DIF A" };
+
+const int8 *decoder_mode_texts[DECODER_MODE_MAX + 1] = { "OFF", "UART", "I2C", "SPI" };
+
 const uint32 sample_rate_settings[18] =
 {
          0,     //200MSa/s
@@ -638,6 +772,30 @@ const uint8 bmpheader[PICTURE_HEADER_SIZE] =
   0, 0, 0, 0,
 };
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//Header for compressed pictures. The coded data follows in blocks, each preceded by its 16 bit length
+
+const uint8 bmpcompressedheader[PICTURE_COMPRESSED_HEADER_SIZE] =
+{
+  //Header identifier
+  'F', 'N', 'P', 'C',
+
+  //Format version
+  1, 0, 0, 0,
+
+  //Picture width and height in pixels
+   800        & 0xFF,
+  (800 >>  8) & 0xFF,
+   480        & 0xFF,
+  (480 >>  8) & 0xFF,
+
+  //Size of the decoded pixel data
+   PICTURE_DATA_SIZE        & 0xFF,
+  (PICTURE_DATA_SIZE >>  8) & 0xFF,
+  (PICTURE_DATA_SIZE >> 16) & 0xFF,
+  (PICTURE_DATA_SIZE >> 24) & 0xFF,
+};
+
 
 
 
@@ -10,6 +10,9 @@
 #include "types.h"
 #include "font_structs.h"
 #include "fnirsi_1013d_scope.h"
+#include "display_lib.h"
+#include "file_compression.h"
+#include "protocol_decoder.h"
 #include "ff.h"
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -47,6 +50,15 @@
 
 #define VIEW_MAX_ITEMS                 1000
 
+#define VIEW_THUMBNAIL_SIGNATURE     0x4D554854     //"THUM"
+#define VIEW_THUMBNAIL_VERSION                1
+
+#define VIEW_THUMBNAIL_RECORD_SIZE          512
+#define VIEW_THUMBNAIL_CHUNK_RECORDS          8
+#define VIEW_SLOT_BITMAP_WORDS       ((VIEW_MAX_ITEMS + 31) / 32)
+
+#define VIEW_LINK_MAP_SIZE               64
+
 #define VIEW_ITEMS_PER_PAGE              16
 
 #define VIEW_TYPE_MASK                    1
@@ -96,6 +108,8 @@
 
 #define WAVEFORM_FILE_VERSION    0x01010101    //Version 1.1.1.1
 
+#define WAVEFORM_COMPRESSED_DATA 0x43574E46    //"FNWC" in the setup data signals the sample data is compressed
+
 #define WAVEFORM_FILE_ERROR             200
 
 #define THUMBNAIL_POINTER_RIGHT           0
@@ -108,6 +122,8 @@
 
 #define PICTURE_HEADER_MISMATCH           100
 
+#define PICTURE_COMPRESSED_HEADER_SIZE     16
+
 #define MESSAGE_SAVE_SUCCESSFUL           0
 #define MESSAGE_FILE_CREATE_FAILED        1
 #define MESSAGE_FILE_OPEN_FAILED          2
@@ -156,7 +172,7 @@
 
 #define CH_MENU_YPOS                        46
 #define CH_MENU_WIDTH                      183
-#define CH_MENU_HEIGHT                     252
+#define CH_MENU_HEIGHT                     376
 
 #define CH1_TOUCHED_COLOR            0x000000FF
 #define CH2_TOUCHED_COLOR            0x00FF0000
@@ -175,7 +191,7 @@
 #define ACQ_MENU_XPOS          ACQ_BUTTON_XPOS
 #define ACQ_MENU_YPOS                       46
 #define ACQ_MENU_WIDTH                     304
-#define ACQ_MENU_HEIGHT                    336
+#define ACQ_MENU_HEIGHT                    422
 
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -184,15 +200,19 @@
 
 typedef struct tagTouchCoords           TOUCHCOORDS,          *PTOUCHCOORDS;
 
-typedef struct tagDisplayPoints         DISPLAYPOINTS,        *PDISPLAYPOINTS;
-
 typedef struct tagChannelSettings       CHANNELSETTINGS,      *PCHANNELSETTINGS;
 typedef struct tagScopeSettings         SCOPESETTINGS,        *PSCOPESETTINGS;
 
 typedef struct tagThumbnailData         THUMBNAILDATA,        *PTHUMBNAILDATA;
+typedef struct tagThumbnailHeader       THUMBNAILHEADER,      *PTHUMBNAILHEADER;
+typedef struct tagThumbnailRecord       THUMBNAILRECORD,      *PTHUMBNAILRECORD;
 
 typedef struct tagPathInfo              PATHINFO,             *PPATHINFO;
 
+typedef struct tagSegment               SEGMENT,              *PSEGMENT;
+
+typedef struct tagFpgaBatchEntry        FPGABATCHENTRY,       *PFPGABATCHENTRY;
+
 typedef struct tagTimeCalcData          TIMECALCDATA,         *PTIMECALCDATA;
 typedef struct tagVoltCalcData          VOLTCALCDATA,         *PVOLTCALCDATA;
 typedef struct tagFreqCalcData          FREQCALCDATA,         *PFREQCALCDATA;
@@ -211,14 +231,6 @@ struct tagTouchCoords
 
 //----------------------------------------------------------------------------------------------------------------------------------
 
-struct tagDisplayPoints
-{
-  uint16 x;
-  uint16 y;  
-};
-
-//----------------------------------------------------------------------------------------------------------------------------------
-
 struct tagChannelSettings
 {
   //Settings
@@ -281,6 +293,11 @@ struct tagChannelSettings
   PDISPLAYPOINTS tracepoints;
   uint32         noftracepoints;
   
+  //Volts per div setting the samples in the trace buffer were taken with, and the factor for showing them on the set volts per div
+  //setting. On a stopped trace the two settings can differ
+  uint8          sampledvoltperdiv;
+  int32          displayadjuster;
+  
   //Sample gathering options
   uint8 checkfirstadc;
   uint8 enabletrigger;
@@ -310,6 +327,7 @@ struct tagScopeSettings
 {
   CHANNELSETTINGS channel1;
   CHANNELSETTINGS channel2;
+  CHANNELSETTINGS mathchannel;         //Virtual channel computed from the samples of the two real channels
 
   uint16 samplecount;       //Number of samples in trace buffer
   uint16 nofsamples;        //Number of samples to read from the FPGA
@@ -342,6 +360,12 @@ struct tagScopeSettings
   uint8 alwaystrigger50;
   uint8 xymodedisplay;
   uint8 confirmationmode;
+  uint8 persistence;                   //0 is off, otherwise the number of frames between halving the persistence intensities
+  uint8 filecompression;               //When set pictures and waveforms are saved in the compressed formats
+  uint8 acquisitionmode;               //Normal, block average, exponential average or high resolution
+  uint8 averageshift;                  //Number of acquisitions to average as power of two. Also sets the number of segments
+  uint8 mathmode;                      //Math channel off, or the function it shows
+  uint8 decodermode;                   //Protocol decoder off, or the protocol decoded from the traces
   
   uint8 timecursorsenable;
   uint8 voltcursorsenable;
@@ -375,6 +399,59 @@ struct tagThumbnailData
   uint8 channel2data[VIEW_ITEM_TRACE_POINTS];
 };
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//The thumbnail file starts with this header sector, followed by a sector per slot. The slot index is the file number minus one
+
+struct tagThumbnailHeader
+{
+  uint32 signature;
+  uint32 version;
+  uint32 sequence;                                   //Sequence number for the next saved item, used to order the items newest first
+  uint32 items;
+  uint32 slotbitmap[VIEW_SLOT_BITMAP_WORDS];         //A set bit signals the slot is in use
+  uint8  filler[VIEW_THUMBNAIL_RECORD_SIZE - 16 - (VIEW_SLOT_BITMAP_WORDS * 4)];
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagThumbnailRecord
+{
+  uint32        sequence;
+  THUMBNAILDATA thumbnail;
+  uint8         filler[VIEW_THUMBNAIL_RECORD_SIZE - 4 - sizeof(THUMBNAILDATA)];
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A single capture of the segmented acquisition mode with the settings it was taken with
+
+struct tagSegment
+{
+  uint32 timestamp;                  //Timer ticks (mS) at which the trigger was seen
+  uint32 sequence;
+  uint8  timeperdiv;
+  uint8  samplerate;
+  uint8  triggerchannel;
+  uint8  triggeredge;
+  uint16 triggerlevel;
+  uint8  channel1voltperdiv;
+  uint8  channel2voltperdiv;
+  uint16 havetrigger;                //Trigger position found in the samples
+  uint16 triggerindex;
+  float  triggerfraction;
+  uint8  channel1data[SEGMENT_SAMPLES];
+  uint8  channel2data[SEGMENT_SAMPLES];
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A setting write to the FPGA waiting in the batch
+
+struct tagFpgaBatchEntry
+{
+  uint8  command;
+  uint8  size;                       //Number of data bytes, 1, 2 or 4
+  uint32 data;
+};
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 struct tagPathInfo
@@ -470,6 +547,61 @@ CHANNELSETTINGS calibrationsettings;
 extern SCOPESETTINGS savedscopesettings1;
 extern SCOPESETTINGS savedscopesettings2;
 
+extern uint8  conversionpending;
+extern uint8  conversiontimeperdiv;
+extern uint32 conversionsettingschanges;
+
+extern volatile uint8  conversionwatch;
+extern volatile uint8  conversiondone;
+extern volatile uint32 conversiondoneticks;
+
+extern uint32 fpgasettingschanges;
+
+extern uint32 fpgashadowdata[FPGA_SHADOW_SIZE];
+extern uint8  fpgashadowvalid[FPGA_SHADOW_SIZE];
+
+extern FPGABATCHENTRY fpgabatch[FPGA_BATCH_SIZE];
+extern uint32 fpgabatchcount;
+extern uint8  fpgabatchopen;
+
+extern uint32 adcrawbuffer[ADC_MAX_SAMPLES / 4];
+extern uint8  adcclamptable[768];
+
+extern uint8  rollactive;
+extern uint8  rolltimeperdiv;
+extern uint8  rollredraw;
+extern uint32 rollindex;
+extern uint32 rollcount;
+extern uint32 rollnewsamples;
+extern uint32 rollnextticks;
+
+extern uint8  rollchannel1buffer[ROLL_MODE_SAMPLES];
+extern uint8  rollchannel2buffer[ROLL_MODE_SAMPLES];
+
+extern uint16 rolldisplaybuffer[SCREEN_SIZE];
+
+extern uint32 rolldisplaysettings[6];
+
+extern uint32 averagecount;
+extern uint8  averageresultvalid;
+extern uint32 averagesettings[6];
+
+extern uint32 *channel1averagebuffer;
+extern uint32 *channel2averagebuffer;
+
+extern uint32 *channel1averageresult;
+extern uint32 *channel2averageresult;
+
+extern PSEGMENT segmentblocks[SEGMENT_MAX_BLOCKS];
+extern uint32   segmentblockcount;
+extern uint32   segmentsize;
+extern uint32   segmentcount;
+extern uint32   segmentindex;
+extern uint32   segmentview;
+extern uint32   segmentsequence;
+extern uint8    segmentcapturing;
+extern uint8    segmentoverlay;
+
 extern uint32 channel1tracebuffer[750];
 
 extern DISPLAYPOINTS channel1pointsbuffer[730];
@@ -478,6 +610,16 @@ extern uint32 channel2tracebuffer[750];
 
 extern DISPLAYPOINTS channel2pointsbuffer[730];
 
+extern uint32 mathtracebuffer[750];
+
+extern DISPLAYPOINTS mathpointsbuffer[730];
+
+extern uint32 mathdisplayshift;
+
+extern DECODERRESULT decoderresult;
+
+extern DISPLAYPOINTS xymodepointsbuffer[750];
+
 extern uint16 thumbnailtracedata[730];
 
 extern uint16 system_ok;
@@ -502,10 +644,14 @@ extern int32 disp_first_sample;
 
 extern uint32 disp_have_trigger;
 extern uint32 disp_trigger_index;
+extern double disp_trigger_fraction;
 
 extern int32 disp_xstart;
 extern int32 disp_xend;
 
+extern int32  zoomoffset;
+extern double zoomxpospersample;
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //Distances of touch point to traces and cursors
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -513,6 +659,8 @@ extern int32 disp_xend;
 extern uint16 distance_channel_1;
 extern uint16 distance_channel_2;
 
+extern uint16 distance_math_channel;
+
 extern uint16 distance_trigger_level;
 
 extern uint16 distance_time_cursor_left;
@@ -527,10 +675,12 @@ extern uint16 distance_volt_cursor_bottom;
 
 extern uint16 previous_channel_1_offset;
 extern uint16 previous_channel_2_offset;
+extern uint16 previous_math_channel_offset;
 
 extern uint16 previous_trigger_level_offset;
 
 extern uint16 previous_trigger_point_position;
+extern int32  previous_zoom_offset;
 
 extern uint16 previous_left_time_cursor_position;
 extern uint16 previous_right_time_cursor_position;
@@ -558,6 +708,12 @@ extern const int8 *volt_div_texts[3][7];
 
 extern const int32 signal_adjusters[7];
 
+extern const uint32 probe_magnification_factors[3];
+
+extern const int8 *math_mode_texts[MATH_MODE_MAX + 1];
+
+extern const int8 *decoder_mode_texts[DECODER_MODE_MAX + 1];
+
 extern const uint32 timebase_settings[24];
 
 extern const uint32 sample_rate_settings[18];
@@ -582,6 +738,8 @@ extern const char    *thumbnail_file_names[2];
 
 extern const uint8 bmpheader[PICTURE_HEADER_SIZE];
 
+extern const uint8 bmpcompressedheader[PICTURE_COMPRESSED_HEADER_SIZE];
+
 extern const uint32 frequency_per_div[24];
 extern const uint32 sample_rate[18];
 
@@ -595,6 +753,15 @@ extern const int8 time_div_text_x_offsets[24];
 extern const int8 *acquisition_speed_texts[18];
 extern const int8 acquisition_speed_text_x_offsets[18];
 
+extern const int8 *acquisition_mode_texts[5];
+extern const int8 acquisition_mode_text_x_offsets[5];
+
+extern const int8 *average_count_texts[ACQUISITION_MAX_AVERAGE_SHIFT];
+extern const int8 average_count_text_x_offsets[ACQUISITION_MAX_AVERAGE_SHIFT];
+
+extern const int8 *segment_count_texts[ACQUISITION_MAX_AVERAGE_SHIFT];
+extern const int8 segment_count_text_x_offsets[ACQUISITION_MAX_AVERAGE_SHIFT];
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //For touch filtering on slider movement
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -609,6 +776,8 @@ extern FIL     viewfp;
 extern DIR     viewdir;
 extern FILINFO viewfileinfo;
 
+extern DWORD viewlinkmap[VIEW_LINK_MAP_SIZE];
+
 extern char viewfilename[32];
 
 extern uint8 viewactive;
@@ -632,6 +801,11 @@ extern THUMBNAILDATA viewthumbnaildata[VIEW_MAX_ITEMS];
 
 extern uint16 viewfilenumberdata[VIEW_MAX_ITEMS];
 
+extern uint32 viewthumbnailsequence[VIEW_MAX_ITEMS];
+
+extern THUMBNAILHEADER viewthumbnailheader;
+extern THUMBNAILRECORD viewthumbnailrecords[VIEW_THUMBNAIL_CHUNK_RECORDS];
+
 extern uint8 viewbitmapheader[PICTURE_HEADER_SIZE];
 
 extern uint32 viewfilesetupdata[VIEW_NUMBER_OF_SETTINGS];
@@ -648,6 +822,14 @@ extern uint16 displaybuffer2[SCREEN_SIZE];
 
 extern uint16 gradientbuffer[SCREEN_HEIGHT];
 
+//Defined as 32 bits to keep it word aligned for handling four pixels at a time
+extern uint32 persistencebuffer[(TRACE_WINDOW_WIDTH * TRACE_WINDOW_HEIGHT) / 4];
+
+extern uint16 persistencecolors[256];
+
+extern uint32 persistenceframes;
+extern uint8  persistenceactive;
+
 //----------------------------------------------------------------------------------------------------------------------------------
 //Fonts
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -672,6 +854,8 @@ extern const uint8 trigger_50_percent_icon[];
 extern const uint8 baseline_calibration_icon[];
 extern const uint8 x_y_mode_display_icon[];
 extern const uint8 confirmation_icon[];
+extern const uint8 persistence_icon[];
+extern const uint8 file_compression_icon[];
 extern const uint8 return_arrow_icon[];
 extern const uint8 left_pointer_icon[];
 extern const uint8 right_pointer_icon[];
@@ -0,0 +1,197 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "bl_boot_image.h"
+#include "bl_sd_card_interface.h"
+#include "lz4_decompress.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Table for the byte wise CRC32 calculation. Filled in on startup to keep the bootloader small
+uint32 crc32_table[256];
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void boot_image_crc32_init(void)
+{
+  uint32 crc;
+  uint32 i;
+  uint32 j;
+
+  //Calculate the table for the reversed 0x04C11DB7 polynomial
+  for(i=0;i<256;i++)
+  {
+    crc = i;
+
+    for(j=0;j<8;j++)
+    {
+      if(crc & 1)
+      {
+        crc = (crc >> 1) ^ 0xEDB88320;
+      }
+      else
+      {
+        crc >>= 1;
+      }
+    }
+
+    crc32_table[i] = crc;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Continue a CRC32 over the next part of the data. Start with zero for the first part
+
+uint32 boot_image_crc32(uint32 crc, uint8 *data, uint32 length)
+{
+  crc = ~crc;
+
+  while(length--)
+  {
+    crc = crc32_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  }
+
+  return(~crc);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Load a boot image from the SD card. The payload is read in parts with the DMA, and the CRC is calculated over each part while the next
+//one is read. A compressed payload is read into the staging area and unpacked to the load address. On success the load address is returned
+
+int32 boot_image_load(uint32 sector, uint8 *staging, uint32 *address)
+{
+  uint32           buffer[128];
+  PBOOTIMAGEHEADER header = (PBOOTIMAGEHEADER)buffer;
+  uint8           *dest;
+  uint8           *next;
+  uint32           blocks;
+  uint32           count;
+  uint32           nextcount = 0;
+  uint32           checked = 0;
+  uint32           bytes;
+  uint32           crc = 0;
+
+  //Get the header sector
+  if(sd_card_read(sector, 1, (uint8 *)buffer) != SD_OK)
+  {
+    return(BOOT_IMAGE_ERROR);
+  }
+
+  //Check if there is a boot image
+  if(memcmp(header->signature, BOOT_IMAGE_SIGNATURE, BOOT_IMAGE_SIGNATURE_SIZE) != 0)
+  {
+    return(BOOT_IMAGE_NOT_FOUND);
+  }
+
+  //Make sure the header itself is valid
+  if((header->version != BOOT_IMAGE_VERSION) || (boot_image_crc32(0, (uint8 *)header, (uint32)&header->headercrc - (uint32)header) != header->headercrc) || (header->length == 0))
+  {
+    return(BOOT_IMAGE_CRC_ERROR);
+  }
+
+  //A compressed payload goes into the staging area first
+  if(header->flags & BOOT_IMAGE_FLAG_LZ4)
+  {
+    //The staging area is not allowed to overlap the program
+    if(((staging + header->length) > (uint8 *)header->loadaddress) && (staging < ((uint8 *)header->loadaddress + header->size)))
+    {
+      return(BOOT_IMAGE_ERROR);
+    }
+
+    dest = staging;
+  }
+  else
+  {
+    dest = (uint8 *)header->loadaddress;
+  }
+
+  //Skip the header sector
+  sector++;
+  blocks = (header->length + 511) / 512;
+
+  //Start reading the first part
+  count = blocks;
+
+  if(count > BOOT_IMAGE_CHUNK_BLOCKS)
+  {
+    count = BOOT_IMAGE_CHUNK_BLOCKS;
+  }
+
+  if(sd_card_start_read(sector, count, dest) != SD_OK)
+  {
+    //Make sure nothing is still being read when the caller falls back on the SPI flash
+    sd_card_stop_transfer();
+    return(BOOT_IMAGE_ERROR);
+  }
+
+  //Handle all the parts
+  while(blocks)
+  {
+    //Wait for the current part to arrive
+    if(sd_card_wait_transfer() != SD_OK)
+    {
+      sd_card_stop_transfer();
+      return(BOOT_IMAGE_ERROR);
+    }
+
+    //Skip the part that is read
+    sector += count;
+    blocks -= count;
+    next = dest + (count * 512);
+
+    //Start reading the next part before checking this one
+    if(blocks)
+    {
+      nextcount = blocks;
+
+      if(nextcount > BOOT_IMAGE_CHUNK_BLOCKS)
+      {
+        nextcount = BOOT_IMAGE_CHUNK_BLOCKS;
+      }
+
+      if(sd_card_start_read(sector, nextcount, next) != SD_OK)
+      {
+        sd_card_stop_transfer();
+        return(BOOT_IMAGE_ERROR);
+      }
+    }
+
+    //Only the payload bytes count. The last sector can have some filler
+    bytes = count * 512;
+
+    if(bytes > (header->length - checked))
+    {
+      bytes = header->length - checked;
+    }
+
+    //Add this part to the CRC while the next part is read
+    crc = boot_image_crc32(crc, dest, bytes);
+    checked += bytes;
+
+    dest = next;
+    count = nextcount;
+  }
+
+  //Check if the payload is intact
+  if(crc != header->crc)
+  {
+    return(BOOT_IMAGE_CRC_ERROR);
+  }
+
+  //Unpack the program when needed
+  if(header->flags & BOOT_IMAGE_FLAG_LZ4)
+  {
+    if(lz4_decompress(staging, header->length, (uint8 *)header->loadaddress, header->size) != (int32)header->size)
+    {
+      return(BOOT_IMAGE_ERROR);
+    }
+  }
+
+  //Hand back where to start the program
+  *address = header->loadaddress;
+
+  return(BOOT_IMAGE_OK);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
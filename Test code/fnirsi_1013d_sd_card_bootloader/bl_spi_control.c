@@ -0,0 +1,171 @@
+//--------------------------------------------------------------------------------------
+
+#include "bl_spi_control.h"
+#include "ccu_control.h"
+#include "gpio_control.h"
+
+//--------------------------------------------------------------------------------------
+
+void sys_spi_flash_init(void)
+{
+  //Configure PC0, PC1, PC2 and PC3 for SPI0
+  *PORTC_CFG0_REG = PORTC_CFG0_PIN_3_SPI0_MOSI | PORTC_CFG0_PIN_2_SPI0_MISO | PORTC_CFG0_PIN_1_SPI0_CS | PORTC_CFG0_PIN_0_SPI0_CLK;
+
+  //De-assert SPI0 reset
+  *CCU_BUS_SOFT_RST0 |= CCU_BSRR0_SPI0_RST;
+
+  //Open the SPI0 bus gate
+  *CCU_BUS_CLK_GATE0 |= CCU_BCGR0_SPI0_EN;
+  
+  //15-11-2021
+  //Some FLASH chips seem to have an issue with to high a speed!! Lowered it to 2 instead of 1, which does the trick
+  //In the main program init this is written with 0x00001001, so clock seems to be set faster there
+  //Tested this and it works so kept on that setting (zero is to fast)
+  //Set SPI0 clock rate control register to AHB_CLK divided by 4 = (2 * (1 + 1))
+  *SPI0_CCR = SPI_CCR_DRS_DIV_2 | SPI_CCR_CDR2(2);
+
+  //Enable SPI0 in master mode with transmit pause enabled and do a soft reset
+  *SPI0_GCR = SPI_GCR_SRST | SPI_GCR_TP_EN | SPI_GCR_MODE_MASTER | SPI_GCR_MODE_EN;
+
+  //Wait for it to be reset  
+  while(*SPI0_GCR & SPI_GCR_SRST);
+
+  //In the main program init it is and-ed with 0xFFFFFFFC | 0x44
+  //Set slave select level high, and controlled by software with signal polarity active low
+  *SPI0_TCR = SPI_TCR_SS_LEVEL_HIGH | SPI_TCR_SS_OWNER_SOFT | SPI_TCR_SPOL_ACTIVE_LOW;
+  
+  //In the main program init it only resets the fifos. 0x80008000
+  //Reset the FIFO's
+  *SPI0_FCR = SPI_FCR_TX_FIFO_RST | SPI_FCR_TX_TRIG_LEV_64 | SPI_FCR_RX_FIFO_RST | SPI_FCR_RX_TRIG_LEV_1;
+}
+
+//--------------------------------------------------------------------------------------
+
+void sys_spi_flash_exit(void)
+{
+  //Disable the SPI0 controller and revert back to slave mode
+  *SPI0_GCR &= ~(SPI_GCR_MODE_MASTER | SPI_GCR_MODE_EN);
+}
+
+//--------------------------------------------------------------------------------------
+
+void sys_spi_flash_read(int addr, unsigned char *buffer, int length)
+{
+  unsigned char command[4];
+
+  //Fill in the command buffer with the read command and the address to read from
+  command[0] = 0x03;
+  command[1] = (unsigned char)(addr >> 16);
+  command[2] = (unsigned char)(addr >> 8);
+  command[3] = (unsigned char)(addr >> 0);
+  
+  //Assert the pre selected CS0 line
+  *SPI0_TCR &= ~SPI_TCR_SS_LEVEL_HIGH;
+  
+  //Write the read command with the memory address to read from
+  sys_spi_write(command, 4);
+
+  //Read the data into the receive buffer
+  sys_spi_read(buffer, length);
+  
+  //De-assert the pre selected CS0 line
+  *SPI0_TCR |= SPI_TCR_SS_LEVEL_HIGH;
+}
+
+//--------------------------------------------------------------------------------------
+//Send a buffer full of data to the SPI, but do it in chunks of max 64 bytes (FIFO length)
+//--------------------------------------------------------------------------------------
+
+void sys_spi_write(unsigned char *buffer, int length)
+{
+  int i;
+  int cnt;
+  
+  //Send all the bytes in smaller chunks as needed
+  while(length)
+  {
+    //Need to do it in chunks of max 64 bytes
+    if(length <= 64)
+      cnt = length;
+    else
+      cnt = 64;
+    
+    //Set the number of bytes to transfer in this burst
+    *SPI0_MBC = cnt;
+
+    //Set master transmit count with the number of bytes to transmit
+    *SPI0_MTC = cnt;
+
+    //Set the master single mode transmit counter to the same number of bytes to transmit
+    *SPI0_BCC = cnt;
+
+    //Load the bytes into the FIFO via the transmit byte register
+    for(i=0;i<cnt;++i)
+      *SPI0_TXD_BYTE = *buffer++;
+
+    //Start the transfer
+    *SPI0_TCR |= SPI_TCR_XCH_START;
+    
+    //Take of the chunk send
+    length -= cnt;
+
+    //Wait till SPI is done with writing
+    //Is needed for the control of the CS line. Can't change it's level while the SPI is still busy
+    while(*SPI0_TCR & SPI_TCR_XCH_START);
+
+    //Clear the receive FIFO to drop what ever is in there
+    //Without this it will not continue. The SPI seems to stop transmission when the receive fifo is full
+    *SPI0_FCR |= SPI_FCR_RX_FIFO_RST;
+
+    //Make sure it is cleared
+    while(*SPI0_FCR & SPI_FCR_RX_FIFO_RST);
+  }
+}
+
+//--------------------------------------------------------------------------------------
+//Read a buffer of bytes from the SPI, but do it in chunks of max 64 bytes (FIFO length)
+//--------------------------------------------------------------------------------------
+
+void sys_spi_read(unsigned char *buffer, int length)
+{
+  int i;
+  int cnt;
+
+  //Clear the receive FIFO to drop what ever is left in there
+  *SPI0_FCR |= SPI_FCR_RX_FIFO_RST;
+  
+  //Make sure it is cleared
+  while(*SPI0_FCR & SPI_FCR_RX_FIFO_RST);
+  
+  //No bytes to transmit
+  *SPI0_MTC = 0;
+  *SPI0_BCC = 0;
+  
+  //Receive all the bytes in smaller chunks as needed  
+  while(length)
+  {
+    //Check if more then 64 bytes (FIFO size) to read
+    if(length <= 64)
+      cnt = length;
+    else
+      cnt = 64;
+    
+    //Set the number of bytes to read in this burst
+    *SPI0_MBC = cnt;
+    
+    //Start the transfer
+    *SPI0_TCR |= SPI_TCR_XCH_START;
+    
+    //Wait until all the bytes have been received
+    while((*SPI0_FSR & 0xFF) < cnt);
+    
+    for(i=0;i<cnt;i++)
+    {
+      *buffer++ = *SPI0_RXD_BYTE;
+    }
+
+    length -= cnt;
+  }
+}
+
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,109 @@
+#include "lz4_decompress.h"
+
+//--------------------------------------------------------------------------------------
+//Check if the header read from flash is the one of a compressed main program
+int lz4_is_compressed_image(unsigned char *header)
+{
+  unsigned char *magic = (unsigned char *)LZ4_IMAGE_MAGIC;
+  int i;
+  
+  //Compare the magic bytes
+  for(i=0;i<LZ4_IMAGE_MAGIC_SIZE;i++)
+  {
+    if(header[LZ4_IMAGE_MAGIC_OFFSET + i] != magic[i])
+      return(0);
+  }
+  
+  return(1);
+}
+
+//--------------------------------------------------------------------------------------
+//Decompress a single LZ4 block. Returns the number of bytes written to the destination
+//or -1 when the data is not valid or does not fit
+int lz4_decompress(unsigned char *source, int length, unsigned char *dest, int size)
+{
+  unsigned char *sptr = source;
+  unsigned char *send = source + length;
+  unsigned char *dptr = dest;
+  unsigned char *dend = dest + size;
+  unsigned char *mptr;
+  unsigned int   token;
+  unsigned int   count;
+  unsigned int   offset;
+  unsigned int   byte;
+  
+  //Handle all the sequences in the block
+  while(sptr < send)
+  {
+    //Each sequence starts with a token holding the literal length and the match length
+    token = *sptr++;
+    
+    //Get the number of literals. When the field is 15 more length bytes follow
+    count = token >> 4;
+    
+    if(count == 15)
+    {
+      do
+      {
+        if(sptr >= send)
+          return(-1);
+        
+        byte = *sptr++;
+        count += byte;
+      } while(byte == 255);
+    }
+    
+    //Make sure the literals are available and fit the destination
+    if((count > (unsigned int)(send - sptr)) || (count > (unsigned int)(dend - dptr)))
+      return(-1);
+    
+    //Copy the literals
+    while(count--)
+      *dptr++ = *sptr++;
+    
+    //The last sequence only has literals
+    if(sptr >= send)
+      break;
+    
+    //Get the offset of the match
+    if((send - sptr) < 2)
+      return(-1);
+    
+    offset = sptr[0] | (sptr[1] << 8);
+    sptr += 2;
+    
+    //The match needs to be within the data already decompressed
+    if((offset == 0) || (offset > (unsigned int)(dptr - dest)))
+      return(-1);
+    
+    //Get the length of the match. When the field is 15 more length bytes follow
+    count = token & 0x0F;
+    
+    if(count == 15)
+    {
+      do
+      {
+        if(sptr >= send)
+          return(-1);
+        
+        byte = *sptr++;
+        count += byte;
+      } while(byte == 255);
+    }
+    
+    //A match is at least four bytes
+    count += 4;
+    
+    //Make sure it fits the destination
+    if(count > (unsigned int)(dend - dptr))
+      return(-1);
+
+    //Copy the match byte by byte, since it can overlap the bytes being written
+    mptr = dptr - offset;
+    
+    while(count--)
+      *dptr++ = *mptr++;
+  }
+  
+  return(dptr - dest);
+}
@@ -36,9 +36,12 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 # Object Files
 OBJECTFILES= \
 	${OBJECTDIR}/_ext/5fc58e7f/bl_sd_card_interface.o \
+	${OBJECTDIR}/bl_boot_image.o \
+	${OBJECTDIR}/bl_spi_control.o \
 	${OBJECTDIR}/ccu_control.o \
 	${OBJECTDIR}/dram_control.o \
 	${OBJECTDIR}/fnirsi_1013d_sd_card_bootloader.o \
+	${OBJECTDIR}/lz4_decompress.o \
 	${OBJECTDIR}/memcmp.o \
 	${OBJECTDIR}/memcpy.o \
 	${OBJECTDIR}/memset.o \
@@ -74,6 +77,16 @@ ${OBJECTDIR}/_ext/5fc58e7f/bl_sd_card_interface.o: ../fnirsi_1013d_firmware_back
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5fc58e7f/bl_sd_card_interface.o ../fnirsi_1013d_firmware_backup_startup/bl_sd_card_interface.c
 
+${OBJECTDIR}/bl_boot_image.o: bl_boot_image.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/bl_boot_image.o bl_boot_image.c
+
+${OBJECTDIR}/bl_spi_control.o: bl_spi_control.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/bl_spi_control.o bl_spi_control.c
+
 ${OBJECTDIR}/ccu_control.o: ccu_control.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -89,6 +102,11 @@ ${OBJECTDIR}/fnirsi_1013d_sd_card_bootloader.o: fnirsi_1013d_sd_card_bootloader.
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/fnirsi_1013d_sd_card_bootloader.o fnirsi_1013d_sd_card_bootloader.c
 
+${OBJECTDIR}/lz4_decompress.o: lz4_decompress.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/lz4_decompress.o lz4_decompress.c
+
 ${OBJECTDIR}/memcmp.o: memcmp.s
 	${MKDIR} -p ${OBJECTDIR}
 	$(AS) $(ASFLAGS) -o ${OBJECTDIR}/memcmp.o memcmp.s
@@ -0,0 +1,57 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#ifndef BOOT_IMAGE_H
+#define BOOT_IMAGE_H
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include "types.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//The header is in the first sector of the image and the payload starts on the next sector
+//The signature is on the same place as in the eGON header, so both can be told apart from the same sector
+#define BOOT_IMAGE_SIGNATURE            "FNBOOTIM"
+#define BOOT_IMAGE_SIGNATURE_SIZE                8
+#define BOOT_IMAGE_VERSION                       1
+
+#define BOOT_IMAGE_FLAG_LZ4             0x00000001      //Payload is a single LZ4 block
+
+//Number of sectors read per command. While one part is read the CRC is calculated over the previous part
+#define BOOT_IMAGE_CHUNK_BLOCKS                128
+
+//Results of loading an image
+#define BOOT_IMAGE_OK                            0
+#define BOOT_IMAGE_NOT_FOUND                     1
+#define BOOT_IMAGE_ERROR                        -1
+#define BOOT_IMAGE_CRC_ERROR                    -2
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct tagBootImageHeader       BOOTIMAGEHEADER, *PBOOTIMAGEHEADER;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct tagBootImageHeader
+{
+  uint32 jump;                  //Not used
+  uint8  signature[8];
+  uint32 version;
+  uint32 loadaddress;           //Where the program needs to be in DRAM. Also the start address
+  uint32 length;                //Number of payload bytes stored after the header sector
+  uint32 size;                  //Number of program bytes after unpacking. Same as length when not compressed
+  uint32 crc;                   //CRC32 of the stored payload
+  uint32 flags;
+  uint32 headercrc;             //CRC32 of the header fields above
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void boot_image_crc32_init(void);
+uint32 boot_image_crc32(uint32 crc, uint8 *data, uint32 length);
+
+int32 boot_image_load(uint32 sector, uint8 *staging, uint32 *address);
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#endif /* BOOT_IMAGE_H */
@@ -29,6 +29,9 @@ SD_CARD_DATA    sd_data;
 
 uint32 sd_buffer[128];  //512B data buffer. Defined as uint32 to assure dword alignment
 
+SD_CARD_TRANSFER    sd_transfer;
+SD_IDMA_DESCRIPTOR  sd_descriptors[SD_DMA_DESCRIPTORS];
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 int32 sd_card_init(void)
@@ -312,16 +315,44 @@ int32 sd_card_init(void)
 int32 sd_card_read(uint32 sector, uint32 blocks, uint8 *buffer)
 {
   int32 result;
-  
+
+  //Start the transfer
+  if((result = sd_card_start_read(sector, blocks, buffer)) != SD_OK)
+  {
+    return(result);
+  }
+
+  //Wait for it to finish
+  return(sd_card_wait_transfer());
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Sector reads are done with the internal DMA controller of the SD interface in the background.
+//A read is started with sd_card_start_read, and then moved along with sd_card_transfer_busy until it is done.
+//This allows the caller to work on the data already loaded while the next part comes in. Starting a new read waits for the previous one.
+//Reads are split into multiple block commands of at most SD_DMA_MAX_BLOCKS. Buffers that are not 32 bit aligned go through sd_buffer.
+//The MMU is not enabled, so the data cache is not used for the buffers and no cache maintenance is needed.
+
+int32 sd_card_start_read(uint32 sector, uint32 blocks, uint8 *buffer)
+{
+  int32 result;
+
+  //Only one transfer can be in flight, so finish the previous one first
+  sd_card_wait_transfer();
+
   //Check if valid buffer given
   if(buffer == 0)
+  {
     return(SD_ERROR_INVALID_BUFFER);
-  
+  }
+
   //This might be wrong. Need testing with last sector!!!!!
   //Check if last bytes to read in range of the card sectors
-  if((sector + blocks - 1) > cardsectors)
+  if((blocks == 0) || ((sector + blocks - 1) > cardsectors))
+  {
     return(SD_ERROR_SECTOR_OUT_OF_RANGE);
-  
+  }
+
   //Send card select command
   sd_command.cmdidx    = 7;
   sd_command.cmdarg    = cardrca;
@@ -329,54 +360,310 @@ int32 sd_card_read(uint32 sector, uint32 blocks, uint8 *buffer)
   result = sd_card_send_command(&sd_command, 0);
 
   //Only continue when card selected without errors
-  if(result == SD_OK)
+  if(result != SD_OK)
   {
-    //Prepare data buffer for reading
-    sd_data.blocks    = blocks;
-    sd_data.blocksize = 512;
-    sd_data.flags     = SD_DATA_READ;
-    sd_data.data      = buffer;
-    
-    //Send read command based on number of blocks
-    if(blocks == 1)
+    return(result);
+  }
+
+  //Setup the transfer
+  sd_transfer.sector = sector;
+  sd_transfer.blocks = blocks;
+  sd_transfer.buffer = buffer;
+  sd_transfer.result = SD_OK;
+  sd_transfer.active = 1;
+
+  //Start the first command
+  result = sd_card_start_chunk();
+
+  //On failure end the transfer
+  if(result != SD_OK)
+  {
+    sd_card_end_transfer(result);
+  }
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_start_chunk(void)
+{
+  uint8 *buffer = sd_transfer.buffer;
+  uint32 blocks = sd_transfer.blocks;
+
+  //Check if the buffer is 32 bit aligned
+  if((uint32)buffer & 3)
+  {
+    //Not aligned so the data needs to go through the aligned bounce buffer
+    if(blocks > SD_BOUNCE_MAX_BLOCKS)
     {
-      //Set read single block command
-      sd_command.cmdidx = 17;
+      blocks = SD_BOUNCE_MAX_BLOCKS;
     }
-    else
+
+    buffer = (uint8 *)sd_buffer;
+  }
+  else if(blocks > SD_DMA_MAX_BLOCKS)
+  {
+    //Limit on what the descriptor table can handle
+    blocks = SD_DMA_MAX_BLOCKS;
+  }
+
+  //Remember the size of this command for when it is done
+  sd_transfer.chunk = blocks;
+
+  //Setup the descriptors and the controller for the transfer
+  sd_card_setup_dma(buffer, blocks * 512);
+
+  //Prepare data information for the transfer
+  sd_data.blocks    = blocks;
+  sd_data.blocksize = 512;
+  sd_data.flags     = SD_DATA_READ | SD_DATA_DMA;
+  sd_data.data      = buffer;
+
+  //Send read command based on number of blocks
+  if(blocks == 1)
+  {
+    //Set read single block command
+    sd_command.cmdidx = 17;
+  }
+  else
+  {
+    //Set read multiple blocks command
+    sd_command.cmdidx = 18;
+  }
+
+  //Indicate which sector to start reading from
+  if(cardtype != SD_CARD_TYPE_SDHC)
+  {
+    //For non HC type cards use the byte address
+    sd_command.cmdarg = sd_transfer.sector << 9;
+  }
+  else
+  {
+    //For HC type card use the sector address
+    sd_command.cmdarg = sd_transfer.sector;
+  }
+
+  //Number of status checks before giving up on this command
+  sd_transfer.timeout = SD_TRANSFER_TIMEOUT;
+
+  //Card allowed to be busy. Only the command is handled here, the data is moved by the DMA controller
+  sd_command.resp_type = SD_RESPONSE_BUSY | SD_RESPONSE_CRC | SD_RESPONSE_PRESENT;
+  return(sd_card_send_command(&sd_command, &sd_data));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void sd_card_setup_dma(uint8 *buffer, uint32 length)
+{
+  PSD_IDMA_DESCRIPTOR descriptor = sd_descriptors;
+  uint32 size;
+
+  //Fill in a descriptor for every part of the buffer
+  while(length)
+  {
+    //Limit on the size one descriptor can handle
+    size = length;
+
+    if(size > SD_DMA_DESCRIPTOR_SIZE)
     {
-      //Set read multiple blocks command
-      sd_command.cmdidx = 18;
+      size = SD_DMA_DESCRIPTOR_SIZE;
     }
-    
-    //Indicate which sector to start reading from
-    if(cardtype != SD_CARD_TYPE_SDHC)
+
+    //Chained descriptor owned by the DMA controller, without interrupt on completion
+    descriptor->config = SD_IDMA_DES_OWN | SD_IDMA_DES_CH | SD_IDMA_DES_DIC;
+    descriptor->size   = size;
+    descriptor->buffer = (uint32)buffer;
+    descriptor->next   = (uint32)(descriptor + 1);
+
+    //Next part of the buffer
+    buffer += size;
+    length -= size;
+
+    //Check if there is more to do
+    if(length)
     {
-      //For non HC type cards use the byte address
-      sd_command.cmdarg = sector << 9;
+      descriptor++;
     }
-    else
+  }
+
+  //Mark the first and the last descriptor
+  sd_descriptors[0].config |= SD_IDMA_DES_FD;
+  descriptor->config |= SD_IDMA_DES_LD | SD_IDMA_DES_ER;
+  descriptor->config &= ~SD_IDMA_DES_DIC;
+  descriptor->next = 0;
+
+  //Let the DMA controller access the FIFO instead of the cpu and reset it
+  *SD0_GCTL = (*SD0_GCTL & ~SD_GCTL_FIFO_ACCESS_AHB) | SD_GCTL_DMA_ENB | SD_GCTL_DMA_RST;
+
+  //Reset the internal DMA controller
+  *SD0_DMAC = SD_DMAC_SOFT_RST;
+
+  //Clear the status and don't use interrupts
+  *SD0_IDST = SD_IDST_CLEAR_ALL;
+  *SD0_IDIE = 0;
+
+  //Set the descriptor list and start the controller with fixed bursts
+  *SD0_DLBA = (uint32)sd_descriptors;
+  *SD0_DMAC = SD_DMAC_FIX_BURST | SD_DMAC_IDMA_ON;
+
+  //Burst size and FIFO thresholds for the DMA transfers
+  *SD0_FWLR = SD_FWLR_DMA_SETTING;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_transfer_busy(void)
+{
+  uint32 status;
+  uint32 done;
+  int32  result;
+
+  //Nothing to do when no transfer is in flight
+  if(sd_transfer.active == 0)
+  {
+    return(0);
+  }
+
+  //Get the current interrupt status
+  status = *SD0_RISR;
+
+  //Depending on the number of blocks either auto command done or data transfered signals the end of the command
+  if(sd_transfer.chunk > 1)
+  {
+    done = SD_RINT_AUTO_COMMAND_DONE;
+  }
+  else
+  {
+    done = SD_RINT_DATA_OVER;
+  }
+
+  //Check on errors
+  if(status & SD_RINT_INTERRUPT_ERROR_BITS)
+  {
+    sd_card_end_transfer(SD_ERROR);
+    return(0);
+  }
+
+  //Check if the command is done and the card is no longer busy
+  if(((status & done) == 0) || (*SD0_STAR & SD_STATUS_CARD_DATA_BUSY))
+  {
+    //Check on timeout
+    if(--sd_transfer.timeout == 0)
     {
-      //For HC type card use the sector address
-      sd_command.cmdarg = sector;
+      sd_card_end_transfer(SD_ERROR_TIMEOUT);
+      return(0);
     }
-    
-    //Card allowed to be busy.
-    sd_command.resp_type = SD_RESPONSE_BUSY | SD_RESPONSE_CRC | SD_RESPONSE_PRESENT;
-    result = sd_card_send_command(&sd_command, &sd_data);
-    
-    //Deselect the card if all went well
-    if(result == SD_OK)
+
+    //Still busy
+    return(1);
+  }
+
+  //Stop the DMA controller and give the FIFO back to the cpu
+  sd_card_stop_dma();
+
+  //Clear all raw interrupts
+  *SD0_RISR = 0xFFFFFFFF;
+
+  //When the data went through the bounce buffer it needs to be copied to the actual buffer
+  if((uint32)sd_transfer.buffer & 3)
+  {
+    memcpy(sd_transfer.buffer, sd_buffer, sd_transfer.chunk * 512);
+  }
+
+  //Move on to the next part of the transfer
+  sd_transfer.buffer += sd_transfer.chunk * 512;
+  sd_transfer.sector += sd_transfer.chunk;
+  sd_transfer.blocks -= sd_transfer.chunk;
+
+  //Check if there is more to do
+  if(sd_transfer.blocks)
+  {
+    //Start the next command
+    if((result = sd_card_start_chunk()) != SD_OK)
     {
-      //Send deselect card command to the card
-      sd_command.cmdidx    = 7;
-      sd_command.cmdarg    = 0;
-      sd_command.resp_type = SD_RESPONSE_NONE;
-      result = sd_card_send_command(&sd_command, 0);
+      sd_card_end_transfer(result);
+      return(0);
     }
+
+    //Still busy
+    return(1);
   }
-  
-  return(result);
+
+  //All done
+  sd_card_end_transfer(SD_OK);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 sd_card_wait_transfer(void)
+{
+  //Keep the transfer going until it is done. The timeout is handled in the busy check
+  while(sd_card_transfer_busy());
+
+  return(sd_transfer.result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Stop a transfer that is still in flight when its data is no longer needed, so the DMA controller does not write into memory that is
+//taken into use for something else
+
+void sd_card_stop_transfer(void)
+{
+  if(sd_transfer.active)
+  {
+    sd_card_end_transfer(SD_ERROR);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void sd_card_end_transfer(int32 result)
+{
+  //Check if there was an error
+  if(result < 0)
+  {
+    //Stop the DMA controller
+    sd_card_stop_dma();
+
+    //Reset the DMA, FIFO and controller
+    *SD0_GCTL |= (SD_GCTL_DMA_RST | SD_GCTL_FIFO_RST | SD_GCTL_SOFT_RST);
+
+    sd_card_update_clock();
+
+    //Clear all raw interrupts
+    *SD0_RISR = 0xFFFFFFFF;
+  }
+
+  //Transfer no longer in flight
+  sd_transfer.active = 0;
+
+  //Send deselect card command to the card
+  sd_command.cmdidx    = 7;
+  sd_command.cmdarg    = 0;
+  sd_command.resp_type = SD_RESPONSE_NONE;
+
+  //Keep the first error
+  if((sd_card_send_command(&sd_command, 0) != SD_OK) && (result == SD_OK))
+  {
+    result = SD_ERROR;
+  }
+
+  sd_transfer.result = result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void sd_card_stop_dma(void)
+{
+  //Stop the internal DMA controller and clear its status
+  *SD0_DMAC = 0;
+  *SD0_IDST = SD_IDST_CLEAR_ALL;
+
+  //Give the FIFO back to the cpu
+  *SD0_GCTL = (*SD0_GCTL & ~SD_GCTL_DMA_ENB) | SD_GCTL_FIFO_ACCESS_AHB | SD_GCTL_FIFO_RST;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -970,10 +1257,24 @@ int32 sd_card_send_command(PSD_CARD_COMMAND command, PSD_CARD_DATA data)
   //See if data needs to be written or read
   if(data)
   {
-    //The original code is different!!!!!
-    //For larger blobs of data it uses DMA
-    
-    //Send or receive the data using the cpu
+    //Check if the DMA controller handles the data
+    if(data->flags & SD_DATA_DMA)
+    {
+      //Only wait for the command to finish. The data is handled in the background and checked with sd_card_transfer_busy
+      if((error = sd_rint_wait(1000, SD_RINT_COMMAND_DONE)) == SD_OK)
+      {
+        //Only clear the command done flag, since the data flags are needed to see when the transfer is done
+        *SD0_RISR = SD_RINT_COMMAND_DONE;
+
+        return(SD_OK);
+      }
+
+      //Stop the DMA controller on an error
+      sd_card_stop_dma();
+      goto out;
+    }
+
+    //Send or receive small amounts of data using the cpu
     if((error = sd_send_data(data)))
     {
       goto out;
@@ -5,18 +5,43 @@
 #include "dram_control.h"
 #include "bl_fpga_control.h"
 #include "bl_sd_card_interface.h"
+#include "bl_spi_control.h"
+#include "bl_boot_image.h"
+#include "lz4_decompress.h"
 
 #include <string.h>
 
+//----------------------------------------------------------------------------------------------------------------------------------
+//
+//The program on the SD card can either be an eGON image or a boot image with a CRC check (bl_boot_image.h).
+//When the SD card or the boot image fails, the scope program in the SPI flash is started instead.
+//
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define PROGRAM_START_SECTOR      80
+
+#define PROGRAM_ADDRESS           0x80000000
+
+//Compressed images are read here first. Gives 8MB at the end of the DRAM
+#define STAGING_ADDRESS           0x81800000
+
+//Location of the scope program in the SPI flash
+#define FLASH_PROGRAM_HEADER      0x27000
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 load_egon_program(unsigned char *buffer);
+void boot_from_spi_flash(void);
+void start_program(unsigned int address);
+
 //----------------------------------------------------------------------------------------------------------------------------------
 
 int main(void)
 {
-  //Buffer for reading header from flash
+  //Buffer for reading sector from sd card
   unsigned char buffer[512];
-  unsigned int length;
-  unsigned int blocks;
-  int i,j;
+  unsigned int address = PROGRAM_ADDRESS;
+  int32 result;
   
   //Initialize the clock system
   sys_clock_init();
@@ -31,11 +56,30 @@ int main(void)
   //Initialize FPGA (PORT E)
   fpga_init();
   
-  //Got some time to spare
-  for(j=0;j<1000;j++)
+  //Prepare the CRC calculation for the boot image
+  boot_image_crc32_init();
+  
+  //The program is loaded while the FPGA starts up, so no need for an extra delay
+  //Initialize the SD card
+  if(sd_card_init() != SD_OK)
+  {
+    //Without a card use the program in flash
+    boot_from_spi_flash();
+  }
+  
+  //Try to load the program as a boot image first
+  result = boot_image_load(PROGRAM_START_SECTOR, (uint8 *)STAGING_ADDRESS, &address);
+  
+  //When it is not a boot image check on an eGON image
+  if(result == BOOT_IMAGE_NOT_FOUND)
+  {
+    result = load_egon_program(buffer);
+  }
+  
+  //A broken program is not started
+  if(result != BOOT_IMAGE_OK)
   {
-    //At 600MHz CPU_CLK 1000 = ~200uS
-    for(i=0;i<1000;i++);
+    boot_from_spi_flash();
   }
   
   //Wait and make sure FPGA is ready
@@ -44,25 +88,27 @@ int main(void)
   //Turn of the display brightness
   fpga_set_backlight_brightness(0x0000);
   
-  //Initialize the SD card
-  if(sd_card_init() != SD_OK)
-  {
-    //On error just frees
-    while(1);
-  }
+  //Run the main program
+  start_program(address);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int32 load_egon_program(unsigned char *buffer)
+{
+  unsigned int length;
+  unsigned int blocks;
   
   //Load the first program sector from the SD card
-  if(sd_card_read(80, 1, buffer) != SD_OK)
+  if(sd_card_read(PROGRAM_START_SECTOR, 1, buffer) != SD_OK)
   {
-    //On error just frees
-    while(1);
+    return(BOOT_IMAGE_ERROR);
   }
 
   //Check if there is a brom header there
   if(memcmp(&buffer[4], "eGON.EXE", 8) != 0)
   {
-    //On error just frees
-    while(1);
+    return(BOOT_IMAGE_NOT_FOUND);
   }
   
   //Get the length from the header
@@ -72,7 +118,7 @@ int main(void)
   blocks = (length + 511) / 512;
   
   //Copy the first bytes to DRAM
-  memcpy((void *)0x80000000, &buffer[32], 480);
+  memcpy((void *)PROGRAM_ADDRESS, &buffer[32], 480);
   
   //Check if more data needs to be read
   if(blocks > 1)
@@ -81,15 +127,67 @@ int main(void)
     blocks--;
     
     //Load the remainder of the program from the SD card
-    if(sd_card_read(81, blocks, (void *)0x800001E0) != SD_OK)
+    if(sd_card_read(PROGRAM_START_SECTOR + 1, blocks, (void *)(PROGRAM_ADDRESS + 480)) != SD_OK)
     {
-      //On error just frees
+      return(BOOT_IMAGE_ERROR);
+    }
+  }
+  
+  return(BOOT_IMAGE_OK);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Start the scope program from the SPI flash the same way the flash bootloader does. Does not return
+
+void boot_from_spi_flash(void)
+{
+  unsigned char header[32];
+  unsigned int  length;
+  unsigned int  size;
+  
+  //Make sure the FPGA is ready before the program is started
+  fpga_check_ready();
+
+  //Initialize SPI for flash (PORT C + SPI0)
+  sys_spi_flash_init();
+  
+  //Get the header of the program
+  sys_spi_flash_read(FLASH_PROGRAM_HEADER, header, 32);
+
+  //Get the length from the header and take of the header
+  length = ((header[19] << 24) | (header[18] << 16) | (header[17] << 8) | header[16]) - 32;
+  
+  //Check if the program is stored compressed
+  if(lz4_is_compressed_image(header))
+  {
+    //Get the unpacked length from the header
+    size = (header[LZ4_IMAGE_SIZE_OFFSET + 3] << 24) | (header[LZ4_IMAGE_SIZE_OFFSET + 2] << 16) | (header[LZ4_IMAGE_SIZE_OFFSET + 1] << 8) | header[LZ4_IMAGE_SIZE_OFFSET];
+    
+    //Read it into the staging area and unpack it
+    sys_spi_flash_read(FLASH_PROGRAM_HEADER + 32, (unsigned char *)STAGING_ADDRESS, length);
+    
+    if(lz4_decompress((unsigned char *)STAGING_ADDRESS, length, (unsigned char *)PROGRAM_ADDRESS, size) != (int)size)
+    {
+      //Nothing left to start
       while(1);
     }
   }
- 
-  //Run the main program
-  unsigned int address = 0x80000000;
+  else
+  {
+    //Read the program into DRAM
+    sys_spi_flash_read(FLASH_PROGRAM_HEADER + 32, (unsigned char *)PROGRAM_ADDRESS, length);
+  }
+  
+  start_program(PROGRAM_ADDRESS);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
 
+void start_program(unsigned int address)
+{
   __asm__ __volatile__ ("mov pc, %0\n" :"=r"(address):"0"(address));
+  
+  while(1);
 }
+
+//----------------------------------------------------------------------------------------------------------------------------------
@@ -36,10 +36,13 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 # Object Files
 OBJECTFILES= \
 	${OBJECTDIR}/_ext/5fc58e7f/bl_sd_card_interface.o \
+	${OBJECTDIR}/bl_boot_image.o \
 	${OBJECTDIR}/bl_fpga_control.o \
+	${OBJECTDIR}/bl_spi_control.o \
 	${OBJECTDIR}/ccu_control.o \
 	${OBJECTDIR}/dram_control.o \
 	${OBJECTDIR}/fnirsi_1013d_startup_from_sd_card.o \
+	${OBJECTDIR}/lz4_decompress.o \
 	${OBJECTDIR}/memcmp.o \
 	${OBJECTDIR}/memcpy.o \
 	${OBJECTDIR}/memset.o \
@@ -75,11 +78,21 @@ ${OBJECTDIR}/_ext/5fc58e7f/bl_sd_card_interface.o: ../fnirsi_1013d_firmware_back
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5fc58e7f/bl_sd_card_interface.o ../fnirsi_1013d_firmware_backup_startup/bl_sd_card_interface.c
 
+${OBJECTDIR}/bl_boot_image.o: bl_boot_image.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/bl_boot_image.o bl_boot_image.c
+
 ${OBJECTDIR}/bl_fpga_control.o: bl_fpga_control.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/bl_fpga_control.o bl_fpga_control.c
 
+${OBJECTDIR}/bl_spi_control.o: bl_spi_control.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/bl_spi_control.o bl_spi_control.c
+
 ${OBJECTDIR}/ccu_control.o: ccu_control.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -95,6 +108,11 @@ ${OBJECTDIR}/fnirsi_1013d_startup_from_sd_card.o: fnirsi_1013d_startup_from_sd_c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/fnirsi_1013d_startup_from_sd_card.o fnirsi_1013d_startup_from_sd_card.c
 
+${OBJECTDIR}/lz4_decompress.o: lz4_decompress.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/lz4_decompress.o lz4_decompress.c
+
 ${OBJECTDIR}/memcmp.o: memcmp.s
 	${MKDIR} -p ${OBJECTDIR}
 	$(AS) $(ASFLAGS) -g -o ${OBJECTDIR}/memcmp.o memcmp.s
@@ -0,0 +1,302 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host side converter for the picture and waveform files saved by the scope
+//
+//Compressed pictures are decoded to the same 16 bit bitmap format the scope writes when compression is off, so they can be viewed
+//on the PC. Uncompressed pictures are copied as is. Waveform files, compressed or not, are converted to a CSV file with the raw
+//sample values of both channels.
+//
+//The decoders are the ones from the scope firmware, so the build needs its source directory.
+//
+//Build: make convert_scope_file
+//   or: gcc -O2 -I../fnirsi_1013d_scope -o convert_scope_file convert_scope_file.c ../fnirsi_1013d_scope/file_compression.c
+//Usage: convert_scope_file <scope file> <output file>
+//  e.g. ./convert_scope_file pictures/12.bmp picture_12.bmp
+//       ./convert_scope_file waveforms/3.wav waveform_3.csv
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_compression.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Need to match the settings in the scope firmware (variables.h)
+#define PICTURE_WIDTH                   800
+#define PICTURE_HEIGHT                  480
+#define PICTURE_HEADER_SIZE              70
+#define PICTURE_DATA_SIZE               (PICTURE_WIDTH * PICTURE_HEIGHT * 2)
+
+#define PICTURE_COMPRESSED_HEADER_SIZE   16
+
+#define VIEW_NUMBER_OF_SETTINGS         200
+#define WAVEFORM_FILE_VERSION    0x01010101
+#define WAVEFORM_COMPRESSED_DATA 0x43574E46
+#define WAVEFORM_SAMPLES               3000
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned char *load_file(const char *name, unsigned int *length)
+{
+  unsigned char *data;
+  long           size;
+  FILE          *fi = fopen(name, "rb");
+
+  if(fi == NULL)
+  {
+    printf("Can't open %s\n", name);
+    return(NULL);
+  }
+
+  //Get the size of the file
+  fseek(fi, 0, SEEK_END);
+  size = ftell(fi);
+  fseek(fi, 0, SEEK_SET);
+
+  data = malloc(size + 1);
+
+  if(data)
+  {
+    *length = fread(data, 1, size, fi);
+  }
+
+  fclose(fi);
+
+  return(data);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void put_uint(unsigned char *buffer, unsigned int value, int bytes)
+{
+  //Little endian
+  while(bytes--)
+  {
+    *buffer++ = value & 0xFF;
+    value >>= 8;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int write_bitmap(const char *name, unsigned short *pixels)
+{
+  unsigned char header[PICTURE_HEADER_SIZE];
+  FILE         *fo;
+
+  //Same header as the scope uses, 16 bits per pixel with bit fields and top to bottom lines
+  memset(header, 0, sizeof(header));
+
+  header[0] = 'B';
+  header[1] = 'M';
+
+  put_uint(&header[2], PICTURE_HEADER_SIZE + PICTURE_DATA_SIZE, 4);
+  put_uint(&header[10], PICTURE_HEADER_SIZE, 4);
+  put_uint(&header[14], 56, 4);
+  put_uint(&header[18], PICTURE_WIDTH, 4);
+  put_uint(&header[22], -PICTURE_HEIGHT, 4);
+  put_uint(&header[26], 1, 2);
+  put_uint(&header[28], 16, 2);
+  put_uint(&header[30], 3, 4);
+  put_uint(&header[34], PICTURE_DATA_SIZE, 4);
+
+  //Red, green and blue masks
+  put_uint(&header[54], 0xF800, 4);
+  put_uint(&header[58], 0x07E0, 4);
+  put_uint(&header[62], 0x001F, 4);
+
+  fo = fopen(name, "wb");
+
+  if(fo == NULL)
+  {
+    printf("Can't create %s\n", name);
+    return(1);
+  }
+
+  fwrite(header, 1, sizeof(header), fo);
+  fwrite(pixels, 1, PICTURE_DATA_SIZE, fo);
+
+  fclose(fo);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int convert_compressed_picture(unsigned char *data, unsigned int length, const char *name)
+{
+  PALETTECONTEXT  context;
+  unsigned short *pixels = malloc(PICTURE_DATA_SIZE);
+  unsigned short *dptr = pixels;
+  unsigned short *eptr = pixels + (PICTURE_DATA_SIZE / 2);
+  unsigned int    index = PICTURE_COMPRESSED_HEADER_SIZE;
+  unsigned int    size;
+
+  if(pixels == NULL)
+  {
+    printf("Out of memory\n");
+    return(1);
+  }
+
+  picture_compress_init(&context);
+
+  //Decode the blocks until the picture is filled
+  while(dptr < eptr)
+  {
+    //Check if there is a block length
+    if((index + 2) > length)
+    {
+      printf("File is too short\n");
+      return(1);
+    }
+
+    size = data[index] | (data[index + 1] << 8);
+    index += 2;
+
+    //Check if the block is valid and decode it
+    if(((index + size) > length) || (picture_decompress_block(&context, &data[index], size, &dptr, eptr) != 0))
+    {
+      printf("Coded picture data is not valid\n");
+      return(1);
+    }
+
+    index += size;
+  }
+
+  return(write_bitmap(name, pixels));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int convert_waveform(unsigned char *data, unsigned int length, const char *name)
+{
+  unsigned int  *setup = (unsigned int *)data;
+  unsigned char  channel1[WAVEFORM_SAMPLES];
+  unsigned char  channel2[WAVEFORM_SAMPLES];
+  unsigned int   index = VIEW_NUMBER_OF_SETTINGS * 4;
+  unsigned int   size;
+  int            used;
+  FILE          *fo;
+
+  //Check if this is a waveform file
+  if((length < index) || (setup[1] != WAVEFORM_FILE_VERSION))
+  {
+    printf("Not a scope picture or waveform file\n");
+    return(1);
+  }
+
+  //Check the format of the sample data
+  if(setup[2] == WAVEFORM_COMPRESSED_DATA)
+  {
+    if((index + 4) > length)
+    {
+      printf("File is too short\n");
+      return(1);
+    }
+
+    //Get the length of the coded data
+    size = data[index] | (data[index + 1] << 8) | (data[index + 2] << 16) | (data[index + 3] << 24);
+    index += 4;
+
+    if((index + size) > length)
+    {
+      printf("File is too short\n");
+      return(1);
+    }
+
+    //Decode both channels
+    if(((used = waveform_decompress(&data[index], size, channel1, WAVEFORM_SAMPLES)) < 0) || (waveform_decompress(&data[index + used], size - used, channel2, WAVEFORM_SAMPLES) < 0))
+    {
+      printf("Coded waveform data is not valid\n");
+      return(1);
+    }
+  }
+  else
+  {
+    if((index + (2 * WAVEFORM_SAMPLES)) > length)
+    {
+      printf("File is too short\n");
+      return(1);
+    }
+
+    //Take the raw samples
+    memcpy(channel1, &data[index], WAVEFORM_SAMPLES);
+    memcpy(channel2, &data[index + WAVEFORM_SAMPLES], WAVEFORM_SAMPLES);
+  }
+
+  fo = fopen(name, "w");
+
+  if(fo == NULL)
+  {
+    printf("Can't create %s\n", name);
+    return(1);
+  }
+
+  fprintf(fo, "sample,channel1,channel2\n");
+
+  for(index=0;index<WAVEFORM_SAMPLES;index++)
+  {
+    fprintf(fo, "%u,%u,%u\n", index, channel1[index], channel2[index]);
+  }
+
+  fclose(fo);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  unsigned char *data;
+  unsigned int   length = 0;
+  int            result;
+  FILE          *fo;
+
+  if(argc < 3)
+  {
+    printf("Usage: %s <scope file> <output file>\n", argv[0]);
+    return(1);
+  }
+
+  data = load_file(argv[1], &length);
+
+  if(data == NULL)
+  {
+    return(1);
+  }
+
+  //Check on the type of file
+  if((length >= PICTURE_COMPRESSED_HEADER_SIZE) && (memcmp(data, "FNPC", 4) == 0))
+  {
+    result = convert_compressed_picture(data, length, argv[2]);
+  }
+  else if((length >= PICTURE_HEADER_SIZE) && (data[0] == 'B') && (data[1] == 'M'))
+  {
+    //Already a bitmap so just copy it
+    fo = fopen(argv[2], "wb");
+
+    if(fo)
+    {
+      fwrite(data, 1, length, fo);
+      fclose(fo);
+      result = 0;
+    }
+    else
+    {
+      printf("Can't create %s\n", argv[2]);
+      result = 1;
+    }
+  }
+  else
+  {
+    result = convert_waveform(data, length, argv[2]);
+  }
+
+  free(data);
+
+  return(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,168 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host side protocol decoding of waveforms saved by the scope
+//
+//Reads the CSV file made by convert_scope_file and runs the protocol decoders of the scope firmware on the samples. UART is decoded
+//from channel 1, I2C uses channel 1 for SCL and channel 2 for SDA, and SPI uses channel 1 for the clock and channel 2 for the data.
+//The signals are sliced with the same levels as the scope uses.
+//
+//Build: make decode_scope_waveform
+//   or: gcc -O2 -I../fnirsi_1013d_scope -o decode_scope_waveform decode_scope_waveform.c ../fnirsi_1013d_scope/protocol_decoder.c
+//Usage: decode_scope_waveform <csv file> <uart|i2c|spi>
+//  e.g. ./convert_scope_file waveforms/3.wav waveform_3.csv
+//       ./decode_scope_waveform waveform_3.csv uart
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+
+#include "protocol_decoder.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Need to match the settings in the scope firmware
+#define WAVEFORM_SAMPLES               3000
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned char channel1[WAVEFORM_SAMPLES];
+unsigned char channel2[WAVEFORM_SAMPLES];
+
+DECODERSTREAM streams[2];
+DECODERRESULT result;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int load_csv(const char *name)
+{
+  unsigned int index;
+  unsigned int sample1;
+  unsigned int sample2;
+  unsigned int count = 0;
+  char         line[100];
+  FILE        *fi = fopen(name, "r");
+
+  if(fi == NULL)
+  {
+    printf("Can't open %s\n", name);
+    return(0);
+  }
+
+  //Take the sample lines and skip the header
+  while((count < WAVEFORM_SAMPLES) && fgets(line, sizeof(line), fi))
+  {
+    if(sscanf(line, "%u,%u,%u", &index, &sample1, &sample2) == 3)
+    {
+      channel1[count] = sample1;
+      channel2[count] = sample2;
+      count++;
+    }
+  }
+
+  fclose(fi);
+
+  return(count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void slice_channel(unsigned char *samples, unsigned int count, PDECODERSTREAM stream)
+{
+  unsigned int min = 255;
+  unsigned int max = 0;
+  unsigned int center;
+  unsigned int threshold;
+  unsigned int index;
+
+  for(index=0;index<count;index++)
+  {
+    if(samples[index] < min)
+    {
+      min = samples[index];
+    }
+
+    if(samples[index] > max)
+    {
+      max = samples[index];
+    }
+  }
+
+  //Same levels as the scope uses
+  center    = (max + min) / 2;
+  threshold = ((max - min) / 10) + 2;
+
+  decoder_slice_channel(samples, count, (center > threshold) ? center - threshold : 0, center + threshold, stream);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  unsigned int count;
+  unsigned int index;
+  PDECODERITEM item;
+
+  if(argc < 3)
+  {
+    printf("Usage: %s <csv file> <uart|i2c|spi>\n", argv[0]);
+    return(1);
+  }
+
+  count = load_csv(argv[1]);
+
+  if(count == 0)
+  {
+    printf("No samples in %s\n", argv[1]);
+    return(1);
+  }
+
+  slice_channel(channel1, count, &streams[0]);
+  slice_channel(channel2, count, &streams[1]);
+
+  if(strcmp(argv[2], "uart") == 0)
+  {
+    decoder_uart(&streams[0], &result);
+
+    printf("Bit time %u.%02u samples\n", result.bittime >> DECODER_FRACTION_BITS, ((result.bittime & 0xFF) * 100) >> DECODER_FRACTION_BITS);
+  }
+  else if(strcmp(argv[2], "i2c") == 0)
+  {
+    decoder_i2c(&streams[0], &streams[1], &result);
+  }
+  else if(strcmp(argv[2], "spi") == 0)
+  {
+    decoder_spi(&streams[0], &streams[1], DECODER_SPI_RISING_EDGE, &result);
+  }
+  else
+  {
+    printf("Unknown protocol %s\n", argv[2]);
+    return(1);
+  }
+
+  printf("start,end,value,flags\n");
+
+  for(index=0,item=result.items;index<result.count;index++,item++)
+  {
+    printf("%u,%u,0x%02X,", item->start, item->end, item->value);
+
+    if(item->flags & DECODER_FLAG_ERROR)
+    {
+      printf(" framing error");
+    }
+
+    if(item->flags & DECODER_FLAG_ADDRESS)
+    {
+      printf(" address");
+    }
+
+    if(item->flags & DECODER_FLAG_ACK)
+    {
+      printf(" ack");
+    }
+
+    printf("\n");
+  }
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
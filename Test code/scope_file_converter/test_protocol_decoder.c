@@ -0,0 +1,324 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host side test of the protocol decoders of the scope firmware
+//
+//Builds synthetic UART, I2C and SPI captures with known bytes, on the sample levels and with the noise of a real capture, slices them
+//with the same levels as the scope uses and checks the decoded bytes and flags.
+//
+//Build: make test_protocol_decoder
+//   or: gcc -O2 -I../fnirsi_1013d_scope -o test_protocol_decoder test_protocol_decoder.c ../fnirsi_1013d_scope/protocol_decoder.c
+//  Run: make check
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+
+#include "protocol_decoder.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+//Need to match the settings in the scope firmware
+#define CAPTURE_SAMPLES                3000
+
+//Sample values for the logic levels, with a bit of noise on them
+#define CAPTURE_LOW                      60
+#define CAPTURE_HIGH                    190
+#define CAPTURE_NOISE                     6
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct tagCapture              CAPTURE,             *PCAPTURE;
+typedef struct tagExpected             EXPECTED,            *PEXPECTED;
+
+//Two channels filled one level run at a time
+struct tagCapture
+{
+  unsigned int  count;
+  unsigned char channel1[CAPTURE_SAMPLES];
+  unsigned char channel2[CAPTURE_SAMPLES];
+};
+
+struct tagExpected
+{
+  unsigned char value;
+  unsigned char flags;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+CAPTURE       capture;
+DECODERSTREAM streams[2];
+DECODERRESULT result;
+
+unsigned int  noisestate = 1013;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned char level_sample(unsigned int level)
+{
+  noisestate = (noisestate * 1103515245) + 12345;
+
+  return((level ? CAPTURE_HIGH : CAPTURE_LOW) + ((noisestate >> 16) % ((CAPTURE_NOISE * 2) + 1)) - CAPTURE_NOISE);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Add the given number of samples with the given levels on both channels
+
+void add_levels(unsigned int level1, unsigned int level2, unsigned int samples)
+{
+  while(samples-- && (capture.count < CAPTURE_SAMPLES))
+  {
+    capture.channel1[capture.count] = level_sample(level1);
+    capture.channel2[capture.count] = level_sample(level2);
+    capture.count++;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Fill the rest of the capture with the given levels
+
+void end_capture(unsigned int level1, unsigned int level2)
+{
+  add_levels(level1, level2, CAPTURE_SAMPLES);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Same slicing levels as the scope uses
+
+void slice_channel(unsigned char *samples, unsigned int count, PDECODERSTREAM stream)
+{
+  unsigned int min = 255;
+  unsigned int max = 0;
+  unsigned int center;
+  unsigned int threshold;
+  unsigned int index;
+
+  for(index=0;index<count;index++)
+  {
+    if(samples[index] < min)
+    {
+      min = samples[index];
+    }
+
+    if(samples[index] > max)
+    {
+      max = samples[index];
+    }
+  }
+
+  center    = (max + min) / 2;
+  threshold = ((max - min) / 10) + 2;
+
+  decoder_slice_channel(samples, count, (center > threshold) ? center - threshold : 0, center + threshold, stream);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Returns the number of errors found in the decoded bytes
+
+unsigned int check_result(const char *name, PEXPECTED expected, unsigned int count)
+{
+  unsigned int errors = 0;
+  unsigned int index;
+
+  if(result.count != count)
+  {
+    printf("%s: %u bytes decoded, expected %u\n", name, result.count, count);
+    errors++;
+  }
+
+  for(index=0;(index<count)&&(index<result.count);index++)
+  {
+    if((result.items[index].value != expected[index].value) || (result.items[index].flags != expected[index].flags))
+    {
+      printf("%s: byte %u is 0x%02X with flags 0x%02X, expected 0x%02X with flags 0x%02X\n", name, index, result.items[index].value, result.items[index].flags, expected[index].value, expected[index].flags);
+      errors++;
+    }
+  }
+
+  printf("%s: %s\n", name, errors ? "failed" : "ok");
+
+  return(errors);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//8N1 frames on channel 1 with a bit time of 12.5 samples, so the auto baud has to find the fraction. The last frame has a low stop bit
+
+unsigned int test_uart(void)
+{
+  static EXPECTED expected[] =
+  {
+    { 0x55, 0 }, { 0xA3, 0 }, { 0x00, 0 }, { 0xFF, 0 }, { 0x4B, 0 }, { 0x81, DECODER_FLAG_ERROR }
+  };
+
+  unsigned int count = sizeof(expected) / sizeof(EXPECTED);
+  unsigned int frame;
+  unsigned int bits;
+  unsigned int sample;
+  unsigned int start;
+
+  capture.count = 0;
+
+  add_levels(1, 0, 50);
+
+  for(frame=0;frame<count;frame++)
+  {
+    //Start bit, data least significant bit first and the stop bit. The last frame is cut short with the line held low
+    bits = (expected[frame].value << 1) | ((expected[frame].flags & DECODER_FLAG_ERROR) ? 0 : 0x200);
+
+    start = capture.count;
+
+    for(sample=0;sample<125;sample++)
+    {
+      add_levels((bits >> ((sample * 2) / 25)) & 1, 0, 1);
+    }
+
+    //Idle time between the frames, except after the framing error which keeps the line low for a while
+    if(expected[frame].flags & DECODER_FLAG_ERROR)
+    {
+      add_levels(0, 0, 40);
+    }
+
+    add_levels(1, 0, 30 + (start % 17));
+  }
+
+  end_capture(1, 0);
+
+  slice_channel(capture.channel1, capture.count, &streams[0]);
+  decoder_uart(&streams[0], &result);
+
+  printf("uart: bit time %u.%02u samples\n", result.bittime >> DECODER_FRACTION_BITS, ((result.bittime & 0xFF) * 100) >> DECODER_FRACTION_BITS);
+
+  return(check_result("uart", expected, count));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Add an I2C byte with the acknowledge bit. The data changes halfway the low time of the clock
+
+void add_i2c_byte(unsigned int value, unsigned int ack, unsigned int *sda)
+{
+  unsigned int bit;
+  unsigned int level;
+
+  for(bit=0;bit<9;bit++)
+  {
+    level = (bit < 8) ? ((value >> (7 - bit)) & 1) : (ack ? 0 : 1);
+
+    add_levels(0, *sda, 5);
+    add_levels(0, level, 5);
+    add_levels(1, level, 10);
+
+    *sda = level;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//A write and a read transfer on channel 1 for SCL and channel 2 for SDA, with a repeated start in between. The last read byte is not
+//acknowledged
+
+unsigned int test_i2c(void)
+{
+  static EXPECTED expected[] =
+  {
+    { 0xA0, DECODER_FLAG_ADDRESS | DECODER_FLAG_ACK }, { 0x3C, DECODER_FLAG_ACK },
+    { 0xA1, DECODER_FLAG_ADDRESS | DECODER_FLAG_ACK }, { 0x5A, DECODER_FLAG_ACK }, { 0xC3, 0 }
+  };
+
+  unsigned int sda = 1;
+
+  capture.count = 0;
+
+  //Idle and start condition
+  add_levels(1, 1, 40);
+  add_levels(1, 0, 10);
+  sda = 0;
+
+  add_i2c_byte(0xA0, 1, &sda);
+  add_i2c_byte(0x3C, 1, &sda);
+
+  //Repeated start. Data goes high while the clock is low, then low while the clock is high
+  add_levels(0, sda, 5);
+  add_levels(0, 1, 5);
+  add_levels(1, 1, 10);
+  add_levels(1, 0, 10);
+  sda = 0;
+
+  add_i2c_byte(0xA1, 1, &sda);
+  add_i2c_byte(0x5A, 1, &sda);
+  add_i2c_byte(0xC3, 0, &sda);
+
+  //Stop condition
+  add_levels(0, sda, 5);
+  add_levels(0, 0, 5);
+  add_levels(1, 0, 10);
+
+  end_capture(1, 1);
+
+  slice_channel(capture.channel1, capture.count, &streams[0]);
+  slice_channel(capture.channel2, capture.count, &streams[1]);
+  decoder_i2c(&streams[0], &streams[1], &result);
+
+  return(check_result("i2c", expected, sizeof(expected) / sizeof(EXPECTED)));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Add SPI bits on an idle low clock, most significant bit first. The data changes on the falling edge and is taken on the rising edge
+
+void add_spi_bits(unsigned int value, unsigned int bits)
+{
+  unsigned int level;
+
+  while(bits--)
+  {
+    level = (value >> bits) & 1;
+
+    add_levels(0, level, 6);
+    add_levels(1, level, 6);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Two transfers on channel 1 for the clock and channel 2 for the data, with a cut off transfer in between that has to be dropped on the
+//pause in the clock
+
+unsigned int test_spi(void)
+{
+  static EXPECTED expected[] =
+  {
+    { 0x96, 0 }, { 0x0F, 0 }, { 0xE1, 0 }
+  };
+
+  capture.count = 0;
+
+  add_levels(0, 0, 60);
+
+  add_spi_bits(0x96, 8);
+  add_spi_bits(0x0F, 8);
+  add_levels(0, 0, 100);
+
+  add_spi_bits(0x05, 3);
+  add_levels(0, 1, 100);
+
+  add_spi_bits(0xE1, 8);
+
+  end_capture(0, 0);
+
+  slice_channel(capture.channel1, capture.count, &streams[0]);
+  slice_channel(capture.channel2, capture.count, &streams[1]);
+  decoder_spi(&streams[0], &streams[1], DECODER_SPI_RISING_EDGE, &result);
+
+  return(check_result("spi", expected, sizeof(expected) / sizeof(EXPECTED)));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  unsigned int errors = 0;
+
+  errors += test_uart();
+  errors += test_i2c();
+  errors += test_spi();
+
+  return(errors ? 1 : 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
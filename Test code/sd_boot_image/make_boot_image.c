@@ -0,0 +1,370 @@
+//----------------------------------------------------------------------------------------------------------------------------------
+//Host side tool to make a boot image for the SD card bootloaders
+//
+//The image starts with a 512 byte header sector that holds the load address, the lengths and CRC32 checksums of the payload and the
+//header itself. The payload follows on the next sector. Optional the program is stored LZ4 compressed, which makes the card read
+//shorter. The bootloader then unpacks it into DRAM.
+//
+//An eGON header on the input file is stripped, since the bootloader starts the program itself.
+//
+//The header layout needs to match the bootloaders (bl_boot_image.h).
+//
+//Build: make make_boot_image
+//   or: gcc -O2 -o make_boot_image make_boot_image.c
+//Usage: make_boot_image [-z] [-a load address] <program file> <image file>
+//  e.g. ./make_boot_image -z -a 0x80000000 fnirsi_1013d.bin boot_image.bin
+//       dd if=boot_image.bin of=/dev/sdX bs=512 seek=80
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#define BOOT_IMAGE_SIGNATURE            "FNBOOTIM"
+#define BOOT_IMAGE_SIGNATURE_SIZE                8
+#define BOOT_IMAGE_VERSION                       1
+#define BOOT_IMAGE_FLAG_LZ4             0x00000001
+
+#define BOOT_IMAGE_HEADER_SECTOR               512
+
+//Offsets of the header fields
+#define BOOT_IMAGE_SIGNATURE_OFFSET              4
+#define BOOT_IMAGE_VERSION_OFFSET               12
+#define BOOT_IMAGE_LOADADDRESS_OFFSET           16
+#define BOOT_IMAGE_LENGTH_OFFSET                20
+#define BOOT_IMAGE_SIZE_OFFSET                  24
+#define BOOT_IMAGE_CRC_OFFSET                   28
+#define BOOT_IMAGE_FLAGS_OFFSET                 32
+#define BOOT_IMAGE_HEADERCRC_OFFSET             36
+
+#define DEFAULT_LOAD_ADDRESS            0x80000000
+
+#define EGON_HEADER_SIZE                        32
+
+//Same settings as the flash file packer
+#define LZ4_HASH_BITS                           16
+#define LZ4_MAX_OFFSET                       65535
+#define LZ4_MIN_MATCH                            4
+#define LZ4_LAST_LITERALS                        5
+#define LZ4_MATCH_LIMIT                         12
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int crc32_table[256];
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void crc32_init(void)
+{
+  unsigned int crc;
+  int          i;
+  int          j;
+
+  for(i=0;i<256;i++)
+  {
+    crc = i;
+
+    for(j=0;j<8;j++)
+    {
+      crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+    }
+
+    crc32_table[i] = crc;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int crc32(unsigned char *data, unsigned int length)
+{
+  unsigned int crc = 0xFFFFFFFF;
+
+  while(length--)
+  {
+    crc = crc32_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  }
+
+  return(~crc);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void put_uint(unsigned char *buffer, unsigned int value)
+{
+  //Little endian
+  buffer[0] = value;
+  buffer[1] = value >> 8;
+  buffer[2] = value >> 16;
+  buffer[3] = value >> 24;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+unsigned char *load_file(const char *name, unsigned int *length)
+{
+  unsigned char *data;
+  long           size;
+  FILE          *fi = fopen(name, "rb");
+
+  if(fi == NULL)
+  {
+    printf("Can't open %s\n", name);
+    return(NULL);
+  }
+
+  //Get the size of the file
+  fseek(fi, 0, SEEK_END);
+  size = ftell(fi);
+  fseek(fi, 0, SEEK_SET);
+
+  data = malloc(size + 1);
+
+  if(data)
+  {
+    *length = fread(data, 1, size, fi);
+  }
+
+  fclose(fi);
+
+  return(data);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void lz4_put_length(unsigned char **dest, int length)
+{
+  unsigned char *ptr = *dest;
+
+  //Lengths of 15 and up are continued in extra bytes
+  while(length >= 255)
+  {
+    *ptr++ = 255;
+    length -= 255;
+  }
+
+  *ptr++ = length;
+
+  *dest = ptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+//Greedy LZ4 block compressor. The destination needs to be able to hold the worst case size (length + (length / 255) + 16)
+
+int lz4_compress(unsigned char *source, int length, unsigned char *dest)
+{
+  int           *table = malloc(sizeof(int) << LZ4_HASH_BITS);
+  unsigned char *dptr = dest;
+  unsigned char *token;
+  unsigned int   sequence;
+  unsigned int   hash;
+  int            index = 0;
+  int            anchor = 0;
+  int            match;
+  int            matchlength;
+  int            literals;
+
+  if(table == NULL)
+  {
+    return(-1);
+  }
+
+  //No positions seen yet
+  memset(table, 0xFF, sizeof(int) << LZ4_HASH_BITS);
+
+  //Matches are not allowed to start in the last bytes of the block
+  while(index < (length - LZ4_MATCH_LIMIT))
+  {
+    //Look up the last position of the next four bytes
+    sequence = source[index] | (source[index + 1] << 8) | (source[index + 2] << 16) | (source[index + 3] << 24);
+    hash = (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+    match = table[hash];
+    table[hash] = index;
+
+    //Check if there is a usable match
+    if((match < 0) || ((index - match) > LZ4_MAX_OFFSET) || (memcmp(&source[match], &source[index], LZ4_MIN_MATCH) != 0))
+    {
+      index++;
+      continue;
+    }
+
+    //See how far the match goes. The last bytes of the block need to be literals
+    matchlength = LZ4_MIN_MATCH;
+
+    while(((index + matchlength) < (length - LZ4_LAST_LITERALS)) && (source[match + matchlength] == source[index + matchlength]))
+    {
+      matchlength++;
+    }
+
+    //Write the token with the literal length and the match length
+    literals = index - anchor;
+    token = dptr++;
+    *token = 0;
+
+    if(literals >= 15)
+    {
+      *token = 0xF0;
+      lz4_put_length(&dptr, literals - 15);
+    }
+    else
+    {
+      *token = literals << 4;
+    }
+
+    //Copy the literals
+    memcpy(dptr, &source[anchor], literals);
+    dptr += literals;
+
+    //Write the offset
+    *dptr++ = (index - match) & 0xFF;
+    *dptr++ = (index - match) >> 8;
+
+    //Write the match length minus the minimum length
+    if((matchlength - LZ4_MIN_MATCH) >= 15)
+    {
+      *token |= 0x0F;
+      lz4_put_length(&dptr, matchlength - LZ4_MIN_MATCH - 15);
+    }
+    else
+    {
+      *token |= matchlength - LZ4_MIN_MATCH;
+    }
+
+    //Continue after the match
+    index += matchlength;
+    anchor = index;
+  }
+
+  //The last sequence only holds literals
+  literals = length - anchor;
+
+  if(literals >= 15)
+  {
+    *dptr++ = 0xF0;
+    lz4_put_length(&dptr, literals - 15);
+  }
+  else
+  {
+    *dptr++ = literals << 4;
+  }
+
+  memcpy(dptr, &source[anchor], literals);
+  dptr += literals;
+
+  free(table);
+
+  return(dptr - dest);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  unsigned char  header[BOOT_IMAGE_HEADER_SECTOR];
+  unsigned char *data;
+  unsigned char *program;
+  unsigned char *payload;
+  unsigned int   length = 0;
+  unsigned int   size;
+  unsigned int   address = DEFAULT_LOAD_ADDRESS;
+  unsigned int   flags = 0;
+  int            compress = 0;
+  int            option;
+  FILE          *fo;
+
+  while((option = getopt(argc, argv, "za:")) != -1)
+  {
+    switch(option)
+    {
+      case 'z':
+        compress = 1;
+        break;
+
+      case 'a':
+        address = strtoul(optarg, NULL, 0);
+        break;
+
+      default:
+        printf("Usage: %s [-z] [-a load address] <program file> <image file>\n", argv[0]);
+        return(1);
+    }
+  }
+
+  if((argc - optind) < 2)
+  {
+    printf("Usage: %s [-z] [-a load address] <program file> <image file>\n", argv[0]);
+    return(1);
+  }
+
+  data = load_file(argv[optind], &length);
+
+  if(data == NULL)
+  {
+    return(1);
+  }
+
+  program = data;
+
+  //Take of the eGON header when there is one
+  if((length > EGON_HEADER_SIZE) && (memcmp(&data[4], "eGON.EXE", 8) == 0))
+  {
+    program += EGON_HEADER_SIZE;
+    length -= EGON_HEADER_SIZE;
+  }
+
+  size = length;
+  payload = program;
+
+  if(compress)
+  {
+    //Room for the worst case
+    payload = malloc(length + (length / 255) + 16);
+
+    if(payload == NULL)
+    {
+      printf("Out of memory\n");
+      return(1);
+    }
+
+    length = lz4_compress(program, size, payload);
+
+    flags |= BOOT_IMAGE_FLAG_LZ4;
+
+    printf("Compressed %u bytes to %u bytes\n", size, length);
+  }
+
+  crc32_init();
+
+  //Fill in the header. The rest of the sector stays zero
+  memset(header, 0, sizeof(header));
+  memcpy(&header[BOOT_IMAGE_SIGNATURE_OFFSET], BOOT_IMAGE_SIGNATURE, BOOT_IMAGE_SIGNATURE_SIZE);
+  put_uint(&header[BOOT_IMAGE_VERSION_OFFSET], BOOT_IMAGE_VERSION);
+  put_uint(&header[BOOT_IMAGE_LOADADDRESS_OFFSET], address);
+  put_uint(&header[BOOT_IMAGE_LENGTH_OFFSET], length);
+  put_uint(&header[BOOT_IMAGE_SIZE_OFFSET], size);
+  put_uint(&header[BOOT_IMAGE_CRC_OFFSET], crc32(payload, length));
+  put_uint(&header[BOOT_IMAGE_FLAGS_OFFSET], flags);
+  put_uint(&header[BOOT_IMAGE_HEADERCRC_OFFSET], crc32(header, BOOT_IMAGE_HEADERCRC_OFFSET));
+
+  fo = fopen(argv[optind + 1], "wb");
+
+  if(fo == NULL)
+  {
+    printf("Can't create %s\n", argv[optind + 1]);
+    return(1);
+  }
+
+  fwrite(header, 1, sizeof(header), fo);
+  fwrite(payload, 1, length, fo);
+
+  //Pad the payload to a full sector
+  memset(header, 0, sizeof(header));
+  fwrite(header, 1, (BOOT_IMAGE_HEADER_SECTOR - (length % BOOT_IMAGE_HEADER_SECTOR)) % BOOT_IMAGE_HEADER_SECTOR, fo);
+
+  fclose(fo);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------